@@ -34,3 +34,42 @@ __attribute__((weak)) int select(int maxfdp1, fd_set *readset, fd_set *writeset,
 {
     return select2(maxfdp1, readset, writeset, exceptset, timeout, NULL);
 }
+
+/* dummy readiness set, fix compile error with no net evn */
+struct evset {
+    void *semaphore;
+};
+
+__attribute__((weak)) evset_t *evset_new(void *semaphore)
+{
+    evset_t *set = aos_zalloc(sizeof(evset_t));
+
+    if (set) {
+        set->semaphore = semaphore;
+    }
+
+    return set;
+}
+
+__attribute__((weak)) void evset_free(evset_t *set)
+{
+    aos_free(set);
+}
+
+__attribute__((weak)) int evset_ctl(evset_t *set, int op, int fd, uint32_t events)
+{
+    return -1;
+}
+
+__attribute__((weak)) int evset_wait(evset_t *set, evset_event_t *evs, int maxevents, int timeout_ms)
+{
+    uint32_t tomeout_ms = timeout_ms < 0 ? AOS_WAIT_FOREVER : timeout_ms;
+
+    if (set && set->semaphore && aos_sem_is_valid(set->semaphore)) {
+        aos_sem_wait(set->semaphore, tomeout_ms);
+    } else {
+        aos_msleep(tomeout_ms);
+    }
+
+    return 0;
+}
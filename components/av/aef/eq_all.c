@@ -25,5 +25,13 @@ int eqx_register_ipc()
     return eqx_ops_register(&eqx_ops_ipc);
 }
 
-
+/**
+ * @brief  regist equalizer for local
+ * @return 0/-1
+ */
+int eqx_register_local()
+{
+    extern struct eqx_ops eqx_ops_local;
+    return eqx_ops_register(&eqx_ops_local);
+}
 
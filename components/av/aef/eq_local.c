@@ -0,0 +1,331 @@
+/*
+ * Copyright (C) 2018-2020 Alibaba Group Holding Limited
+ */
+
+#if defined(CONFIG_EQXER_LOCAL) && CONFIG_EQXER_LOCAL
+#include <math.h>
+#include "avutil/common.h"
+#include "avutil/av_typedef.h"
+#include "aef/eq_cls.h"
+
+#define TAG                   "eq_local"
+
+/*
+ * cascaded rbj biquads in fixed point, transposed direct form II:
+ * coefficients are Q28, the signal is Q27(s16 << 12, +18dB headroom), the states are 64 bits Q55.
+ * a new param ramps the coefficients linearly over EQ_RAMP_SAMPLES, so no zipper noise.
+ * mono only: avf_eq_open refuses a sf of other than 1 channel, so the one set of states
+ * per biquad is never shared by interleaved channels
+ */
+#define EQ_COEF_SHIFT         (28)
+#define EQ_SIG_SHIFT          (12)
+#define EQ_SIG_MAX            (INT32_MAX >> 1)  ///< 8.0 in Q27
+#define EQ_RAMP_SAMPLES       (256)
+
+enum {
+    EQ_B0,
+    EQ_B1,
+    EQ_B2,
+    EQ_A1,
+    EQ_A2,
+    EQ_COEF_NUM,
+};
+
+typedef struct {
+    int32_t                   coef[EQ_COEF_NUM];   ///< in use
+    int32_t                   target[EQ_COEF_NUM];
+    int32_t                   step[EQ_COEF_NUM];
+    int32_t                   on[EQ_COEF_NUM];     ///< of the param, used when the segment & eq enabled
+    uint32_t                  ramp;                ///< samples left to the target
+    uint8_t                   enable;              ///< enable of the segment
+    int64_t                   s1;
+    int64_t                   s2;
+} eq_biquad_t;
+
+struct eq_local_priv {
+    uint32_t                  rate;
+    uint8_t                   enable;
+    uint8_t                   nb_biquads;
+    eq_biquad_t               *biquads;
+    int32_t                   *buf;                ///< POST_PROC_SAMPLES_MAX
+};
+
+static const int32_t _coef_unity[EQ_COEF_NUM] = { 1 << EQ_COEF_SHIFT, 0, 0, 0, 0 };
+
+static inline int32_t _sat_sig(int64_t v)
+{
+    return v > EQ_SIG_MAX ? EQ_SIG_MAX : (v < -EQ_SIG_MAX ? -EQ_SIG_MAX : (int32_t)v);
+}
+
+static inline int16_t _sat_s16(int32_t v)
+{
+    return v > INT16_MAX ? INT16_MAX : (v < INT16_MIN ? INT16_MIN : (int16_t)v);
+}
+
+/**
+ * @brief  rbj cookbook coefficients, the gain is used by the peak filter only
+ * @return 0/-1
+ */
+static int _eq_biquad_coef(uint32_t rate, const eqfp_t *param, int32_t coef[EQ_COEF_NUM])
+{
+    int i;
+    double w0, cw, alpha, a, k, c[EQ_COEF_NUM + 1];
+
+    if (!(param->rate > 0 && param->rate < rate / 2)) {
+        LOGE(TAG, "freq error. freq = %u, rate = %u", param->rate, rate);
+        return -1;
+    }
+
+    w0    = 2 * M_PI * param->rate / rate;
+    cw    = cos(w0);
+    alpha = sin(w0) / (2 * param->q);
+    /* c: b0 b1 b2 a1 a2 a0 */
+    switch (param->type) {
+    case EQF_TYPE_PEAK:
+        a    = pow(10, param->gain / 40);
+        c[0] = 1 + alpha * a;
+        c[1] = -2 * cw;
+        c[2] = 1 - alpha * a;
+        c[3] = -2 * cw;
+        c[4] = 1 - alpha / a;
+        c[5] = 1 + alpha / a;
+        break;
+    case EQF_TYPE_NOTCH:
+        c[0] = 1;
+        c[1] = -2 * cw;
+        c[2] = 1;
+        c[3] = -2 * cw;
+        c[4] = 1 - alpha;
+        c[5] = 1 + alpha;
+        break;
+    case EQF_TYPE_LP1:
+    case EQF_TYPE_HP1:
+        k    = tan(w0 / 2);
+        c[0] = param->type == EQF_TYPE_LP1 ? k : 1;
+        c[1] = param->type == EQF_TYPE_LP1 ? k : -1;
+        c[2] = 0;
+        c[3] = k - 1;
+        c[4] = 0;
+        c[5] = k + 1;
+        break;
+    case EQF_TYPE_LP2:
+        c[0] = (1 - cw) / 2;
+        c[1] = 1 - cw;
+        c[2] = (1 - cw) / 2;
+        c[3] = -2 * cw;
+        c[4] = 1 - alpha;
+        c[5] = 1 + alpha;
+        break;
+    case EQF_TYPE_HP2:
+        c[0] = (1 + cw) / 2;
+        c[1] = -(1 + cw);
+        c[2] = (1 + cw) / 2;
+        c[3] = -2 * cw;
+        c[4] = 1 - alpha;
+        c[5] = 1 + alpha;
+        break;
+    case EQF_TYPE_BP2:
+        c[0] = alpha;
+        c[1] = 0;
+        c[2] = -alpha;
+        c[3] = -2 * cw;
+        c[4] = 1 - alpha;
+        c[5] = 1 + alpha;
+        break;
+    default:
+        LOGE(TAG, "type not support. type = %d", param->type);
+        return -1;
+    }
+
+    for (i = 0; i < EQ_COEF_NUM; i++) {
+        c[i] /= c[5];
+        if (!(fabs(c[i]) < (1 << (31 - EQ_COEF_SHIFT)))) {
+            LOGE(TAG, "coef out of range. type = %d, gain = %f, q = %f", param->type, param->gain, param->q);
+            return -1;
+        }
+        coef[i] = (int32_t)lrint(c[i] * (1 << EQ_COEF_SHIFT));
+    }
+
+    return 0;
+}
+
+static void _eq_biquad_retarget(struct eq_local_priv *priv, eq_biquad_t *bq)
+{
+    int i;
+    const int32_t *target = (priv->enable && bq->enable) ? bq->on : _coef_unity;
+
+    for (i = 0; i < EQ_COEF_NUM; i++) {
+        bq->target[i] = target[i];
+        bq->step[i]   = (int32_t)(((int64_t)target[i] - bq->coef[i]) / EQ_RAMP_SAMPLES);
+    }
+    bq->ramp = EQ_RAMP_SAMPLES;
+}
+
+static int _eq_biquad_is_unity(const eq_biquad_t *bq)
+{
+    return bq->ramp == 0 && !memcmp(bq->coef, _coef_unity, sizeof(_coef_unity));
+}
+
+#define EQ_BIQUAD_STEP(x, y, b0, b1, b2, a1, a2, s1, s2)                              \
+    do {                                                                              \
+        int64_t acc = (int64_t)(b0) * (x) + (s1);                                     \
+        (y)  = _sat_sig((acc + (1 << (EQ_COEF_SHIFT - 1))) >> EQ_COEF_SHIFT);         \
+        (s1) = (int64_t)(b1) * (x) - (int64_t)(a1) * (y) + (s2);                      \
+        (s2) = (int64_t)(b2) * (x) - (int64_t)(a2) * (y);                             \
+    } while (0)
+
+static void _eq_biquad_run(eq_biquad_t *bq, int32_t *buf, size_t nb_samples)
+{
+    size_t i, n;
+    int32_t x, y;
+    int64_t s1 = bq->s1, s2 = bq->s2;
+    int32_t *c = bq->coef;
+
+    /* coefficients move to the target sample by sample first */
+    n = MIN(bq->ramp, nb_samples);
+    for (i = 0; i < n; i++) {
+        c[EQ_B0] += bq->step[EQ_B0];
+        c[EQ_B1] += bq->step[EQ_B1];
+        c[EQ_B2] += bq->step[EQ_B2];
+        c[EQ_A1] += bq->step[EQ_A1];
+        c[EQ_A2] += bq->step[EQ_A2];
+        x = buf[i];
+        EQ_BIQUAD_STEP(x, y, c[EQ_B0], c[EQ_B1], c[EQ_B2], c[EQ_A1], c[EQ_A2], s1, s2);
+        buf[i] = y;
+    }
+    bq->ramp -= n;
+    if (n && bq->ramp == 0) {
+        /* drop the rounding of the steps */
+        memcpy(c, bq->target, sizeof(bq->target));
+    }
+
+    {
+        const int32_t b0 = c[EQ_B0], b1 = c[EQ_B1], b2 = c[EQ_B2], a1 = c[EQ_A1], a2 = c[EQ_A2];
+
+        for (; i < nb_samples; i++) {
+            x = buf[i];
+            EQ_BIQUAD_STEP(x, y, b0, b1, b2, a1, a2, s1, s2);
+            buf[i] = y;
+        }
+    }
+
+    bq->s1 = s1;
+    bq->s2 = s2;
+}
+
+static int _eq_local_init(eqx_t *eq, uint32_t rate, uint8_t eq_segments)
+{
+    int i;
+    struct eq_local_priv *priv = NULL;
+
+    priv = aos_zalloc(sizeof(struct eq_local_priv));
+    CHECK_RET_TAG_WITH_RET(priv, -1);
+    priv->biquads = aos_zalloc(sizeof(eq_biquad_t) * eq_segments);
+    priv->buf     = aos_malloc(sizeof(int32_t) * POST_PROC_SAMPLES_MAX);
+    CHECK_RET_TAG_WITH_GOTO(priv->biquads && priv->buf, err);
+
+    for (i = 0; i < eq_segments; i++) {
+        memcpy(priv->biquads[i].coef, _coef_unity, sizeof(_coef_unity));
+        memcpy(priv->biquads[i].on, _coef_unity, sizeof(_coef_unity));
+    }
+    priv->rate       = rate;
+    priv->nb_biquads = eq_segments;
+    eq->priv         = priv;
+
+    return 0;
+err:
+    aos_free(priv->biquads);
+    aos_free(priv->buf);
+    aos_free(priv);
+    return -1;
+}
+
+static int _eq_local_set_enable(eqx_t *eq, uint8_t enable)
+{
+    int i;
+    struct eq_local_priv *priv = eq->priv;
+
+    priv->enable = enable;
+    for (i = 0; i < priv->nb_biquads; i++) {
+        _eq_biquad_retarget(priv, &priv->biquads[i]);
+    }
+
+    return 0;
+}
+
+static int _eq_local_set_param(eqx_t *eq, uint8_t segid, const eqfp_t *param)
+{
+    int rc;
+    int32_t coef[EQ_COEF_NUM];
+    struct eq_local_priv *priv = eq->priv;
+    eq_biquad_t *bq            = &priv->biquads[segid];
+
+    rc = _eq_biquad_coef(priv->rate, param, coef);
+    CHECK_RET_TAG_WITH_RET(rc == 0, -1);
+
+    memcpy(bq->on, coef, sizeof(coef));
+    bq->enable = param->enable;
+    _eq_biquad_retarget(priv, bq);
+
+    return 0;
+}
+
+static int _eq_local_process(eqx_t *eq, const int16_t *in, int16_t *out, size_t nb_samples)
+{
+    int i, active = 0;
+    size_t j;
+    int32_t *buf               = NULL;
+    struct eq_local_priv *priv = eq->priv;
+
+    for (i = 0; i < priv->nb_biquads; i++) {
+        eq_biquad_t *bq = &priv->biquads[i];
+
+        if (_eq_biquad_is_unity(bq)) {
+            /* start from the rest when enabled again */
+            bq->s1 = 0;
+            bq->s2 = 0;
+            continue;
+        }
+        if (!active) {
+            buf = priv->buf;
+            for (j = 0; j < nb_samples; j++) {
+                buf[j] = (int32_t)in[j] * (1 << EQ_SIG_SHIFT);
+            }
+            active = 1;
+        }
+        _eq_biquad_run(bq, buf, nb_samples);
+    }
+
+    if (active) {
+        for (j = 0; j < nb_samples; j++) {
+            out[j] = _sat_s16((buf[j] + (1 << (EQ_SIG_SHIFT - 1))) >> EQ_SIG_SHIFT);
+        }
+    } else if (in != out) {
+        memcpy(out, in, nb_samples * sizeof(int16_t));
+    }
+
+    return 0;
+}
+
+static int _eq_local_uninit(eqx_t *eq)
+{
+    struct eq_local_priv *priv = eq->priv;
+
+    aos_free(priv->biquads);
+    aos_free(priv->buf);
+    aos_free(priv);
+    eq->priv = NULL;
+    return 0;
+}
+
+const struct eqx_ops eqx_ops_local = {
+    .name            = "eq_local",
+
+    .init            = _eq_local_init,
+    .set_enable      = _eq_local_set_enable,
+    .set_param       = _eq_local_set_param,
+    .process         = _eq_local_process,
+    .uninit          = _eq_local_uninit,
+};
+
+#endif
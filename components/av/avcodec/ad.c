@@ -139,6 +139,9 @@ err:
  * @param  [in]  pkt : data of encoded audio
  * @return -1 when err happens, otherwise the number of bytes consumed from the
  *         input avpacket is returned
+ * attention: a decoder may give the frame of a packet back one call later (the ipc one with
+ *            CONFIG_AD_ICORE_ASYNC), the caller calls ad_flush at the end of the stream, or
+ *            the last frame is lost
  */
 int ad_decode(ad_cls_t *o, avframe_t *frame, int *got_frame, const avpacket_t *pkt)
 {
@@ -172,6 +175,30 @@ quit:
     return ret;
 }
 
+/**
+ * @brief  get the frame still held by the decoder, called at the end of the stream until no frame got
+ * @param  [in] o
+ * @param  [out] frame : frame of pcm
+ * @param  [out] got_frame : whether decode one frame
+ * @return 0/-1
+ */
+int ad_flush(ad_cls_t *o, avframe_t *frame, int *got_frame)
+{
+    int ret = 0;
+
+    CHECK_PARAM(o && frame && got_frame, -1);
+    *got_frame = 0;
+    if (!o->ops->flush) {
+        return 0;
+    }
+
+    aos_mutex_lock(&o->lock, AOS_WAIT_FOREVER);
+    ret = o->ops->flush(o, frame, got_frame);
+    aos_mutex_unlock(&o->lock);
+
+    return ret;
+}
+
 /**
  * @brief  control a audio decoder
  * @param  [in] o
@@ -63,6 +63,19 @@ static int _ad_ipc_decode(ad_cls_t *o, avframe_t *frame, int *got_frame, const a
     return ret;
 }
 
+static int _ad_ipc_flush(ad_cls_t *o, avframe_t *frame, int *got_frame)
+{
+    int ret = -1;
+    struct ad_ipc_priv *priv = o->priv;
+
+    ret = ad_icore_flush(priv->hdl, frame, got_frame);
+    if (*got_frame) {
+        o->ash.sf = frame->sf;
+    }
+
+    return ret;
+}
+
 static int _ad_ipc_control(ad_cls_t *o, int cmd, void *arg, size_t *arg_size)
 {
     //TODO
@@ -96,6 +109,7 @@ const struct ad_ops ad_ops_ipc = {
 
     .open           = _ad_ipc_open,
     .decode         = _ad_ipc_decode,
+    .flush          = _ad_ipc_flush,
     .control        = _ad_ipc_control,
     .reset          = _ad_ipc_reset,
     .close          = _ad_ipc_close,
@@ -10,6 +10,14 @@
 
 #define TAG                                     "demux_flac"
 #define FLAC_SYNC_HDR_MAX                       (FLAC_FRAME_SIZE_DEFAULT * 4)
+#define FLAC_SEEK_POINT_SIZE                    (18)
+#define FLAC_SEEK_POINTS_MAX                    (512)    ///< a larger seektable is decimated
+#define FLAC_SEEK_PROBES_MAX                    (32)     ///< frame headers probed by one seek
+
+typedef struct flac_seek_point {
+    uint64_t                   sample;           ///< first sample of the target frame
+    uint64_t                   offset;           ///< offset of the frame from the first frame
+} fsp_t;
 
 typedef struct flac_sync_block {
     uint8_t                    *data;
@@ -29,9 +37,45 @@ struct flac_priv {
     int32_t                    flac_size;        ///< not contain the ID3 size, etc
     size_t                     bsize_fixed;      ///< block size
     uint64_t                   iduration;        ///< inner duration, base time_base
-    struct flac_hdr            hinfo;
+    struct flac_hdr            hinfo;            ///< header of the frame at sync1
+    fsp_t                      *seek_points;     ///< from the SEEKTABLE, may be null
+    size_t                     nb_seek_points;
 };
 
+/**
+ * @brief  read the SEEKTABLE block, placeholder points are dropped
+ * @return 0/-1
+ */
+static int _flac_read_seektable(stream_cls_t *s, struct flac_priv *priv, uint32_t block_size)
+{
+    int rc;
+    size_t i, n, step;
+    uint64_t sample;
+    uint8_t buf[FLAC_SEEK_POINT_SIZE];
+
+    n = block_size / FLAC_SEEK_POINT_SIZE;
+    if (n == 0 || priv->seek_points) {
+        return stream_skip(s, block_size);
+    }
+    step              = (n + FLAC_SEEK_POINTS_MAX - 1) / FLAC_SEEK_POINTS_MAX;
+    priv->seek_points = aos_malloc(sizeof(fsp_t) * ((n + step - 1) / step));
+    CHECK_RET_TAG_WITH_RET(priv->seek_points, -1);
+
+    for (i = 0; i < n; i++) {
+        rc = stream_read(s, buf, FLAC_SEEK_POINT_SIZE);
+        CHECK_RET_TAG_WITH_RET(rc == FLAC_SEEK_POINT_SIZE, -1);
+        sample = ((uint64_t)byte_r32be(buf) << 32) | byte_r32be(buf + 4);
+        if (i % step || sample == (uint64_t)-1) {
+            continue;
+        }
+        priv->seek_points[priv->nb_seek_points].sample = sample;
+        priv->seek_points[priv->nb_seek_points].offset = ((uint64_t)byte_r32be(buf + 8) << 32) | byte_r32be(buf + 12);
+        priv->nb_seek_points++;
+    }
+
+    return stream_skip(s, block_size - n * FLAC_SEEK_POINT_SIZE);
+}
+
 static int _demux_flac_probe(const avprobe_data_t *pd)
 {
     if (strncmp((const char*)pd->buf, "fLaC", 4))
@@ -85,6 +129,10 @@ static int _demux_flac_open(demux_cls_t *o)
             si_find        = 1;
             break;
         }
+        case FLAC_METADATA_TYPE_SEEKTABLE:
+            rc = _flac_read_seektable(o->s, priv, block_size);
+            CHECK_RET_TAG_WITH_GOTO(rc == 0, err);
+            break;
         default:
             stream_skip(o->s, block_size);
             break;
@@ -121,8 +169,9 @@ static int _demux_flac_open(demux_cls_t *o)
     return 0;
 err:
     if (priv) {
-        aos_free(priv);
+        aos_free(priv->seek_points);
         aos_free(priv->fsb.data);
+        aos_free(priv);
     }
     aos_free(extradata);
     return -1;
@@ -132,6 +181,7 @@ static int _demux_flac_close(demux_cls_t *o)
 {
     struct flac_priv *priv = o->priv;
 
+    aos_free(priv->seek_points);
     aos_free(priv->fsb.data);
     aos_free(priv);
     o->priv = NULL;
@@ -211,6 +261,7 @@ resync:
         if (fsb->offset_sync1 < 0) {
             fsb->offset_sync1 = fsb->offset_r - FLAC_HDR_SIZE_MAX;
             fsb->offset_r     = fsb->offset_sync1 + FLAC_HDR_SIZE_MIN;
+            priv->hinfo       = *hinfo;
             memset(hdr, 0, FLAC_HDR_SIZE_MAX);
             /* get sync2 */
             goto resync;
@@ -221,10 +272,13 @@ resync:
         }
     }
 
-    if (hinfo->is_var)
-        sample_numbers = hinfo->nb_frame_or_sample;
+    /* the packet is the frame at sync1, the header at sync2 is the one of the next packet */
+    if (priv->hinfo.is_var)
+        sample_numbers = priv->hinfo.nb_frame_or_sample;
     else
-        sample_numbers = priv->bsize_fixed ? hinfo->nb_frame_or_sample * priv->bsize_fixed : 0;
+        sample_numbers = priv->bsize_fixed ? priv->hinfo.nb_frame_or_sample * priv->bsize_fixed : -1;
+    if (rc >= 0)
+        priv->hinfo = *hinfo;
 
     if (pkt->size < fsize) {
         rc = avpacket_grow(pkt, fsize);
@@ -243,8 +297,8 @@ resync:
     fsb->offset_r     = FLAC_HDR_SIZE_MIN;
     fsb->offset_sync1 = 0;
     fsb->offset_sync2 = -1;
-    if (sample_numbers > 0 && priv->flac_size > 0 && si->nb_samples > 0) {
-        pkt->pts = 1.0 * sample_numbers / si->nb_samples * priv->iduration;
+    if (sample_numbers >= 0 && si->rate > 0) {
+        pkt->pts = (uint64_t)sample_numbers * o->time_scale / si->rate;
     }
 
     return fsize;
@@ -252,6 +306,113 @@ err:
     return rc;
 }
 
+/**
+ * @brief  find the first frame at or after the offset
+ * @param  [in] pos       : offset from the first frame
+ * @param  [out] ppos     : offset of the frame
+ * @param  [out] psample  : first sample of the frame
+ * @param  [out] pbsize   : samples of the frame
+ * @return 0/-1
+ */
+static int _flac_probe_frame(demux_cls_t *o, uint64_t pos, uint64_t *ppos, uint64_t *psample, size_t *pbsize)
+{
+    int rc;
+    sf_t sf = o->ash.sf;
+    uint8_t hdr[FLAC_HDR_SIZE_MAX] = { 0 };
+    struct flac_priv *priv         = o->priv;
+    fsb_t *fsb                     = &priv->fsb;
+    struct flac_hdr info, *hinfo   = &info;
+
+    rc = stream_seek(o->s, priv->start_pos + pos, SEEK_SET);
+    if (rc < 0) {
+        return -1;
+    }
+    rc = stream_read(o->s, fsb->data, fsb->cap);
+    if (rc <= FLAC_HDR_SIZE_MIN) {
+        return -1;
+    }
+    fsb->size     = rc;
+    fsb->offset_r = 0;
+
+    for (;;) {
+        rc = flac_sync(_sync_read_stream, fsb, fsb->size, hdr, hinfo);
+        if (rc < 0) {
+            return -1;
+        }
+        if (hinfo->channels == sf_get_channel(sf) &&
+            (hinfo->block_size > 0 && hinfo->block_size <= priv->si.bsize_max) &&
+            (hinfo->bits == sf_get_bit(sf)) &&
+            (hinfo->rate == sf_get_rate(sf))) {
+            break;
+        }
+        hdr[0] = 0; /* reset hdr for resync */
+    }
+
+    *ppos    = pos + fsb->offset_r - FLAC_HDR_SIZE_MAX;
+    /* the blocks of a fixed-blocksize stream are of the max size but the last one */
+    *psample = hinfo->is_var ? hinfo->nb_frame_or_sample : hinfo->nb_frame_or_sample * priv->si.bsize_max;
+    *pbsize  = hinfo->block_size;
+
+    return 0;
+}
+
+/**
+ * @brief  offset of a frame not after the sample, the frame of the sample mostly.
+ *         the seek points around the sample bound the search, the whole file without them.
+ *         the interpolated offset is probed first, then the interval is bisected by the frame headers
+ * @return offset from the first frame
+ */
+static uint64_t _flac_seek_offset(demux_cls_t *o, uint64_t sample)
+{
+    size_t bsize;
+    int probes = 0;
+    fsp_t p0 = { 0, 0 }, p1;
+    struct flac_priv *priv = o->priv;
+    size_t lo = 0, hi = priv->nb_seek_points, mid;
+    uint64_t pos, at, first, start, end;
+
+    /* the last point not after the sample */
+    while (lo < hi) {
+        mid = (lo + hi) / 2;
+        if (priv->seek_points[mid].sample <= sample) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo) {
+        p0 = priv->seek_points[lo - 1];
+    }
+    if (lo < priv->nb_seek_points) {
+        p1 = priv->seek_points[lo];
+    } else {
+        p1.sample = priv->si.nb_samples;
+        p1.offset = priv->flac_size;
+    }
+    if (!(p1.sample > p0.sample && p1.offset > p0.offset)) {
+        return p0.offset;
+    }
+
+    /* a seek point is a frame start, start stays on a frame not after the sample */
+    start = p0.offset;
+    end   = p1.offset;
+    pos   = p0.offset + 1.0 * (sample - p0.sample) / (p1.sample - p0.sample) * (p1.offset - p0.offset);
+    while (pos > start && pos < end && probes++ < FLAC_SEEK_PROBES_MAX) {
+        if (_flac_probe_frame(o, pos, &at, &first, &bsize) == 0 && at < end &&
+            first >= p0.sample && first <= sample) {
+            start = at;
+            if (sample < first + bsize) {
+                break;
+            }
+        } else {
+            end = pos;
+        }
+        pos = start + (end - start) / 2;
+    }
+
+    return start;
+}
+
 static int _demux_flac_seek(demux_cls_t *o, uint64_t timestamp)
 {
     int rc = -1;
@@ -265,11 +426,16 @@ static int _demux_flac_seek(demux_cls_t *o, uint64_t timestamp)
         return -1;
     }
 
+    if (priv->si.nb_samples) {
+        /* not by the duration, it is in ms only */
+        new_pos = priv->start_pos + _flac_seek_offset(o, timestamp * priv->si.rate / o->time_scale);
+    } else {
+        new_pos = priv->start_pos + (1.0 * timestamp / priv->iduration) * priv->flac_size;
+    }
     fsb->size         = 0;
     fsb->offset_r     = 0;
     fsb->offset_sync1 = -1;
     fsb->offset_sync2 = -1;
-    new_pos = priv->start_pos + (1.0 * timestamp / priv->iduration) * priv->flac_size;
     rc = stream_seek(o->s, new_pos, SEEK_SET);
 
     return rc;
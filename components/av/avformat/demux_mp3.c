@@ -10,6 +10,7 @@
 
 #define TAG                    "demux_mp3"
 #define MP3_SYNC_HDR_MAX       (2*1024)
+#define MP3_DECODER_DELAY      (528 + 1)
 
 static const uint8_t mp3_side_tbl[2][2] = {
     {32, 17},
@@ -62,6 +63,7 @@ static int _demux_mp3_open(demux_cls_t *o)
     bio_t bio;
     int fsize;
     uint32_t val, rate;
+    int info_frame = 0;
     struct mp3_priv *priv;
     struct mp3_hdr_info *hinfo;
 
@@ -81,11 +83,31 @@ static int _demux_mp3_open(demux_cls_t *o)
     val = bio_r32le(&bio);
     priv->is_cbr = val == TAG_VAL('I', 'n', 'f', 'o');
     if (priv->is_cbr || val == TAG_VAL('X', 'i', 'n', 'g')) {
+        uint32_t delay, padding;
+
         val = bio_r32be(&bio);
         if (val & 0x1)
             priv->nb_frames = bio_r32be(&bio);
         if (val & 0x2)
             priv->mp3_size = bio_r32be(&bio);
+        if (val & 0x4)
+            bio_skip(&bio, 100); /* toc */
+        if (val & 0x8)
+            bio_skip(&bio, 4);   /* quality */
+
+        /* lame tag: encoder delay and padding, 12 bits each */
+        val = bio_r32le(&bio);
+        if (val == TAG_VAL('L', 'A', 'M', 'E') || val == TAG_VAL('L', 'a', 'v', 'f') || val == TAG_VAL('L', 'a', 'v', 'c')) {
+            bio_skip(&bio, 5 + 12);
+            val     = bio_r24be(&bio);
+            delay   = val >> 12;
+            padding = val & 0xfff;
+            o->skip_samples = delay + MP3_DECODER_DELAY;
+            if (priv->nb_frames * hinfo->spf > delay + padding)
+                o->nb_samples = priv->nb_frames * hinfo->spf - delay - padding;
+            LOGD(TAG, "lame tag, delay = %u, padding = %u", delay, padding);
+        }
+        info_frame = 1;
     }
 
     fsize         = stream_get_size(o->s);
@@ -99,6 +121,10 @@ static int _demux_mp3_open(demux_cls_t *o)
         priv->start_pos = stream_tell(o->s) - o->fpkt.len;
         priv->mp3_size  = priv->mp3_size > 0 ? priv->mp3_size : fsize - priv->start_pos;
     }
+    if (info_frame) {
+        /* the xing/info frame is silence, not a part of the stream */
+        o->fpkt.len = 0;
+    }
 
     return 0;
 err:
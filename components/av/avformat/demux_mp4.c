@@ -1035,6 +1035,63 @@ static int _mp4_read_schm(demux_cls_t *o, mp4_atom_t *atom)
     return 0;
 }
 
+static int _mp4_read_meta(demux_cls_t *o, mp4_atom_t *atom)
+{
+    mp4_atom_t meta;
+    stream_cls_t *s = o->s;
+
+    /* full box in the mp4, quicktime meta isn't supported now */
+    if (atom->size <= 4 || stream_r32be(s) != 0) {
+        return 0;
+    }
+
+    meta.type = atom->type;
+    meta.size = atom->size - 4;
+
+    return _mp4_read_atom(o, &meta);
+}
+
+/* freeform tag of the itunes, only the iTunSMPB(gapless info) is used now */
+static int _mp4_read_itunes_tag(demux_cls_t *o, mp4_atom_t *atom)
+{
+    char buf[128];
+    int gapless = 0;
+    int32_t count = 0;
+    uint32_t size, type, delay, padding;
+    unsigned long long samples;
+    stream_cls_t *s = o->s;
+
+    while (count + 8 <= atom->size) {
+        size = stream_r32be(s);
+        type = stream_r32le(s);
+        if (size < 16 || count + size > atom->size) {
+            break;
+        }
+
+        if (type == ATOMID('n', 'a', 'm', 'e') && size - 12 < sizeof(buf)) {
+            stream_skip(s, 4); /* version & flags */
+            stream_read(s, (uint8_t*)buf, size - 12);
+            buf[size - 12] = '\0';
+            gapless = !strcmp(buf, "iTunSMPB");
+        } else if (type == ATOMID('d', 'a', 't', 'a') && gapless && size - 16 < sizeof(buf)) {
+            stream_skip(s, 8); /* type & locale */
+            stream_read(s, (uint8_t*)buf, size - 16);
+            buf[size - 16] = '\0';
+            /* " 00000000 00000840 000001CA 00000000003F31F6 ..." */
+            if (sscanf(buf, "%*x %x %x %llx", &delay, &padding, &samples) == 3) {
+                o->skip_samples = delay;
+                o->nb_samples   = samples;
+                LOGD(TAG, "iTunSMPB, delay = %u, padding = %u, samples = %llu", delay, padding, samples);
+            }
+        } else {
+            stream_skip(s, size - 8);
+        }
+        count += size;
+    }
+
+    return 0;
+}
+
 static const mp4_parser_t g_mp4_parser_table[] = {
     {ATOMID('e', 's', 'd', 's'), _mp4_read_esds}, //1
     {ATOMID('d', 'i', 'n', 'f'), _mp4_read_atom}, //1
@@ -1061,6 +1118,10 @@ static const mp4_parser_t g_mp4_parser_table[] = {
     {ATOMID('s', 't', 't', 's'), _mp4_read_stts}, //1
     {ATOMID('t', 'k', 'h', 'd'), _mp4_read_tkhd}, //1
     {ATOMID('t', 'r', 'a', 'k'), _mp4_read_trak}, //1
+    {ATOMID('u', 'd', 't', 'a'), _mp4_read_atom}, //1
+    {ATOMID('m', 'e', 't', 'a'), _mp4_read_meta}, //1
+    {ATOMID('i', 'l', 's', 't'), _mp4_read_atom}, //1
+    {ATOMID('-', '-', '-', '-'), _mp4_read_itunes_tag}, //1
 };
 
 static atom_parser_t  _find_atom_parser(uint32_t atomid)
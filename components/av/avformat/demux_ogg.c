@@ -10,6 +10,9 @@
 
 #define TAG                    "demux_ogg"
 #define OGG_SYNC_HDR_MAX       (2*1024)
+#define OGG_SEEK_CHUNK         (8*1024)                   ///< bytes read by one bisect probe
+#define OGG_DURATION_TAIL      (64*1024)                  ///< tail of the file for the last granule
+#define OPUS_SEEK_PREROLL_MS   (80)                       ///< opus decoder converges after 80ms
 
 struct ogg_priv {
     uint8_t                    channels;
@@ -19,6 +22,12 @@ struct ogg_priv {
     uint32_t                   serial_nb;                 ///< stream serial number for play
     int                        rate;
     int                        header;
+    uint16_t                   pre_skip;                  ///< samples of opus to discard at the start
+    uint8_t                    skip_cont;                 ///< skip the continued packet on the first page after seek
+    int64_t                    page_pos;                  ///< offset of the last page read
+    uint64_t                   page_granule;              ///< granule of the last page read, -1: no packet ends on it
+    uint64_t                   granule;                   ///< granule at the start of the next packet
+    int64_t                    data_start;                ///< offset of the first audio page
 
     uint8_t                    *data;                     ///< segment data of page
     size_t                     len;                       ///< length of avilable data
@@ -28,6 +37,72 @@ struct ogg_priv {
 
 static int _demux_ogg_read_packet(demux_cls_t *o, avpacket_t *pkt);
 
+/**
+ * @brief  samples of the opus packet at 48k, from the toc
+ */
+static uint32_t _opus_pkt_samples(const uint8_t *data, size_t len)
+{
+    static const uint16_t silk[] = { 480, 960, 1920, 2880 };
+    static const uint16_t celt[] = { 120, 240, 480, 960 };
+    uint8_t cfg;
+    uint32_t fsize, count;
+
+    if (len == 0) {
+        return 0;
+    }
+    cfg   = data[0] >> 3;
+    fsize = cfg < 12 ? silk[cfg & 3] : (cfg < 16 ? ((cfg & 1) ? 960 : 480) : celt[cfg & 3]);
+    switch (data[0] & 3) {
+    case 0:
+        count = 1;
+        break;
+    case 1:
+    case 2:
+        count = 2;
+        break;
+    default:
+        count = len > 1 ? data[1] & 0x3f : 0;
+        break;
+    }
+
+    return fsize * count;
+}
+
+/**
+ * @brief  granule at the start of the first audio page of opus: its granule less its packets,
+ *         not 0 when the stream is cut from another one
+ */
+static uint64_t _opus_page_start(const struct ogg_priv *priv)
+{
+    int i;
+    size_t pos = 0, start = 0;
+    uint64_t samples = 0;
+
+    for (i = 0; i < priv->nb_segs; i++) {
+        pos += priv->seg_table[i];
+        if (priv->seg_table[i] < 255) {
+            samples += _opus_pkt_samples(priv->data + start, pos - start);
+            start    = pos;
+        }
+    }
+
+    return priv->page_granule != (uint64_t)-1 && priv->page_granule > samples ? priv->page_granule - samples : 0;
+}
+
+/* whether one more packet ends on the page */
+static int _ogg_page_has_pkt(const struct ogg_priv *priv)
+{
+    int i;
+
+    for (i = priv->seg_idx; i < priv->nb_segs; i++) {
+        if (priv->seg_table[i] < 255) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
 static int _demux_ogg_probe(const avprobe_data_t *pd)
 {
     return strncmp((const char*)pd->buf, "OggS", 4) == 0 ? AVPROBE_SCORE_MAX : 0;
@@ -74,8 +149,29 @@ resync:
 
     rc = stream_read(o->s, priv->data, len);
     CHECK_RET_TAG_WITH_GOTO(rc == len, err);
-    priv->len     = len;
-    priv->nb_segs = phdr->nb_segs;
+    priv->len      = len;
+    priv->nb_segs  = phdr->nb_segs;
+    priv->page_pos = stream_tell(o->s) - len - phdr->nb_segs - OGG_HDR_LEN;
+
+    if (priv->skip_cont && phdr->serial_nb == priv->serial_nb) {
+        /* the tail of a packet from the page before the seek point */
+        if (phdr->type & 0x1) {
+            while (priv->seg_idx < priv->nb_segs) {
+                len        = priv->seg_table[priv->seg_idx++];
+                priv->pos += len;
+                if (len < 255) {
+                    break;
+                }
+            }
+            if (priv->seg_idx == priv->nb_segs) {
+                priv->pos     = 0;
+                priv->seg_idx = 0;
+                memset(buf, 0, sizeof(buf));
+                goto resync;
+            }
+        }
+        priv->skip_cont = 0;
+    }
 
     return 0;
 err:
@@ -114,12 +210,16 @@ retry:
         //FIXME: only read audio pkt
         if (page_read && priv->serial_nb != phdr->serial_nb)
             goto retry;
+        if (page_read) {
+            priv->page_granule = phdr->granule;
+        }
 
         if (priv->header) {
             if (o->ash.id == AVCODEC_ID_OPUS) {
                 if (IS_FIRST_PAGE(phdr->type)) {
                     priv->rate     = 48000;
                     priv->channels = priv->data[9];
+                    priv->pre_skip = byte_r16le(priv->data + 10);
                 } else {
                     if (priv->len < 8 || memcmp(priv->data, "OpusTags", 8))
                         goto err;
@@ -157,19 +257,101 @@ err:
     return ret;
 }
 
+/**
+ * @brief  find the first page of the playing stream which ends a packet in [pos, end)
+ * @param  [in] buf        : OGG_SEEK_CHUNK
+ * @param  [out] ppos      : offset of the page
+ * @param  [out] psize     : size of the page, header included
+ * @param  [out] pgranule
+ * @return 0/-1
+ */
+static int _ogg_find_page(demux_cls_t *o, uint8_t *buf, int64_t pos, int64_t end,
+                          int64_t *ppos, size_t *psize, uint64_t *pgranule)
+{
+    int rc;
+    size_t i, j, len, size;
+    struct page_hdr hdr;
+    struct ogg_priv *priv = o->priv;
+
+    while (pos + OGG_HDR_LEN <= end) {
+        len = MIN(OGG_SEEK_CHUNK, end - pos);
+        rc  = stream_seek(o->s, pos, SEEK_SET);
+        if (rc < 0) {
+            break;
+        }
+        rc = stream_read(o->s, buf, len);
+        if (rc < OGG_HDR_LEN) {
+            break;
+        }
+        len = rc;
+        for (i = 0; i + OGG_HDR_LEN <= len; i++) {
+            if (!(buf[i] == 'O' && page_hdr_get(buf + i, &hdr) == 0 && hdr.version == 0)) {
+                continue;
+            }
+            if (i + OGG_HDR_LEN + hdr.nb_segs > len) {
+                /* the segment table is cut, read again from the page */
+                break;
+            }
+            /* granule -1: no packet ends on the page */
+            if (hdr.serial_nb != priv->serial_nb || hdr.granule == (uint64_t)-1) {
+                continue;
+            }
+            for (size = OGG_HDR_LEN + hdr.nb_segs, j = 0; j < hdr.nb_segs; j++) {
+                size += buf[i + OGG_HDR_LEN + j];
+            }
+            *ppos     = pos + i;
+            *psize    = size;
+            *pgranule = hdr.granule;
+            return 0;
+        }
+        if (i == 0) {
+            break;
+        }
+        pos += i;
+    }
+
+    return -1;
+}
+
 static int _demux_ogg_open(demux_cls_t *o)
 {
     int rc;
+    int64_t fsize;
     struct ogg_priv *priv;
 
     priv = aos_zalloc(sizeof(struct ogg_priv));
-    priv->header = -1;
-    o->priv      = priv;
+    CHECK_RET_TAG_WITH_RET(priv, -1);
+    priv->header     = -1;
+    priv->data_start = -1;
+    priv->granule    = -1;
+    o->priv          = priv;
 
     rc = _demux_ogg_read_packet(o, &o->fpkt);
     CHECK_RET_TAG_WITH_GOTO(rc > 0, err);
     o->ash.sf = sf_make_channel(priv->channels) | sf_make_rate(priv->rate) | sf_make_bit(16) | sf_make_signed(1);
 
+    /* the granule is in samples of the rate */
+    priv->data_start = priv->page_pos;
+    o->time_scale    = priv->rate;
+    fsize            = stream_get_size(o->s);
+    if (stream_is_seekable(o->s) && fsize > 0 && priv->rate > 0) {
+        size_t psize;
+        uint64_t granule, last = 0;
+        int64_t pos, ppos, cur = stream_tell(o->s);
+        uint8_t *buf = aos_malloc(OGG_SEEK_CHUNK);
+
+        if (buf) {
+            pos = MAX(priv->data_start, fsize - OGG_DURATION_TAIL);
+            while (_ogg_find_page(o, buf, pos, fsize, &ppos, &psize, &granule) == 0) {
+                last = granule;
+                pos  = ppos + psize;
+            }
+            o->duration = last > priv->pre_skip ? (last - priv->pre_skip) * 1000 / priv->rate : 0;
+            aos_free(buf);
+        }
+        stream_seek(o->s, cur, SEEK_SET);
+    }
+
     return 0;
 err:
     if (priv) {
@@ -208,6 +390,19 @@ static int _demux_ogg_read_packet(demux_cls_t *o, avpacket_t *pkt)
         memcpy(pkt->data, priv->data + start, len);
         ret      = len;
         pkt->len = len;
+        if (priv->granule == (uint64_t)-1) {
+            /* the first audio packet */
+            priv->granule = o->ash.id == AVCODEC_ID_OPUS ? _opus_page_start(priv) : 0;
+        }
+        pkt->pts = priv->granule > priv->pre_skip ? priv->granule - priv->pre_skip : 0;
+
+        /* opus packets tell their samples, the others get the start of the page */
+        if (o->ash.id == AVCODEC_ID_OPUS) {
+            priv->granule += _opus_pkt_samples(pkt->data, len);
+        }
+        if (!_ogg_page_has_pkt(priv) && priv->page_granule != (uint64_t)-1) {
+            priv->granule = priv->page_granule;
+        }
     }
 
 err:
@@ -216,13 +411,86 @@ err:
 
 static int _demux_ogg_seek(demux_cls_t *o, uint64_t timestamp)
 {
-    //TODO
-    return -1;
+    int rc;
+    uint8_t *buf;
+    size_t psize;
+    uint64_t target, granule, preroll;
+    int64_t lo, hi, mid, pos, ppos, fsize;
+    struct ogg_priv *priv = o->priv;
+
+    fsize = stream_get_size(o->s);
+    if (!(fsize > 0 && priv->data_start >= 0)) {
+        LOGE(TAG, "seek failed. ts = %llu, file_size = %lld", timestamp, fsize);
+        return -1;
+    }
+    buf = aos_malloc(OGG_SEEK_CHUNK);
+    CHECK_RET_TAG_WITH_RET(buf, -1);
+
+    /* granule of the target, the decoder gets the pre-roll before it */
+    preroll = o->ash.id == AVCODEC_ID_OPUS ? OPUS_SEEK_PREROLL_MS * priv->rate / 1000 : 0;
+    target  = timestamp + priv->pre_skip;
+    target  = target > preroll ? target - preroll : 0;
+
+    /* bisect on the byte position by the granule of the first page after it */
+    lo = priv->data_start;
+    hi = fsize;
+    while (hi - lo > OGG_SEEK_CHUNK) {
+        mid = lo + (hi - lo) / 2;
+        rc  = _ogg_find_page(o, buf, mid, hi, &ppos, &psize, &granule);
+        if (rc == 0 && granule <= target) {
+            lo = ppos;
+        } else {
+            hi = mid;
+        }
+    }
+    /* the packets after the last page not after the target start from the target */
+    pos           = priv->data_start;
+    priv->granule = 0;
+    while (_ogg_find_page(o, buf, lo, fsize, &ppos, &psize, &granule) == 0 && granule <= target) {
+        pos           = ppos + psize;
+        lo            = pos;
+        priv->granule = granule;
+    }
+    aos_free(buf);
+
+    rc = stream_seek(o->s, pos, SEEK_SET);
+    CHECK_RET_TAG_WITH_RET(rc == 0, -1);
+    priv->pos       = 0;
+    priv->len       = 0;
+    priv->nb_segs   = 0;
+    priv->seg_idx   = 0;
+    priv->skip_cont = pos != priv->data_start;
+
+    return 0;
 }
 
 static int _demux_ogg_control(demux_cls_t *o, int cmd, void *arg, size_t *arg_size)
 {
-    //TODO
+    int64_t fsize;
+    struct ogg_priv *priv = o->priv;
+
+    CHECK_PARAM(arg && arg_size, -1);
+    switch (cmd) {
+    case DEMUX_CMD_GET_DURATION:
+        CHECK_PARAM(*arg_size >= sizeof(uint64_t), -1);
+        /* ms */
+        *(uint64_t*)arg = o->duration;
+        *arg_size       = sizeof(uint64_t);
+        return 0;
+    case DEMUX_CMD_GET_BITRATE:
+        CHECK_PARAM(*arg_size >= sizeof(uint32_t), -1);
+        /* bps, average of the audio pages */
+        fsize = stream_get_size(o->s);
+        if (!(o->duration && fsize > priv->data_start && priv->data_start >= 0)) {
+            return -1;
+        }
+        *(uint32_t*)arg = (fsize - priv->data_start) * 8 * 1000 / o->duration;
+        *arg_size       = sizeof(uint32_t);
+        return 0;
+    default:
+        break;
+    }
+
     return -1;
 }
 
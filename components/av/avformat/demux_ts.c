@@ -16,6 +16,11 @@
 
 #define TS_SYNC_CNT           (3)
 #define TS_SYNC_HDR_MAX       (2*1024)
+#define TS_READ_SIZE          (TS_PACKET_SIZE * 8)      ///< packets read from the stream at once
+#define TS_TIME_SCALE         (90000)                   ///< pes pts clock
+#define TS_PTS_MASK           ((1ULL << 33) - 1)
+#define TS_SEEK_WINDOW        (16*1024)                 ///< bisect down to this, then scan forward
+#define TS_DURATION_TAIL      (64*1024)                 ///< tail of the file for the last pts
 
 static int _demux_ts_read_packet(demux_cls_t *o, avpacket_t *pkt);
 
@@ -60,9 +65,30 @@ struct ts_priv {
     uint16_t                  audio_pid;                ///< pid for audio player
 
     slist_t                   tsf_list;
+    tsf_t                     *last_tsf;                ///< hit of the last lookup, the audio pes mostly
+    uint8_t                   pid_map[NB_PID_MAX / 8];  ///< bit set if the pid has a filter
     avpacket_t                *pkt;                     ///< point to the caller
+
+    uint8_t                   *rbuf;                    ///< TS_READ_SIZE, packets read ahead
+    size_t                    rpos;
+    size_t                    rlen;
+    int64_t                   rbuf_pos;                 ///< stream offset of the rbuf[0]
+    int64_t                   data_start;               ///< offset of the first sync packet, -1 if unknown
+    int64_t                   first_pts;                ///< -1 if unknown, the pts of packet are relative to it
 };
 
+static int64_t _pes_pts(const uint8_t *pes)
+{
+    int64_t pts;
+
+    if (!(pes[7] & 0x80)) {
+        return -1;
+    }
+    pts = ((int64_t)((pes[9] >> 1) & 0x07) << 30) | ((byte_r16be(pes + 10) >> 1) << 15) | (byte_r16be(pes + 12) >> 1);
+
+    return pts;
+}
+
 static int _push_data_to_pes(tsf_t *f, const uint8_t *buf, int size, int is_start)
 {
     int rc;
@@ -102,6 +128,13 @@ static int _push_data_to_pes(tsf_t *f, const uint8_t *buf, int size, int is_star
             }
             memcpy(pkt->data, data + pl_start, pl_size);
             pkt->len = pl_size;
+            pkt->pts = _pes_pts(data);
+            if (pkt->pts >= 0) {
+                if (priv->first_pts < 0) {
+                    priv->first_pts = pkt->pts;
+                }
+                pkt->pts = (pkt->pts - priv->first_pts) & TS_PTS_MASK;
+            }
             mb->used = 0;
         }
     }
@@ -141,10 +174,17 @@ static int _push_data_to_section(tsf_t *f, const uint8_t *buf, size_t size, int
 
 static tsf_t* _get_tsf(struct ts_priv *priv, uint16_t pid)
 {
-    tsf_t *f;
+    tsf_t *f = priv->last_tsf;
 
+    if (f && f->pid == pid) {
+        return f;
+    }
+    if (!(priv->pid_map[pid >> 3] & (1 << (pid & 7)))) {
+        return NULL;
+    }
     slist_for_each_entry(&priv->tsf_list, f, tsf_t, node) {
         if (f->pid == pid) {
+            priv->last_tsf = f;
             return f;
         }
     }
@@ -156,7 +196,7 @@ static tsf_t* _tsf_new(struct ts_priv *priv, uint16_t pid, enum tsf_type type, s
 {
     tsf_t *f;
 
-    f = _get_tsf(priv, pid);
+    f = pid < NB_PID_MAX ? _get_tsf(priv, pid) : NULL;
     if (pid >= NB_PID_MAX || f || (fsize == 0)) {
         LOGE(TAG, "param err, pid = %u, f = %p, fsize = %u", pid, f, fsize);
         return NULL;
@@ -169,6 +209,7 @@ static tsf_t* _tsf_new(struct ts_priv *priv, uint16_t pid, enum tsf_type type, s
     f->pid     = pid;
     f->last_cc = -1;
     slist_add_tail(&f->node, &priv->tsf_list);
+    priv->pid_map[pid >> 3] |= 1 << (pid & 7);
 
     return f;
 }
@@ -185,10 +226,28 @@ static void _tsf_free(struct ts_priv *priv, tsf_t *f)
         aos_free(sec->buf);
     }
 
+    if (priv->last_tsf == f) {
+        priv->last_tsf = NULL;
+    }
+    priv->pid_map[f->pid >> 3] &= ~(1 << (f->pid & 7));
     slist_del(&f->node, &priv->tsf_list);
     aos_free(f);
 }
 
+static void _reset_all_tsf(struct ts_priv *priv)
+{
+    tsf_t *f;
+
+    slist_for_each_entry(&priv->tsf_list, f, tsf_t, node) {
+        f->last_cc = -1;
+        if (f->type == TSF_TYPE_PES) {
+            ((struct tsf_pes*)f)->mb->used = 0;
+        } else if (f->type == TSF_TYPE_SECTION) {
+            ((struct tsf_section*)f)->size = 0;
+        }
+    }
+}
+
 static void _free_all_tsf(struct ts_priv *priv)
 {
     tsf_t *f;
@@ -316,21 +375,59 @@ static int _demux_ts_probe(const avprobe_data_t *pd)
     return sync_cnt == TS_SYNC_CNT ? max : 0;
 }
 
-static int _read_sync_packet(stream_cls_t *s, uint8_t packet[TS_PACKET_SIZE])
+static void _reader_reset(struct ts_priv *priv, int64_t pos)
+{
+    priv->rpos     = 0;
+    priv->rlen     = 0;
+    priv->rbuf_pos = pos;
+}
+
+/**
+ * @brief  get the next sync packet from the read ahead buffer, refilled TS_READ_SIZE at once
+ * @param  [in] o
+ * @param  [out] packet : point to the packet in the buffer, valid until the next call
+ * @return 0/-1
+ */
+static int _read_sync_packet(demux_cls_t *o, const uint8_t **packet)
 {
-    int rc, i = 0;
-
-    while ((!stream_is_eof(s)) && (i++ < TS_SYNC_HDR_MAX)) {
-        packet[0] = stream_r8(s);
-        if (packet[0] == 0x47) {
-            rc = stream_read(s, &packet[1], TS_PACKET_SIZE - 1);
-            if (rc == TS_PACKET_SIZE - 1) {
-                return 0;
+    int rc, skip = 0;
+    size_t remain;
+    struct ts_priv *priv = o->priv;
+    uint8_t *rbuf        = priv->rbuf;
+
+    for (;;) {
+        if (priv->rlen - priv->rpos < TS_PACKET_SIZE) {
+            remain = priv->rlen - priv->rpos;
+            memmove(rbuf, rbuf + priv->rpos, remain);
+            priv->rbuf_pos += priv->rpos;
+            priv->rpos      = 0;
+            priv->rlen      = remain;
+            if (stream_is_eof(o->s)) {
+                return -1;
             }
+            rc = stream_read(o->s, rbuf + remain, TS_READ_SIZE - remain);
+            if (rc <= 0) {
+                return -1;
+            }
+            priv->rlen += rc;
+            continue;
         }
-    }
 
-    return -1;
+        /* the next sync byte is checked too when buffered, a 0x47 in the payload is not a packet */
+        if (rbuf[priv->rpos] == 0x47 &&
+            (priv->rpos + TS_PACKET_SIZE >= priv->rlen || rbuf[priv->rpos + TS_PACKET_SIZE] == 0x47)) {
+            if (priv->data_start < 0) {
+                priv->data_start = priv->rbuf_pos + priv->rpos;
+            }
+            *packet     = rbuf + priv->rpos;
+            priv->rpos += TS_PACKET_SIZE;
+            return 0;
+        }
+        priv->rpos++;
+        if (++skip > TS_SYNC_HDR_MAX) {
+            return -1;
+        }
+    }
 }
 
 static int _parse_one_packet(demux_cls_t *o, const uint8_t buf[TS_PACKET_SIZE])
@@ -390,12 +487,12 @@ static int _parse_packets(demux_cls_t *o, int nb_packets)
 {
     int rc;
     int cnt = 0;
-    uint8_t packet[TS_PACKET_SIZE];
+    const uint8_t *packet;
     struct ts_priv *priv = o->priv;
 
     priv->stop_parse = 0;
     for (;;) {
-        rc = _read_sync_packet(o->s, packet);
+        rc = _read_sync_packet(o, &packet);
         if (rc < 0)
             break;
 
@@ -414,18 +511,104 @@ static int _parse_packets(demux_cls_t *o, int nb_packets)
     return rc;
 }
 
+/**
+ * @brief  get the relative pts if the packet starts an audio pes with pts
+ * @return -1 if not
+ */
+static int64_t _packet_pts(struct ts_priv *priv, const uint8_t *p)
+{
+    const uint8_t *pl;
+    int pid, afc;
+    int64_t pts;
+
+    pid = ((p[1] & 0x1F) << 8) | p[2];
+    afc = (p[3] >> 4) & 0x03;
+    if (!(pid == priv->audio_pid && (p[1] & 0x40) && (afc & 1))) {
+        return -1;
+    }
+    pl = (afc & 2) ? p + 4 + p[4] + 1 : p + 4;
+    if (!(pl + 14 <= p + TS_PACKET_SIZE && byte_r24le(pl) == 0x10000)) {
+        return -1;
+    }
+    pts = _pes_pts(pl);
+
+    return pts < 0 ? -1 : (int64_t)((pts - priv->first_pts) & TS_PTS_MASK);
+}
+
+/**
+ * @brief  scan the packets in [pos, end) for the audio pes starts, resync on 0x47
+ * @param  [in] buf    : TS_READ_SIZE
+ * @param  [in] target : -1 for the first pes start,
+ *                       otherwise the last one whose pts not after the target
+ * @param  [out] hpos  : offset of the packet hit
+ * @param  [out] hpts  : relative pts of the packet hit
+ * @return 0/-1(not found)
+ */
+static int _scan_pes_pts(demux_cls_t *o, uint8_t *buf, int64_t pos, int64_t end, int64_t target,
+                         int64_t *hpos, int64_t *hpts)
+{
+    int rc, found = 0;
+    size_t i, len;
+    int64_t pts;
+    const uint8_t *p;
+    struct ts_priv *priv = o->priv;
+
+    while (pos + TS_PACKET_SIZE <= end) {
+        len = MIN(TS_READ_SIZE, end - pos);
+        rc  = stream_seek(o->s, pos, SEEK_SET);
+        if (rc < 0) {
+            break;
+        }
+        rc = stream_read(o->s, buf, len);
+        if (rc < TS_PACKET_SIZE) {
+            break;
+        }
+        len = rc;
+        for (i = 0; i + TS_PACKET_SIZE <= len;) {
+            p = buf + i;
+            if (p[0] != 0x47 || (i + TS_PACKET_SIZE < len && p[TS_PACKET_SIZE] != 0x47)) {
+                i++;
+                continue;
+            }
+            pts = _packet_pts(priv, p);
+            if (pts >= 0) {
+                if (target >= 0 && pts > target) {
+                    return found ? 0 : -1;
+                }
+                found = 1;
+                *hpos = pos + i;
+                *hpts = pts;
+                if (target < 0) {
+                    return 0;
+                }
+            }
+            i += TS_PACKET_SIZE;
+        }
+        pos += i;
+    }
+
+    return found ? 0 : -1;
+}
+
 static int _demux_ts_open(demux_cls_t *o)
 {
     int rc;
     tsf_t *f;
     uint8_t *extradata = NULL;
     int esize;
+    int64_t fsize;
     struct ts_priv *priv;
 
     priv = aos_zalloc(sizeof(struct ts_priv));
     CHECK_RET_TAG_WITH_RET(priv, -1);
     o->priv = priv;
 
+    priv->rbuf = aos_malloc(TS_READ_SIZE);
+    CHECK_RET_TAG_WITH_GOTO(priv->rbuf, err);
+    priv->data_start = -1;
+    priv->first_pts  = -1;
+    _reader_reset(priv, stream_tell(o->s));
+
     f = _section_filter_new(priv, PAT_TID, _pat_cb, priv);
     CHECK_RET_TAG_WITH_GOTO(f, err);
 
@@ -458,11 +641,27 @@ static int _demux_ts_open(demux_cls_t *o)
         o->ash.sf = hinfo.sf;
     }
 
+    o->time_scale = TS_TIME_SCALE;
+    fsize         = stream_get_size(o->s);
+    if (stream_is_seekable(o->s) && fsize > 0 && priv->first_pts >= 0) {
+        int64_t pos, pts, cur = stream_tell(o->s);
+        uint8_t *buf = aos_malloc(TS_READ_SIZE);
+
+        /* the duration is the last pts of the file */
+        if (buf) {
+            rc = _scan_pes_pts(o, buf, MAX(priv->data_start, fsize - TS_DURATION_TAIL), fsize, INT64_MAX, &pos, &pts);
+            o->duration = rc == 0 ? pts * 1000 / TS_TIME_SCALE : 0;
+            aos_free(buf);
+        }
+        stream_seek(o->s, cur, SEEK_SET);
+    }
+
     return 0;
 err:
     aos_free(extradata);
     if (priv) {
         _free_all_tsf(priv);
+        aos_free(priv->rbuf);
         aos_free(priv);
     }
     o->priv = NULL;
@@ -474,6 +673,7 @@ static int _demux_ts_close(demux_cls_t *o)
     struct ts_priv *priv = o->priv;
 
     _free_all_tsf(priv);
+    aos_free(priv->rbuf);
     aos_free(priv);
     o->priv = NULL;
     return 0;
@@ -493,8 +693,42 @@ static int _demux_ts_read_packet(demux_cls_t *o, avpacket_t *pkt)
 
 static int _demux_ts_seek(demux_cls_t *o, uint64_t timestamp)
 {
-    //TODO
-    return -1;
+    int rc;
+    uint8_t *buf;
+    int64_t lo, hi, mid, pos, pts, fsize;
+    struct ts_priv *priv = o->priv;
+
+    fsize = stream_get_size(o->s);
+    if (!(fsize > 0 && priv->data_start >= 0 && priv->first_pts >= 0)) {
+        LOGE(TAG, "seek failed. ts = %llu, file_size = %lld", timestamp, fsize);
+        return -1;
+    }
+    buf = aos_malloc(TS_READ_SIZE);
+    CHECK_RET_TAG_WITH_RET(buf, -1);
+
+    /* bisect on the byte position by the pts of the first pes start after it */
+    lo = priv->data_start;
+    hi = fsize;
+    while (hi - lo > TS_SEEK_WINDOW) {
+        mid = lo + (hi - lo) / 2;
+        rc  = _scan_pes_pts(o, buf, mid, hi, -1, &pos, &pts);
+        if (rc == 0 && pts <= timestamp) {
+            lo = pos;
+        } else {
+            hi = mid;
+        }
+    }
+    /* then the last pes start not after the timestamp, scanned forward */
+    pos = priv->data_start;
+    _scan_pes_pts(o, buf, lo, fsize, timestamp, &pos, &pts);
+    aos_free(buf);
+
+    rc = stream_seek(o->s, pos, SEEK_SET);
+    CHECK_RET_TAG_WITH_RET(rc == 0, -1);
+    _reader_reset(priv, pos);
+    _reset_all_tsf(priv);
+
+    return 0;
 }
 
 static int _demux_ts_control(demux_cls_t *o, int cmd, void *arg, size_t *arg_size)
@@ -4,6 +4,7 @@
 
 #if defined(CONFIG_DECODER_IPC) && CONFIG_DECODER_IPC
 #include "ipc.h"
+#include "ipc_ring.h"
 #include <csi_core.h>
 #include "ad_icore.h"
 #include "icore/ad_icore_internal.h"
@@ -19,7 +20,13 @@ struct ad_icore {
     void            *priv;    // priv only for ap/cpu0
 };
 
-struct ad_icore_ap_priv {
+/*
+ * packets in flight. the async one decodes packet N on the cp while the ap demuxes packet N+1,
+ * the frame of packet N is copied out before packet N+1 is submitted, so one context is enough
+ */
+#define AD_ICORE_INFLIGHT        (1)
+
+struct ad_icore_ctx {
     uint8_t         *pool;
     uint8_t         *pool_orip;
     size_t          pool_size;
@@ -31,9 +38,26 @@ struct ad_icore_ap_priv {
     icore_msg_t     *msg_dec; // malloc only once for opt
 };
 
+struct ad_icore_ap_priv {
+    struct ad_icore_ctx ctx[AD_ICORE_INFLIGHT];
+#if CONFIG_AD_ICORE_ASYNC
+    slist_t         node;
+    void            *ring_orip;
+    ipc_ring_t      req;      // producer, ap -> cp
+    ipc_ring_t      cpl;      // consumer, cp -> ap
+    aos_sem_t       sem;
+    uint32_t        widx;     // packets submitted
+    uint32_t        ridx;     // packets completed
+#endif
+};
+
 static struct {
     ipc_t           *ipc;
     int             init;
+#if CONFIG_AD_ICORE_ASYNC
+    slist_t         list;     // async decoders waiting for the cp doorbell
+    aos_mutex_t     lock;
+#endif
 } g_ad_icore;
 
 static int _ipc_cmd_send(icore_msg_t *data, int sync)
@@ -54,6 +78,200 @@ static int _ipc_cmd_send(icore_msg_t *data, int sync)
     return data->ret.code;
 }
 
+static void _ipc_process(ipc_t *ipc, message_t *msg, void *arg)
+{
+#if CONFIG_AD_ICORE_ASYNC
+    struct ad_icore_ap_priv *priv;
+
+    if (msg->command == IPC_CMD_AD_ICORE_KICK) {
+        aos_mutex_lock(&g_ad_icore.lock, AOS_WAIT_FOREVER);
+        slist_for_each_entry(&g_ad_icore.list, priv, struct ad_icore_ap_priv, node) {
+            aos_sem_signal(&priv->sem);
+        }
+        aos_mutex_unlock(&g_ad_icore.lock);
+    }
+#endif
+}
+
+static void _ctx_free(struct ad_icore_ctx *ctx)
+{
+    aos_free(ctx->es_orip);
+    aos_free(ctx->pool_orip);
+    icore_msg_free(ctx->msg_dec);
+}
+
+static int _ctx_alloc(struct ad_icore_ctx *ctx, size_t pool_size)
+{
+    ctx->es_orip = aos_zalloc(ICORE_ALIGN_BUFZ(AD_ICORE_ES_SIZE));
+    CHECK_RET_TAG_WITH_GOTO(ctx->es_orip, err);
+    ctx->es_data = ICORE_ALIGN(ctx->es_orip);
+    ctx->es_size = AD_ICORE_ES_SIZE;
+
+    ctx->pool_orip = aos_zalloc(ICORE_ALIGN_BUFZ(pool_size));
+    CHECK_RET_TAG_WITH_GOTO(ctx->pool_orip, err);
+    ctx->pool      = ICORE_ALIGN(ctx->pool_orip);
+    ctx->pool_size = pool_size;
+
+    ctx->msg_dec = icore_msg_new(ICORE_CMD_AD_DECODE, sizeof(ad_icore_decode_t));
+    CHECK_RET_TAG_WITH_GOTO(ctx->msg_dec, err);
+
+    return 0;
+err:
+    _ctx_free(ctx);
+    memset(ctx, 0, sizeof(struct ad_icore_ctx));
+    return -1;
+}
+
+static void _ctx_fill(ad_icore_t *hdl, struct ad_icore_ctx *ctx, const avpacket_t *pkt)
+{
+    ad_icore_decode_t *inp = icore_get_msg(ctx->msg_dec, ad_icore_decode_t);
+
+    memset(inp, 0, sizeof(ad_icore_decode_t));
+    avframe_set_mempool(&inp->frame, ctx->pool, ctx->pool_size);
+    inp->ad      = hdl->ad;
+    inp->es_len  = pkt->len;
+    inp->es_data = ctx->es_data;
+    memcpy(inp->es_data, pkt->data, pkt->len);
+    csi_dcache_clean_invalid_range((uint32_t*)inp->es_data, inp->es_len);
+}
+
+static int _ctx_output(struct ad_icore_ctx *ctx, int rc, avframe_t *frame, int *got_frame)
+{
+    int ret;
+    ad_icore_decode_t *inp = icore_get_msg(ctx->msg_dec, ad_icore_decode_t);
+
+    if (rc > 0 && inp->got_frame) {
+        *got_frame = inp->got_frame;
+        csi_dcache_invalid_range((uint32_t*)ctx->pool, ctx->pool_size);
+        ret = avframe_copy_from(&inp->frame, frame);
+        if (ret != 0) {
+            rc = -1;
+            LOGE(TAG, "frame copy failed, may be oom. ret = %d, mpool = %p, msize = %d, linesize = %d\n",
+                 ret, frame->mpool, frame->msize, inp->frame.linesize[0]);
+        }
+    }
+
+    return rc;
+}
+
+#if CONFIG_AD_ICORE_ASYNC
+static int _ring_open(ad_icore_t *hdl, struct ad_icore_ap_priv *priv)
+{
+    int rc;
+    char *shm;
+    icore_msg_t *msg;
+    ad_icore_ring_t *inp;
+    int flag = IPC_RING_CACHE;
+    size_t size = ipc_ring_shm_size(AD_ICORE_RING_SLOTS, sizeof(ad_icore_desc_t));
+
+    priv->ring_orip = aos_zalloc(AV_ALIGN_BUFZ(size * 2, IPC_RING_CACHE_LINE * 2));
+    CHECK_RET_TAG_WITH_RET(priv->ring_orip, -1);
+    shm = AV_ALIGN(priv->ring_orip, IPC_RING_CACHE_LINE);
+
+    ipc_ring_init(&priv->req, shm, AD_ICORE_RING_SLOTS, sizeof(ad_icore_desc_t), flag);
+    ipc_ring_init(&priv->cpl, shm + size, AD_ICORE_RING_SLOTS, sizeof(ad_icore_desc_t), flag);
+    aos_sem_new(&priv->sem, 0);
+
+    msg = icore_msg_new(ICORE_CMD_AD_RING, sizeof(ad_icore_ring_t));
+    CHECK_RET_TAG_WITH_GOTO(msg, err);
+    inp            = icore_get_msg(msg, ad_icore_ring_t);
+    inp->ad        = hdl->ad;
+    inp->req_ring  = shm;
+    inp->cpl_ring  = shm + size;
+    inp->ring_flag = flag;
+
+    rc = _ipc_cmd_send(msg, MESSAGE_SYNC);
+    icore_msg_free(msg);
+    CHECK_RET_TAG_WITH_GOTO(rc == 0, err);
+
+    aos_mutex_lock(&g_ad_icore.lock, AOS_WAIT_FOREVER);
+    slist_add_tail(&priv->node, &g_ad_icore.list);
+    aos_mutex_unlock(&g_ad_icore.lock);
+
+    return 0;
+err:
+    aos_sem_free(&priv->sem);
+    aos_freep((char**)&priv->ring_orip);
+    return -1;
+}
+
+static void _ring_close(struct ad_icore_ap_priv *priv)
+{
+    if (priv->ring_orip) {
+        aos_mutex_lock(&g_ad_icore.lock, AOS_WAIT_FOREVER);
+        slist_del(&priv->node, &g_ad_icore.list);
+        aos_mutex_unlock(&g_ad_icore.lock);
+        aos_sem_free(&priv->sem);
+        aos_freep((char**)&priv->ring_orip);
+    }
+}
+
+static void _ring_kick()
+{
+    message_t msg;
+
+    memset(&msg, 0, sizeof(message_t));
+    msg.service_id = AD_ICORE_IPC_SERIVCE_ID;
+    msg.command    = IPC_CMD_AD_ICORE_KICK;
+    msg.flag       = MESSAGE_ASYNC;
+    ipc_message_send(g_ad_icore.ipc, &msg, AOS_WAIT_FOREVER);
+}
+
+static void _ring_submit(struct ad_icore_ap_priv *priv, struct ad_icore_ctx *ctx)
+{
+    ad_icore_desc_t *desc;
+
+    /* the cp reads the message in place, not through the ipc copy */
+    csi_dcache_clean_invalid_range((uint32_t*)ctx->msg_dec, ICORE_MSG_SIZE + ctx->msg_dec->size);
+    while ((desc = ipc_ring_reserve(&priv->req)) == NULL) {
+        aos_msleep(1);
+    }
+    desc->msg = ctx->msg_dec;
+    ipc_ring_push(&priv->req);
+    priv->widx++;
+
+    if (ipc_ring_publish(&priv->req)) {
+        _ring_kick();
+    }
+}
+
+/* wait the oldest packet in flight, completions come back in submit order */
+static int _ring_complete(struct ad_icore_ap_priv *priv, struct ad_icore_ctx **ctx)
+{
+    ad_icore_desc_t *desc;
+    icore_msg_t *msg;
+
+    for (;;) {
+        desc = ipc_ring_peek(&priv->cpl);
+        if (desc) {
+            msg = desc->msg;
+            ipc_ring_pop(&priv->cpl);
+            break;
+        }
+
+        if (ipc_ring_idle(&priv->cpl)) {
+            continue;
+        }
+        aos_sem_wait(&priv->sem, AOS_WAIT_FOREVER);
+    }
+
+    *ctx = &priv->ctx[priv->ridx % AD_ICORE_INFLIGHT];
+    priv->ridx++;
+    csi_dcache_invalid_range((uint32_t*)msg, ICORE_MSG_SIZE + msg->size);
+
+    return msg->ret.code;
+}
+
+static void _ring_drain(struct ad_icore_ap_priv *priv)
+{
+    struct ad_icore_ctx *ctx;
+
+    while (priv->ridx != priv->widx) {
+        _ring_complete(priv, &ctx);
+    }
+}
+#endif
+
 /**
  * @brief  init the icore audio decoder
  * @return 0/-1
@@ -62,8 +280,11 @@ int ad_icore_init()
 {
     if (!g_ad_icore.init) {
         g_ad_icore.ipc = ipc_get(AD_ICORE_CP_IDX);
-        ipc_add_service(g_ad_icore.ipc, AD_ICORE_IPC_SERIVCE_ID, NULL, NULL);
         CHECK_RET_TAG_WITH_RET(g_ad_icore.ipc, -1);
+#if CONFIG_AD_ICORE_ASYNC
+        aos_mutex_new(&g_ad_icore.lock);
+#endif
+        ipc_add_service(g_ad_icore.ipc, AD_ICORE_IPC_SERIVCE_ID, _ipc_process, NULL);
         g_ad_icore.init = 1;
     }
 
@@ -90,15 +311,12 @@ int ad_icore_conf_init(adi_conf_t *adi_cnf)
  */
 ad_icore_t* ad_icore_open(avcodec_id_t id, const adi_conf_t *adi_cnf)
 {
-    int rc;
-    char *es_data, *es_orip      = NULL;
-    char *pool, *pool_orip       = NULL;
+    int rc, i;
     uint8_t *extradata           = NULL;
     uint8_t *extradata_orip      = NULL;
     ad_icore_t *hdl               = NULL;
     struct ad_icore_ap_priv *priv = NULL;
     icore_msg_t *msg             = NULL;
-    icore_msg_t *msg_dec         = NULL;
     ad_icore_open_t *inp;
 
     if (!(adi_cnf && (id != AVCODEC_ID_UNKNOWN))) {
@@ -109,19 +327,13 @@ ad_icore_t* ad_icore_open(avcodec_id_t id, const adi_conf_t *adi_cnf)
     hdl = aos_zalloc(sizeof(ad_icore_t));
     CHECK_RET_TAG_WITH_RET(hdl, NULL);
 
-    es_orip = aos_zalloc(ICORE_ALIGN_BUFZ(AD_ICORE_ES_SIZE));
-    CHECK_RET_TAG_WITH_GOTO(es_orip, err);
-    es_data = ICORE_ALIGN(es_orip);
-
-    pool_orip = aos_zalloc(ICORE_ALIGN_BUFZ(AD_ICORE_FRAME_POOL_SIZE));
-    CHECK_RET_TAG_WITH_GOTO(pool_orip, err);
-    pool = ICORE_ALIGN(pool_orip);
-
     priv = aos_zalloc(sizeof(struct ad_icore_ap_priv));
     CHECK_RET_TAG_WITH_GOTO(priv, err);
 
-    msg_dec = icore_msg_new(ICORE_CMD_AD_DECODE, sizeof(ad_icore_decode_t));
-    CHECK_RET_TAG_WITH_GOTO(msg_dec, err);
+    for (i = 0; i < AD_ICORE_INFLIGHT; i++) {
+        rc = _ctx_alloc(&priv->ctx[i], AD_ICORE_FRAME_POOL_SIZE / AD_ICORE_INFLIGHT);
+        CHECK_RET_TAG_WITH_GOTO(rc == 0, err);
+    }
 
     msg = icore_msg_new(ICORE_CMD_AD_OPEN, sizeof(ad_icore_open_t));
     CHECK_RET_TAG_WITH_GOTO(msg, err);
@@ -141,29 +353,36 @@ ad_icore_t* ad_icore_open(avcodec_id_t id, const adi_conf_t *adi_cnf)
 
     rc = _ipc_cmd_send(msg, MESSAGE_SYNC);
     CHECK_RET_TAG_WITH_GOTO(rc == 0, err);
-    priv->es_data   = (uint8_t*)es_data;
-    priv->es_orip   = (uint8_t*)es_orip;
-    priv->es_size   = AD_ICORE_ES_SIZE;
-    priv->pool      = (uint8_t*)pool;
-    priv->pool_orip = (uint8_t*)pool_orip;
-    priv->pool_size = AD_ICORE_FRAME_POOL_SIZE;
-    priv->msg_dec   = msg_dec;
 
     hdl->ad   = inp->ad;
     hdl->sf   = inp->sf;
     hdl->priv = priv;
+#if CONFIG_AD_ICORE_ASYNC
+    if (_ring_open(hdl, priv) != 0) {
+        LOGE(TAG, "ring open failed");
+        icore_msg_free(msg);
+        msg = NULL;
+        ad_icore_close(hdl);
+        goto quit;
+    }
+#endif
     icore_msg_free(msg);
     aos_free(extradata_orip);
 
     return hdl;
 err:
-    aos_free(extradata_orip);
     aos_free(hdl);
-    aos_free(es_orip);
-    aos_free(pool_orip);
+    if (priv) {
+        for (i = 0; i < AD_ICORE_INFLIGHT; i++) {
+            _ctx_free(&priv->ctx[i]);
+        }
+    }
     aos_free(priv);
     icore_msg_free(msg);
-    icore_msg_free(msg_dec);
+#if CONFIG_AD_ICORE_ASYNC
+quit:
+#endif
+    aos_free(extradata_orip);
     return NULL;
 }
 
@@ -197,9 +416,8 @@ int ad_icore_get_sf(ad_icore_t *hdl, sf_t *sf)
  */
 int ad_icore_decode(ad_icore_t *hdl, avframe_t *frame, int *got_frame, const avpacket_t *pkt)
 {
-    int rc = -1, ret;
-    icore_msg_t *msg;
-    ad_icore_decode_t *inp;
+    int rc = -1;
+    struct ad_icore_ctx *ctx;
     struct ad_icore_ap_priv *priv;
 
     if (!(hdl && frame && got_frame && pkt && pkt->data && pkt->len && (pkt->len < AD_ICORE_ES_SIZE))) {
@@ -208,28 +426,64 @@ int ad_icore_decode(ad_icore_t *hdl, avframe_t *frame, int *got_frame, const avp
 
     *got_frame = 0;
     priv       = hdl->priv;
-    msg        = priv->msg_dec;
-    inp        = icore_get_msg(msg, ad_icore_decode_t);
-    memset(inp, 0, sizeof(ad_icore_decode_t));
-    avframe_set_mempool(&inp->frame, priv->pool, priv->pool_size);
-    inp->ad      = hdl->ad;
-    inp->es_len  = pkt->len;
-    inp->es_data = priv->es_data;
-    memcpy(inp->es_data, pkt->data, pkt->len);
-    csi_dcache_clean_invalid_range((uint32_t*)inp->es_data, inp->es_len);
-    rc = _ipc_cmd_send(msg, MESSAGE_SYNC);
-    if (rc > 0 && inp->got_frame) {
-        *got_frame = inp->got_frame;
-        csi_dcache_invalid_range((uint32_t*)priv->pool, priv->pool_size);
-        ret = avframe_copy_from(&inp->frame, frame);
-        if (ret != 0) {
-            rc = -1;
-            LOGE(TAG, "frame copy failed, may be oom. ret = %d, mpool = %p, msize = %d, linesize = %d\n",
-                 ret, frame->mpool, frame->msize, inp->frame.linesize[0]);
+#if CONFIG_AD_ICORE_ASYNC
+    /*
+     * the frame returned is the one of the previous packet, so the cp decodes
+     * this packet while the ap is demuxing the next one. the previous packet is
+     * completed first: when it failed this packet is not taken, and the last one
+     * in flight is got by ad_icore_flush
+     */
+    if (priv->widx != priv->ridx) {
+        rc = _ring_complete(priv, &ctx);
+        rc = _ctx_output(ctx, rc, frame, got_frame);
+        if (rc < 0) {
+            return rc;
         }
     }
 
-    return rc;
+    ctx = &priv->ctx[priv->widx % AD_ICORE_INFLIGHT];
+    _ctx_fill(hdl, ctx, pkt);
+    _ring_submit(priv, ctx);
+
+    return pkt->len;
+#else
+    ctx = &priv->ctx[0];
+    _ctx_fill(hdl, ctx, pkt);
+    rc = _ipc_cmd_send(ctx->msg_dec, MESSAGE_SYNC);
+
+    return _ctx_output(ctx, rc, frame, got_frame);
+#endif
+}
+
+/**
+ * @brief  get the frame of the last packet in flight, called at the end of the stream
+ * @param  [in] hdl
+ * @param  [out] frame : frame of pcm
+ * @param  [out] got_frame : whether decode one frame
+ * @return 0/-1, -1 when decode of that packet failed
+ */
+int ad_icore_flush(ad_icore_t *hdl, avframe_t *frame, int *got_frame)
+{
+    int rc = 0;
+#if CONFIG_AD_ICORE_ASYNC
+    struct ad_icore_ctx *ctx;
+    struct ad_icore_ap_priv *priv;
+#endif
+
+    if (!(hdl && frame && got_frame)) {
+        return -1;
+    }
+
+    *got_frame = 0;
+#if CONFIG_AD_ICORE_ASYNC
+    priv = hdl->priv;
+    if (priv->widx != priv->ridx) {
+        rc = _ring_complete(priv, &ctx);
+        rc = _ctx_output(ctx, rc, frame, got_frame);
+    }
+#endif
+
+    return rc < 0 ? rc : 0;
 }
 
 /**
@@ -246,6 +500,10 @@ int ad_icore_reset(ad_icore_t *hdl)
         return rc;
     }
 
+#if CONFIG_AD_ICORE_ASYNC
+    /* frames in flight belong to the old position, dropped. flush before to keep them */
+    _ring_drain(hdl->priv);
+#endif
     msg  = icore_msg_new(ICORE_CMD_AD_RESET, sizeof(ad_icore_reset_t));
     if (msg) {
         ad_icore_reset_t *inp = icore_get_msg(msg, ad_icore_reset_t);
@@ -265,7 +523,7 @@ int ad_icore_reset(ad_icore_t *hdl)
  */
 int ad_icore_close(ad_icore_t *hdl)
 {
-    int rc = -1;
+    int rc = -1, i;
     icore_msg_t *msg;
     struct ad_icore_ap_priv *priv;
 
@@ -274,6 +532,9 @@ int ad_icore_close(ad_icore_t *hdl)
     }
 
     priv = hdl->priv;
+#if CONFIG_AD_ICORE_ASYNC
+    _ring_drain(priv);
+#endif
     msg  = icore_msg_new(ICORE_CMD_AD_CLOSE, sizeof(ad_icore_close_t));
     if (msg) {
         ad_icore_close_t *inp = icore_get_msg(msg, ad_icore_close_t);
@@ -283,9 +544,12 @@ int ad_icore_close(ad_icore_t *hdl)
         icore_msg_free(msg);
     }
 
-    aos_free(priv->es_orip);
-    aos_free(priv->pool_orip);
-    icore_msg_free(priv->msg_dec);
+#if CONFIG_AD_ICORE_ASYNC
+    _ring_close(priv);
+#endif
+    for (i = 0; i < AD_ICORE_INFLIGHT; i++) {
+        _ctx_free(&priv->ctx[i]);
+    }
     aos_free(hdl->priv);
     aos_free(hdl);
 
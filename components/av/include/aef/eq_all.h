@@ -28,6 +28,12 @@ int eqx_register_silan();
  */
 int eqx_register_ipc();
 
+/**
+ * @brief  regist equalizer for local(portable fixed-point biquads)
+ * @return 0/-1
+ */
+int eqx_register_local();
+
 /**
  * @brief  regist audio equalizer
  * @return 0/-1
@@ -39,6 +45,10 @@ static inline int eqx_register()
 #endif
 #if defined(CONFIG_EQXER_IPC)
     REGISTER_EQXER(IPC, ipc);
+#endif
+#if defined(CONFIG_EQXER_LOCAL) && !CONFIG_EQXER_SILAN && !CONFIG_EQXER_IPC
+    /* fallback for the chips without an equalizer backend */
+    REGISTER_EQXER(LOCAL, local);
 #endif
     return 0;
 }
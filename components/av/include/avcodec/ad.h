@@ -58,9 +58,23 @@ ad_cls_t* ad_open(avcodec_id_t id, const ad_conf_t *ad_cnf);
  * @param  [in]  pkt : data of encoded audio
  * @return -1 when err happens, otherwise the number of bytes consumed from the
  *         input avpacket is returned
+ * attention: a decoder may give the frame of a packet back one call later (the ipc one with
+ *            CONFIG_AD_ICORE_ASYNC), the caller calls ad_flush at the end of the stream, or
+ *            the last frame is lost
  */
 int ad_decode(ad_cls_t *o, avframe_t *frame, int *got_frame, const avpacket_t *pkt);
 
+/**
+ * @brief  get the frame still held by the decoder, called at the end of the stream until no frame got
+ *         and before ad_reset/ad_close when the held frame is wanted. a decoder which holds no
+ *         frame returns 0 with no frame got
+ * @param  [in] o
+ * @param  [out] frame : frame of pcm
+ * @param  [out] got_frame : whether decode one frame
+ * @return 0/-1
+ */
+int ad_flush(ad_cls_t *o, avframe_t *frame, int *got_frame);
+
 /**
  * @brief  control a audio decoder
  * @param  [in] o
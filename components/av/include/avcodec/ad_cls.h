@@ -19,6 +19,7 @@ struct ad_ops {
 
     int      (*open)          (ad_cls_t *o);
     int      (*decode)        (ad_cls_t *o, avframe_t *frame, int *got_frame, const avpacket_t *pkt);
+    int      (*flush)         (ad_cls_t *o, avframe_t *frame, int *got_frame);  ///< if the decoder holds frames
     int      (*control)       (ad_cls_t *o, int cmd, void *arg, size_t *arg_size);
     int      (*reset)         (ad_cls_t *o);
     int      (*close)         (ad_cls_t *o);
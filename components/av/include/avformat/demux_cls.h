@@ -52,6 +52,8 @@ struct demux_cls {
     uint64_t                    bps;
     size_t                      time_scale;    ///< only for audio
     uint64_t                    duration;      ///< only for audio, ms
+    uint32_t                    skip_samples;  ///< samples to drop at the begin(encoder and decoder delay), for gapless
+    uint64_t                    nb_samples;    ///< valid samples after the skip_samples, without the padding. 0 if unknown
     track_info_t                *tracks;       ///< TODO: need call tracks_info_freep when unused
 
     avparser_t                  *psr;
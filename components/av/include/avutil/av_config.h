@@ -90,6 +90,10 @@
 #define CONFIG_DECODER_IPC                             (0)
 #endif
 
+#ifndef CONFIG_AD_ICORE_ASYNC
+#define CONFIG_AD_ICORE_ASYNC                          (0)
+#endif
+
 #ifndef CONFIG_AV_AO_ALSA
 #define CONFIG_AV_AO_ALSA                              (1)
 #endif
@@ -116,6 +120,28 @@
 #define CONFIG_PLAYER_TASK_STACK_SIZE                  (98304) ///< 96 * 1024
 #endif
 
+/* the demux and output stages run in tasks of their own when the stack size is not zero,
+ * 16 * 1024 and 32 * 1024 are enough for them. 0 runs the stage in the player task */
+#ifndef CONFIG_PLAYER_DEMUX_TASK_STACK_SIZE
+#define CONFIG_PLAYER_DEMUX_TASK_STACK_SIZE            (0)
+#endif
+
+#ifndef CONFIG_PLAYER_OUTPUT_TASK_STACK_SIZE
+#define CONFIG_PLAYER_OUTPUT_TASK_STACK_SIZE           (0)
+#endif
+
+#ifndef CONFIG_PLAYER_NEXT_TASK_STACK_SIZE
+#define CONFIG_PLAYER_NEXT_TASK_STACK_SIZE             (16384) ///< 16 * 1024
+#endif
+
+#ifndef CONFIG_PLAYER_PKT_NUM_DEFAULT
+#define CONFIG_PLAYER_PKT_NUM_DEFAULT                  (16)    ///< packets queued between demux and decode
+#endif
+
+#ifndef CONFIG_PLAYER_FRAME_NUM_DEFAULT
+#define CONFIG_PLAYER_FRAME_NUM_DEFAULT                (4)     ///< frames queued between decode and output
+#endif
+
 #ifndef CONFIG_WEB_CACHE_TASK_STACK_SIZE
 #define CONFIG_WEB_CACHE_TASK_STACK_SIZE               (6144)  ///< 6 * 1024
 #endif
@@ -124,6 +150,10 @@
 #define CONFIG_AV_STREAM_INNER_BUF_SIZE                (1024)
 #endif
 
+#ifndef CONFIG_AV_STREAM_CRYPTO_BUF_SIZE
+#define CONFIG_AV_STREAM_CRYPTO_BUF_SIZE               (4*1024)     ///< read-ahead of the crypto stream, decrypted in place
+#endif
+
 #ifndef CONFIG_AV_STREAM_RCV_TIMEOUT_DEFAULT
 #define CONFIG_AV_STREAM_RCV_TIMEOUT_DEFAULT           (3*1000)     ///< ms
 #endif
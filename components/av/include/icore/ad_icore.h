@@ -49,9 +49,20 @@ int ad_icore_get_sf(ad_icore_t *hdl, sf_t *sf);
  * @param  [in]  pkt : data of encoded audio
  * @return -1 when err happens, otherwise the number of bytes consumed from the
  *         input avpacket is returned
+ * attention: with CONFIG_AD_ICORE_ASYNC the frame got is the one of the previous packet,
+ *            ad_icore_flush gets the last one
  */
 int ad_icore_decode(ad_icore_t *hdl, avframe_t *frame, int *got_frame, const avpacket_t *pkt);
 
+/**
+ * @brief  get the frame of the last packet in flight, called at the end of the stream
+ * @param  [in] hdl
+ * @param  [out] frame : frame of pcm
+ * @param  [out] got_frame : whether decode one frame
+ * @return 0/-1, -1 when decode of that packet failed
+ */
+int ad_icore_flush(ad_icore_t *hdl, avframe_t *frame, int *got_frame);
+
 /**
  * @brief  reset the ad_icore
  * @param  [in] hdl
@@ -21,6 +21,7 @@ __BEGIN_DECLS__
 #define AD_ICORE_CP_IDX          (2)
 #endif
 #define IPC_CMD_AD_ICORE  (55)
+#define IPC_CMD_AD_ICORE_KICK  (56)     // doorbell of the async decode rings
 #define AD_ICORE_IPC_SERIVCE_ID 0x10
 
 enum {
@@ -29,8 +30,15 @@ enum {
     ICORE_CMD_AD_DECODE,
     ICORE_CMD_AD_RESET,
     ICORE_CMD_AD_CLOSE,
+    ICORE_CMD_AD_RING,
 };
 
+#define AD_ICORE_RING_SLOTS      (4)
+
+typedef struct {
+    icore_msg_t       *msg;     // ICORE_CMD_AD_DECODE message, ret.code filled by cp
+} ad_icore_desc_t;
+
 typedef struct {
     avcodec_id_t  id;
     adi_conf_t    adi_cnf;      // req
@@ -47,6 +55,13 @@ typedef struct {
     void          *ad;          // ad_cls_t
 } ad_icore_close_t;
 
+typedef struct {
+    void          *ad;          // ad_cls_t
+    void          *req_ring;    // ipc_ring shm of ad_icore_desc_t, ap -> cp
+    void          *cpl_ring;    // ipc_ring shm of ad_icore_desc_t, cp -> ap
+    int           ring_flag;    // IPC_RING_CACHE
+} ad_icore_ring_t;
+
 typedef struct {
     void              *ad;      // ad_cls_t
     uint8_t           *es_data;
@@ -12,7 +12,7 @@ __BEGIN_DECLS__
 enum {
     MCA_TYPE_UNKNOWN,
     MCA_TYPE_IIR,
-    MCA_TYPE_FIR,       // TODO
+    MCA_TYPE_FIR,
     MCA_TYPE_MCA,       // TODO:
 };
 
@@ -49,11 +49,37 @@ int mcax_iir_fxp32_coeff32_config(mcax_t *mca, const fxp32_t *coeff);
  *   # input_size must be greater than order, and size of output is
  *     (input_size - 2).
  *   # yn1 and yn2 are the 1st and 2nd samples from the last output.
+ *   # output may be the same buffer as input.
  * @return -1/0
  */
 int mcax_iir_fxp32(mcax_t *mca, const fxp32_t *input, size_t input_size, fxp32_t yn1, fxp32_t yn2,
                    fxp32_t *output);
 
+/**
+ * Configures FIR filter with 32-bit input/ouput and 32-bit coefficients.
+ *
+ * Note:
+ *   # coeff is 32-bit (Q1.7.24), with size of (order + 1), stored as
+ *     [b(nb) ... b(2) b(1) b(0)].
+ *   # order must be in range of [0, 4095].
+ *   # Input/output are 32-bit (Q1.31.0).
+ * @return -1/0
+ */
+int mcax_fir_fxp32_coeff32_config(mcax_t *mca, const fxp32_t *coeff, size_t order);
+
+/**
+ * FIR filter with 32-bit input/output.
+ *
+ * Note:
+ *   # input is 32-bit (Q1.31.0), output also 32-bit but its precision is
+ *     determined by configuration.
+ *   # input_size must be greater than order, and size of output is
+ *     (input_size - order).
+ *   # output may be the same buffer as input.
+ * @return -1/0
+ */
+int mcax_fir_fxp32(mcax_t *mca, const fxp32_t *input, size_t input_size, fxp32_t *output);
+
 /**
  * @brief  free the mca
  * @param  [in] mca
@@ -28,6 +28,8 @@ struct mcax_ops {
     int      (*iir_fxp32_coeff32_config)    (mcax_t *mca, const fxp32_t *coeff);
     int      (*iir_fxp32)                   (mcax_t *mca, const fxp32_t *input, size_t input_size,
             fxp32_t yn1, fxp32_t yn2, fxp32_t *output);
+    int      (*fir_fxp32_coeff32_config)    (mcax_t *mca, const fxp32_t *coeff, size_t order);
+    int      (*fir_fxp32)                   (mcax_t *mca, const fxp32_t *input, size_t input_size, fxp32_t *output);
     int      (*uninit)                      (mcax_t *mca);
 };
 
@@ -30,6 +30,7 @@ enum {
     PLAYER_EVENT_FINISH,
     PLAYER_EVENT_UNDER_RUN,    ///< for stream-cache status
     PLAYER_EVENT_OVER_RUN,     ///< for stream-cache status
+    PLAYER_EVENT_NEXT_START,   ///< the url set by player_set_next starts to play
 };
 
 typedef struct player_cb player_t;
@@ -70,6 +71,8 @@ typedef struct player_conf {
     uint32_t                  cache_start_threshold; ///< (0~100)start read for player when up to cache_start_threshold. 0 use default
     uint32_t                  period_ms;     ///< period cache size(ms) for audio out. 0 means use default
     uint32_t                  period_num;    ///< number of period_ms. total cache size for ao is (period_num * period_ms * (rate / 1000) * 2 * (16/8)). 0 means use default
+    uint32_t                  pkt_num;       ///< number of packets queued between demux and decode. 0 means use default
+    uint32_t                  frame_num;     ///< number of frames queued between decode and output. 0 means use default
     get_decrypt_cb_t          get_dec_cb;    ///< used for get decrypt info
     player_event_t            event_cb;      ///< callback of the player event
 } ply_conf_t;
@@ -113,6 +116,16 @@ int player_ioctl(player_t *player, int cmd, ...);
  */
 int player_play(player_t *player, const char *url, uint64_t start_time);
 
+/**
+ * @brief  set the url played right after the current one, without a gap
+ * attention: the next url is opened while the current one plays, the ao is reused when the sample format is same.
+ *            PLAYER_EVENT_NEXT_START is sent when it starts, then another next url may be set
+ * @param  [in] player
+ * @param  [in] url : the next url
+ * @return 0/-1
+ */
+int player_set_next(player_t *player, const char *url);
+
 /**
  * @brief  pause the player
  * @param  [in] player
@@ -100,6 +100,55 @@ int mcax_iir_fxp32(mcax_t *mca, const fxp32_t *input, size_t input_size, fxp32_t
     return rc;
 }
 
+/**
+ * Configures FIR filter with 32-bit input/ouput and 32-bit coefficients.
+ *
+ * Note:
+ *   # coeff is 32-bit (Q1.7.24), with size of (order + 1), stored as
+ *     [b(nb) ... b(2) b(1) b(0)].
+ *   # order must be in range of [0, 4095].
+ *   # Input/output are 32-bit (Q1.31.0).
+ * @return -1/0
+ */
+int mcax_fir_fxp32_coeff32_config(mcax_t *mca, const fxp32_t *coeff, size_t order)
+{
+    int rc = -1;
+
+    CHECK_PARAM(mca && coeff, -1);
+    aos_mutex_lock(&mca->lock, AOS_WAIT_FOREVER);
+    if (mca->ops->fir_fxp32_coeff32_config) {
+        rc = mca->ops->fir_fxp32_coeff32_config(mca, coeff, order);
+    }
+    aos_mutex_unlock(&mca->lock);
+
+    return rc;
+}
+
+/**
+ * FIR filter with 32-bit input/output.
+ *
+ * Note:
+ *   # input is 32-bit (Q1.31.0), output also 32-bit but its precision is
+ *     determined by configuration.
+ *   # input_size must be greater than order, and size of output is
+ *     (input_size - order).
+ *   # output may be the same buffer as input.
+ * @return -1/0
+ */
+int mcax_fir_fxp32(mcax_t *mca, const fxp32_t *input, size_t input_size, fxp32_t *output)
+{
+    int rc = -1;
+
+    CHECK_PARAM(mca && input && input_size && output, -1);
+    aos_mutex_lock(&mca->lock, AOS_WAIT_FOREVER);
+    if (mca->ops->fir_fxp32) {
+        rc = mca->ops->fir_fxp32(mca, input, input_size, output);
+    }
+    aos_mutex_unlock(&mca->lock);
+
+    return rc;
+}
+
 /**
  * @brief  free the mca
  * @param  [in] mca
@@ -5,53 +5,62 @@
 #if defined(CONFIG_MCAXER_LOCAL) && CONFIG_MCAXER_LOCAL
 #include "avutil/common.h"
 #include "avutil/av_typedef.h"
+#include "mca/mca.h"
 #include "mca/mca_cls.h"
-#include "mca/csky_mca.h"
 
 #define TAG                   "mca_local"
-static struct {
-    fxp32_t                   coeff[5];
-    fxp32_t                   input[POST_PROC_SAMPLES_MAX];
-    fxp32_t                   output[POST_PROC_SAMPLES_MAX - 2];
-} _res_iir  __attribute__((section(".fast_heap")));
 
-static struct {
-    aos_mutex_t               iir_lock;
-    int                       init;
-} g_mcalocal;
-
-#define mca_iir_lock()   (aos_mutex_lock(&g_mcalocal.iir_lock, AOS_WAIT_FOREVER))
-#define mca_iir_unlock() (aos_mutex_unlock(&g_mcalocal.iir_lock))
+/*
+ * portable engine with the semantics of csky_mca_iir/fir_fxp32. the csky library keeps
+ * the coefficients in a global, so every handle here owns its coefficients and nothing
+ * is shared between the instances. input and output may be the same buffer
+ */
+#define MCA_COEFF_SHIFT       (24)             ///< Q1.7.24
+#define MCA_FIR_ORDER_MAX     (4095)
+#define MCA_FIR_BLOCK         (4)              ///< outputs per pass over the coefficients
+
+enum {
+    MCA_IIR_B2,
+    MCA_IIR_B1,
+    MCA_IIR_B0,
+    MCA_IIR_NA1,                               ///< -a(1)
+    MCA_IIR_NA2,                               ///< -a(2)
+    MCA_IIR_COEFF_NUM,
+};
 
 struct mca_local_priv {
-    void                      *hdl;
+    fxp32_t                   iir[MCA_IIR_COEFF_NUM];
+    fxp32_t                   *fir;            ///< [b(nb) ... b(1) b(0)]
+    size_t                    fir_order;
 };
 
+static inline fxp32_t _sat_fxp32(int64_t v)
+{
+    v >>= MCA_COEFF_SHIFT;
+    return v > INT32_MAX ? INT32_MAX : (v < INT32_MIN ? INT32_MIN : (fxp32_t)v);
+}
+
 static int _mca_local_init(mcax_t *mca, int32_t type)
 {
-    void *hdl = NULL;
     struct mca_local_priv *priv = NULL;
 
-    if (!g_mcalocal.init) {
-        aos_mutex_new(&g_mcalocal.iir_lock);
-        g_mcalocal.init = 1;
+    if (!(type == MCA_TYPE_IIR || type == MCA_TYPE_FIR)) {
+        LOGE(TAG, "type not support. type = %d", type);
+        return -1;
     }
 
     priv = aos_zalloc(sizeof(struct mca_local_priv));
     CHECK_RET_TAG_WITH_RET(priv, -1);
 
-    priv->hdl = hdl;
     mca->priv = priv;
     return 0;
 }
 
 static int _mca_local_iir_fxp32_coeff32_config(mcax_t *mca, const fxp32_t *coeff)
 {
-    UNUSED(mca);
-    mca_iir_lock();
-    memcpy(_res_iir.coeff, coeff, sizeof(_res_iir.coeff));
-    csky_mca_iir_fxp32_coeff32_config(_res_iir.coeff);
-    mca_iir_unlock();
+    struct mca_local_priv *priv = mca->priv;
+
+    memcpy(priv->iir, coeff, sizeof(priv->iir));
 
     return 0;
 }
@@ -59,14 +68,91 @@ static int _mca_local_iir_fxp32_coeff32_config(mcax_t *mca, const fxp32_t *coeff
 static int _mca_local_iir_fxp32(mcax_t *mca, const fxp32_t *input, size_t input_size,
                                 fxp32_t yn1, fxp32_t yn2, fxp32_t *output)
 {
-    UNUSED(mca);
-    CHECK_PARAM(input_size <= POST_PROC_SAMPLES_MAX, -1);
+    size_t i;
+    fxp32_t x0, x1, x2, y;
+    struct mca_local_priv *priv = mca->priv;
+    const fxp32_t b2 = priv->iir[MCA_IIR_B2], b1 = priv->iir[MCA_IIR_B1], b0 = priv->iir[MCA_IIR_B0];
+    const fxp32_t na1 = priv->iir[MCA_IIR_NA1], na2 = priv->iir[MCA_IIR_NA2];
+
+    CHECK_PARAM(input_size > 2, -1);
+    /* output[i] is for input[i + 2], so it may overwrite input[i] which is used up */
+    x2 = input[0];
+    x1 = input[1];
+    for (i = 0; i < input_size - 2; i++) {
+        x0 = input[i + 2];
+        y  = _sat_fxp32((int64_t)b2 * x2 + (int64_t)b1 * x1 + (int64_t)b0 * x0
+                        + (int64_t)na1 * yn1 + (int64_t)na2 * yn2);
+        output[i] = y;
+        x2  = x1;
+        x1  = x0;
+        yn2 = yn1;
+        yn1 = y;
+    }
+
+    return 0;
+}
+
+static int _mca_local_fir_fxp32_coeff32_config(mcax_t *mca, const fxp32_t *coeff, size_t order)
+{
+    fxp32_t *fir;
+    struct mca_local_priv *priv = mca->priv;
 
-    mca_iir_lock();
-    memcpy(_res_iir.input, input, input_size * sizeof(fxp32_t));
-    csky_mca_iir_fxp32(_res_iir.input, input_size, yn1, yn2, _res_iir.output);
-    memcpy(output, _res_iir.output, (input_size - 2) * sizeof(fxp32_t));
-    mca_iir_unlock();
+    CHECK_PARAM(order <= MCA_FIR_ORDER_MAX, -1);
+    if (!(priv->fir && order == priv->fir_order)) {
+        fir = aos_realloc(priv->fir, sizeof(fxp32_t) * (order + 1));
+        CHECK_RET_TAG_WITH_RET(fir, -1);
+        priv->fir = fir;
+    }
+    memcpy(priv->fir, coeff, sizeof(fxp32_t) * (order + 1));
+    priv->fir_order = order;
+
+    return 0;
+}
+
+static int _mca_local_fir_fxp32(mcax_t *mca, const fxp32_t *input, size_t input_size, fxp32_t *output)
+{
+    size_t i, k, nb_out;
+    int64_t acc0, acc1, acc2, acc3;
+    struct mca_local_priv *priv = mca->priv;
+    const fxp32_t *c            = priv->fir;
+    const size_t taps           = priv->fir_order + 1;
+
+    CHECK_PARAM(c && input_size > priv->fir_order, -1);
+    nb_out = input_size - priv->fir_order;
+    /*
+     * output[i] = sum(c[k] * input[i + k]). a block of outputs shares one pass over the
+     * coefficients, each input load feeds several products. output[i] may overwrite
+     * input[i], the later outputs don't need it
+     */
+    for (i = 0; i + MCA_FIR_BLOCK <= nb_out; i += MCA_FIR_BLOCK) {
+        const fxp32_t *x = input + i;
+        fxp32_t x0 = x[0], x1 = x[1], x2 = x[2], x3;
+
+        acc0 = acc1 = acc2 = acc3 = 0;
+        for (k = 0; k < taps; k++) {
+            int64_t ck = c[k];
+
+            x3    = x[k + 3];
+            acc0 += ck * x0;
+            acc1 += ck * x1;
+            acc2 += ck * x2;
+            acc3 += ck * x3;
+            x0    = x1;
+            x1    = x2;
+            x2    = x3;
+        }
+        output[i]     = _sat_fxp32(acc0);
+        output[i + 1] = _sat_fxp32(acc1);
+        output[i + 2] = _sat_fxp32(acc2);
+        output[i + 3] = _sat_fxp32(acc3);
+    }
+    for (; i < nb_out; i++) {
+        acc0 = 0;
+        for (k = 0; k < taps; k++) {
+            acc0 += (int64_t)c[k] * input[i + k];
+        }
+        output[i] = _sat_fxp32(acc0);
+    }
 
     return 0;
 }
@@ -75,6 +161,7 @@ static int _mca_local_uninit(mcax_t *mca)
 {
     struct mca_local_priv *priv = mca->priv;
 
+    aos_free(priv->fir);
     aos_free(priv);
     mca->priv = NULL;
     return 0;
@@ -86,6 +173,8 @@ const struct mcax_ops mcax_ops_local = {
     .init                             = _mca_local_init,
     .iir_fxp32_coeff32_config         = _mca_local_iir_fxp32_coeff32_config,
     .iir_fxp32                        = _mca_local_iir_fxp32,
+    .fir_fxp32_coeff32_config         = _mca_local_fir_fxp32_coeff32_config,
+    .fir_fxp32                        = _mca_local_fir_fxp32,
     .uninit                           = _mca_local_uninit,
 };
 #endif
@@ -33,6 +33,64 @@ enum player_status {
 	} while(0)
 
 #define PLAYER_TASK_QUIT_EVT           (0x01)
+#define PLAYER_DEMUX_QUIT_EVT          (0x02)
+#define PLAYER_OUTPUT_QUIT_EVT         (0x04)
+#define PLAYER_SEEK_REQ_EVT            (0x08)
+#define PLAYER_SEEK_DONE_EVT           (0x10)
+#define PLAYER_NEXT_QUIT_EVT           (0x20)
+
+#define PLAYER_QUEUE_WAIT_MS           (200)
+#define PLAYER_INLINE_IDLE_MS          (10)
+
+/* single producer/single consumer queue of pointers */
+typedef struct {
+    void                         **item;
+    uint32_t                     num;
+    uint32_t                     rd;
+    uint32_t                     wr;
+    aos_sem_t                    sem;           ///< number of queued items
+} ply_queue_t;
+
+/* the track set by player_set_next, opened by the next task while the current one plays */
+typedef struct ply_track {
+    char                         *url;
+    stream_cls_t                 *s;
+    demux_cls_t                  *demuxer;
+    ad_cls_t                     *ad;
+    sf_t                         sf;
+    struct ply_track             *next;         ///< switched in the demux, not output yet
+} ply_track_t;
+
+typedef struct {
+    avpacket_t                   pkt;
+    uint32_t                     gen;
+    int                          eos;           ///< 0: data, 1: end of stream, -1: demux error
+    ply_track_t                  *track;        ///< not NULL: the stream goes on with this track from here
+} ply_pkt_t;
+
+typedef struct {
+    avframe_t                    *frame;
+    int64_t                      pts;
+    uint32_t                     gen;
+    int                          eos;           ///< 0: data, 1: end of stream, -1: demux/decode error
+    ply_track_t                  *track;        ///< not NULL: the stream goes on with this track from here
+    size_t                       offset;        ///< pcm to write, the delay and padding are trimmed
+    size_t                       size;
+} ply_frame_t;
+
+/* state of the demux stage, kept here as the stage may run in its task or in the player task */
+typedef struct {
+    demux_cls_t                  *demuxer;
+    ply_pkt_t                    *ppkt;
+    int                          end;
+} ply_demux_stage_t;
+
+/* state of the output stage */
+typedef struct {
+    ply_frame_t                  *pf;
+    uint8_t                      play_first;
+    uint8_t                      done;
+} ply_output_stage_t;
 
 struct player_cb {
     char                         *url;
@@ -47,6 +105,8 @@ struct player_cb {
     uint32_t                     cache_start_threshold; ///< (0~100)start read for player when up to cache_start_threshold. 0 use default
     uint32_t                     period_ms;     ///< period cache size(ms) for audio out. 0 means use default
     uint32_t                     period_num;    ///< number of period_ms. total cache size for ao is (period_num * period_ms * (rate / 1000) * 2 * (16/8)). 0 means use default
+    uint32_t                     pkt_num;       ///< number of packets queued between demux and decode
+    uint32_t                     frame_num;     ///< number of frames queued between decode and output
     uint32_t                     resample_rate; ///< none zereo means need to resample
     uint8_t                      vol_en;        ///< soft vol scale enable
     uint8_t                      vol_index;     ///< soft vol scale index (0~255)
@@ -70,6 +130,31 @@ struct player_cb {
     aos_mutex_t                  lock;
     uint32_t                     rcv_timeout;
 
+    /* demux stage -> pkt -> decode(player task) -> frame -> output stage.
+     * a stage with a zero stack size runs in the player task, see CONFIG_PLAYER_DEMUX_TASK_STACK_SIZE */
+    ply_pkt_t                    *pkts;
+    ply_frame_t                  *frames;
+    ply_queue_t                  pkt_idle;
+    ply_queue_t                  pkt_ready;
+    ply_queue_t                  frame_idle;
+    ply_queue_t                  frame_ready;
+    ply_demux_stage_t            dmx;
+    ply_output_stage_t           out;
+    uint32_t                     pipe_tasks;    ///< quit events of the running stage tasks
+    uint8_t                      pipe_quit;
+    int                          out_rc;
+    uint32_t                     gen;           ///< bumped by a seek, older packets and frames are dropped
+    uint64_t                     seek_time;
+    int                          seek_rc;
+    sf_t                         ao_sf;
+
+    /* gapless: the demux task switches to the next track at the end of the current one */
+    aos_mutex_t                  next_lock;
+    ply_track_t                  *next;         ///< set by player_set_next
+    ply_track_t                  *pending;      ///< list of the tracks switched in the demux, not output yet
+    uint8_t                      next_busy;     ///< the next task is opening the next track
+    uint8_t                      demux_end;     ///< the end of the stream or an error is queued, too late for the next
+
     struct {
         uint32_t  ao_write_size;
         uint32_t  run_loop;
@@ -97,7 +182,15 @@ static void _player_inner_init(player_t *player)
     player->before_status = PLAYER_STATUS_STOPED;
     player->evt_status    = PLAYER_EVENT_UNKNOWN;
 
-    aos_event_set(&player->evt, ~PLAYER_TASK_QUIT_EVT, AOS_EVENT_AND);
+    player->pipe_quit     = 0;
+    player->out_rc        = 0;
+    player->gen           = 0;
+    player->next          = NULL;
+    player->pending       = NULL;
+    player->next_busy     = 0;
+    player->demux_end     = 0;
+
+    aos_event_set(&player->evt, 0, AOS_EVENT_AND);
     memset(&player->stat, 0, sizeof(player->stat));
 }
 
@@ -144,6 +237,8 @@ int player_conf_init(ply_conf_t *ply_cnf)
     ply_cnf->cache_start_threshold = CONFIG_AV_STREAM_CACHE_THRESHOLD_DEFAULT;
     ply_cnf->period_ms             = AO_ONE_PERIOD_MS;
     ply_cnf->period_num            = AO_TOTAL_PERIOD_NUM;
+    ply_cnf->pkt_num               = CONFIG_PLAYER_PKT_NUM_DEFAULT;
+    ply_cnf->frame_num             = CONFIG_PLAYER_FRAME_NUM_DEFAULT;
 
     return 0;
 }
@@ -194,8 +289,11 @@ player_t* player_new(const ply_conf_t *ply_cnf)
     player->cache_start_threshold = ply_cnf->cache_start_threshold ? ply_cnf->cache_start_threshold : CONFIG_AV_STREAM_CACHE_THRESHOLD_DEFAULT;
     player->period_ms             = ply_cnf->period_ms ? ply_cnf->period_ms : AO_ONE_PERIOD_MS;
     player->period_num            = ply_cnf->period_num ? ply_cnf->period_num : AO_TOTAL_PERIOD_NUM;
+    player->pkt_num               = ply_cnf->pkt_num ? ply_cnf->pkt_num : CONFIG_PLAYER_PKT_NUM_DEFAULT;
+    player->frame_num             = ply_cnf->frame_num ? ply_cnf->frame_num : CONFIG_PLAYER_FRAME_NUM_DEFAULT;
     aos_event_new(&player->evt, 0);
     aos_mutex_new(&player->lock);
+    aos_mutex_new(&player->next_lock);
     _player_inner_init(player);
 
     LOGI(TAG, "%s, %d leave. player = %p", __FUNCTION__, __LINE__, player);
@@ -309,7 +407,7 @@ static int _interrupt(void *arg)
 {
     player_t *player = arg;
 
-    return player->need_quit;
+    return player->need_quit || player->pipe_quit;
 }
 
 static ao_cls_t* _player_ao_new(player_t *player, sf_t ao_sf)
@@ -380,16 +478,14 @@ static void _stream_event(void *opaque, uint8_t event, const void *data, uint32_
     }
 }
 
-static int _player_prepare(player_t *player)
+static int _player_track_open(player_t *player, ply_track_t *track, uint64_t start_time)
 {
     int rc;
-    sf_t sf;
     ad_conf_t ad_cnf;
     stm_conf_t stm_cnf;
     stream_cls_t  *s       = NULL;
     demux_cls_t   *demuxer = NULL;
     ad_cls_t      *ad      = NULL;
-    ao_cls_t      *ao      = NULL;
 
     stream_conf_init(&stm_cnf);
     stm_cnf.rcv_timeout           = player->rcv_timeout;
@@ -400,13 +496,12 @@ static int _player_prepare(player_t *player)
     stm_cnf.irq.handler           = _interrupt;
     stm_cnf.opaque                = player;
     stm_cnf.stream_event_cb       = _stream_event;
-    s = stream_open(player->url, &stm_cnf);
+    s = stream_open(track->url, &stm_cnf);
     CHECK_RET_TAG_WITH_GOTO(s, err);
-    player->speed = stream_is_live(s) ? 1 : player->speed;
     demuxer = demux_open(s);
     CHECK_RET_TAG_WITH_GOTO(demuxer, err);
-    if (player->start_time) {
-        rc = demux_seek(demuxer, player->start_time);
+    if (start_time) {
+        rc = demux_seek(demuxer, start_time);
         CHECK_RET_TAG_WITH_GOTO(rc == 0, err);
     }
 
@@ -420,40 +515,530 @@ static int _player_prepare(player_t *player)
     CHECK_RET_TAG_WITH_GOTO(ad, err);
 
     /* FIXME: sf of the demuxer may be inaccurate */
-    sf = ad->ash.sf ? ad->ash.sf : demuxer->ash.sf;
+    track->sf      = ad->ash.sf ? ad->ash.sf : demuxer->ash.sf;
+    track->s       = s;
+    track->demuxer = demuxer;
+    track->ad      = ad;
+
+    return 0;
+err:
+    ad_close(ad);
+    demux_close(demuxer);
+    stream_close(s);
+    return -1;
+}
+
+static void _player_track_close(ply_track_t *track)
+{
+    if (track->ad) {
+        ad_close(track->ad);
+        track->ad = NULL;
+    }
+    if (track->demuxer) {
+        demux_close(track->demuxer);
+        track->demuxer = NULL;
+    }
+    if (track->s) {
+        stream_close(track->s);
+        track->s = NULL;
+    }
+}
+
+static int _player_prepare(player_t *player)
+{
+    int rc;
+    ply_track_t track;
+    ao_cls_t *ao = NULL;
+
+    memset(&track, 0, sizeof(ply_track_t));
+    track.url = player->url;
+    rc = _player_track_open(player, &track, player->start_time);
+    CHECK_RET_TAG_WITH_RET(rc == 0, -1);
+    player->speed = stream_is_live(track.s) ? 1 : player->speed;
 
-    ao = _player_ao_new(player, sf);
+    ao = _player_ao_new(player, track.sf);
     CHECK_RET_TAG_WITH_GOTO(ao, err);
     rc = ao_start(ao);
     CHECK_RET_TAG_WITH_GOTO(rc == 0, err);
 
-    player->s       = s;
-    player->demuxer = demuxer;
-    player->ad      = ad;
+    player->s       = track.s;
+    player->demuxer = track.demuxer;
+    player->ad      = track.ad;
     player->ao      = ao;
+    player->ao_sf   = track.sf;
 
     return 0;
 err:
     ao_close(ao);
-    ad_close(ad);
-    demux_close(demuxer);
-    stream_close(s);
+    _player_track_close(&track);
     return -1;
 }
 
+/**
+ * @brief  install the track switched to, called by the output task with the player lock
+ * @param  [in] player
+ * @param  [in] track : head of the pending list
+ * @return 0/-1
+ */
+static int _player_track_switch(player_t *player, ply_track_t *track)
+{
+    int rc = 0;
+
+    aos_mutex_lock(&player->next_lock, AOS_WAIT_FOREVER);
+    player->pending = track->next;
+    aos_mutex_unlock(&player->next_lock);
+
+    /* the demux and decode stages have gone on with the new track already */
+    ad_close(player->ad);
+    demux_close(player->demuxer);
+    stream_close(player->s);
+    aos_free(player->url);
+    player->s       = track->s;
+    player->demuxer = track->demuxer;
+    player->ad      = track->ad;
+    player->url     = track->url;
+    player->cur_pts = 0;
+
+    if (track->sf != player->ao_sf) {
+        LOGI(TAG, "sf changed, reopen the ao. %s", sf_get_format_str(track->sf));
+        ao_drain(player->ao);
+        ao_stop(player->ao);
+        ao_close(player->ao);
+        player->ao = _player_ao_new(player, track->sf);
+        if (!(player->ao && ao_start(player->ao) == 0)) {
+            LOGE(TAG, "ao open fail for the next track");
+            AV_ERRNO_SET(AV_ERRNO_OUTPUT_FAILD);
+            rc = -1;
+        }
+        player->ao_sf = track->sf;
+    }
+    aos_free(track);
+
+    return rc;
+}
+
+/* open the next track while the current one plays */
+static void _next_task(void *arg)
+{
+    player_t *player   = arg;
+    ply_track_t *track = player->next;
+
+    if (_player_track_open(player, track, 0) < 0) {
+        LOGE(TAG, "open the next track fail, url = %s", track->url);
+    }
+    aos_event_set(&player->evt, PLAYER_NEXT_QUIT_EVT, AOS_EVENT_OR);
+}
+
+/**
+ * @brief  called by the demux task at the end of the current track
+ * @param  [in] player
+ * @return the next track opened, NULL if none
+ */
+static ply_track_t* _player_next_take(player_t *player)
+{
+    unsigned int flag;
+    ply_track_t *track, **pp;
+
+    aos_mutex_lock(&player->next_lock, AOS_WAIT_FOREVER);
+    if (player->next_busy) {
+        aos_mutex_unlock(&player->next_lock);
+        aos_event_get(&player->evt, PLAYER_NEXT_QUIT_EVT, AOS_EVENT_OR, &flag, AOS_WAIT_FOREVER);
+        aos_mutex_lock(&player->next_lock, AOS_WAIT_FOREVER);
+        player->next_busy = 0;
+    }
+
+    track        = player->next;
+    player->next = NULL;
+    if (track && !track->s) {
+        aos_free(track->url);
+        aos_freep((char**)&track);
+    }
+    if (track) {
+        for (pp = &player->pending; *pp; pp = &(*pp)->next);
+        *pp = track;
+    } else {
+        player->demux_end = 1;
+    }
+    aos_mutex_unlock(&player->next_lock);
+
+    return track;
+}
+
+static int _queue_init(ply_queue_t *q, uint32_t num)
+{
+    int rc;
+
+    q->item = aos_zalloc(sizeof(void*) * num);
+    CHECK_RET_TAG_WITH_RET(q->item, -1);
+    rc = aos_sem_new(&q->sem, 0);
+    if (rc != 0) {
+        aos_freep((char**)&q->item);
+        return -1;
+    }
+    q->num = num;
+    q->rd  = 0;
+    q->wr  = 0;
+
+    return 0;
+}
+
+static void _queue_deinit(ply_queue_t *q)
+{
+    if (q->item) {
+        aos_sem_free(&q->sem);
+        aos_freep((char**)&q->item);
+    }
+}
+
+static void _queue_put(ply_queue_t *q, void *item)
+{
+    q->item[q->wr] = item;
+    q->wr = (q->wr + 1) % q->num;
+    aos_sem_signal(&q->sem);
+}
+
+static void* _queue_get(ply_queue_t *q, unsigned int ms)
+{
+    void *item;
+
+    if (aos_sem_wait(&q->sem, ms) != 0) {
+        return NULL;
+    }
+    item  = q->item[q->rd];
+    q->rd = (q->rd + 1) % q->num;
+
+    return item;
+}
+
+/**
+ * @brief  demux stage: owns the demuxer, reads one packet ahead and does the seek
+ * @param  [in] player
+ * @param  [in] ms : time to wait for a free packet, or for a seek once the end is queued
+ * @return 1 if the stage did some work, 0 if idle
+ */
+static int _demux_step(player_t *player, unsigned int ms)
+{
+    ply_demux_stage_t *st = &player->dmx;
+    ply_pkt_t *ppkt;
+    ply_track_t *track;
+    unsigned int flag;
+    int rc, busy = 0;
+
+    /* wait here for a seek once the end of the stream is queued */
+    rc = aos_event_get(&player->evt, PLAYER_SEEK_REQ_EVT, AOS_EVENT_OR_CLEAR, &flag,
+                       st->end ? ms : AOS_NO_WAIT);
+    if (rc == 0) {
+        aos_mutex_lock(&player->next_lock, AOS_WAIT_FOREVER);
+        /* the track heard is not the one read after a switch, refuse it for a moment */
+        rc = player->pending ? -1 : demux_seek(st->demuxer, player->seek_time);
+        if (rc == 0) {
+            player->gen++;
+            player->demux_end = 0;
+            st->end = 0;
+        }
+        aos_mutex_unlock(&player->next_lock);
+        player->seek_rc = rc;
+        aos_event_set(&player->evt, PLAYER_SEEK_DONE_EVT, AOS_EVENT_OR);
+        busy = 1;
+    }
+    if (st->end) {
+        return busy;
+    }
+
+    if (!st->ppkt) {
+        st->ppkt = _queue_get(&player->pkt_idle, ms);
+        if (!st->ppkt) {
+            return busy;
+        }
+    }
+
+    ppkt = st->ppkt;
+    rc   = demux_read_packet(st->demuxer, &ppkt->pkt);
+    if (rc < 0) {
+        LOGE(TAG, "read packet fail, rc = %d", rc);
+        /* the stream is over, a next track set from now on would never be heard */
+        aos_mutex_lock(&player->next_lock, AOS_WAIT_FOREVER);
+        player->demux_end = 1;
+        aos_mutex_unlock(&player->next_lock);
+    }
+    track = (rc == 0) ? _player_next_take(player) : NULL;
+    if (track) {
+        /* gapless, the stream goes on with the next track */
+        LOGI(TAG, "switch to the next track, url = %s", track->url);
+        st->demuxer = track->demuxer;
+    }
+    ppkt->eos   = rc < 0 ? -1 : (rc == 0 && !track ? 1 : 0);
+    ppkt->gen   = player->gen;
+    ppkt->track = track;
+    st->end     = ppkt->eos;
+    st->ppkt    = NULL;
+    _queue_put(&player->pkt_ready, ppkt);
+
+    return 1;
+}
+
+static void _demux_task(void *arg)
+{
+    player_t *player = arg;
+
+    while (!(player->need_quit || player->pipe_quit)) {
+        _demux_step(player, PLAYER_QUEUE_WAIT_MS);
+    }
+
+    LOGD(TAG, "demux task quit");
+    aos_event_set(&player->evt, PLAYER_DEMUX_QUIT_EVT, AOS_EVENT_OR);
+}
+
+/**
+ * @brief  output stage: writes one frame to the ao, the only stage which holds the player lock
+ * @param  [in] player
+ * @param  [in] ms : time to wait for a frame or for the player lock
+ * @return 1 if the stage did some work, 0 if idle
+ */
+static int _output_step(player_t *player, unsigned int ms)
+{
+    ply_output_stage_t *st = &player->out;
+    ply_frame_t *pf;
+    uint8_t next_start = 0;
+    int rc = 0;
+
+    if (st->done) {
+        return 0;
+    }
+    if (!st->pf) {
+        st->pf = _queue_get(&player->frame_ready, ms);
+        if (!st->pf) {
+            return 0;
+        }
+    }
+
+    /* not forever: in the player task the lock may be held by a seek waiting for this task */
+    if (aos_mutex_lock(&player->lock, ms) != 0) {
+        return 0;
+    }
+    pf = st->pf;
+    player->stat.run_loop++;
+    if (pf->gen != player->gen) {
+        /* decoded before a seek, drop it */
+    } else if (player->status != PLAYER_STATUS_PLAYING) {
+        /* paused, keep the frame */
+        player_unlock();
+        if (ms != AOS_NO_WAIT) {
+            aos_msleep(ms);
+        }
+        return 0;
+    } else if (pf->eos) {
+        rc       = pf->eos < 0 ? -1 : 0;
+        st->done = 1;
+    } else if (pf->track) {
+        rc         = _player_track_switch(player, pf->track);
+        st->done   = rc < 0;
+        next_start = rc == 0;
+        pf->track  = NULL;
+    } else {
+        player->cur_pts = pf->pts;
+        rc = ao_write(player->ao, pf->frame->data[0] + pf->offset, pf->size);
+        if (rc >= 0) {
+            player->stat.ao_write_size += rc;
+            player->stat.run_loop_valid++;
+            if (st->play_first == 1) {
+                st->play_first = 0;
+                LOGI(TAG, "first frame output");
+            }
+            rc = 0;
+        } else {
+            LOGE(TAG, "ao write fail, rc = %d, pcm_size = %u", rc, pf->size);
+            AV_ERRNO_SET(AV_ERRNO_OUTPUT_FAILD);
+            st->done = 1;
+        }
+    }
+    player_unlock();
+
+    if (next_start) {
+        EVENT_CALL(player, PLAYER_EVENT_NEXT_START, NULL, 0);
+    }
+    st->pf = NULL;
+    _queue_put(&player->frame_idle, pf);
+    if (st->done) {
+        player->out_rc = rc;
+    }
+
+    return 1;
+}
+
+static void _output_task(void *arg)
+{
+    player_t *player = arg;
+
+    while (!(player->need_quit || player->pipe_quit || player->out.done)) {
+        _output_step(player, PLAYER_QUEUE_WAIT_MS);
+    }
+
+    LOGD(TAG, "output task quit");
+    aos_event_set(&player->evt, PLAYER_OUTPUT_QUIT_EVT, AOS_EVENT_OR);
+}
+
+static int _player_pipe_start(player_t *player)
+{
+    int i, rc;
+    aos_task_t task;
+
+    player->pkts   = aos_zalloc(sizeof(ply_pkt_t) * player->pkt_num);
+    player->frames = aos_zalloc(sizeof(ply_frame_t) * player->frame_num);
+    CHECK_RET_TAG_WITH_RET(player->pkts && player->frames, -1);
+
+    rc = _queue_init(&player->pkt_idle, player->pkt_num);
+    CHECK_RET_TAG_WITH_RET(rc == 0, -1);
+    rc = _queue_init(&player->pkt_ready, player->pkt_num);
+    CHECK_RET_TAG_WITH_RET(rc == 0, -1);
+    rc = _queue_init(&player->frame_idle, player->frame_num);
+    CHECK_RET_TAG_WITH_RET(rc == 0, -1);
+    rc = _queue_init(&player->frame_ready, player->frame_num);
+    CHECK_RET_TAG_WITH_RET(rc == 0, -1);
+
+    for (i = 0; i < player->pkt_num; i++) {
+        avpacket_init(&player->pkts[i].pkt);
+        _queue_put(&player->pkt_idle, &player->pkts[i]);
+    }
+    for (i = 0; i < player->frame_num; i++) {
+        player->frames[i].frame = avframe_alloc();
+        CHECK_RET_TAG_WITH_RET(player->frames[i].frame, -1);
+        _queue_put(&player->frame_idle, &player->frames[i]);
+    }
+
+    memset(&player->dmx, 0, sizeof(player->dmx));
+    memset(&player->out, 0, sizeof(player->out));
+    player->dmx.demuxer    = player->demuxer;
+    player->out.play_first = 1;
+
+    if (CONFIG_PLAYER_DEMUX_TASK_STACK_SIZE) {
+        rc = aos_task_new_ext(&task, "player_demux", _demux_task, (void *)player,
+                              CONFIG_PLAYER_DEMUX_TASK_STACK_SIZE, AOS_DEFAULT_APP_PRI - 2);
+        if (rc != 0) {
+            LOGE(TAG, "player_demux create faild, may be oom, rc = %d", rc);
+            AV_ERRNO_SET(AV_ERRNO_OOM);
+            return -1;
+        }
+        player->pipe_tasks |= PLAYER_DEMUX_QUIT_EVT;
+    }
+
+    if (CONFIG_PLAYER_OUTPUT_TASK_STACK_SIZE) {
+        /* the sink runs above the decoder so a busy decode can't starve it */
+        rc = aos_task_new_ext(&task, "player_output", _output_task, (void *)player,
+                              CONFIG_PLAYER_OUTPUT_TASK_STACK_SIZE, AOS_DEFAULT_APP_PRI - 3);
+        if (rc != 0) {
+            LOGE(TAG, "player_output create faild, may be oom, rc = %d", rc);
+            AV_ERRNO_SET(AV_ERRNO_OOM);
+            return -1;
+        }
+        player->pipe_tasks |= PLAYER_OUTPUT_QUIT_EVT;
+    }
+
+    return 0;
+}
+
+static void _player_pipe_stop(player_t *player)
+{
+    int i;
+    unsigned int flag;
+    ply_track_t *track;
+
+    player->pipe_quit = 1;
+    aos_mutex_lock(&player->next_lock, AOS_WAIT_FOREVER);
+    player->demux_end = 1;
+    aos_mutex_unlock(&player->next_lock);
+    if (player->next_busy) {
+        aos_event_get(&player->evt, PLAYER_NEXT_QUIT_EVT, AOS_EVENT_OR, &flag, AOS_WAIT_FOREVER);
+        player->next_busy = 0;
+    }
+    if (player->pipe_tasks) {
+        aos_event_get(&player->evt, player->pipe_tasks, AOS_EVENT_AND, &flag, AOS_WAIT_FOREVER);
+        player->pipe_tasks = 0;
+    }
+    /* a seek waits on it, also when the demux stage ran in the player task */
+    aos_event_set(&player->evt, PLAYER_DEMUX_QUIT_EVT, AOS_EVENT_OR);
+
+    /* the next tracks never heard */
+    if (player->next) {
+        player->next->next = player->pending;
+        player->pending    = player->next;
+        player->next       = NULL;
+    }
+    while (player->pending) {
+        track           = player->pending;
+        player->pending = track->next;
+        _player_track_close(track);
+        aos_free(track->url);
+        aos_free(track);
+    }
+
+    if (player->pkts) {
+        for (i = 0; i < player->pkt_num; i++) {
+            avpacket_free(&player->pkts[i].pkt);
+        }
+        aos_freep((char**)&player->pkts);
+    }
+    if (player->frames) {
+        for (i = 0; i < player->frame_num; i++) {
+            avframe_free(&player->frames[i].frame);
+        }
+        aos_freep((char**)&player->frames);
+    }
+    _queue_deinit(&player->pkt_idle);
+    _queue_deinit(&player->pkt_ready);
+    _queue_deinit(&player->frame_idle);
+    _queue_deinit(&player->frame_ready);
+}
+
+/**
+ * @brief  drop the encoder/decoder delay and the padding of the track, for gapless
+ * @param  [in] pf
+ * @param  [in/out] pos    : samples decoded from the begin of the track
+ * @param  [in] skip       : samples of the delay
+ * @param  [in] nb_samples : valid samples of the track, 0 if unknown
+ * @return bytes to output
+ */
+static size_t _frame_trim(ply_frame_t *pf, int64_t *pos, uint32_t skip, uint64_t nb_samples)
+{
+    int64_t first, last, start = *pos;
+    avframe_t *frame = pf->frame;
+    size_t fsize     = sf_get_frame_size(frame->sf);
+
+    pf->offset = 0;
+    pf->size   = frame->linesize[0];
+    if (!(skip || nb_samples) || frame->nb_samples <= 0 || fsize == 0) {
+        return pf->size;
+    }
+
+    *pos  = start + frame->nb_samples;
+    first = MAX(start, skip);
+    last  = nb_samples ? MIN(*pos, (int64_t)(skip + nb_samples)) : *pos;
+    if (first >= last || (first - start) * fsize >= frame->linesize[0]) {
+        pf->size = 0;
+    } else {
+        pf->offset = (first - start) * fsize;
+        pf->size   = MIN((last - first) * fsize, frame->linesize[0] - pf->offset);
+    }
+
+    return pf->size;
+}
+
+/**
+ * @brief  decode stage, also prepares and tears down the pipeline
+ * @param  [in] arg : player
+ */
 static void _ptask(void *arg)
 {
-    avpacket_t pkt;
-    uint8_t play_first = 1;
-    avframe_t *dframe;
     ad_cls_t *ad;
-    demux_cls_t *demuxer;
     player_t *player = arg;
-    int rc = -1, got_frame = 0;
-
-    avpacket_init(&pkt);
-    dframe = avframe_alloc();
-    CHECK_RET_TAG_WITH_GOTO(dframe, quit);
+    ply_pkt_t *ppkt  = NULL;
+    ply_frame_t *pf  = NULL;
+    unsigned int flag;
+    uint32_t gen = 0, skip;
+    uint64_t nb_samples;
+    int64_t pts = 0, pos = 0;
+    unsigned int wait;
+    int rc = -1, got_frame = 0, end = 0, drained = 0, busy;
 
     /* FIXME: prepare may be block too long */
     rc = _player_prepare(player);
@@ -461,6 +1046,12 @@ static void _ptask(void *arg)
         goto quit;
     }
 
+    /* the demux task starts reading ahead while the player is still preparing */
+    rc = _player_pipe_start(player);
+    if (rc < 0) {
+        goto quit;
+    }
+
 loop:
     player_lock();
     if (player->status == PLAYER_STATUS_PREPARING) {
@@ -477,69 +1068,126 @@ loop:
         goto quit;
     }
 
-    ad      = player->ad;
-    demuxer = player->demuxer;
+    ad = player->ad;
+    /* the delay and padding are trimmed only when the track plays from the begin */
+    skip       = player->start_time ? 0 : player->demuxer->skip_samples;
+    nb_samples = player->start_time ? 0 : player->demuxer->nb_samples;
     EVENT_CALL(player, PLAYER_EVENT_START, NULL, 0);
 
+    /* a stage run here must not be held up by a wait on the others */
+    wait = (player->pipe_tasks == (PLAYER_DEMUX_QUIT_EVT | PLAYER_OUTPUT_QUIT_EVT)) ? PLAYER_QUEUE_WAIT_MS : AOS_NO_WAIT;
     for (;;) {
-        player->stat.run_loop++;
-        if (PLAYER_STATUS_PAUSED == player->status) {
-            aos_msleep(200);
-            continue;
-        } else if (PLAYER_STATUS_STOPED == player->status) {
+        if (player->need_quit || PLAYER_STATUS_STOPED == player->status) {
             break;
         }
 
-        if (!pkt.len) {
-            rc = demux_read_packet(demuxer, &pkt);
-            if (rc < 0) {
-                LOGE(TAG, "read packet fail, rc = %d", rc);
-                goto quit;
-            } else if (rc == 0) {
+        busy = 0;
+        if (!(player->pipe_tasks & PLAYER_DEMUX_QUIT_EVT)) {
+            busy |= _demux_step(player, AOS_NO_WAIT);
+        }
+        if (!(player->pipe_tasks & PLAYER_OUTPUT_QUIT_EVT)) {
+            busy |= _output_step(player, AOS_NO_WAIT);
+            if (player->out.done) {
                 break;
             }
-            player->cur_pts = pkt.pts;
+        } else if (aos_event_get(&player->evt, PLAYER_OUTPUT_QUIT_EVT, AOS_EVENT_OR, &flag, AOS_NO_WAIT) == 0) {
+            /* the output task quits on the end of the stream or on error */
+            break;
         }
 
-        player_lock();
-        if (player->status == PLAYER_STATUS_PLAYING) {
-            rc = ad_decode(ad, dframe, &got_frame, &pkt);
-            if (rc <= 0) {
-                LOGE(TAG, "ad decode fail, rc = %d", rc);
-                AV_ERRNO_SET(AV_ERRNO_DECODE_FAILD);
-                player_unlock();
-                goto quit;
+        if (!ppkt) {
+            ppkt = _queue_get(&player->pkt_ready, wait);
+            if (!ppkt) {
+                if (wait == AOS_NO_WAIT && !busy) {
+                    aos_msleep(PLAYER_INLINE_IDLE_MS);
+                }
+                continue;
             }
-            pkt.len = 0;
-            if (!got_frame) {
-                player_unlock();
+        }
+        if (ppkt->gen != player->gen || (end && ppkt->gen == gen)) {
+            /* read before a seek, or after the end/error already sent */
+            _queue_put(&player->pkt_idle, ppkt);
+            ppkt    = NULL;
+            drained = 0;
+            continue;
+        }
+
+        if (!pf) {
+            pf = _queue_get(&player->frame_idle, wait);
+            if (!pf) {
+                if (wait == AOS_NO_WAIT && !busy) {
+                    aos_msleep(PLAYER_INLINE_IDLE_MS);
+                }
                 continue;
             }
+        }
+
+        if (ppkt->gen != gen) {
+            ad_reset(ad);
+            gen        = ppkt->gen;
+            end        = 0;
+            skip       = 0;
+            nb_samples = 0;
+        }
 
-            rc = ao_write(player->ao, dframe->data[0], dframe->linesize[0]);
-            if (rc >= 0) {
-                player->stat.ao_write_size += rc;
-                player->stat.run_loop_valid++;
-                if (play_first == 1) {
-                    play_first = 0;
-                    LOGI(TAG, "first frame output");
+        if ((ppkt->eos > 0 || ppkt->track) && !drained) {
+            /* the frames still held by the decoder go out before the end or the next track */
+            rc = ad_flush(ad, pf->frame, &got_frame);
+            if (rc == 0 && got_frame) {
+                if (_frame_trim(pf, &pos, skip, nb_samples) > 0) {
+                    pf->eos   = 0;
+                    pf->track = NULL;
+                    pf->gen   = gen;
+                    pf->pts   = pts;
+                    _queue_put(&player->frame_ready, pf);
+                    pf = NULL;
                 }
-                player_unlock();
-            } else {
-                LOGE(TAG, "ao write fail, rc = %d, pcm_size = %d", rc, dframe->linesize[0]);
-                AV_ERRNO_SET(AV_ERRNO_OUTPUT_FAILD);
-                player_unlock();
-                goto quit;
+                continue;
             }
-        } else {
-            player_unlock();
+            if (rc < 0) {
+                LOGE(TAG, "ad flush fail, rc = %d", rc);
+                AV_ERRNO_SET(AV_ERRNO_DECODE_FAILD);
+            }
+            drained = rc < 0 ? -1 : 1;
+        }
+
+        got_frame = 0;
+        pts       = ppkt->pkt.pts;
+        pf->eos   = drained < 0 ? -1 : ppkt->eos;
+        pf->track = drained < 0 ? NULL : ppkt->track;
+        if (pf->track) {
+            /* the next track, the old decoder is closed by the output task */
+            ad         = pf->track->ad;
+            skip       = pf->track->demuxer->skip_samples;
+            nb_samples = pf->track->demuxer->nb_samples;
+            pos        = 0;
+        } else if (!pf->eos) {
+            rc = ad_decode(ad, pf->frame, &got_frame, &ppkt->pkt);
+            if (rc <= 0) {
+                LOGE(TAG, "ad decode fail, rc = %d", rc);
+                AV_ERRNO_SET(AV_ERRNO_DECODE_FAILD);
+                pf->eos = -1;
+            } else if (got_frame) {
+                got_frame = _frame_trim(pf, &pos, skip, nb_samples) > 0;
+            }
+        }
+        _queue_put(&player->pkt_idle, ppkt);
+        ppkt    = NULL;
+        drained = 0;
+
+        if (pf->eos || pf->track || got_frame) {
+            end     = pf->eos;
+            pf->gen = gen;
+            pf->pts = pts;
+            _queue_put(&player->frame_ready, pf);
+            pf = NULL;
         }
     }
     rc = 0;
 quit:
     LOGD(TAG, "cb run task quit");
-    avpacket_free(&pkt);
-    avframe_free(&dframe);
+    _player_pipe_stop(player);
+    rc = rc < 0 ? rc : player->out_rc;
     aos_event_set(&player->evt, PLAYER_TASK_QUIT_EVT, AOS_EVENT_OR);
     if ((player->status != PLAYER_STATUS_STOPED) && (player->need_quit != 1)) {
         player->evt_status = (rc < 0) ? PLAYER_EVENT_ERROR : PLAYER_EVENT_FINISH;
@@ -591,6 +1239,60 @@ quit:
     return rc;
 }
 
+/**
+ * @brief  set the url played right after the current one, without a gap
+ * @param  [in] player
+ * @param  [in] url : the next url
+ * @return 0/-1
+ */
+int player_set_next(player_t *player, const char *url)
+{
+    int rc = -1;
+    aos_task_t task;
+    ply_track_t *track = NULL;
+
+    if (!(player && url && strlen(url))) {
+        LOGE(TAG, "param err, %s", __FUNCTION__);
+        return -1;
+    }
+
+    aos_mutex_lock(&player->lock, AOS_WAIT_FOREVER);
+    aos_mutex_lock(&player->next_lock, AOS_WAIT_FOREVER);
+    LOGI(TAG, "%s, %d enter. player = %p", __FUNCTION__, __LINE__, player);
+    if (player->status == PLAYER_STATUS_STOPED || player->demux_end || player->next) {
+        LOGE(TAG, "the player: %p is stopped, at the end or the next is set already!", player);
+        goto quit;
+    }
+
+    track = aos_zalloc(sizeof(ply_track_t));
+    CHECK_RET_TAG_WITH_GOTO(track, quit);
+    track->url = strdup(url);
+    CHECK_RET_TAG_WITH_GOTO(track->url, quit);
+
+    aos_event_set(&player->evt, ~PLAYER_NEXT_QUIT_EVT, AOS_EVENT_AND);
+    player->next      = track;
+    player->next_busy = 1;
+    rc = aos_task_new_ext(&task, "player_next", _next_task, (void *)player, CONFIG_PLAYER_NEXT_TASK_STACK_SIZE, AOS_DEFAULT_APP_PRI);
+    if (rc != 0) {
+        player->next      = NULL;
+        player->next_busy = 0;
+        LOGE(TAG, "player_next create faild, may be oom, rc = %d", rc);
+        AV_ERRNO_SET(AV_ERRNO_OOM);
+        goto quit;
+    }
+    track = NULL;
+
+quit:
+    if (track) {
+        aos_free(track->url);
+        aos_free(track);
+    }
+    LOGI(TAG, "%s, %d leave. player = %p", __FUNCTION__, __LINE__, player);
+    aos_mutex_unlock(&player->next_lock);
+    aos_mutex_unlock(&player->lock);
+    return rc;
+}
+
 /**
  * @brief  pause the player
  * @param  [in] player
@@ -728,6 +1430,7 @@ int player_free(player_t *player)
 
     aos_event_free(&player->evt);
     aos_mutex_free(&player->lock);
+    aos_mutex_free(&player->next_lock);
     aos_free(player->ao_name);
     aos_free(player->aef_conf);
     aos_free(player);
@@ -745,19 +1448,22 @@ int player_free(player_t *player)
 int player_seek(player_t *player, uint64_t timestamp)
 {
     int rc = -1;
-    demux_cls_t *demuxer;
 
     CHECK_PARAM(player, -1);
     aos_mutex_lock(&player->lock, AOS_WAIT_FOREVER);
     LOGI(TAG, "%s, %d enter. player = %p, timestamp = %llu", __FUNCTION__, __LINE__, player, timestamp);
-    demuxer = player->demuxer;
     if (player->status == PLAYER_STATUS_PLAYING
         || (player->status == PLAYER_STATUS_PAUSED && player->before_status != PLAYER_STATUS_PREPARING)) {
+        unsigned int flag;
+
+        /* the demuxer belongs to the demux task. what was queued before
+         * the seek is dropped by the decode and output stages */
         ao_stop(player->ao);
-        rc = demux_seek(demuxer, timestamp);
-        if (rc == 0) {
-            ad_reset(player->ad);
-        }
+        player->seek_time = timestamp;
+        aos_event_set(&player->evt, PLAYER_SEEK_REQ_EVT, AOS_EVENT_OR);
+        aos_event_get(&player->evt, PLAYER_SEEK_DONE_EVT | PLAYER_DEMUX_QUIT_EVT, AOS_EVENT_OR, &flag, AOS_WAIT_FOREVER);
+        aos_event_set(&player->evt, ~(PLAYER_SEEK_REQ_EVT | PLAYER_SEEK_DONE_EVT), AOS_EVENT_AND);
+        rc = (flag & PLAYER_SEEK_DONE_EVT) ? player->seek_rc : -1;
         ao_start(player->ao);
     }
     LOGI(TAG, "%s, %d leave. player = %p", __FUNCTION__, __LINE__, player);
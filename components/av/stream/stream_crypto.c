@@ -11,29 +11,56 @@
 #include "mbedtls/debug.h"
 
 #define TAG                    "s_crypto"
-#define CRYPTO_BLOCK_NUM       (64)
 #define CRYPTO_BLOCK_SIZE      (16)
-#define CRYPTO_SIZE_DEFAULT    (CRYPTO_BLOCK_NUM * CRYPTO_BLOCK_SIZE)
+#define CRYPTO_FILL_MIN        (64 * CRYPTO_BLOCK_SIZE)     ///< first fill after a seek, doubled up to the buf size
 
+enum {
+    CRYPTO_MODE_CBC,
+    CRYPTO_MODE_CTR,           ///< random access, no chaining between the blocks
+};
+
+/*
+ * the ciphertext is read ahead into one aligned buffer and decrypted there in place,
+ * one crypto call per fill: [rpos, dpos) is plain text for the user, [dpos, len) is the
+ * partial block waiting for more ciphertext
+ */
 struct crypto_priv {
     stream_cls_t               *rs;                         ///< real stream
     mbedtls_aes_context        ctx;
+    uint8_t                    mode;
     uint8_t                    eof;
     uint8_t                    iv[16];                      ///< decrypt for the first 16B
-    uint8_t                    dec_iv[16];
-    uint16_t                   ilen;                        ///< total len of input data, contains decrypted
-    uint16_t                   ipos;                        ///< decrypted pos
-    uint16_t                   olen;                        ///< total valid len of obuf, contains readed data
-    uint16_t                   opos;                        ///< read pos by the user
-    uint8_t                    ibuf[CRYPTO_SIZE_DEFAULT];
-    uint8_t                    obuf[CRYPTO_SIZE_DEFAULT];
+    uint8_t                    dec_iv[16];                  ///< cbc: prev cipher block, ctr: counter
+    uint8_t                    ctr_block[16];
+    size_t                     ctr_off;
+    uint8_t                    *buf_orip;
+    uint8_t                    *buf;                        ///< aligned to the block
+    size_t                     bsize;
+    size_t                     fsize;                       ///< size of the next fill
+    size_t                     len;                         ///< valid len of the buf
+    size_t                     dpos;                        ///< decrypted pos
+    size_t                     rpos;                        ///< read pos by the user
+    size_t                     skip;                        ///< plain text to drop after a seek
 };
 
-// example: crypto://http://www.baidu.com/xx.mp3?key=111&iv=222
+/* iv + nb_blocks as a 128 bits big endian counter */
+static void _crypto_ctr_set(uint8_t counter[16], const uint8_t iv[16], uint32_t nb_blocks)
+{
+    int i;
+    uint32_t sum;
+
+    for (i = 15; i >= 0; i--) {
+        sum        = iv[i] + (nb_blocks & 0xff);
+        counter[i] = sum & 0xff;
+        nb_blocks  = (nb_blocks >> 8) + (sum >> 8);
+    }
+}
+
+// example: crypto://http://www.baidu.com/xx.mp3?key=111&iv=222[&mode=ctr]
 static int _stream_crypto_open(stream_cls_t *o, int mode)
 {
     uint8_t key[16];
-    char s_iv[32 + 1], s_key[32 + 1];
+    char s_iv[32 + 1], s_key[32 + 1], s_mode[8];
     stm_conf_t stm_cnf;
     stream_cls_t *rs         = NULL;
     struct crypto_priv *priv = NULL;
@@ -44,15 +71,31 @@ static int _stream_crypto_open(stream_cls_t *o, int mode)
 
     memset(&s_iv, 0, sizeof(s_iv));
     memset(&s_key, 0, sizeof(s_key));
+    memset(&s_mode, 0, sizeof(s_mode));
     url_get_item_value(o->url, "key", s_key, sizeof(s_key));
     CHECK_RET_TAG_WITH_GOTO(strlen(s_key), err);
     url_get_item_value(o->url, "iv", s_iv, sizeof(s_iv));
     CHECK_RET_TAG_WITH_GOTO(strlen(s_iv), err);
+    url_get_item_value(o->url, "mode", s_mode, sizeof(s_mode));
+    if (strcasecmp(s_mode, "ctr") == 0) {
+#if defined(MBEDTLS_CIPHER_MODE_CTR)
+        priv->mode = CRYPTO_MODE_CTR;
+#else
+        LOGE(TAG, "aes ctr is not enabled in the mbedtls");
+        goto err;
+#endif
+    }
 
     bytes_from_hex(s_key, key, sizeof(key));
     bytes_from_hex(s_iv, priv->iv, sizeof(priv->iv));
     memcpy(&priv->dec_iv, &priv->iv, sizeof(priv->iv));
 
+    priv->bsize    = AV_ALIGN_SIZE(CONFIG_AV_STREAM_CRYPTO_BUF_SIZE, CRYPTO_BLOCK_SIZE);
+    priv->buf_orip = aos_malloc(priv->bsize + CRYPTO_BLOCK_SIZE);
+    CHECK_RET_TAG_WITH_GOTO(priv->buf_orip, err);
+    priv->buf      = AV_ALIGN(priv->buf_orip, CRYPTO_BLOCK_SIZE);
+    priv->fsize    = priv->bsize;
+
     stream_conf_init(&stm_cnf);
     stm_cnf.rcv_timeout           = o->rcv_timeout;
     stm_cnf.get_dec_cb            = o->get_dec_cb;
@@ -63,7 +106,12 @@ static int _stream_crypto_open(stream_cls_t *o, int mode)
     CHECK_RET_TAG_WITH_GOTO(rs, err);
 
     mbedtls_aes_init(&priv->ctx);
-    mbedtls_aes_setkey_dec(&priv->ctx, key, sizeof(key) * 8);
+    /* ctr decrypts with the encrypt key */
+    if (priv->mode == CRYPTO_MODE_CTR) {
+        mbedtls_aes_setkey_enc(&priv->ctx, key, sizeof(key) * 8);
+    } else {
+        mbedtls_aes_setkey_dec(&priv->ctx, key, sizeof(key) * 8);
+    }
 
     priv->rs = rs;
     o->size  = stream_get_size(rs);
@@ -71,6 +119,7 @@ static int _stream_crypto_open(stream_cls_t *o, int mode)
 
     return 0;
 err:
+    aos_free(priv->buf_orip);
     aos_free(priv);
     return -1;
 }
@@ -84,62 +133,88 @@ static int _stream_crypto_close(stream_cls_t *o)
         priv->rs = NULL;
     }
 
+    mbedtls_aes_free(&priv->ctx);
+    aos_free(priv->buf_orip);
     aos_free(priv);
     o->priv = NULL;
     return 0;
 }
 
-static int _stream_crypto_read(stream_cls_t *o, uint8_t *buf, size_t count)
+/**
+ * @brief  read ahead as much ciphertext as the buf holds and decrypt it in place
+ * @return decrypted size, 0 on eof, -1 on err
+ */
+static int _crypto_fill(struct crypto_priv *priv)
 {
     int rc;
-    uint16_t remain, nb_blocks;
-    struct crypto_priv *priv = o->priv;
-    stream_cls_t *rs         = priv->rs;
+    size_t n;
 
-retry:
-    remain = priv->olen - priv->opos;
-    if (remain) {
-        rc = MIN(count, remain);
-        memcpy(buf, &priv->obuf[priv->opos], rc);
-        priv->opos += rc;
-        return rc;
-    } else {
-        priv->olen = 0;
-        priv->opos = 0;
+    n = priv->len - priv->dpos;
+    if (n && priv->dpos) {
+        memmove(priv->buf, &priv->buf[priv->dpos], n);
     }
-
-    while (priv->ilen - priv->ipos < CRYPTO_BLOCK_SIZE) {
-        rc = stream_read(rs, &priv->ibuf[priv->ilen], sizeof(priv->ibuf) - priv->ilen);
-        if (rc <= 0) {
+    priv->len  = n;
+    priv->dpos = 0;
+    priv->rpos = 0;
+    if (!priv->eof) {
+        rc = stream_read(priv->rs, &priv->buf[priv->len], priv->fsize - priv->len);
+        if (rc > 0) {
+            priv->len += rc;
+        }
+        if (rc < (int)(priv->fsize - n)) {
             priv->eof = 1;
-            break;
         }
-        priv->ilen += rc;
+        priv->fsize = MIN(priv->fsize * 2, priv->bsize);
     }
 
-    nb_blocks = (priv->ilen - priv->ipos) / CRYPTO_BLOCK_SIZE;
-    if (!nb_blocks) {
-        LOGD(TAG, "may be eof, ilen = %u, opos = %u", priv->ilen, priv->opos);
-        return 0;
+    n = priv->len / CRYPTO_BLOCK_SIZE * CRYPTO_BLOCK_SIZE;
+#if defined(MBEDTLS_CIPHER_MODE_CTR)
+    if (priv->mode == CRYPTO_MODE_CTR) {
+        /* ctr has no padding, the tail is valid */
+        n  = priv->eof ? priv->len : n;
+        rc = n ? mbedtls_aes_crypt_ctr(&priv->ctx, n, &priv->ctr_off, priv->dec_iv, priv->ctr_block,
+                                       priv->buf, priv->buf) : 0;
+    } else
+#endif
+    {
+        rc = n ? mbedtls_aes_crypt_cbc(&priv->ctx, MBEDTLS_AES_DECRYPT, n, priv->dec_iv,
+                                       priv->buf, priv->buf) : 0;
+    }
+    CHECK_RET_TAG_WITH_RET(rc == 0, -1);
+    if (!n) {
+        LOGD(TAG, "may be eof, len = %d", (int)priv->len);
     }
+    priv->dpos = n;
+
+    return n;
+}
+
+static int _stream_crypto_read(stream_cls_t *o, uint8_t *buf, size_t count)
+{
+    int rc;
+    size_t remain;
+    struct crypto_priv *priv = o->priv;
 
-    rc = mbedtls_aes_crypt_cbc(&priv->ctx, MBEDTLS_AES_DECRYPT, nb_blocks * CRYPTO_BLOCK_SIZE,
-                               priv->dec_iv, &priv->ibuf[priv->ipos], &priv->obuf[priv->olen]);
-    CHECK_RET_TAG_WITH_GOTO(rc == 0, err);
-    rc = nb_blocks * CRYPTO_BLOCK_SIZE;
-    priv->olen += rc;
-    priv->ipos += rc;
-    if (priv->ipos >= sizeof(priv->ibuf) / 2) {
-        priv->ilen -= rc;
-        if (priv->ilen) {
-            memmove(priv->ibuf, &priv->ibuf[priv->ipos], priv->ilen);
+    for (;;) {
+        remain = priv->dpos - priv->rpos;
+        if (remain && priv->skip) {
+            rc          = MIN(priv->skip, remain);
+            priv->rpos += rc;
+            priv->skip -= rc;
+            remain     -= rc;
+        }
+        if (remain) {
+            rc = MIN(count, remain);
+            memcpy(buf, &priv->buf[priv->rpos], rc);
+            priv->rpos += rc;
+            return rc;
         }
-        priv->ipos = 0;
-    }
 
-    goto retry;
-err:
-    return -1;
+        rc = _crypto_fill(priv);
+        if (rc <= 0) {
+            return rc;
+        }
+    }
 }
 
 static int _stream_crypto_write(stream_cls_t *o, const uint8_t *buf, size_t count)
@@ -150,42 +225,39 @@ static int _stream_crypto_write(stream_cls_t *o, const uint8_t *buf, size_t coun
 
 static int _stream_crypto_seek(stream_cls_t *o, int32_t pos)
 {
-    int rc = -1, diff;
-    uint32_t cpos, nb_blocks;
-    uint8_t buf[CRYPTO_BLOCK_SIZE * 2];
+    int rc = -1;
+    uint32_t nb_blocks, cpos;
     struct crypto_priv *priv = o->priv;
     stream_cls_t *rs         = priv->rs;
 
-    priv->ilen = 0;
-    priv->ipos = 0;
-    priv->olen = 0;
-    priv->opos = 0;
-    nb_blocks = pos / CRYPTO_BLOCK_SIZE;
-    if (nb_blocks) {
-        nb_blocks--;
-        cpos = nb_blocks * CRYPTO_BLOCK_SIZE;
-    } else {
-        cpos = 0;
-        memcpy(&priv->dec_iv, &priv->iv, sizeof(priv->iv));
-    }
-
-    rc = stream_seek(rs, cpos, SEEK_SET);
-    CHECK_RET_TAG_WITH_RET(rc == 0, -1);
-
-    diff = pos - cpos;
-    if (diff) {
-        while (diff > 0) {
-            rc = _stream_crypto_read(o, buf, diff);
-            if (rc <= 0) {
-                break;
-            }
-            diff -= rc;
-        }
-        if (diff) {
-            LOGE(TAG, "crypto diff = %d", diff);
+    /* small reads after a seek are common(probe, index), don't read ahead the whole buf */
+    priv->len   = 0;
+    priv->dpos  = 0;
+    priv->rpos  = 0;
+    priv->eof   = 0;
+    priv->fsize = MIN(CRYPTO_FILL_MIN, priv->bsize);
+    nb_blocks   = pos / CRYPTO_BLOCK_SIZE;
+    cpos        = nb_blocks * CRYPTO_BLOCK_SIZE;
+    if (priv->mode == CRYPTO_MODE_CTR) {
+        _crypto_ctr_set(priv->dec_iv, priv->iv, nb_blocks);
+        priv->ctr_off = 0;
+        rc = stream_seek(rs, cpos, SEEK_SET);
+        CHECK_RET_TAG_WITH_RET(rc == 0, -1);
+    } else if (nb_blocks) {
+        /* the iv of the block is the cipher block before it, nothing else is read */
+        rc = stream_seek(rs, cpos - CRYPTO_BLOCK_SIZE, SEEK_SET);
+        CHECK_RET_TAG_WITH_RET(rc == 0, -1);
+        rc = stream_read(rs, priv->dec_iv, CRYPTO_BLOCK_SIZE);
+        if (rc != CRYPTO_BLOCK_SIZE) {
+            LOGE(TAG, "read iv fail, rc = %d", rc);
             return -1;
         }
+    } else {
+        memcpy(&priv->dec_iv, &priv->iv, sizeof(priv->iv));
+        rc = stream_seek(rs, 0, SEEK_SET);
+        CHECK_RET_TAG_WITH_RET(rc == 0, -1);
     }
+    priv->skip = pos - cpos;
 
     return 0;
 }
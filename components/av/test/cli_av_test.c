@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2018-2020 Alibaba Group Holding Limited
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <aos/cli.h>
+
+extern int demux_seek_test(void);
+#if defined(CONFIG_STREAMER_CRYPTO) && CONFIG_STREAMER_CRYPTO && defined(CONFIG_USING_TLS)
+extern int stream_crypto_test(void);
+#endif
+#if defined(CONFIG_DEMUXER_WAV) && CONFIG_DEMUXER_WAV && defined(CONFIG_DECODER_PCM) && CONFIG_DECODER_PCM \
+    && (CONFIG_AV_AO_CHANNEL_NUM == 2)
+#define PLAYER_PIPE_TEST
+extern int player_pipe_test(void);
+#endif
+#if defined(CONFIG_EQXER_LOCAL) && CONFIG_EQXER_LOCAL && !CONFIG_EQXER_SILAN && !CONFIG_EQXER_IPC
+#define EQ_LOCAL_TEST
+extern int eq_local_test(void);
+#endif
+#if defined(CONFIG_MCAXER_LOCAL) && CONFIG_MCAXER_LOCAL && !CONFIG_MCAXER_IPC
+#define MCA_LOCAL_TEST
+extern int mca_local_test(void);
+#endif
+
+static void cmd_avtest_func(char *wbuf, int wbuf_len, int argc, char **argv)
+{
+    int all = argc < 2 || strcmp(argv[1], "all") == 0;
+    int rc  = 0;
+
+    if (all || strcmp(argv[1], "demux") == 0) {
+        rc |= demux_seek_test();
+    }
+#if defined(CONFIG_STREAMER_CRYPTO) && CONFIG_STREAMER_CRYPTO && defined(CONFIG_USING_TLS)
+    if (all || strcmp(argv[1], "crypto") == 0) {
+        rc |= stream_crypto_test();
+    }
+#endif
+#ifdef PLAYER_PIPE_TEST
+    if (all || strcmp(argv[1], "player") == 0) {
+        rc |= player_pipe_test();
+    }
+#endif
+#ifdef EQ_LOCAL_TEST
+    if (all || strcmp(argv[1], "eq") == 0) {
+        rc |= eq_local_test();
+    }
+#endif
+#ifdef MCA_LOCAL_TEST
+    if (all || strcmp(argv[1], "mca") == 0) {
+        rc |= mca_local_test();
+    }
+#endif
+
+    printf("avtest %s\n", rc == 0 ? "pass" : "fail");
+}
+
+void cli_reg_cmd_avtest(void)
+{
+    static const struct cli_command cmd_info = {
+        "avtest",
+        "av self test, avtest [all|demux|crypto|player|eq|mca]",
+        cmd_avtest_func
+    };
+
+    aos_cli_register_command(&cmd_info);
+}
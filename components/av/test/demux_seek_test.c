@@ -0,0 +1,657 @@
+/*
+ * Copyright (C) 2018-2020 Alibaba Group Holding Limited
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <aos/aos.h>
+#include "stream/stream.h"
+#include "stream/stream_all.h"
+#include "avformat/demux.h"
+#include "avformat/avformat_all.h"
+
+/*
+ * the streams are made in memory with the index of every frame in its payload,
+ * so where a seek lands is told by the packet read after it, not by its pts only
+ */
+
+#define TEST_ASSERT(name, v)  do { \
+                            if (!(v)) { \
+                                printf("ASSERT[%s] %d\n", name, __LINE__); \
+                                return -1; \
+                            } \
+                        } while(0);
+
+#define TEST_SEEK_CNT          (97)
+
+typedef struct {
+    uint8_t  *data;
+    size_t   size;
+    size_t   len;
+} test_buf_t;
+
+typedef struct {
+    const char *name;
+    /* frame index in the payload of the packet, -1 on error */
+    int (*frame_idx)(const avpacket_t *pkt);
+    uint32_t frame_samples;
+    uint32_t rate;
+    /* samples the seek starts before the target, for the frames, pages or the pre-roll */
+    uint32_t lag_min;
+    uint32_t lag_max;
+} test_fmt_t;
+
+static uint32_t g_seed;
+
+static uint32_t _rand(void)
+{
+    g_seed = g_seed * 1103515245 + 12345;
+    return g_seed >> 8;
+}
+
+static void _put(test_buf_t *b, const uint8_t *data, size_t len)
+{
+    if (b->len + len <= b->size) {
+        memcpy(b->data + b->len, data, len);
+    }
+    b->len += len;
+}
+
+/* crc32 of ts sections and ogg pages, msb first */
+static uint32_t _crc32(uint32_t crc, const uint8_t *data, size_t len)
+{
+    int i;
+
+    while (len--) {
+        crc ^= (uint32_t)*data++ << 24;
+        for (i = 0; i < 8; i++) {
+            crc = crc & 0x80000000 ? (crc << 1) ^ 0x04C11DB7 : crc << 1;
+        }
+    }
+
+    return crc;
+}
+
+static int _demux_open_mem(test_buf_t *b, stream_cls_t **ps, demux_cls_t **pd)
+{
+    char url[128];
+    stm_conf_t stm_cnf;
+
+    snprintf(url, sizeof(url), "mem://addr=%u&size=%u", (uint32_t)(uintptr_t)b->data, (uint32_t)b->len);
+    stream_conf_init(&stm_cnf);
+    *ps = stream_open(url, &stm_cnf);
+    if (*ps == NULL) {
+        return -1;
+    }
+    *pd = demux_open(*ps);
+    if (*pd == NULL) {
+        stream_close(*ps);
+        return -1;
+    }
+
+    return 0;
+}
+
+/* ms of the pts, as the index tells */
+static int _pts_check(demux_cls_t *o, const test_fmt_t *fmt, const avpacket_t *pkt, int idx)
+{
+    int64_t ms  = pkt->pts * 1000 / o->time_scale;
+    int64_t ims = (int64_t)idx * fmt->frame_samples * 1000 / fmt->rate;
+
+    return ms >= ims - 1 && ms <= ims + 1;
+}
+
+static int _demux_check(const test_fmt_t *fmt, test_buf_t *b, int nb_frames)
+{
+    int i, rc, idx;
+    uint64_t ms, start;
+    avpacket_t pkt;
+    stream_cls_t *s;
+    demux_cls_t *o;
+    const char *name = fmt->name;
+
+    TEST_ASSERT(name, b->len <= b->size);
+    TEST_ASSERT(name, _demux_open_mem(b, &s, &o) == 0);
+    TEST_ASSERT(name, o->time_scale && o->duration);
+    avpacket_init(&pkt);
+    TEST_ASSERT(name, avpacket_new(&pkt, 1024) == 0);
+
+    /* the packets come in order, the pts is the start of the frame */
+    for (i = 0; i < nb_frames; i++) {
+        rc = demux_read_packet(o, &pkt);
+        TEST_ASSERT(name, rc > 0);
+        idx = fmt->frame_idx(&pkt);
+        TEST_ASSERT(name, idx == i);
+        TEST_ASSERT(name, _pts_check(o, fmt, &pkt, idx));
+    }
+    TEST_ASSERT(name, demux_read_packet(o, &pkt) <= 0);
+
+    /* the first packet after a seek starts at the target or before, never late */
+    for (i = 0; i < TEST_SEEK_CNT; i++) {
+        ms = i == 0 ? 0 : (uint64_t)_rand() % o->duration;
+        rc = demux_seek(o, ms);
+        TEST_ASSERT(name, rc == 0);
+        rc = demux_read_packet(o, &pkt);
+        TEST_ASSERT(name, rc > 0);
+        idx = fmt->frame_idx(&pkt);
+        TEST_ASSERT(name, idx >= 0 && idx < nb_frames);
+        TEST_ASSERT(name, _pts_check(o, fmt, &pkt, idx));
+
+        /* in samples * 1000 */
+        start = (uint64_t)idx * fmt->frame_samples * 1000;
+        TEST_ASSERT(name, start <= ms * fmt->rate);
+        TEST_ASSERT(name, ms * fmt->rate - start <= (uint64_t)fmt->lag_max * 1000);
+        TEST_ASSERT(name, ms * fmt->rate - start >= (uint64_t)fmt->lag_min * 1000 || idx == 0);
+
+        /* and the next ones go on from there */
+        rc = demux_read_packet(o, &pkt);
+        TEST_ASSERT(name, rc > 0 || idx == nb_frames - 1);
+        TEST_ASSERT(name, rc <= 0 || fmt->frame_idx(&pkt) == idx + 1);
+    }
+
+    avpacket_free(&pkt);
+    demux_close(o);
+    stream_close(s);
+
+    return 0;
+}
+
+#if defined(CONFIG_DEMUXER_TS) && CONFIG_DEMUXER_TS
+#define TS_PKT_SIZE            (188)
+#define TS_PID_PMT             (0x1000)
+#define TS_PID_AUDIO           (0x100)
+#define TS_PID_OTHER           (0x200)
+#define TS_PTS_FIRST           (1234567)
+#define TS_FRAME_SAMPLES       (1024)
+#define TS_RATE                (48000)
+#define TS_DURATION_MS         (10*1000)
+#define TS_FRAME_CNT           (TS_DURATION_MS * TS_RATE / 1000 / TS_FRAME_SAMPLES)
+
+static uint8_t g_ts_cc[4];   /* continuity counters of pat, pmt, audio and the other pid */
+
+/* one ts packet, the payload is stuffed by the adaptation field to 184 bytes */
+static void _ts_put_packet(test_buf_t *b, int pid, int cc_idx, const uint8_t *payload, size_t len)
+{
+    uint8_t pkt[TS_PKT_SIZE];
+    size_t alen;
+
+    pkt[0] = 0x47;
+    pkt[1] = 0x40 | (pid >> 8);
+    pkt[2] = pid & 0xff;
+    pkt[3] = 0x10 | (g_ts_cc[cc_idx]++ & 0xf);
+    if (len < TS_PKT_SIZE - 4) {
+        alen   = TS_PKT_SIZE - 4 - len - 1;
+        pkt[3] |= 0x20;
+        pkt[4] = alen;
+        if (alen) {
+            pkt[5] = 0;
+            memset(pkt + 6, 0xff, alen - 1);
+        }
+        memcpy(pkt + 5 + alen, payload, len);
+    } else {
+        memcpy(pkt + 4, payload, TS_PKT_SIZE - 4);
+    }
+    _put(b, pkt, TS_PKT_SIZE);
+}
+
+static void _ts_put_section(test_buf_t *b, int pid, int cc_idx, uint8_t tid, const uint8_t *body, size_t len)
+{
+    uint8_t sec[64];
+    uint32_t crc;
+    size_t slen = 1 + 3 + 5 + len;
+
+    sec[0] = 0;                               /* pointer field */
+    sec[1] = tid;
+    sec[2] = 0xb0 | ((len + 5 + 4) >> 8);
+    sec[3] = (len + 5 + 4) & 0xff;
+    sec[4] = 0;
+    sec[5] = 1;
+    sec[6] = 0xc1;
+    sec[7] = 0;
+    sec[8] = 0;
+    memcpy(sec + 9, body, len);
+    crc = _crc32(0xffffffff, sec + 1, slen - 1);
+    sec[slen]     = crc >> 24;
+    sec[slen + 1] = crc >> 16;
+    sec[slen + 2] = crc >> 8;
+    sec[slen + 3] = crc;
+    _ts_put_packet(b, pid, cc_idx, sec, slen + 4);
+}
+
+/* adts aac in pes, the pat/pmt are repeated and the packets of another pid are mixed in */
+static void _ts_make(test_buf_t *b)
+{
+    int i, j;
+    uint8_t pes[TS_PKT_SIZE];
+    size_t plen, flen;
+    uint64_t pts;
+    static const uint8_t pat[] = { 0x00, 0x01, 0xe0 | (TS_PID_PMT >> 8), TS_PID_PMT & 0xff };
+    static const uint8_t pmt[] = { 0xe0 | (TS_PID_AUDIO >> 8), TS_PID_AUDIO & 0xff, 0xf0, 0x00,
+                                   0x0f, 0xe0 | (TS_PID_AUDIO >> 8), TS_PID_AUDIO & 0xff, 0xf0, 0x00 };
+
+    memset(g_ts_cc, 0, sizeof(g_ts_cc));
+    for (i = 0; i < TS_FRAME_CNT; i++) {
+        if (i % 40 == 0) {
+            _ts_put_section(b, 0, 0, 0x00, pat, sizeof(pat));
+            _ts_put_section(b, TS_PID_PMT, 1, 0x02, pmt, sizeof(pmt));
+        }
+
+        /* pes header with the pts, then one adts frame with the index */
+        flen    = 7 + 4 + _rand() % 100;
+        pts     = TS_PTS_FIRST + (uint64_t)i * TS_FRAME_SAMPLES * 90000 / TS_RATE;
+        plen    = 3 + 5 + flen;
+        pes[0]  = 0x00;
+        pes[1]  = 0x00;
+        pes[2]  = 0x01;
+        pes[3]  = 0xc0;
+        pes[4]  = plen >> 8;
+        pes[5]  = plen & 0xff;
+        pes[6]  = 0x80;
+        pes[7]  = 0x80;
+        pes[8]  = 0x05;
+        pes[9]  = 0x21 | ((pts >> 29) & 0x0e);
+        pes[10] = pts >> 22;
+        pes[11] = ((pts >> 14) & 0xfe) | 1;
+        pes[12] = pts >> 7;
+        pes[13] = ((pts << 1) & 0xfe) | 1;
+        pes[14] = 0xff;
+        pes[15] = 0xf1;
+        pes[16] = (1 << 6) | (3 << 2);        /* aac lc, 48000 */
+        pes[17] = (2 << 6) | ((flen >> 11) & 3);
+        pes[18] = flen >> 3;
+        pes[19] = ((flen & 7) << 5) | 0x1f;
+        pes[20] = 0xfc;
+        pes[21] = i;
+        pes[22] = i >> 8;
+        pes[23] = i >> 16;
+        pes[24] = i >> 24;
+        for (j = 25; j < 14 + flen; j++) {
+            pes[j] = _rand();
+        }
+        _ts_put_packet(b, TS_PID_AUDIO, 2, pes, 14 + flen);
+
+        if (i % 3 == 0) {
+            memset(pes, 0, sizeof(pes));
+            _ts_put_packet(b, TS_PID_OTHER, 3, pes, TS_PKT_SIZE - 4);
+        }
+    }
+}
+
+static int _ts_frame_idx(const avpacket_t *pkt)
+{
+    const uint8_t *d = pkt->data;
+
+    if (pkt->len < 11 || d[0] != 0xff || (d[1] & 0xf0) != 0xf0) {
+        return -1;
+    }
+
+    return d[7] | d[8] << 8 | d[9] << 16 | d[10] << 24;
+}
+
+static int _demux_ts_test(void)
+{
+    int rc;
+    test_buf_t b;
+    static const test_fmt_t fmt = {
+        "ts", _ts_frame_idx, TS_FRAME_SAMPLES, TS_RATE, 0, TS_FRAME_SAMPLES
+    };
+
+    /* pat and pmt every 40 frames, another pid every 3 */
+    b.size = (TS_FRAME_CNT + TS_FRAME_CNT / 40 * 2 + 2 + TS_FRAME_CNT / 3 + 1) * TS_PKT_SIZE;
+    b.len  = 0;
+    b.data = aos_malloc(b.size);
+    TEST_ASSERT("ts", b.data);
+
+    _ts_make(&b);
+    rc = _demux_check(&fmt, &b, TS_FRAME_CNT);
+    aos_free(b.data);
+
+    return rc;
+}
+#endif
+
+#if defined(CONFIG_DEMUXER_OGG) && CONFIG_DEMUXER_OGG
+#define OGG_SERIAL_OPUS        (0x1234)
+#define OGG_SERIAL_OTHER       (0x99)
+#define OPUS_PRE_SKIP          (312)
+#define OPUS_FRAME_SAMPLES     (960)
+#define OPUS_RATE              (48000)
+#define OPUS_PREROLL           (80 * OPUS_RATE / 1000)
+#define OPUS_PAGE_PKTS_MAX     (50)
+#define OPUS_DURATION_MS       (10*1000)
+#define OPUS_FRAME_CNT         (OPUS_DURATION_MS * OPUS_RATE / 1000 / OPUS_FRAME_SAMPLES)
+#define OPUS_PKT_SIZE_MAX      (100)
+
+static uint32_t g_ogg_seq[2];
+
+/* one page, the packets are shorter than 255 bytes */
+static void _ogg_put_page(test_buf_t *b, int other, uint8_t type, uint64_t granule,
+                          const uint8_t *data, const uint8_t *sizes, int nb_pkts)
+{
+    int i;
+    uint32_t crc, serial = other ? OGG_SERIAL_OTHER : OGG_SERIAL_OPUS;
+    size_t len = 0, start = b->len;
+    uint8_t hdr[27];
+
+    memcpy(hdr, "OggS", 4);
+    hdr[4] = 0;
+    hdr[5] = type;
+    for (i = 0; i < 8; i++) {
+        hdr[6 + i] = granule >> (8 * i);
+    }
+    for (i = 0; i < 4; i++) {
+        hdr[14 + i] = serial >> (8 * i);
+        hdr[18 + i] = g_ogg_seq[other] >> (8 * i);
+        hdr[22 + i] = 0;
+    }
+    g_ogg_seq[other]++;
+    hdr[26] = nb_pkts;
+    _put(b, hdr, sizeof(hdr));
+    _put(b, sizes, nb_pkts);
+    for (i = 0; i < nb_pkts; i++) {
+        len += sizes[i];
+    }
+    _put(b, data, len);
+
+    if (b->len <= b->size) {
+        crc = _crc32(0, b->data + start, b->len - start);
+        for (i = 0; i < 4; i++) {
+            b->data[start + 22 + i] = crc >> (8 * i);
+        }
+    }
+}
+
+/* opus of 20ms packets in pages of 5~50 packets, the pages of another stream mixed in */
+static void _ogg_make(test_buf_t *b)
+{
+    int i, n, idx = 0;
+    uint8_t sizes[OPUS_PAGE_PKTS_MAX], *pkt;
+    uint8_t *data = aos_malloc(OPUS_PAGE_PKTS_MAX * OPUS_PKT_SIZE_MAX);
+    uint64_t granule = OPUS_PRE_SKIP;
+    static const uint8_t head[] = { 'O', 'p', 'u', 's', 'H', 'e', 'a', 'd', 1, 2,
+                                    OPUS_PRE_SKIP & 0xff, OPUS_PRE_SKIP >> 8,
+                                    OPUS_RATE & 0xff, (OPUS_RATE >> 8) & 0xff, OPUS_RATE >> 16, 0, 0, 0, 0 };
+    static const uint8_t tags[] = { 'O', 'p', 'u', 's', 'T', 'a', 'g', 's', 4, 0, 0, 0, 't', 'e', 's', 't', 0, 0, 0, 0 };
+
+    if (!data) {
+        b->len = b->size + 1;
+        return;
+    }
+    memset(g_ogg_seq, 0, sizeof(g_ogg_seq));
+    sizes[0] = sizeof(head);
+    _ogg_put_page(b, 0, 2, 0, head, sizes, 1);
+    sizes[0] = sizeof(tags);
+    _ogg_put_page(b, 0, 0, 0, tags, sizes, 1);
+    memset(data, 0, 80);
+    memcpy(data, "Speex   ", 8);
+    sizes[0] = 80;
+    _ogg_put_page(b, 1, 2, 0, data, sizes, 1);
+
+    while (idx < OPUS_FRAME_CNT) {
+        n   = 5 + _rand() % (OPUS_PAGE_PKTS_MAX - 5 + 1);
+        pkt = data;
+        for (i = 0; i < n && idx < OPUS_FRAME_CNT; i++, idx++) {
+            /* celt, one frame of 20ms */
+            sizes[i] = 5 + _rand() % (OPUS_PKT_SIZE_MAX - 5 + 1);
+            pkt[0]   = 0x98;
+            pkt[1]   = idx;
+            pkt[2]   = idx >> 8;
+            pkt[3]   = idx >> 16;
+            pkt[4]   = idx >> 24;
+            memset(pkt + 5, _rand(), sizes[i] - 5);
+            pkt     += sizes[i];
+            granule += OPUS_FRAME_SAMPLES;
+        }
+        _ogg_put_page(b, 0, 0, granule, data, sizes, i);
+
+        if (_rand() % 5 == 0) {
+            memset(data, 0, 200);
+            sizes[0] = 200;
+            _ogg_put_page(b, 1, 0, _rand(), data, sizes, 1);
+        }
+    }
+    aos_free(data);
+}
+
+static int _ogg_frame_idx(const avpacket_t *pkt)
+{
+    const uint8_t *d = pkt->data;
+
+    if (pkt->len < 5 || d[0] != 0x98) {
+        return -1;
+    }
+
+    return d[1] | d[2] << 8 | d[3] << 16 | d[4] << 24;
+}
+
+static int _demux_ogg_test(void)
+{
+    int rc;
+    test_buf_t b;
+    static const test_fmt_t fmt = {
+        "ogg", _ogg_frame_idx, OPUS_FRAME_SAMPLES, OPUS_RATE,
+        OPUS_PREROLL, OPUS_PREROLL + OPUS_PAGE_PKTS_MAX * OPUS_FRAME_SAMPLES
+    };
+
+    /* the pages of the other stream are 200 bytes, one in 5 pages at most */
+    b.size = 512 + OPUS_FRAME_CNT * (OPUS_PKT_SIZE_MAX + 1) + (OPUS_FRAME_CNT / 5 + 1) * (27 + 1) * 2
+             + (OPUS_FRAME_CNT / 5 + 1) * 200;
+    b.len  = 0;
+    b.data = aos_malloc(b.size);
+    TEST_ASSERT("ogg", b.data);
+
+    _ogg_make(&b);
+    rc = _demux_check(&fmt, &b, OPUS_FRAME_CNT);
+    aos_free(b.data);
+
+    return rc;
+}
+#endif
+
+#if defined(CONFIG_DEMUXER_FLAC) && CONFIG_DEMUXER_FLAC
+#define FLAC_FRAME_SAMPLES     (576)
+#define FLAC_RATE              (44100)
+#define FLAC_DURATION_MS       (5*1000)
+#define FLAC_FRAME_CNT         (FLAC_DURATION_MS * FLAC_RATE / 1000 / FLAC_FRAME_SAMPLES)
+#define FLAC_FRAME_SIZE_MAX    (6 + 2 + 1 + 1 + FLAC_FRAME_SAMPLES + 2)
+#define FLAC_SEEK_POINT_STEP   (16)
+#define FLAC_SEEK_POINT_CNT    (FLAC_FRAME_CNT / FLAC_SEEK_POINT_STEP + 2)
+
+static uint8_t _crc8(const uint8_t *data, size_t len)
+{
+    int i;
+    uint8_t crc = 0;
+
+    while (len--) {
+        crc ^= *data++;
+        for (i = 0; i < 8; i++) {
+            crc = crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1;
+        }
+    }
+
+    return crc;
+}
+
+static uint16_t _crc16(const uint8_t *data, size_t len)
+{
+    int i;
+    uint16_t crc = 0;
+
+    while (len--) {
+        crc ^= (uint16_t)*data++ << 8;
+        for (i = 0; i < 8; i++) {
+            crc = crc & 0x8000 ? (crc << 1) ^ 0x8005 : crc << 1;
+        }
+    }
+
+    return crc;
+}
+
+static void _put_be(uint8_t *buf, uint64_t v, int n)
+{
+    while (n--) {
+        buf[n] = v;
+        v >>= 8;
+    }
+}
+
+/* mono 8 bits, the frames are constant or verbatim, so their sizes differ */
+static size_t _flac_frame(uint8_t *f, int idx)
+{
+    int i;
+    size_t len;
+    uint16_t crc;
+
+    f[0] = 0xff;
+    f[1] = 0xf8;
+    f[2] = (2 << 4) | 9;                      /* 576 samples, 44100 */
+    f[3] = 1 << 1;                            /* mono, 8 bits */
+    /* frame number in utf-8 */
+    if (idx < 0x80) {
+        f[4] = idx;
+        len  = 5;
+    } else {
+        f[4] = 0xc0 | (idx >> 6);
+        f[5] = 0x80 | (idx & 0x3f);
+        len  = 6;
+    }
+    f[len] = _crc8(f, len);
+    len++;
+
+    /* the sync of a frame needs 16 bytes from its header on, so the last one is not a short one */
+    if (idx % 3 == 2 || idx == FLAC_FRAME_CNT - 1) {
+        f[len++] = 0x02;
+        for (i = 0; i < FLAC_FRAME_SAMPLES; i++) {
+            f[len++] = _rand();
+        }
+    } else {
+        f[len++] = 0x00;
+        f[len++] = idx;
+    }
+    crc = _crc16(f, len);
+    f[len++] = crc >> 8;
+    f[len++] = crc & 0xff;
+
+    return len;
+}
+
+static void _flac_make(test_buf_t *b, int seektable)
+{
+    int i, n = 0;
+    uint8_t f[FLAC_FRAME_SIZE_MAX], blk[4 + 34];
+    uint8_t *st = NULL;
+    size_t len, pos, flen_min = SIZE_MAX, flen_max = 0;
+    uint32_t seed = g_seed;
+
+    /* the frame sizes and offsets first, the same frames again later */
+    if (seektable) {
+        st = aos_zalloc(4 + FLAC_SEEK_POINT_CNT * 18);
+        if (!st) {
+            b->len = b->size + 1;
+            return;
+        }
+    }
+    for (i = 0, pos = 0; i < FLAC_FRAME_CNT; i++, pos += len) {
+        len      = _flac_frame(f, i);
+        flen_min = len < flen_min ? len : flen_min;
+        flen_max = len > flen_max ? len : flen_max;
+        if (st && i % FLAC_SEEK_POINT_STEP == 0) {
+            _put_be(st + 4 + n * 18, (uint64_t)i * FLAC_FRAME_SAMPLES, 8);
+            _put_be(st + 4 + n * 18 + 8, pos, 8);
+            _put_be(st + 4 + n * 18 + 16, FLAC_FRAME_SAMPLES, 2);
+            n++;
+        }
+    }
+    g_seed = seed;
+
+    _put(b, (const uint8_t *)"fLaC", 4);
+    blk[0] = seektable ? 0 : 0x80;
+    _put_be(blk + 1, 34, 3);
+    _put_be(blk + 4, FLAC_FRAME_SAMPLES, 2);
+    _put_be(blk + 6, FLAC_FRAME_SAMPLES, 2);
+    _put_be(blk + 8, flen_min, 3);
+    _put_be(blk + 11, flen_max, 3);
+    _put_be(blk + 14, ((uint64_t)FLAC_RATE << 44) | ((uint64_t)7 << 36) | (uint64_t)FLAC_FRAME_CNT * FLAC_FRAME_SAMPLES, 8);
+    memset(blk + 22, 0, 16);
+    _put(b, blk, sizeof(blk));
+
+    if (st) {
+        /* and a placeholder point */
+        _put_be(st + 4 + n * 18, UINT64_MAX, 8);
+        n++;
+        st[0] = 0x80 | 3;
+        _put_be(st + 1, n * 18, 3);
+        _put(b, st, 4 + n * 18);
+        aos_free(st);
+    }
+
+    for (i = 0; i < FLAC_FRAME_CNT; i++) {
+        len = _flac_frame(f, i);
+        _put(b, f, len);
+    }
+}
+
+static int _flac_frame_idx(const avpacket_t *pkt)
+{
+    const uint8_t *d = pkt->data;
+
+    if (pkt->len < 6 || d[0] != 0xff || d[1] != 0xf8) {
+        return -1;
+    }
+
+    return d[4] < 0x80 ? d[4] : (d[4] & 0x1f) << 6 | (d[5] & 0x3f);
+}
+
+static int _demux_flac_test(int seektable)
+{
+    int rc;
+    test_buf_t b;
+    static const test_fmt_t fmt = {
+        "flac", _flac_frame_idx, FLAC_FRAME_SAMPLES, FLAC_RATE, 0, FLAC_FRAME_SAMPLES
+    };
+
+    b.size = 4 + 4 + 34 + 4 + FLAC_SEEK_POINT_CNT * 18 + FLAC_FRAME_CNT * FLAC_FRAME_SIZE_MAX;
+    b.len  = 0;
+    b.data = aos_malloc(b.size);
+    TEST_ASSERT("flac", b.data);
+
+    _flac_make(&b, seektable);
+    rc = _demux_check(&fmt, &b, FLAC_FRAME_CNT);
+    aos_free(b.data);
+
+    return rc;
+}
+#endif
+
+/**
+ * @brief  test the demuxers on streams made in memory: the packets in order and the seeks
+ * @return 0/-1
+ */
+int demux_seek_test(void)
+{
+    int rc = 0;
+
+    g_seed = 1;
+    stream_register_mem();
+#if defined(CONFIG_DEMUXER_TS) && CONFIG_DEMUXER_TS
+    demux_register_ts();
+    rc |= _demux_ts_test();
+#endif
+#if defined(CONFIG_DEMUXER_OGG) && CONFIG_DEMUXER_OGG
+    demux_register_ogg();
+    rc |= _demux_ogg_test();
+#endif
+#if defined(CONFIG_DEMUXER_FLAC) && CONFIG_DEMUXER_FLAC
+    demux_register_flac();
+    /* by the seek table and by the bisection */
+    rc |= _demux_flac_test(1);
+    rc |= _demux_flac_test(0);
+#endif
+
+    if (rc == 0) {
+        printf("test over, all pass\n");
+    }
+
+    return rc;
+}
@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2018-2020 Alibaba Group Holding Limited
+ */
+
+#if defined(CONFIG_EQXER_LOCAL) && CONFIG_EQXER_LOCAL && !CONFIG_EQXER_SILAN && !CONFIG_EQXER_IPC
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <aos/aos.h>
+#include "avutil/common.h"
+#include "avutil/av_typedef.h"
+#include "aef/eq.h"
+#include "player.h"
+
+/*
+ * the fixed point biquads of eq_local against the magnitude response of the same rbj
+ * filters in double, with sine tones. then a gain change on a running tone must ramp,
+ * with no step larger than the slope of the louder tone
+ */
+
+#define TEST_ASSERT(name, v)  do { \
+                            if (!(v)) { \
+                                printf("ASSERT[%s] %d\n", name, __LINE__); \
+                                return -1; \
+                            } \
+                        } while(0);
+
+#define TEST_RATE              (16000)
+#define TEST_SETTLE            (4096)
+#define TEST_MEASURE           (8000)     ///< whole periods of all the tones
+#define TEST_AMP               (0.25)
+#define TEST_STEP_AMP          (0.1)
+#define TEST_STEP_GAIN         (18)
+#define TEST_STEP_FREQ         (200)
+
+static const uint32_t g_freqs[] = { 100, 1000, 4000 };
+
+static const eqfp_t g_params[] = {
+    { 1, EQF_TYPE_PEAK,  6,   1.0, 1000 },
+    { 1, EQF_TYPE_PEAK,  -12, 2.0, 1000 },
+    { 1, EQF_TYPE_PEAK,  12,  10,  100  },
+    { 1, EQF_TYPE_NOTCH, 0,   1.0, 2000 },
+    { 1, EQF_TYPE_LP1,   0,   1.0, 1000 },
+    { 1, EQF_TYPE_HP1,   0,   1.0, 1000 },
+    { 1, EQF_TYPE_LP2,   0,   0.7, 1000 },
+    { 1, EQF_TYPE_HP2,   0,   0.7, 1000 },
+    { 1, EQF_TYPE_BP2,   0,   1.0, 1000 },
+};
+
+static int16_t g_buf[POST_PROC_SAMPLES_MAX];
+
+/* |H| of the rbj biquad at freq, as eq_local designs it */
+static double _mag(const eqfp_t *p, uint32_t freq)
+{
+    double w0 = 2 * M_PI * p->rate / TEST_RATE, cw = cos(w0), alpha = sin(w0) / (2 * p->q);
+    double a = pow(10, p->gain / 40), k = tan(w0 / 2), w = 2 * M_PI * freq / TEST_RATE;
+    double b[3], d[3], nr, ni, dr, di;
+
+    switch (p->type) {
+    case EQF_TYPE_PEAK:
+        b[0] = 1 + alpha * a; b[1] = -2 * cw; b[2] = 1 - alpha * a;
+        d[0] = 1 + alpha / a; d[1] = -2 * cw; d[2] = 1 - alpha / a;
+        break;
+    case EQF_TYPE_NOTCH:
+        b[0] = 1; b[1] = -2 * cw; b[2] = 1;
+        d[0] = 1 + alpha; d[1] = -2 * cw; d[2] = 1 - alpha;
+        break;
+    case EQF_TYPE_LP1:
+    case EQF_TYPE_HP1:
+        b[0] = p->type == EQF_TYPE_LP1 ? k : 1; b[1] = p->type == EQF_TYPE_LP1 ? k : -1; b[2] = 0;
+        d[0] = k + 1; d[1] = k - 1; d[2] = 0;
+        break;
+    case EQF_TYPE_LP2:
+        b[0] = (1 - cw) / 2; b[1] = 1 - cw; b[2] = (1 - cw) / 2;
+        d[0] = 1 + alpha; d[1] = -2 * cw; d[2] = 1 - alpha;
+        break;
+    case EQF_TYPE_HP2:
+        b[0] = (1 + cw) / 2; b[1] = -(1 + cw); b[2] = (1 + cw) / 2;
+        d[0] = 1 + alpha; d[1] = -2 * cw; d[2] = 1 - alpha;
+        break;
+    default:
+        b[0] = alpha; b[1] = 0; b[2] = -alpha;
+        d[0] = 1 + alpha; d[1] = -2 * cw; d[2] = 1 - alpha;
+        break;
+    }
+
+    nr = b[0] + b[1] * cos(w) + b[2] * cos(2 * w);
+    ni = -b[1] * sin(w) - b[2] * sin(2 * w);
+    dr = d[0] + d[1] * cos(w) + d[2] * cos(2 * w);
+    di = -d[1] * sin(w) - d[2] * sin(2 * w);
+
+    return sqrt((nr * nr + ni * ni) / (dr * dr + di * di));
+}
+
+/* tone through the eq from sample pos on, returns the rms of the output after the settle */
+static double _run(eqx_t *eq, uint32_t freq, double amp, size_t *pos, size_t count, int16_t *last, int *step_max)
+{
+    size_t i, n;
+    double sum = 0;
+    int step;
+
+    while (count) {
+        n = MIN(count, POST_PROC_SAMPLES_MAX);
+        for (i = 0; i < n; i++) {
+            g_buf[i] = (int16_t)lrint(amp * 32767 * sin(2 * M_PI * freq * (*pos + i) / TEST_RATE));
+        }
+        eqx_process(eq, g_buf, g_buf, n);
+        for (i = 0; i < n; i++) {
+            sum += (double)g_buf[i] * g_buf[i];
+            if (step_max) {
+                step = abs(g_buf[i] - *last);
+                *step_max = MAX(*step_max, step);
+            }
+            *last = g_buf[i];
+        }
+        *pos  += n;
+        count -= n;
+    }
+
+    return sum;
+}
+
+static int _response_check(const char *name, const eqfp_t *p)
+{
+    int i;
+    eqx_t *eq;
+    int16_t last = 0;
+    size_t pos = 0;
+    double rms, want;
+
+    eq = eqx_new(TEST_RATE, 1);
+    TEST_ASSERT(name, eq);
+    eqx_set_param(eq, 0, p);
+    eqx_set_enable(eq, 1);
+
+    for (i = 0; i < ARRAY_SIZE(g_freqs); i++) {
+        pos = 0;
+        _run(eq, g_freqs[i], TEST_AMP, &pos, TEST_SETTLE, &last, NULL);
+        rms  = sqrt(_run(eq, g_freqs[i], TEST_AMP, &pos, TEST_MEASURE, &last, NULL) / TEST_MEASURE);
+        want = _mag(p, g_freqs[i]) * TEST_AMP * 32767 / sqrt(2);
+        if (fabs(rms - want) > 0.01 * want + 1) {
+            printf("%s: type %d, %u Hz: rms %.1f, want %.1f\n", name, p->type, g_freqs[i], rms, want);
+            eqx_free(eq);
+            return -1;
+        }
+    }
+    eqx_free(eq);
+
+    return 0;
+}
+
+/*
+ * +18 -> -18dB at 1kHz on a running 200Hz tone. the tone is off the center, a coefficient
+ * jump there shows as a click about ten times the slope of the sine
+ */
+static int _ramp_check(const char *name)
+{
+    eqx_t *eq;
+    int16_t last = 0;
+    int step_max = 0;
+    size_t pos = 0;
+    double slope;
+    eqfp_t p = { 1, EQF_TYPE_PEAK, TEST_STEP_GAIN, 1.0, 1000 };
+
+    eq = eqx_new(TEST_RATE, 1);
+    TEST_ASSERT(name, eq);
+    eqx_set_param(eq, 0, &p);
+    eqx_set_enable(eq, 1);
+    _run(eq, TEST_STEP_FREQ, TEST_STEP_AMP, &pos, TEST_SETTLE, &last, NULL);
+    /* the largest step of the louder sine */
+    slope = _mag(&p, TEST_STEP_FREQ);
+
+    p.gain = -TEST_STEP_GAIN;
+    eqx_set_param(eq, 0, &p);
+    _run(eq, TEST_STEP_FREQ, TEST_STEP_AMP, &pos, TEST_SETTLE, &last, &step_max);
+    eqx_free(eq);
+
+    slope = MAX(slope, _mag(&p, TEST_STEP_FREQ)) * TEST_STEP_AMP * 32767 * 2 * sin(M_PI * TEST_STEP_FREQ / TEST_RATE);
+    printf("%s: step max %d, slope %.1f\n", name, step_max, slope);
+    TEST_ASSERT(name, step_max <= slope + 2);
+
+    return 0;
+}
+
+/**
+ * @brief  test the eq_local backend: response of every filter type and the ramp of a gain change
+ * @return 0/-1
+ */
+int eq_local_test(void)
+{
+    int i, rc = 0;
+
+    player_init();
+    for (i = 0; i < ARRAY_SIZE(g_params); i++) {
+        rc |= _response_check("eq response", &g_params[i]);
+    }
+    rc |= _ramp_check("eq ramp");
+
+    if (rc == 0) {
+        printf("test over, all pass\n");
+    }
+
+    return rc;
+}
+#endif
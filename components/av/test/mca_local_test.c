@@ -0,0 +1,242 @@
+/*
+ * Copyright (C) 2018-2020 Alibaba Group Holding Limited
+ */
+
+#if defined(CONFIG_MCAXER_LOCAL) && CONFIG_MCAXER_LOCAL && !CONFIG_MCAXER_IPC
+#include <stdio.h>
+#include <string.h>
+#include <aos/kernel.h>
+#include "mca/mca.h"
+#include "mca/mca_all.h"
+
+/*
+ * the iir and fir of mca_local against a naive 64 bits reference, bit exact: out of place,
+ * in place, every fir order up to TEST_FIR_ORDER_MAX with every tail of the output block.
+ * then two tasks run one instance each with their own coefficients, so a coefficient or
+ * state shared by the instances shows as a wrong output
+ */
+
+#define TEST_ASSERT(name, v)  do { \
+                            if (!(v)) { \
+                                printf("ASSERT[%s] %d\n", name, __LINE__); \
+                                return -1; \
+                            } \
+                        } while(0);
+
+#define TEST_COEFF_SHIFT       (24)
+#define TEST_FIR_ORDER_MAX     (39)
+#define TEST_SIZE              (256)
+#define TEST_TASK_LOOPS        (2000)
+#define TEST_TIMEOUT_MS        (10000)
+
+static struct {
+    uint32_t   seed;
+    fxp32_t    in[TEST_SIZE];
+    fxp32_t    out[TEST_SIZE];
+    fxp32_t    ref[TEST_SIZE];
+    aos_sem_t  done;
+} g_mca;
+
+typedef struct {
+    mcax_t     *mca;
+    fxp32_t    coeff[TEST_FIR_ORDER_MAX + 1];
+    size_t     order;
+    fxp32_t    in[TEST_SIZE];
+    fxp32_t    out[TEST_SIZE];
+    fxp32_t    ref[TEST_SIZE];
+    int        bad;
+} test_task_t;
+
+static uint32_t _rand(void)
+{
+    g_mca.seed = g_mca.seed * 1103515245 + 12345;
+    return g_mca.seed;
+}
+
+static fxp32_t _sat(int64_t v)
+{
+    v >>= TEST_COEFF_SHIFT;
+    return v > INT32_MAX ? INT32_MAX : (v < INT32_MIN ? INT32_MIN : (fxp32_t)v);
+}
+
+static void _iir_ref(const fxp32_t *c, const fxp32_t *in, size_t size, fxp32_t yn1, fxp32_t yn2, fxp32_t *out)
+{
+    size_t i;
+
+    for (i = 0; i < size - 2; i++) {
+        out[i] = _sat((int64_t)c[0] * in[i] + (int64_t)c[1] * in[i + 1] + (int64_t)c[2] * in[i + 2]
+                      + (int64_t)c[3] * yn1 + (int64_t)c[4] * yn2);
+        yn2 = yn1;
+        yn1 = out[i];
+    }
+}
+
+static void _fir_ref(const fxp32_t *c, size_t order, const fxp32_t *in, size_t size, fxp32_t *out)
+{
+    size_t i, k;
+    int64_t acc;
+
+    for (i = 0; i < size - order; i++) {
+        acc = 0;
+        for (k = 0; k <= order; k++) {
+            acc += (int64_t)c[k] * in[i + k];
+        }
+        out[i] = _sat(acc);
+    }
+}
+
+static void _fill(fxp32_t *buf, size_t size, int shift)
+{
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        buf[i] = (fxp32_t)_rand() >> shift;
+    }
+}
+
+static int _iir_check(const char *name)
+{
+    int rc;
+    size_t size;
+    mcax_t *mca;
+    fxp32_t c[5], yn1, yn2;
+
+    mca = mcax_new(MCA_TYPE_IIR);
+    TEST_ASSERT(name, mca);
+
+    /*
+     * a stable biquad: b in +-0.5, -a(1) in +-1, -a(2) in +-0.25. then wild ones up to +-32 to
+     * saturate, the sum of 5 products stays in 64 bits
+     */
+    _fill(c, 3, 32 - TEST_COEFF_SHIFT);
+    c[3] = (fxp32_t)_rand() >> (31 - TEST_COEFF_SHIFT);
+    c[4] = (fxp32_t)_rand() >> (33 - TEST_COEFF_SHIFT);
+    for (size = 3; size <= TEST_SIZE; size += 37) {
+        _fill(g_mca.in, size, 1);
+        yn1 = (fxp32_t)_rand();
+        yn2 = (fxp32_t)_rand();
+        rc = mcax_iir_fxp32_coeff32_config(mca, c);
+        _iir_ref(c, g_mca.in, size, yn1, yn2, g_mca.ref);
+        rc |= mcax_iir_fxp32(mca, g_mca.in, size, yn1, yn2, g_mca.out);
+        TEST_ASSERT(name, rc == 0 && memcmp(g_mca.out, g_mca.ref, (size - 2) * sizeof(fxp32_t)) == 0);
+
+        rc = mcax_iir_fxp32(mca, g_mca.in, size, yn1, yn2, g_mca.in);
+        TEST_ASSERT(name, rc == 0 && memcmp(g_mca.in, g_mca.ref, (size - 2) * sizeof(fxp32_t)) == 0);
+
+        _fill(c, 5, 2);
+    }
+    TEST_ASSERT(name, mcax_iir_fxp32(mca, g_mca.in, 2, 0, 0, g_mca.out) != 0);
+    mcax_free(mca);
+
+    return 0;
+}
+
+static int _fir_check(const char *name)
+{
+    int rc;
+    mcax_t *mca;
+    size_t order, size;
+    fxp32_t c[TEST_FIR_ORDER_MAX + 1];
+
+    mca = mcax_new(MCA_TYPE_FIR);
+    TEST_ASSERT(name, mca);
+    TEST_ASSERT(name, mcax_fir_fxp32(mca, g_mca.in, TEST_SIZE, g_mca.out) != 0);
+
+    for (order = 0; order <= TEST_FIR_ORDER_MAX; order++) {
+        _fill(c, order + 1, order < 8 ? 3 : 32 - TEST_COEFF_SHIFT);
+        rc = mcax_fir_fxp32_coeff32_config(mca, c, order);
+        TEST_ASSERT(name, rc == 0);
+        /* every tail of the 4 outputs block, and a long run */
+        for (size = order + 1; size <= order + 9; size++) {
+            _fill(g_mca.in, size, 1);
+            _fir_ref(c, order, g_mca.in, size, g_mca.ref);
+            rc = mcax_fir_fxp32(mca, g_mca.in, size, g_mca.out);
+            TEST_ASSERT(name, rc == 0 && memcmp(g_mca.out, g_mca.ref, (size - order) * sizeof(fxp32_t)) == 0);
+        }
+        _fill(g_mca.in, TEST_SIZE, 1);
+        _fir_ref(c, order, g_mca.in, TEST_SIZE, g_mca.ref);
+        rc = mcax_fir_fxp32(mca, g_mca.in, TEST_SIZE, g_mca.in);
+        TEST_ASSERT(name, rc == 0 && memcmp(g_mca.in, g_mca.ref, (TEST_SIZE - order) * sizeof(fxp32_t)) == 0);
+        TEST_ASSERT(name, mcax_fir_fxp32(mca, g_mca.in, order, g_mca.out) != 0);
+    }
+    mcax_free(mca);
+
+    return 0;
+}
+
+static void _fir_task(void *arg)
+{
+    int i;
+    test_task_t *t = arg;
+
+    for (i = 0; i < TEST_TASK_LOOPS; i++) {
+        /* config again on every loop, a coefficient shared with the other task is overwritten */
+        if (mcax_fir_fxp32_coeff32_config(t->mca, t->coeff, t->order) != 0
+            || mcax_fir_fxp32(t->mca, t->in, TEST_SIZE, t->out) != 0
+            || memcmp(t->out, t->ref, (TEST_SIZE - t->order) * sizeof(fxp32_t)) != 0) {
+            t->bad++;
+        }
+    }
+    aos_sem_signal(&g_mca.done);
+}
+
+static int _instance_check(const char *name)
+{
+    int i, rc;
+    aos_task_t task;
+    static test_task_t tasks[2];
+
+    rc = aos_sem_new(&g_mca.done, 0);
+    TEST_ASSERT(name, rc == 0);
+    for (i = 0; i < ARRAY_SIZE(tasks); i++) {
+        test_task_t *t = &tasks[i];
+
+        memset(t, 0, sizeof(test_task_t));
+        t->order = TEST_FIR_ORDER_MAX - i * 8;
+        _fill(t->coeff, t->order + 1, 32 - TEST_COEFF_SHIFT);
+        _fill(t->in, TEST_SIZE, 1);
+        _fir_ref(t->coeff, t->order, t->in, TEST_SIZE, t->ref);
+        t->mca = mcax_new(MCA_TYPE_FIR);
+        TEST_ASSERT(name, t->mca);
+    }
+    for (i = 0; i < ARRAY_SIZE(tasks); i++) {
+        rc = aos_task_new_ext(&task, "mca_test", _fir_task, &tasks[i], 4096, AOS_DEFAULT_APP_PRI);
+        TEST_ASSERT(name, rc == 0);
+    }
+
+    /* the tasks are left behind on a timeout, the test is over anyway */
+    for (i = 0; i < ARRAY_SIZE(tasks); i++) {
+        rc = aos_sem_wait(&g_mca.done, TEST_TIMEOUT_MS);
+        TEST_ASSERT(name, rc == 0);
+    }
+    for (i = 0; i < ARRAY_SIZE(tasks); i++) {
+        TEST_ASSERT(name, tasks[i].bad == 0);
+        mcax_free(tasks[i].mca);
+    }
+    aos_sem_free(&g_mca.done);
+
+    return 0;
+}
+
+/**
+ * @brief  test the mca_local backend: iir & fir against a reference, instances side by side
+ * @return 0/-1
+ */
+int mca_local_test(void)
+{
+    int rc = 0;
+
+    /* refused when the app has registered it yet */
+    mcax_register();
+    g_mca.seed = 1;
+    rc |= _iir_check("mca iir");
+    rc |= _fir_check("mca fir");
+    rc |= _instance_check("mca instance");
+
+    if (rc == 0) {
+        printf("test over, all pass\n");
+    }
+
+    return rc;
+}
+#endif
@@ -0,0 +1,435 @@
+/*
+ * Copyright (C) 2018-2020 Alibaba Group Holding Limited
+ */
+
+#if defined(CONFIG_DEMUXER_WAV) && CONFIG_DEMUXER_WAV && defined(CONFIG_DECODER_PCM) && CONFIG_DECODER_PCM \
+    && (CONFIG_AV_AO_CHANNEL_NUM == 2)
+#include <stdio.h>
+#include <string.h>
+#include <aos/aos.h>
+#include "avutil/av_config.h"
+#include "stream/stream.h"
+#include "stream/stream_cls.h"
+#include "output/ao.h"
+#include "output/ao_cls.h"
+#include "avformat/avformat_all.h"
+#include "avcodec/avcodec_all.h"
+#include "player.h"
+
+/*
+ * the player plays a wav through a stream which stalls now and then, into a sink which
+ * keeps TEST_SINK_MS of pcm and counts its underruns. the pcm carries the index of each
+ * sample frame, so the sink also checks that nothing is lost, repeated or reordered.
+ * a track starts again from index 0, which is how the sink sees a gapless switch
+ */
+
+#define TEST_ASSERT(name, v)  do { \
+                            if (!(v)) { \
+                                printf("ASSERT[%s] %d\n", name, __LINE__); \
+                                return -1; \
+                            } \
+                        } while(0);
+
+#define TEST_URL               "plytest://pipe.wav"
+#define TEST_RATE              (16000)
+#define TEST_BYTES_PER_MS      (TEST_RATE / 1000 * 4)
+#define TEST_PLAY_MS           (3000)
+#define TEST_DATA_SIZE         (TEST_PLAY_MS * TEST_BYTES_PER_MS)
+#define TEST_WAV_HEAD          (44)
+#define TEST_STALL_MS          (200)
+#define TEST_STALL_EVERY       (750 * TEST_BYTES_PER_MS)
+#define TEST_SINK_MS           (150)
+#define TEST_SEEK_MS           (2000)
+#define TEST_ERR_MS            (1000)
+
+struct test_priv {
+    int32_t                    pos;
+    int32_t                    stall_at;
+};
+
+static struct {
+    uint8_t                    *wav;
+    int32_t                    err_at;        ///< reads fail from here, 0: never
+    int                        err_hit;       ///< reads failed
+
+    long long                  dry_at;        ///< the sink runs dry then, 0: stopped
+    uint8_t                    resync;        ///< the next frame starts a new position
+    uint32_t                   first;         ///< frame index played first after a resync
+    uint32_t                   next;          ///< frame index expected
+    int                        tracks;        ///< tracks started without a resync
+    int                        underrun;
+    int                        bad;
+
+    aos_sem_t                  done;
+    uint8_t                    evt;
+    int                        next_start;
+} g_pipe;
+
+static void _wr_le(uint8_t *p, uint32_t v, int n)
+{
+    while (n--) {
+        *p++ = v;
+        v >>= 8;
+    }
+}
+
+static uint8_t* _wav_new(void)
+{
+    uint32_t i;
+    uint8_t *wav, *p;
+
+    wav = aos_malloc(TEST_WAV_HEAD + TEST_DATA_SIZE);
+    if (!wav) {
+        return NULL;
+    }
+
+    memcpy(wav, "RIFF", 4);
+    _wr_le(wav + 4, TEST_WAV_HEAD - 8 + TEST_DATA_SIZE, 4);
+    memcpy(wav + 8, "WAVEfmt ", 8);
+    _wr_le(wav + 16, 16, 4);
+    _wr_le(wav + 20, 1, 2);
+    _wr_le(wav + 22, 2, 2);
+    _wr_le(wav + 24, TEST_RATE, 4);
+    _wr_le(wav + 28, TEST_RATE * 4, 4);
+    _wr_le(wav + 32, 4, 2);
+    _wr_le(wav + 34, 16, 2);
+    memcpy(wav + 36, "data", 4);
+    _wr_le(wav + 40, TEST_DATA_SIZE, 4);
+
+    /* the two channels carry the index of the sample frame */
+    p = wav + TEST_WAV_HEAD;
+    for (i = 0; i < TEST_DATA_SIZE / 4; i++, p += 4) {
+        _wr_le(p, i, 4);
+    }
+
+    return wav;
+}
+
+static int _stream_test_open(stream_cls_t *o, int mode)
+{
+    struct test_priv *priv;
+
+    UNUSED(mode);
+    priv = aos_zalloc(sizeof(struct test_priv));
+    if (!priv) {
+        return -1;
+    }
+    priv->stall_at = TEST_STALL_EVERY;
+    o->size        = TEST_WAV_HEAD + TEST_DATA_SIZE;
+    o->priv        = priv;
+
+    return 0;
+}
+
+static int _stream_test_close(stream_cls_t *o)
+{
+    aos_freep((char**)&o->priv);
+    return 0;
+}
+
+static int _stream_test_read(stream_cls_t *o, uint8_t *buf, size_t count)
+{
+    int len;
+    struct test_priv *priv = o->priv;
+
+    if (g_pipe.err_at && priv->pos >= g_pipe.err_at) {
+        g_pipe.err_hit++;
+        return -1;
+    }
+    if (priv->pos >= priv->stall_at) {
+        /* the network hangs for a while */
+        aos_msleep(TEST_STALL_MS);
+        priv->stall_at += TEST_STALL_EVERY;
+    }
+
+    len = MIN(o->size - priv->pos, count);
+    len = g_pipe.err_at ? MIN(g_pipe.err_at - priv->pos, len) : len;
+    memcpy(buf, g_pipe.wav + priv->pos, len);
+    priv->pos += len;
+
+    return len;
+}
+
+static int _stream_test_write(stream_cls_t *o, const uint8_t *buf, size_t count)
+{
+    return -1;
+}
+
+static int _stream_test_seek(stream_cls_t *o, int32_t pos)
+{
+    struct test_priv *priv = o->priv;
+
+    if (pos < 0 || pos > o->size) {
+        return -1;
+    }
+    priv->pos      = pos;
+    priv->stall_at = (pos / TEST_STALL_EVERY + 1) * TEST_STALL_EVERY;
+
+    return 0;
+}
+
+static int _stream_test_control(stream_cls_t *o, int cmd, void *arg, size_t *arg_size)
+{
+    return -1;
+}
+
+static const struct stream_ops stream_ops_test = {
+    .name            = "plytest",
+    .type            = STREAM_TYPE_MEM,
+    .protocols       = { "plytest", NULL },
+
+    .open            = _stream_test_open,
+    .close           = _stream_test_close,
+    .read            = _stream_test_read,
+    .write           = _stream_test_write,
+    .seek            = _stream_test_seek,
+    .control         = _stream_test_control,
+};
+
+static int _ao_test_open(ao_cls_t *o, sf_t sf)
+{
+    return 0;
+}
+
+static int _ao_test_start(ao_cls_t *o)
+{
+    return 0;
+}
+
+static int _ao_test_stop(ao_cls_t *o)
+{
+    g_pipe.dry_at = 0;
+    g_pipe.resync = 1;
+    return 0;
+}
+
+static int _ao_test_drain(ao_cls_t *o)
+{
+    return 0;
+}
+
+static int _ao_test_close(ao_cls_t *o)
+{
+    return 0;
+}
+
+static int _ao_test_write(ao_cls_t *o, const uint8_t *buf, size_t count)
+{
+    size_t i;
+    uint32_t idx;
+    long long now = aos_now_ms();
+
+    if (g_pipe.dry_at && now > g_pipe.dry_at) {
+        g_pipe.underrun++;
+    }
+
+    for (i = 0; i + 4 <= count; i += 4) {
+        idx = buf[i] | buf[i + 1] << 8 | buf[i + 2] << 16 | (uint32_t)buf[i + 3] << 24;
+        if (g_pipe.resync) {
+            g_pipe.resync = 0;
+            g_pipe.first  = idx;
+        } else if (idx == 0) {
+            g_pipe.tracks++;
+        } else if (idx != g_pipe.next) {
+            g_pipe.bad++;
+        }
+        g_pipe.next = idx + 1;
+    }
+
+    /* the sink holds TEST_SINK_MS, the writer blocks on the rest */
+    g_pipe.dry_at = MAX(now, g_pipe.dry_at) + count / TEST_BYTES_PER_MS;
+    if (g_pipe.dry_at - now > TEST_SINK_MS) {
+        aos_msleep(g_pipe.dry_at - now - TEST_SINK_MS);
+    }
+
+    return count;
+}
+
+static const struct ao_ops ao_ops_test = {
+    .name          = "plytest",
+
+    .open          = _ao_test_open,
+    .start         = _ao_test_start,
+    .stop          = _ao_test_stop,
+    .drain         = _ao_test_drain,
+    .close         = _ao_test_close,
+    .write         = _ao_test_write,
+};
+
+static void _player_event(player_t *player, uint8_t type, const void *data, uint32_t len)
+{
+    if (type == PLAYER_EVENT_NEXT_START) {
+        g_pipe.next_start++;
+    } else if (type == PLAYER_EVENT_FINISH || type == PLAYER_EVENT_ERROR) {
+        g_pipe.evt = type;
+        aos_sem_signal(&g_pipe.done);
+    }
+}
+
+static player_t* _player_new(void)
+{
+    ply_conf_t ply_cnf;
+
+    player_conf_init(&ply_cnf);
+    ply_cnf.ao_name  = "plytest";
+    ply_cnf.event_cb = _player_event;
+
+    g_pipe.dry_at   = 0;
+    g_pipe.resync   = 1;
+    g_pipe.next     = 0;
+    g_pipe.tracks   = 0;
+    g_pipe.underrun = 0;
+    g_pipe.bad      = 0;
+    g_pipe.err_at   = 0;
+    g_pipe.err_hit  = 0;
+    g_pipe.evt      = PLAYER_EVENT_UNKNOWN;
+    g_pipe.next_start = 0;
+
+    return player_new(&ply_cnf);
+}
+
+/* the whole stream, the stalls are hidden by the read ahead when the stages have their tasks */
+static int _pipe_check(const char *name)
+{
+    int rc;
+    player_t *player;
+
+    player = _player_new();
+    TEST_ASSERT(name, player);
+    rc = player_play(player, TEST_URL, 0);
+    TEST_ASSERT(name, rc == 0);
+    rc = aos_sem_wait(&g_pipe.done, 3 * TEST_PLAY_MS);
+    printf("%s: %d underruns\n", name, g_pipe.underrun);
+    player_stop(player);
+    player_free(player);
+
+    TEST_ASSERT(name, rc == 0 && g_pipe.evt == PLAYER_EVENT_FINISH);
+    TEST_ASSERT(name, g_pipe.bad == 0 && g_pipe.first == 0 && g_pipe.tracks == 0);
+    TEST_ASSERT(name, g_pipe.next == TEST_DATA_SIZE / 4);
+#if CONFIG_PLAYER_DEMUX_TASK_STACK_SIZE && CONFIG_PLAYER_OUTPUT_TASK_STACK_SIZE
+    TEST_ASSERT(name, g_pipe.underrun == 0);
+#endif
+
+    return 0;
+}
+
+/* what was queued before the seek is not played */
+static int _seek_check(const char *name)
+{
+    int rc;
+    player_t *player;
+    uint32_t pos = TEST_SEEK_MS * (TEST_RATE / 1000);
+
+    player = _player_new();
+    TEST_ASSERT(name, player);
+    rc = player_play(player, TEST_URL, 0);
+    TEST_ASSERT(name, rc == 0);
+    aos_msleep(500);
+    rc = player_seek(player, TEST_SEEK_MS);
+    if (rc == 0) {
+        rc = aos_sem_wait(&g_pipe.done, 3 * TEST_PLAY_MS);
+    }
+    player_stop(player);
+    player_free(player);
+
+    TEST_ASSERT(name, rc == 0 && g_pipe.evt == PLAYER_EVENT_FINISH);
+    TEST_ASSERT(name, g_pipe.bad == 0);
+    TEST_ASSERT(name, g_pipe.first >= pos && g_pipe.first < pos + CONFIG_AV_SAMPLE_NUM_PER_FRAME_MAX);
+    TEST_ASSERT(name, g_pipe.next == TEST_DATA_SIZE / 4);
+
+    return 0;
+}
+
+/* the next track follows the current one without a gap, then one more is refused */
+static int _next_check(const char *name)
+{
+    int rc;
+    player_t *player;
+
+    player = _player_new();
+    TEST_ASSERT(name, player);
+    rc = player_play(player, TEST_URL, 0);
+    TEST_ASSERT(name, rc == 0);
+    aos_msleep(500);
+    rc = player_set_next(player, TEST_URL);
+    if (rc == 0) {
+        rc = player_set_next(player, TEST_URL) == 0 ? -1 : 0;
+    }
+    if (rc == 0) {
+        rc = aos_sem_wait(&g_pipe.done, 3 * 2 * TEST_PLAY_MS);
+    }
+    player_stop(player);
+    player_free(player);
+
+    TEST_ASSERT(name, rc == 0 && g_pipe.evt == PLAYER_EVENT_FINISH);
+    TEST_ASSERT(name, g_pipe.next_start == 1 && g_pipe.tracks == 1);
+    TEST_ASSERT(name, g_pipe.bad == 0 && g_pipe.first == 0);
+    TEST_ASSERT(name, g_pipe.next == TEST_DATA_SIZE / 4);
+
+    return 0;
+}
+
+/* a failed stream ends the track where it failed, too late then for the next track */
+static int _error_check(const char *name)
+{
+    int i, rc;
+    player_t *player;
+
+    player = _player_new();
+    TEST_ASSERT(name, player);
+    g_pipe.err_at = TEST_WAV_HEAD + TEST_ERR_MS * TEST_BYTES_PER_MS;
+    rc = player_play(player, TEST_URL, 0);
+    TEST_ASSERT(name, rc == 0);
+    /* the stream reads ahead of the demuxer, which sees the error at the second failed read */
+    for (i = 0; i < 3 * TEST_PLAY_MS / 10 && g_pipe.err_hit < 2; i++) {
+        aos_msleep(10);
+    }
+    aos_msleep(10);
+    rc = g_pipe.err_hit >= 2 && player_set_next(player, TEST_URL) != 0 ? 0 : -1;
+    if (rc == 0) {
+        rc = aos_sem_wait(&g_pipe.done, 3 * TEST_PLAY_MS);
+    }
+    player_stop(player);
+    player_free(player);
+
+    TEST_ASSERT(name, rc == 0 && g_pipe.evt == PLAYER_EVENT_FINISH);
+    TEST_ASSERT(name, g_pipe.bad == 0 && g_pipe.first == 0 && g_pipe.next_start == 0);
+    TEST_ASSERT(name, g_pipe.next == TEST_ERR_MS * (TEST_RATE / 1000));
+
+    return 0;
+}
+
+/**
+ * @brief  test the player pipeline: read ahead over the stalls, order of the pcm, seek,
+ *         the next track and a failed stream
+ * @return 0/-1
+ */
+int player_pipe_test(void)
+{
+    int rc;
+
+    player_init();
+    stream_ops_register(&stream_ops_test);
+    ao_ops_register(&ao_ops_test);
+    demux_register_wav();
+    ad_register_pcm();
+
+    g_pipe.wav = _wav_new();
+    TEST_ASSERT("pipe", g_pipe.wav);
+    rc = aos_sem_new(&g_pipe.done, 0);
+    TEST_ASSERT("pipe", rc == 0);
+
+    rc = _pipe_check("pipe");
+    rc |= _seek_check("seek");
+    rc |= _next_check("next");
+    rc |= _error_check("error");
+
+    aos_sem_free(&g_pipe.done);
+    aos_freep((char**)&g_pipe.wav);
+    if (rc == 0) {
+        printf("test over, all pass\n");
+    }
+
+    return rc;
+}
+#endif
@@ -3,6 +3,7 @@
  */
 
 #include <ipc.h>
+#include <ipc_ring.h>
 #include <csi_core.h>
 #include <aos/kernel.h>
 #include "avcodec/avcodec.h"
@@ -19,6 +20,16 @@ struct ad_icore_cp_priv {
     uint8_t        qbuf[sizeof(message_t) * MESSAGE_NUM];
 };
 
+/* async decode rings attached by ad_icore on the ap */
+struct ad_icore_cp_ring {
+    slist_t        node;
+    void           *ad;
+    ipc_ring_t     req;
+    ipc_ring_t     cpl;
+};
+
+static slist_t g_ring_list;
+
 static int _icore_ad_open(icore_msg_t *msg)
 {
     ad_conf_t ad_cnf;
@@ -67,6 +78,7 @@ static int _icore_ad_decode(icore_msg_t *msg)
     pkt.data = inp->es_data;
     if (ad) {
         csi_dcache_invalid_range((uint32_t*)pkt.data, pkt.len);
+        /* the decoders of the cp are local ones, they hold no frame back, no ad_flush needed */
         rc = ad_decode(ad, &frame, &got_frame, (const avpacket_t*)&pkt);
         if ((rc >= 0) && got_frame) {
             inp->got_frame = got_frame;
@@ -93,6 +105,43 @@ static int _icore_ad_reset(icore_msg_t *msg)
     return rc;
 }
 
+static int _icore_ad_ring(icore_msg_t *msg)
+{
+    ad_icore_ring_t *inp;
+    struct ad_icore_cp_ring *ring;
+
+    inp = icore_get_msg(msg, ad_icore_ring_t);
+    CHECK_RET_TAG_WITH_RET(inp && inp->ad, -1);
+
+    ring = aos_zalloc(sizeof(struct ad_icore_cp_ring));
+    CHECK_RET_TAG_WITH_RET(ring, -1);
+
+    if (ipc_ring_attach(&ring->req, inp->req_ring, inp->ring_flag) != 0 ||
+        ipc_ring_attach(&ring->cpl, inp->cpl_ring, inp->ring_flag) != 0) {
+        LOGE(TAG, "ring attach faild");
+        aos_free(ring);
+        return -1;
+    }
+    ring->ad = inp->ad;
+    slist_add_tail(&ring->node, &g_ring_list);
+
+    return 0;
+}
+
+static void _ring_detach(void *ad)
+{
+    slist_t *tmp;
+    struct ad_icore_cp_ring *ring;
+
+    slist_for_each_entry_safe(&g_ring_list, tmp, ring, struct ad_icore_cp_ring, node) {
+        if (ring->ad == ad) {
+            slist_del(&ring->node, &g_ring_list);
+            aos_free(ring);
+            break;
+        }
+    }
+}
+
 static int _icore_ad_close(icore_msg_t *msg)
 {
     int rc = -1;
@@ -101,6 +150,7 @@ static int _icore_ad_close(icore_msg_t *msg)
     inp = icore_get_msg(msg, ad_icore_close_t);
     CHECK_RET_TAG_WITH_RET(inp, -1);
 
+    _ring_detach(inp->ad);
     if (inp->ad) {
         rc = ad_close(inp->ad);
     }
@@ -117,13 +167,60 @@ static struct {
     { ICORE_CMD_AD_DECODE, _icore_ad_decode       },
     { ICORE_CMD_AD_RESET, _icore_ad_reset       },
     { ICORE_CMD_AD_CLOSE, _icore_ad_close        },
+    { ICORE_CMD_AD_RING, _icore_ad_ring          },
 };
 
+static void _ring_kick(struct ad_icore_cp_priv *priv)
+{
+    message_t msg;
+
+    memset(&msg, 0, sizeof(message_t));
+    msg.service_id = AD_ICORE_IPC_SERIVCE_ID;
+    msg.command    = IPC_CMD_AD_ICORE_KICK;
+    msg.flag       = MESSAGE_ASYNC;
+    ipc_message_send(priv->ipc, &msg, AOS_WAIT_FOREVER);
+}
+
+/* decode every queued packet, the completions are published one by one so the ap wakes up early */
+static void _ring_poll(struct ad_icore_cp_priv *priv)
+{
+    int busy;
+    icore_msg_t *data;
+    ad_icore_desc_t *desc;
+    struct ad_icore_cp_ring *ring;
+    size_t size = ICORE_MSG_SIZE + sizeof(ad_icore_decode_t);
+
+    do {
+        busy = 0;
+        slist_for_each_entry(&g_ring_list, ring, struct ad_icore_cp_ring, node) {
+            while ((desc = ipc_ring_peek(&ring->req)) != NULL) {
+                data = desc->msg;
+                ipc_ring_pop(&ring->req);
+
+                csi_dcache_invalid_range((uint32_t*)data, size);
+                data->ret.code = _icore_ad_decode(data);
+                csi_dcache_clean_invalid_range((uint32_t*)data, size);
+
+                while ((desc = ipc_ring_reserve(&ring->cpl)) == NULL) {
+                    aos_msleep(1);
+                }
+                desc->msg = data;
+                ipc_ring_push(&ring->cpl);
+                if (ipc_ring_publish(&ring->cpl)) {
+                    _ring_kick(priv);
+                }
+            }
+            busy |= ipc_ring_idle(&ring->req);
+        }
+    } while (busy);
+}
+
 static void _ipc_process(ipc_t *ipc, message_t *msg, void *arg)
 {
     struct ad_icore_cp_priv *priv = arg;
 
     switch (msg->command) {
+    case IPC_CMD_AD_ICORE_KICK:
     case IPC_CMD_AD_ICORE: {
         aos_queue_send(&priv->queue, msg, sizeof(message_t));
     }
@@ -143,6 +240,10 @@ static void _ad_icore_cp_task(void *arg)
 
     for (;;) {
         aos_queue_recv(&priv->queue, AOS_WAIT_FOREVER, &msg, &len);
+        if (msg.command == IPC_CMD_AD_ICORE_KICK) {
+            _ring_poll(priv);
+            continue;
+        }
         data = (icore_msg_t*)msg.req_data;
 
         if (data && (msg.req_len == (ICORE_MSG_SIZE + data->size))) {
@@ -159,6 +260,9 @@ static void _ad_icore_cp_task(void *arg)
             memcpy(msg.resp_data, msg.req_data, msg.req_len);
             ipc_message_ack(priv->ipc, &msg, AOS_WAIT_FOREVER);
         }
+
+        /* a doorbell may be dropped when the queue is full */
+        _ring_poll(priv);
     }
 }
 
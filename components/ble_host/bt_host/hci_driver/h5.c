@@ -313,11 +313,40 @@ static __inline uint16_t bit_rev16(uint16_t x)
     return (bit_rev8(x & 0xff) << 8) | bit_rev8(x >> 8);
 }
 
-static const uint16_t crc_table[] = {
-    0x0000, 0x1081, 0x2102, 0x3183,
-    0x4204, 0x5285, 0x6306, 0x7387,
-    0x8408, 0x9489, 0xa50a, 0xb58b,
-    0xc60c, 0xd68d, 0xe70e, 0xf78f
+/* byte-wise table of the reflected CRC-CCITT (poly 0x8408) */
+static const uint16_t crc_table[256] = {
+    0x0000, 0x1189, 0x2312, 0x329b, 0x4624, 0x57ad, 0x6536, 0x74bf,
+    0x8c48, 0x9dc1, 0xaf5a, 0xbed3, 0xca6c, 0xdbe5, 0xe97e, 0xf8f7,
+    0x1081, 0x0108, 0x3393, 0x221a, 0x56a5, 0x472c, 0x75b7, 0x643e,
+    0x9cc9, 0x8d40, 0xbfdb, 0xae52, 0xdaed, 0xcb64, 0xf9ff, 0xe876,
+    0x2102, 0x308b, 0x0210, 0x1399, 0x6726, 0x76af, 0x4434, 0x55bd,
+    0xad4a, 0xbcc3, 0x8e58, 0x9fd1, 0xeb6e, 0xfae7, 0xc87c, 0xd9f5,
+    0x3183, 0x200a, 0x1291, 0x0318, 0x77a7, 0x662e, 0x54b5, 0x453c,
+    0xbdcb, 0xac42, 0x9ed9, 0x8f50, 0xfbef, 0xea66, 0xd8fd, 0xc974,
+    0x4204, 0x538d, 0x6116, 0x709f, 0x0420, 0x15a9, 0x2732, 0x36bb,
+    0xce4c, 0xdfc5, 0xed5e, 0xfcd7, 0x8868, 0x99e1, 0xab7a, 0xbaf3,
+    0x5285, 0x430c, 0x7197, 0x601e, 0x14a1, 0x0528, 0x37b3, 0x263a,
+    0xdecd, 0xcf44, 0xfddf, 0xec56, 0x98e9, 0x8960, 0xbbfb, 0xaa72,
+    0x6306, 0x728f, 0x4014, 0x519d, 0x2522, 0x34ab, 0x0630, 0x17b9,
+    0xef4e, 0xfec7, 0xcc5c, 0xddd5, 0xa96a, 0xb8e3, 0x8a78, 0x9bf1,
+    0x7387, 0x620e, 0x5095, 0x411c, 0x35a3, 0x242a, 0x16b1, 0x0738,
+    0xffcf, 0xee46, 0xdcdd, 0xcd54, 0xb9eb, 0xa862, 0x9af9, 0x8b70,
+    0x8408, 0x9581, 0xa71a, 0xb693, 0xc22c, 0xd3a5, 0xe13e, 0xf0b7,
+    0x0840, 0x19c9, 0x2b52, 0x3adb, 0x4e64, 0x5fed, 0x6d76, 0x7cff,
+    0x9489, 0x8500, 0xb79b, 0xa612, 0xd2ad, 0xc324, 0xf1bf, 0xe036,
+    0x18c1, 0x0948, 0x3bd3, 0x2a5a, 0x5ee5, 0x4f6c, 0x7df7, 0x6c7e,
+    0xa50a, 0xb483, 0x8618, 0x9791, 0xe32e, 0xf2a7, 0xc03c, 0xd1b5,
+    0x2942, 0x38cb, 0x0a50, 0x1bd9, 0x6f66, 0x7eef, 0x4c74, 0x5dfd,
+    0xb58b, 0xa402, 0x9699, 0x8710, 0xf3af, 0xe226, 0xd0bd, 0xc134,
+    0x39c3, 0x284a, 0x1ad1, 0x0b58, 0x7fe7, 0x6e6e, 0x5cf5, 0x4d7c,
+    0xc60c, 0xd785, 0xe51e, 0xf497, 0x8028, 0x91a1, 0xa33a, 0xb2b3,
+    0x4a44, 0x5bcd, 0x6956, 0x78df, 0x0c60, 0x1de9, 0x2f72, 0x3efb,
+    0xd68d, 0xc704, 0xf59f, 0xe416, 0x90a9, 0x8120, 0xb3bb, 0xa232,
+    0x5ac5, 0x4b4c, 0x79d7, 0x685e, 0x1ce1, 0x0d68, 0x3ff3, 0x2e7a,
+    0xe70e, 0xf687, 0xc41c, 0xd595, 0xa12a, 0xb0a3, 0x8238, 0x93b1,
+    0x6b46, 0x7acf, 0x4854, 0x59dd, 0x2d62, 0x3ceb, 0x0e70, 0x1ff9,
+    0xf78f, 0xe606, 0xd49d, 0xc514, 0xb1ab, 0xa022, 0x92b9, 0x8330,
+    0x7bc7, 0x6a4e, 0x58d5, 0x495c, 0x3de3, 0x2c6a, 0x1ef1, 0x0f78
 };
 
 // Initialise the crc calculator
@@ -329,12 +358,25 @@ static const uint16_t crc_table[] = {
 * @param crc crc data
 * @param d one byte data
 */
-static void h5_crc_update(uint16_t *crc, uint8_t d)
+static inline void h5_crc_update(uint16_t *crc, uint8_t d)
+{
+    *crc = (*crc >> 8) ^ crc_table[(*crc ^ d) & 0xff];
+}
+
+/**
+* Add a run of bytes into crc scope
+*
+* @param crc crc data
+* @param data bytes
+* @param len num of bytes
+*/
+static void h5_crc_update_buf(uint16_t *crc, const uint8_t *data, uint32_t len)
 {
     uint16_t reg = *crc;
 
-    reg = (reg >> 4) ^ crc_table[(reg ^ d) & 0x000f];
-    reg = (reg >> 4) ^ crc_table[(reg ^ (d >> 4)) & 0x000f];
+    while (len--) {
+        reg = (reg >> 8) ^ crc_table[(reg ^ *data++) & 0xff];
+    }
 
     *crc = reg;
 }
@@ -366,52 +408,67 @@ static void h5_slip_msgdelim(sk_buff *skb)
 }
 
 /**
-* Slip ecode one byte in h5 proto, as follows:
-* 0xc0 -> 0xdb, 0xdc
-* 0xdb -> 0xdb, 0xdd
-* 0x11 -> 0xdb, 0xde
-* 0x13 -> 0xdb, 0xdf
-* others will not change
+* Get the second byte of the slip escape sequence of a byte:
+* 0xc0 -> 0xdc
+* 0xdb -> 0xdd
+* 0x11 -> 0xde (only with oof flow control)
+* 0x13 -> 0xdf (only with oof flow control)
+* others -> 0, no escape
 *
-* @param skb socket buffer
-* @c pure data in the one byte
+* @param c pure data in the one byte
+* @param oof oof flow control is used
+* @return escape code
 */
-static void h5_slip_one_byte(sk_buff *skb, uint8_t unencode_form)
+static inline uint8_t h5_slip_esc_code(uint8_t c, int oof)
 {
-    const signed char esc_c0[2] = { 0xdb, 0xdc };
-    const signed char esc_db[2] = { 0xdb, 0xdd };
-    const signed char esc_11[2] = { 0xdb, 0xde };
-    const signed char esc_13[2] = { 0xdb, 0xdf };
-
-    switch (unencode_form) {
+    switch (c) {
         case 0xc0:
-            memcpy(hci_skb_put(skb, 2), &esc_c0, 2);
-            break;
+            return 0xdc;
 
         case 0xdb:
-            memcpy(hci_skb_put(skb, 2), &esc_db, 2);
-            break;
+            return 0xdd;
 
-        case 0x11: {
-            if (rtk_h5.oof_flow_control) {
-                memcpy(hci_skb_put(skb, 2), &esc_11, 2);
-            } else {
-                memcpy(hci_skb_put(skb, 1), &unencode_form, 1);
-            }
+        case 0x11:
+            return oof ? 0xde : 0;
+
+        case 0x13:
+            return oof ? 0xdf : 0;
+
+        default:
+            return 0;
+    }
+}
+
+/**
+* Slip encode a run of bytes in h5 proto, the bytes between two escaped
+* ones are copied at once
+*
+* @param skb socket buffer, with room for the worst case (len * 2)
+* @param data pure data
+* @param len num of data
+*/
+static void h5_slip_buf(sk_buff *skb, const uint8_t *data, uint32_t len)
+{
+    const uint8_t *end = data + len;
+    const uint8_t *run;
+    uint8_t esc[2] = { 0xdb, 0 };
+    int oof = rtk_h5.oof_flow_control;
+
+    while (data < end) {
+        run = data;
+
+        while (data < end && h5_slip_esc_code(*data, oof) == 0) {
+            data++;
         }
-        break;
 
-        case 0x13: {
-            if (rtk_h5.oof_flow_control) {
-                memcpy(hci_skb_put(skb, 2), &esc_13, 2);
-            } else {
-                memcpy(hci_skb_put(skb, 1), &unencode_form, 1);
-            }
+        if (data > run) {
+            memcpy(hci_skb_put(skb, data - run), run, data - run);
         }
-        break;
 
-        default:
-            memcpy(hci_skb_put(skb, 1), &unencode_form, 1);
+        if (data < end) {
+            esc[1] = h5_slip_esc_code(*data++, oof);
+            memcpy(hci_skb_put(skb, 2), esc, 2);
+        }
     }
 }
 
@@ -503,6 +560,52 @@ static void h5_unslip_one_byte(tHCI_H5_CB *h5, unsigned char byte)
     }
 }
 
+/**
+* Decode a run of received bytes in h5 proto, the bytes between two escape
+* sequences are copied and added into crc scope at once. It stops at the
+* end of the current field (rx_count), at a 0xc0 or on a decode error.
+*
+* @param h5 realtek h5 struct
+* @param data received data
+* @param count num of data
+* @return num of consumed data
+*/
+static uint32_t h5_unslip_buf(tHCI_H5_CB *h5, const uint8_t *data, uint32_t count)
+{
+    const uint8_t *ptr = data;
+    const uint8_t *end = data + count;
+    const uint8_t *run;
+    uint8_t *hdr;
+    uint32_t len;
+
+    while (h5->rx_count && ptr < end && *ptr != 0xc0) {
+        if (H5_ESCSTATE_NOESC != h5->rx_esc_state || *ptr == 0xdb) {
+            h5_unslip_one_byte(h5, *ptr++);
+            continue;
+        }
+
+        run = ptr;
+        len = (uint32_t)(end - ptr) < h5->rx_count ? (uint32_t)(end - ptr) : h5->rx_count;
+
+        while (len && *ptr != 0xc0 && *ptr != 0xdb) {
+            ptr++;
+            len--;
+        }
+
+        memcpy(hci_skb_put(h5->rx_skb, ptr - run), run, ptr - run);
+        h5->rx_count -= ptr - run;
+
+        // header is in skb now, check Pkt Header's CRC enable bit
+        hdr = (uint8_t *)hci_skb_get_data(h5->rx_skb);
+
+        if (H5_HDR_CRC(hdr) && h5->rx_state != H5_W4_CRC) {
+            h5_crc_update_buf(&h5->message_crc, run, ptr - run);
+        }
+    }
+
+    return ptr - data;
+}
+
 /**
 * Prepare h5 packet, packet format as follow:
 *  | LSB 4 octets  | 0 ~4095| 2 MSB
@@ -524,8 +627,9 @@ static sk_buff *h5_prepare_pkt(tHCI_H5_CB *h5, uint8_t *data, signed long len, s
 {
     sk_buff *nskb;
     uint8_t hdr[4];
+    uint8_t crc[2];
     uint16_t H5_CRC_INIT(h5_txmsg_crc);
-    int rel, i;
+    int rel;
     //BT_DBG("HCI h5_prepare_pkt");
 
     switch (pkt_type) {
@@ -586,29 +690,18 @@ static sk_buff *h5_prepare_pkt(tHCI_H5_CB *h5, uint8_t *data, signed long len, s
     // set checksum
     hdr[3] = ~(hdr[0] + hdr[1] + hdr[2]);
 
-    // Put h5 header */
-    for (i = 0; i < 4; i++) {
-        h5_slip_one_byte(nskb, hdr[i]);
-
-        if (h5->use_crc) {
-            h5_crc_update(&h5_txmsg_crc, hdr[i]);
-        }
-    }
-
-    // Put payload */
-    for (i = 0; i < len; i++) {
-        h5_slip_one_byte(nskb, data[i]);
-
-        if (h5->use_crc) {
-            h5_crc_update(&h5_txmsg_crc, data[i]);
-        }
-    }
+    // Put h5 header and payload */
+    h5_slip_buf(nskb, hdr, 4);
+    h5_slip_buf(nskb, data, len);
 
     // Put CRC */
     if (h5->use_crc) {
+        h5_crc_update_buf(&h5_txmsg_crc, hdr, 4);
+        h5_crc_update_buf(&h5_txmsg_crc, data, len);
         h5_txmsg_crc = bit_rev16(h5_txmsg_crc);
-        h5_slip_one_byte(nskb, (uint8_t)((h5_txmsg_crc >> 8) & 0x00ff));
-        h5_slip_one_byte(nskb, (uint8_t)(h5_txmsg_crc & 0x00ff));
+        crc[0] = (uint8_t)((h5_txmsg_crc >> 8) & 0x00ff);
+        crc[1] = (uint8_t)(h5_txmsg_crc & 0x00ff);
+        h5_slip_buf(nskb, crc, 2);
     }
 
     // Add SLIP end byte: 0xc0
@@ -1156,6 +1249,7 @@ static uint32_t h5_recv(tHCI_H5_CB *h5, uint8_t *data, int count)
     uint8_t *ptr;
     uint8_t *skb_data = NULL;
     uint8_t *hdr = NULL;
+    uint32_t consumed;
     bool     complete_packet = 0;
 
     ptr = (uint8_t *)data;
@@ -1169,12 +1263,14 @@ static uint32_t h5_recv(tHCI_H5_CB *h5, uint8_t *data, int count)
                 hci_skb_free(&h5->rx_skb);
                 h5->rx_state = H5_W4_PKT_START;
                 h5->rx_count = 0;
+                ptr++;
+                count--;
             } else {
-                h5_unslip_one_byte(h5, *ptr);
+                consumed = h5_unslip_buf(h5, ptr, count);
+                ptr += consumed;
+                count -= consumed;
             }
 
-            ptr++;
-            count--;
             continue;
         }
 
@@ -1583,14 +1679,19 @@ static void hci_h5_cleanup(void)
 static uint8_t data_buffer[4096] = {0};
 static uint32_t hci_h5_receive_msg(uint8_t *byte, uint16_t length)
 {
-    uint32_t read_len = hci_recv(rtk_h5.hci_dev, data_buffer, sizeof(data_buffer));
+    uint32_t complete_packet = 0;
+    int read_len;
 
-    if (read_len > 0) {
+    // drain the uart, the decoder keeps its state across buffers
+    while ((read_len = hci_recv(rtk_h5.hci_dev, data_buffer, sizeof(data_buffer))) > 0) {
+        complete_packet |= h5_recv(&rtk_h5, data_buffer, read_len);
 
-        return h5_recv(&rtk_h5, data_buffer, read_len);
-    } else {
-        return 0;
+        if ((uint32_t)read_len < sizeof(data_buffer)) {
+            break;
+        }
     }
+
+    return complete_packet;
 }
 
 /*******************************************************************************
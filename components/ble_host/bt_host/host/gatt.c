@@ -1017,6 +1017,233 @@ static const struct bt_gatt_service_static *_bt_gatt_service_static[] =
     &_1_gatt_svc,
 };
 
+#if CONFIG_BT_GATT_ATTR_INDEX
+static u8_t gatt_foreach_iter(const struct bt_gatt_attr *attr,
+			      u16_t start_handle, u16_t end_handle,
+			      const struct bt_uuid *uuid,
+			      const void *attr_data, uint16_t *num_matches,
+			      bt_gatt_attr_func_t func, void *user_data);
+
+/* Attributes of the whole database sorted by handle, plus one chain per
+ * attribute type hash bucket. Entries of the chains are stored + 1 so that
+ * 0 ends a chain, the chains are in ascending handle order.
+ */
+struct gatt_attr_index {
+	u16_t ref;
+	u16_t count;
+	u16_t bucket[CONFIG_BT_GATT_ATTR_INDEX_BUCKETS];
+	u16_t *uuid_next;
+	const struct bt_gatt_attr **attrs;
+};
+
+/* Walks hold a reference on the index, a replaced index is freed by
+ * whoever drops its last reference: the rebuild or the last walk.
+ */
+static struct gatt_attr_index *attr_index;
+
+/* 16 and 32 bits UUIDs live in bytes 12..15 of their 128 bits form, hash
+ * only that part so that all forms of the same UUID share a bucket.
+ */
+static u16_t gatt_uuid_hash(const struct bt_uuid *uuid)
+{
+	u32_t val;
+
+	switch (uuid->type) {
+	case BT_UUID_TYPE_16:
+		val = BT_UUID_16(uuid)->val;
+		break;
+	case BT_UUID_TYPE_32:
+		val = BT_UUID_32(uuid)->val;
+		break;
+	default:
+		val = sys_get_le32(&BT_UUID_128(uuid)->val[12]);
+		break;
+	}
+
+	val ^= val >> 16;
+	val ^= val >> 5;
+
+	return val & (CONFIG_BT_GATT_ATTR_INDEX_BUCKETS - 1);
+}
+
+/* First entry whose handle is >= handle, handles are usually dense */
+static u16_t gatt_index_lower_bound(const struct gatt_attr_index *idx,
+				    u16_t handle)
+{
+	u16_t lo = 0, hi = idx->count, mid;
+
+	if (handle && handle <= idx->count &&
+	    idx->attrs[handle - 1]->handle == handle) {
+		return handle - 1;
+	}
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+
+		if (idx->attrs[mid]->handle < handle) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
+static struct gatt_attr_index *gatt_index_get(void)
+{
+	struct gatt_attr_index *idx;
+	unsigned int key;
+
+	key = irq_lock();
+	idx = attr_index;
+	if (idx) {
+		idx->ref++;
+	}
+	irq_unlock(key);
+
+	return idx;
+}
+
+static void gatt_index_put(struct gatt_attr_index *idx)
+{
+	unsigned int key;
+	bool release;
+
+	key = irq_lock();
+	release = --idx->ref == 0;
+	irq_unlock(key);
+
+	if (release) {
+		free(idx);
+	}
+}
+
+static void gatt_index_set(struct gatt_attr_index *idx)
+{
+	struct gatt_attr_index *old;
+	unsigned int key;
+
+	key = irq_lock();
+	old = attr_index;
+	attr_index = idx;
+	irq_unlock(key);
+
+	/* Drop the reference of attr_index, walks may still hold the old one */
+	if (old) {
+		gatt_index_put(old);
+	}
+}
+
+static void gatt_index_rebuild(void)
+{
+	const struct bt_gatt_service_static *static_svc;
+	struct gatt_attr_index *idx;
+	size_t count = 0, i, ii, n = 0;
+	u16_t bucket;
+#if defined(CONFIG_BT_GATT_DYNAMIC_DB)
+	struct bt_gatt_service *svc;
+
+	SYS_SLIST_FOR_EACH_CONTAINER(&db, svc, node) {
+		count += svc->attr_count;
+	}
+#endif /* CONFIG_BT_GATT_DYNAMIC_DB */
+
+	count += last_static_handle;
+
+	idx = malloc(sizeof(*idx) + count * (sizeof(idx->attrs[0]) +
+					      sizeof(idx->uuid_next[0])));
+	if (!idx || count > UINT16_MAX) {
+		/* Fall back to the walk of the services */
+		BT_WARN("No memory for the attribute index");
+		free(idx);
+		gatt_index_set(NULL);
+		return;
+	}
+
+	memset(idx->bucket, 0, sizeof(idx->bucket));
+	idx->ref = 1;
+	idx->count = count;
+	idx->attrs = (const struct bt_gatt_attr **)(idx + 1);
+	idx->uuid_next = (u16_t *)(idx->attrs + count);
+
+	for (ii = 0; ii < ARRAY_SIZE(_bt_gatt_service_static); ii++) {
+		static_svc = _bt_gatt_service_static[ii];
+
+		for (i = 0; i < static_svc->attr_count; i++) {
+			idx->attrs[n++] = &static_svc->attrs[i];
+		}
+	}
+
+#if defined(CONFIG_BT_GATT_DYNAMIC_DB)
+	SYS_SLIST_FOR_EACH_CONTAINER(&db, svc, node) {
+		for (i = 0; i < svc->attr_count; i++) {
+			idx->attrs[n++] = &svc->attrs[i];
+		}
+	}
+#endif /* CONFIG_BT_GATT_DYNAMIC_DB */
+
+	/* Prepend from the end so that the chains are in handle order */
+	for (i = count; i > 0; i--) {
+		bucket = gatt_uuid_hash(idx->attrs[i - 1]->uuid);
+		idx->uuid_next[i - 1] = idx->bucket[bucket];
+		idx->bucket[bucket] = i;
+	}
+
+	BT_DBG("%u attributes indexed", idx->count);
+
+	gatt_index_set(idx);
+}
+
+static bool foreach_attr_type_index(u16_t start_handle, u16_t end_handle,
+				    const struct bt_uuid *uuid,
+				    const void *attr_data, uint16_t num_matches,
+				    bt_gatt_attr_func_t func, void *user_data)
+{
+	struct gatt_attr_index *idx = gatt_index_get();
+	u16_t i;
+
+	if (!idx) {
+		return false;
+	}
+
+	if (uuid) {
+		for (i = idx->bucket[gatt_uuid_hash(uuid)]; i;
+		     i = idx->uuid_next[i - 1]) {
+			if (idx->attrs[i - 1]->handle < start_handle) {
+				continue;
+			}
+
+			if (gatt_foreach_iter(idx->attrs[i - 1], start_handle,
+					      end_handle, uuid, attr_data,
+					      &num_matches, func, user_data) ==
+			    BT_GATT_ITER_STOP) {
+				break;
+			}
+		}
+
+		gatt_index_put(idx);
+		return true;
+	}
+
+	for (i = gatt_index_lower_bound(idx, start_handle); i < idx->count;
+	     i++) {
+		if (gatt_foreach_iter(idx->attrs[i], start_handle, end_handle,
+				      uuid, attr_data, &num_matches,
+				      func, user_data) == BT_GATT_ITER_STOP) {
+			break;
+		}
+	}
+
+	gatt_index_put(idx);
+	return true;
+}
+#else
+static inline void gatt_index_rebuild(void)
+{
+}
+#endif /* CONFIG_BT_GATT_ATTR_INDEX */
+
 void bt_gatt_init(void)
 {
 	if (!atomic_cas(&init, 0, 1)) {
@@ -1029,6 +1256,21 @@ void bt_gatt_init(void)
     last_static_handle += _2_gap_svc.attr_count;
     last_static_handle += _1_gatt_svc.attr_count;
 
+#if CONFIG_BT_GATT_ATTR_INDEX
+	/* Static attributes get their handles in place, so that the index
+	 * can hand out the attributes themselves.
+	 */
+	for (size_t ii = 0, handle = 1; ii < ARRAY_SIZE(_bt_gatt_service_static); ii++) {
+		const struct bt_gatt_service_static *static_svc = _bt_gatt_service_static[ii];
+
+		for (size_t i = 0; i < static_svc->attr_count; i++, handle++) {
+			((struct bt_gatt_attr *)&static_svc->attrs[i])->handle = handle;
+		}
+	}
+#endif /* CONFIG_BT_GATT_ATTR_INDEX */
+
+	gatt_index_rebuild();
+
 	// Z_STRUCT_SECTION_FOREACH(bt_gatt_service_static, svc) {
 
 #if defined(CONFIG_BT_GATT_CACHING)
@@ -1140,6 +1382,8 @@ int bt_gatt_service_register(struct bt_gatt_service *svc)
 		return err;
 	}
 
+	gatt_index_rebuild();
+
 	sc_indicate(svc->attrs[0].handle,
 		    svc->attrs[svc->attr_count - 1].handle);
 
@@ -1156,6 +1400,8 @@ int bt_gatt_service_unregister(struct bt_gatt_service *svc)
 		return -ENOENT;
 	}
 
+	gatt_index_rebuild();
+
 	sc_indicate(svc->attrs[0].handle,
 		    svc->attrs[svc->attr_count - 1].handle);
 
@@ -1417,6 +1663,13 @@ void bt_gatt_foreach_attr_type(u16_t start_handle, u16_t end_handle,
 		num_matches = UINT16_MAX;
 	}
 
+#if CONFIG_BT_GATT_ATTR_INDEX
+	if (foreach_attr_type_index(start_handle, end_handle, uuid, attr_data,
+				    num_matches, func, user_data)) {
+		return;
+	}
+#endif /* CONFIG_BT_GATT_ATTR_INDEX */
+
 	if (start_handle <= last_static_handle) {
 		u16_t handle = 1;
 
@@ -2214,6 +2214,10 @@ static const struct shell_cmd bt_commands[] = {
         "gatt-transport-test-op", cmd_gatt_transport_test,
         "<op 0:stop 1:start 2:show result 3:reset>"
     },
+    {
+        "gatt-bench-lookup", cmd_gatt_bench_lookup,
+        "[attrs 200] [lookups 1000]"
+    },
 
 #if defined(CONFIG_BT_L2CAP_DYNAMIC_CHANNEL)
     { "l2cap-register", cmd_l2cap_register, "<psm> [sec_level]" },
@@ -1891,6 +1891,100 @@ int cmd_gatt_transport_test(int argc, char *argv[])
     return 0;
 }
 
+static u8_t bench_count_attr(const struct bt_gatt_attr *attr, void *user_data)
+{
+    (*(int *)user_data)++;
+
+    return BT_GATT_ITER_CONTINUE;
+}
+
+/* Lookups by handle, as ATT requests do, and by type, as the CCC search of a
+ * notification does, on a service of <attrs> attributes. Build once with
+ * CONFIG_BT_GATT_ATTR_INDEX 0 to get the numbers of the plain walk.
+ */
+int cmd_gatt_bench_lookup(int argc, char *argv[])
+{
+    const struct bt_uuid *uuid = BT_UUID_DECLARE_128(0xF0, 0x32, 0x35, 0xd4, 0x12, 0xf3, 0x11, 0xe9,
+                                 0xab, 0x14, 0xd6, 0x63, 0xbd, 0x87, 0x3d, 0x93);
+    const struct bt_uuid *ccc = BT_UUID_GATT_CCC;
+    const struct bt_uuid *cud = BT_UUID_GATT_CUD;
+    struct bt_gatt_service svc = { 0 };
+    struct bt_gatt_attr *attrs;
+    int count = 200, loops = 1000;
+    int i, found = 0, expect, err;
+    long long start, by_handle, by_type;
+    u16_t first;
+
+    if (argc > 1) {
+        count = strtoul(argv[1], NULL, 0);
+    }
+
+    if (argc > 2) {
+        loops = strtoul(argv[2], NULL, 0);
+    }
+
+    if (count < 2 || loops < 1) {
+        return -EINVAL;
+    }
+
+    attrs = calloc(count, sizeof(*attrs));
+
+    if (!attrs) {
+        return -ENOMEM;
+    }
+
+    /* Not readable by a peer, one CCC every 20 attributes */
+    attrs[0].uuid = BT_UUID_GATT_PRIMARY;
+    attrs[0].read = bt_gatt_attr_read_service;
+    attrs[0].user_data = (void *)uuid;
+    attrs[0].perm = BT_GATT_PERM_READ;
+
+    for (i = 1; i < count; i++) {
+        attrs[i].uuid = i % 20 ? cud : ccc;
+    }
+
+    svc.attrs = attrs;
+    svc.attr_count = count;
+    err = bt_gatt_service_register(&svc);
+
+    if (err) {
+        printf("Registering bench service failed (%d)\n", err);
+        free(attrs);
+        return err;
+    }
+
+    first = attrs[0].handle;
+
+    start = aos_now_ms();
+
+    for (i = 0; i < loops; i++) {
+        u16_t handle = first + (i * 7) % count;
+
+        bt_gatt_foreach_attr(handle, handle, bench_count_attr, &found);
+    }
+
+    by_handle = aos_now_ms() - start;
+
+    start = aos_now_ms();
+
+    for (i = 0; i < loops; i++) {
+        bt_gatt_foreach_attr_type(first, 0xffff, ccc, NULL, 0,
+                                  bench_count_attr, &found);
+    }
+
+    by_type = aos_now_ms() - start;
+
+    bt_gatt_service_unregister(&svc);
+    free(attrs);
+
+    expect = loops + loops * ((count - 1) / 20);
+
+    printf("%d attributes, %d lookups: by handle %lld ms, by type %lld ms, %s\n",
+           count, loops, by_handle, by_type, found == expect ? "ok" : "missed");
+
+    return found == expect ? 0 : -EIO;
+}
+
 int cmd_gatt_unregister_test_svc(int argc, char *argv[])
 {
     printf("Unregistering test vendor services\n");
@@ -27,5 +27,6 @@ int cmd_gatt_register_test_svc(int argc, char *argv[]);
 int cmd_gatt_unregister_test_svc(int argc, char *argv[]);
 int cmd_gatt_write_cmd_metrics(int argc, char *argv[]);
 int cmd_gatt_transport_test(int argc, char *argv[]);
+int cmd_gatt_bench_lookup(int argc, char *argv[]);
 
 #endif /* __GATT_H */
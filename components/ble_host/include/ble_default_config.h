@@ -154,6 +154,18 @@
 #define CONFIG_BT_GATT_DYNAMIC_DB
 #endif
 
+/* Index the GATT database by attribute handle and attribute type, so that
+	  ATT requests and notifications do not walk all the services. The
+	  index is rebuilt when a service is registered or unregistered. */
+#ifndef CONFIG_BT_GATT_ATTR_INDEX
+#define CONFIG_BT_GATT_ATTR_INDEX 1
+#endif
+
+/* Number of attribute type hash buckets of the GATT index, power of 2. */
+#ifndef CONFIG_BT_GATT_ATTR_INDEX_BUCKETS
+#define CONFIG_BT_GATT_ATTR_INDEX_BUCKETS 16
+#endif
+
 /* Maximum data size for each HCI RX buffer. This size includes
 	  everything starting with the ACL or HCI event headers. Note that
 	  buffer sizes are always rounded up to the nearest multiple of 4,
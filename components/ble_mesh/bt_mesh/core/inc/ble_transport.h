@@ -105,3 +105,9 @@ void bt_mesh_rpl_clear(void);
 void bt_mesh_rpl_clear_all(void);
 
 void bt_mesh_rpl_clear_node(uint16_t unicast_addr,uint8_t elem_num);
+
+struct bt_mesh_rpl *bt_mesh_rpl_find(u16_t src);
+
+struct bt_mesh_rpl *bt_mesh_rpl_alloc(u16_t src);
+
+void bt_mesh_rpl_index_rebuild(void);
@@ -86,9 +86,6 @@ struct bt_mesh_subnet {
 struct bt_mesh_rpl {
 	u16_t src;
 	bool  old_iv;
-#if defined(CONFIG_BT_SETTINGS)
-	bool  store;
-#endif
 	u32_t seq;
 };
 
@@ -382,6 +379,13 @@ void bt_mesh_net_start(void);
 
 void bt_mesh_net_init(void);
 
+#if defined(CONFIG_BT_MESH_SELF_TEST)
+/* Message cache access for bt_mesh_test() */
+bool bt_mesh_net_msg_cache_match(struct bt_mesh_net_rx *rx,
+				 struct net_buf_simple *pdu);
+void bt_mesh_net_msg_cache_reset(void);
+#endif
+
 /* Friendship Credential Management */
 struct friend_cred {
 	u16_t net_idx;
@@ -8,6 +8,7 @@
 
 #include <ble_os.h>
 #include <errno.h>
+#include <stdlib.h>
 #include <misc/util.h>
 #include <misc/byteorder.h>
 
@@ -40,6 +41,18 @@
 static const struct bt_mesh_comp *dev_comp = NULL;
 static u16_t dev_primary_addr;
 
+/* Opcode index of the composition: every (model, op) pair sorted by
+ * opcode, then by element and model order, so that the handlers of an
+ * opcode are one run found by a binary search.
+ */
+struct op_entry {
+	struct bt_mesh_model *model;
+	const struct bt_mesh_model_op *op;
+};
+
+static struct op_entry *op_index;
+static u16_t op_index_count;
+
 static const struct {
 	const u16_t id;
 	int (*const init)(struct bt_mesh_model *model, bool primary);
@@ -329,6 +342,79 @@ static void mod_init(struct bt_mesh_model *mod, struct bt_mesh_elem *elem,
 	}
 }
 
+static void op_index_add(struct bt_mesh_model *mod, struct bt_mesh_elem *elem,
+			 bool vnd, bool primary, void *user_data)
+{
+	const struct bt_mesh_model_op *op;
+	struct op_entry *entry;
+	u16_t *count = user_data;
+	int i;
+
+	for (op = mod->op; op->func; op++) {
+		/* SIG models cannot contain 3-byte (vendor) OpCodes, and
+		 * vendor models cannot contain SIG (1- or 2-byte) OpCodes.
+		 */
+		if (vnd != (op->opcode >= 0x10000)) {
+			continue;
+		}
+
+		if (op_index) {
+			/* Insertion keeps the foreach order among equal opcodes */
+			for (i = *count; i > 0 &&
+			     op_index[i - 1].op->opcode > op->opcode; i--) {
+				op_index[i] = op_index[i - 1];
+			}
+
+			entry = &op_index[i];
+			entry->model = mod;
+			entry->op = op;
+		}
+
+		(*count)++;
+	}
+}
+
+static void op_index_build(void)
+{
+	u16_t count = 0;
+
+	if (op_index) {
+		free(op_index);
+		op_index = NULL;
+	}
+
+	op_index_count = 0;
+
+	bt_mesh_model_foreach(op_index_add, &count);
+
+	op_index = malloc(count * sizeof(*op_index));
+	if (!op_index) {
+		BT_WARN("No memory for the opcode index");
+		return;
+	}
+
+	op_index_count = 0;
+	bt_mesh_model_foreach(op_index_add, &op_index_count);
+}
+
+/* First entry of the run of opcode, op_index_count if none */
+static u16_t op_index_find(u32_t opcode)
+{
+	u16_t lo = 0, hi = op_index_count, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+
+		if (op_index[mid].op->opcode < opcode) {
+			lo = mid + 1;
+		} else {
+			hi = mid;
+		}
+	}
+
+	return lo;
+}
+
 int bt_mesh_comp_register(const struct bt_mesh_comp *comp)
 {
 	/* There must be at least one element */
@@ -340,6 +426,8 @@ int bt_mesh_comp_register(const struct bt_mesh_comp *comp)
 
 	bt_mesh_model_foreach(mod_init, NULL);
 
+	op_index_build();
+
 	return 0;
 }
 
@@ -586,6 +674,74 @@ bool bt_mesh_fixed_group_match(u16_t addr)
 	}
 }
 
+static void model_op_call(struct bt_mesh_model *model,
+			  const struct bt_mesh_model_op *op,
+			  struct bt_mesh_net_rx *rx, struct net_buf_simple *buf,
+			  u32_t opcode)
+{
+	struct net_buf_simple_state state;
+
+	if (buf->len < op->min_len) {
+		BT_ERR("Too short message for OpCode 0x%08x", opcode);
+		return;
+	}
+
+	/* The callback will likely parse the buffer, so
+	 * store the parsing state in case multiple models
+	 * receive the message.
+	 */
+	net_buf_simple_save(buf, &state);
+	if (op->func2) {
+		op->func2(model, &rx->ctx, buf, opcode);
+	} else {
+		op->func(model, &rx->ctx, buf);
+	}
+	net_buf_simple_restore(buf, &state);
+}
+
+/* Same matching as the element walk below, on the models which implement
+ * the opcode only.
+ */
+static void model_recv_indexed(struct bt_mesh_net_rx *rx,
+			       struct net_buf_simple *buf, u32_t opcode)
+{
+	u16_t dst = rx->ctx.recv_dst;
+	struct bt_mesh_model *model;
+	int last_elem = -1;
+	u16_t i;
+
+	for (i = op_index_find(opcode);
+	     i < op_index_count && op_index[i].op->opcode == opcode; i++) {
+		model = op_index[i].model;
+
+		/* Only the first matching model of an element gets it */
+		if (model->elem_idx == last_elem) {
+			continue;
+		}
+
+		if (BT_MESH_ADDR_IS_UNICAST(dst)) {
+			if (dev_comp->elem[model->elem_idx].addr != dst) {
+				continue;
+			}
+		} else if (BT_MESH_ADDR_IS_GROUP(dst) ||
+			   BT_MESH_ADDR_IS_VIRTUAL(dst)) {
+			if (!bt_mesh_model_find_group(model, dst)) {
+				continue;
+			}
+		} else if (model->elem_idx != 0 ||
+			   !bt_mesh_fixed_group_match(dst)) {
+			continue;
+		}
+
+		if (!model_has_key(model, rx->ctx.app_idx)) {
+			continue;
+		}
+
+		last_elem = model->elem_idx;
+		model_op_call(model, op_index[i].op, rx, buf, opcode);
+	}
+}
+
 void bt_mesh_model_recv(struct bt_mesh_net_rx *rx, struct net_buf_simple *buf)
 {
 	struct bt_mesh_model *models = NULL, *model = NULL;
@@ -615,6 +771,11 @@ void bt_mesh_model_recv(struct bt_mesh_net_rx *rx, struct net_buf_simple *buf)
 	MESH_RX_D("%s\n", bt_hex_real(buf->data, buf->len));
 #endif
 
+	if (op_index) {
+		model_recv_indexed(rx, buf, opcode);
+		return;
+	}
+
 	for (i = 0; i < dev_comp->elem_count; i++) {
 		struct bt_mesh_elem *elem = &dev_comp->elem[i];
 
@@ -645,29 +806,7 @@ void bt_mesh_model_recv(struct bt_mesh_net_rx *rx, struct net_buf_simple *buf)
 		op = find_op(models, count, rx->ctx.recv_dst, rx->ctx.app_idx,
 			     opcode, &model);
 		if (op) {
-			struct net_buf_simple_state state;
-
-			if (buf->len < op->min_len) {
-				BT_ERR("Too short message for OpCode 0x%08x",
-				       opcode);
-				continue;
-			}
-
-			/* The callback will likely parse the buffer, so
-			 * store the parsing state in case multiple models
-			 * receive the message.
-			 */
-			net_buf_simple_save(buf, &state);
-            if (op->func2)
-            {
-    			op->func2(model, &rx->ctx, buf, opcode);
-            }
-            else
-            {
-    			op->func(model, &rx->ctx, buf);
-            }
-			net_buf_simple_restore(buf, &state);
-
+			model_op_call(model, op, rx, buf, opcode);
 		} else {
 			BT_DBG("No OpCode 0x%08x for elem %d", opcode, i);
 		}
@@ -82,9 +82,20 @@
 static struct friend_cred friend_cred[FRIEND_CRED_COUNT];
 #endif
 
+/* Network message cache: a FIFO of message hashes, the entries are also
+ * chained by hash bucket (entry index + 1, 0 ends a chain) so that a lookup
+ * does not depend on the cache size.
+ */
 static u64_t msg_cache[CONFIG_BT_MESH_MSG_CACHE_SIZE];
+static u16_t msg_cache_link[CONFIG_BT_MESH_MSG_CACHE_SIZE];
+static u16_t msg_cache_bucket[CONFIG_BT_MESH_MSG_CACHE_HASH_SIZE];
 static u16_t msg_cache_next;
 
+/* NIDs of all the network and friend credentials derived so far. It is
+ * never cleared, a stale NID only costs the key search.
+ */
+static u32_t nid_known[4];
+
 u16_t g_sub_list[CONFIG_BT_MESH_MODEL_GROUP_COUNT];
 
 #if defined(CONFIG_BT_MESH_RELAY_SRC_DBG)
@@ -155,25 +166,71 @@ static u64_t msg_hash(struct bt_mesh_net_rx *rx, struct net_buf_simple *pdu)
 	return (u64_t)hash1 << 32 | (u64_t)hash2;
 }
 
+static inline u16_t *msg_cache_head(u64_t hash)
+{
+	u32_t val = (u32_t)hash ^ (u32_t)(hash >> 32);
+
+	val = (val * 2654435761U) >> 16;
+
+	return &msg_cache_bucket[val & (CONFIG_BT_MESH_MSG_CACHE_HASH_SIZE - 1)];
+}
+
+static void msg_cache_reset(void)
+{
+	(void)memset(msg_cache, 0, sizeof(msg_cache));
+	(void)memset(msg_cache_bucket, 0, sizeof(msg_cache_bucket));
+	msg_cache_next = 0U;
+}
+
 static bool msg_cache_match(struct bt_mesh_net_rx *rx,
 			    struct net_buf_simple *pdu)
 {
 	u64_t hash = msg_hash(rx, pdu);
-	u16_t i;
+	u16_t *head = msg_cache_head(hash);
+	u16_t *link;
+	u16_t id;
 
-	for (i = 0; i < ARRAY_SIZE(msg_cache); i++) {
-		if (msg_cache[i] == hash) {
+	for (id = *head; id; id = msg_cache_link[id - 1]) {
+		if (msg_cache[id - 1] == hash) {
 			return true;
 		}
 	}
 
+	/* Drop the oldest entry from its chain, a hash of 0 marks a free entry */
+	id = msg_cache_next + 1;
+	if (msg_cache[id - 1]) {
+		link = msg_cache_head(msg_cache[id - 1]);
+		while (*link != id) {
+			link = &msg_cache_link[*link - 1];
+		}
+
+		*link = msg_cache_link[id - 1];
+	}
+
 	/* Add to the cache */
-	msg_cache[msg_cache_next++] = hash;
+	msg_cache[id - 1] = hash;
+	msg_cache_link[id - 1] = *head;
+	*head = id;
+
+	msg_cache_next++;
 	msg_cache_next %= ARRAY_SIZE(msg_cache);
 
 	return false;
 }
 
+#if defined(CONFIG_BT_MESH_SELF_TEST)
+bool bt_mesh_net_msg_cache_match(struct bt_mesh_net_rx *rx,
+				 struct net_buf_simple *pdu)
+{
+	return msg_cache_match(rx, pdu);
+}
+
+void bt_mesh_net_msg_cache_reset(void)
+{
+	msg_cache_reset();
+}
+#endif
+
 struct bt_mesh_subnet *bt_mesh_subnet_get(u16_t net_idx)
 {
 	int i;
@@ -206,6 +263,7 @@ int bt_mesh_net_keys_create(struct bt_mesh_subnet_keys *keys,
 	memcpy(keys->net, key, 16);
 
 	keys->nid = nid;
+	nid_known[nid >> 5] |= BIT(nid & 0x1f);
 
 	BT_DBG("NID 0x%02x EncKey %s", keys->nid, bt_hex(keys->enc, 16));
 	BT_DBG("PrivacyKey %s", bt_hex(keys->privacy, 16));
@@ -277,6 +335,8 @@ int friend_cred_set(struct friend_cred *cred, u8_t idx, const u8_t net_key[16])
 		return err;
 	}
 
+	nid_known[cred->cred[idx].nid >> 5] |= BIT(cred->cred[idx].nid & 0x1f);
+
 	BT_DBG("Friend NID 0x%02x EncKey %s", cred->cred[idx].nid,
 	       bt_hex(cred->cred[idx].enc, 16));
 	BT_DBG("Friend PrivacyKey %s", bt_hex(cred->cred[idx].privacy, 16));
@@ -478,8 +538,7 @@ int bt_mesh_net_create(u16_t idx, u8_t flags, const u8_t key[16],
 
 	BT_DBG("NetKey %s", bt_hex(key, 16));
 
-	(void)memset(msg_cache, 0, sizeof(msg_cache));
-	msg_cache_next = 0U;
+	msg_cache_reset();
 
 	sub = &bt_mesh.sub[0];
 
@@ -604,8 +663,15 @@ void bt_mesh_rpl_reset(void)
 			} else {
 				rpl->old_iv = true;
 			}
+
+			/* Flushed along with the new IV Index */
+			if (IS_ENABLED(CONFIG_BT_SETTINGS)) {
+				bt_mesh_store_rpl(rpl);
+			}
 		}
 	}
+
+	bt_mesh_rpl_index_rebuild();
 }
 
 #if defined(CONFIG_BT_MESH_IV_UPDATE_TEST)
@@ -683,7 +749,7 @@ bool bt_mesh_net_iv_update(u32_t iv_index, bool iv_update)
 
 		if (iv_index > bt_mesh.iv_index + 1) {
 			BT_WARN("Performing IV Index Recovery");
-			memset(bt_mesh.rpl, 0, sizeof(bt_mesh.rpl));
+			bt_mesh_rpl_clear();
 			bt_mesh.iv_index = iv_index;
 			bt_mesh.seq = 0;
 			goto do_update;
@@ -1124,6 +1190,11 @@ static bool net_find_and_decrypt(const u8_t *data, size_t data_len,
 
 	BT_DBG("");
 
+	/* PDU of another network, no key to try */
+	if (!(nid_known[NID(data) >> 5] & BIT(NID(data) & 0x1f))) {
+		return false;
+	}
+
 	array_size = ARRAY_SIZE(bt_mesh.sub);
 
 	for (i = 0; i < array_size; i++) {
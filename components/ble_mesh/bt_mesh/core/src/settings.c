@@ -42,9 +42,14 @@
 
 #ifdef CONFIG_BT_SETTINGS
 
-#ifndef CONFIG_BT_MESH_RPL_STORE_RATE
-#define CONFIG_BT_MESH_RPL_STORE_RATE 100
-#endif
+/* Tracking of the RPL entries to store. An entry may be given to another
+ * source before it is flushed, so the source each entry is stored under
+ * is kept as well, 0 if none.
+ */
+static ATOMIC_DEFINE(rpl_dirty, CONFIG_BT_MESH_CRPL);
+static u16_t rpl_stored[CONFIG_BT_MESH_CRPL];
+
+void bt_mesh_store_rpl(struct bt_mesh_rpl *entry);
 
 /* Tracking of what storage changes are pending for App and Net Keys. We
  * track this in a separate array here instead of within the respective
@@ -255,39 +260,12 @@ static int seq_set(const char *name, size_t len_rd, settings_read_cb read_cb,
     return 0;
 }
 
-static struct bt_mesh_rpl *rpl_find(u16_t src)
-{
-    int i;
-
-    for (i = 0; i < ARRAY_SIZE(bt_mesh.rpl); i++) {
-        if (bt_mesh.rpl[i].src == src) {
-            return &bt_mesh.rpl[i];
-        }
-    }
-
-    return NULL;
-}
-
-static struct bt_mesh_rpl *rpl_alloc(u16_t src)
-{
-    int i;
-
-    for (i = 0; i < ARRAY_SIZE(bt_mesh.rpl); i++) {
-        if (!bt_mesh.rpl[i].src) {
-            bt_mesh.rpl[i].src = src;
-            return &bt_mesh.rpl[i];
-        }
-    }
-
-    return NULL;
-}
-
 static int rpl_set(const char *name, size_t len_rd,
 		   settings_read_cb read_cb, void *cb_arg)
 {
 	struct bt_mesh_rpl *entry;
 	struct rpl_val rpl;
-	int err;
+	int err, i;
 	u16_t src;
 
 	if (!name) {
@@ -296,12 +274,13 @@ static int rpl_set(const char *name, size_t len_rd,
 	}
 
 	src = strtol(name, NULL, 16);
-	entry = rpl_find(src);
+	entry = bt_mesh_rpl_find(src);
 
 	if (len_rd == 0) {
 		BT_DBG("val (null)");
 		if (entry) {
 			(void)memset(entry, 0, sizeof(*entry));
+			bt_mesh_rpl_index_rebuild();
 		} else {
 			BT_WARN("Unable to find RPL entry for 0x%04x", src);
 		}
@@ -310,11 +289,7 @@ static int rpl_set(const char *name, size_t len_rd,
 	}
 
 	if (!entry) {
-		entry = rpl_alloc(src);
-		if (!entry) {
-			BT_ERR("Unable to allocate RPL entry for 0x%04x", src);
-			return -ENOMEM;
-		}
+		entry = bt_mesh_rpl_alloc(src);
 	}
 
 	err = mesh_x_set(read_cb, cb_arg, &rpl, sizeof(rpl));
@@ -323,9 +298,22 @@ static int rpl_set(const char *name, size_t len_rd,
 		return err;
 	}
 
-	entry->seq = rpl.seq;
+	/* Messages accepted after the last flush are not in flash, the gap
+	 * keeps them from being replayed after a reboot.
+	 */
+	entry->seq = MIN(rpl.seq + CONFIG_BT_MESH_RPL_SEQ_GAP, 0xffffff);
 	entry->old_iv = rpl.old_iv;
 
+	i = entry - bt_mesh.rpl;
+	if (rpl_stored[i] && rpl_stored[i] != src) {
+		/* More entries in flash than in the list, the replaced one is
+		 * removed from flash at the next flush.
+		 */
+		bt_mesh_store_rpl(entry);
+	} else {
+		rpl_stored[i] = src;
+	}
+
 	BT_DBG("RPL entry for 0x%04x: Seq 0x%06x old_iv %u", entry->src,
 	       entry->seq, entry->old_iv);
 
@@ -1180,8 +1168,23 @@ void bt_mesh_store_seq(void)
     schedule_store(BT_MESH_SEQ_PENDING);
 }
 
-static void store_rpl(struct bt_mesh_rpl *entry)
+static void rpl_delete(u16_t src)
 {
+	char path[18];
+	int err;
+
+	snprintk(path, sizeof(path), "bt/mesh/RPL/%x", src);
+	err = settings_delete(path);
+	if (err) {
+		BT_ERR("Failed to clear RPL %s", log_strdup(path));
+	} else {
+		BT_DBG("Cleared RPL %s", log_strdup(path));
+	}
+}
+
+static void store_rpl(int i)
+{
+	struct bt_mesh_rpl *entry = &bt_mesh.rpl[i];
 	struct rpl_val rpl;
 	char path[18];
 	int err;
@@ -1189,6 +1192,21 @@ static void store_rpl(struct bt_mesh_rpl *entry)
     BT_DBG("src 0x%04x seq 0x%06x old_iv %u", entry->src, entry->seq,
            entry->old_iv);
 
+    /* The entry was given to another source, drop the old one unless it
+     * moved to another entry.
+     */
+    if (rpl_stored[i] && rpl_stored[i] != entry->src) {
+        if (!bt_mesh_rpl_find(rpl_stored[i])) {
+            rpl_delete(rpl_stored[i]);
+        }
+
+        rpl_stored[i] = 0;
+    }
+
+    if (!entry->src) {
+        return;
+    }
+
     rpl.seq = entry->seq;
     rpl.old_iv = entry->old_iv;
 
@@ -1199,33 +1217,33 @@ static void store_rpl(struct bt_mesh_rpl *entry)
 		BT_ERR("Failed to store RPL %s value", log_strdup(path));
 	} else {
 		BT_DBG("Stored RPL %s value", log_strdup(path));
+		rpl_stored[i] = entry->src;
 	}
 }
 
 static void clear_rpl(void)
 {
-	int i, err;
+    int i;
 
     BT_DBG("");
 
     for (i = 0; i < ARRAY_SIZE(bt_mesh.rpl); i++) {
         struct bt_mesh_rpl *rpl = &bt_mesh.rpl[i];
-        char path[18];
 
-        if (!rpl->src) {
-            continue;
+        if (rpl_stored[i]) {
+            rpl_delete(rpl_stored[i]);
         }
 
-		snprintk(path, sizeof(path), "bt/mesh/RPL/%x", rpl->src);
-		err = settings_delete(path);
-		if (err) {
-			BT_ERR("Failed to clear RPL");
-		} else {
-			BT_DBG("Cleared RPL");
-		}
+        if (rpl->src && rpl->src != rpl_stored[i]) {
+            rpl_delete(rpl->src);
+        }
 
-		(void)memset(rpl, 0, sizeof(*rpl));
-	}
+        atomic_clear_bit(rpl_dirty, i);
+        rpl_stored[i] = 0;
+        (void)memset(rpl, 0, sizeof(*rpl));
+    }
+
+    bt_mesh_rpl_index_rebuild();
 }
 
 static void store_pending_rpl(void)
@@ -1235,11 +1253,14 @@ static void store_pending_rpl(void)
     BT_DBG("");
 
     for (i = 0; i < ARRAY_SIZE(bt_mesh.rpl); i++) {
-        struct bt_mesh_rpl *rpl = &bt_mesh.rpl[i];
+        /* Skip a clean word at once */
+        if (!(i % ATOMIC_BITS) && !atomic_get(ATOMIC_ELEM(rpl_dirty, i))) {
+            i += ATOMIC_BITS - 1;
+            continue;
+        }
 
-        if (rpl->store) {
-            rpl->store = false;
-            store_rpl(rpl);
+        if (atomic_test_and_clear_bit(rpl_dirty, i)) {
+            store_rpl(i);
         }
     }
 }
@@ -1697,19 +1718,28 @@ static void store_pending(struct k_work *work)
 
 void bt_mesh_store_rpl(struct bt_mesh_rpl *entry)
 {
-    entry->store = true;
-    if ((entry->seq) % CONFIG_BT_MESH_RPL_STORE_RATE == 0) {
+    atomic_set_bit(rpl_dirty, entry - bt_mesh.rpl);
+
+    /* All the entries changed until the store timer fires are written
+     * once, do not push the timer back on every message.
+     */
+    if (!atomic_test_bit(bt_mesh.flags, BT_MESH_RPL_PENDING)) {
         schedule_store(BT_MESH_RPL_PENDING);
     }
 }
 
 void bt_mesh_clear_node_rpl(uint16_t addr)
 {
-    char path[18];
+    int i;
+
     BT_DBG("");
-    snprintk(path, sizeof(path), "bt/mesh/RPL/%x", addr);
-    settings_delete(path);
-    return;
+    rpl_delete(addr);
+
+    for (i = 0; i < ARRAY_SIZE(rpl_stored); i++) {
+        if (rpl_stored[i] == addr) {
+            rpl_stored[i] = 0;
+        }
+    }
 }
 
 void bt_mesh_clear_all_node_rpl()
@@ -1719,14 +1749,17 @@ void bt_mesh_clear_all_node_rpl()
 
     for (i = 0; i < ARRAY_SIZE(bt_mesh.rpl); i++) {
         struct bt_mesh_rpl *rpl = &bt_mesh.rpl[i];
-        char path[18];
 
-        if (!rpl->src) {
-            continue;
+        if (rpl_stored[i]) {
+            rpl_delete(rpl_stored[i]);
+        }
+
+        if (rpl->src && rpl->src != rpl_stored[i]) {
+            rpl_delete(rpl->src);
         }
 
-        snprintk(path, sizeof(path), "bt/mesh/RPL/%x", rpl->src);
-        settings_delete(path);
+        atomic_clear_bit(rpl_dirty, i);
+        rpl_stored[i] = 0;
     }
 }
 
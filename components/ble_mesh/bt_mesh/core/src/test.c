@@ -6,17 +6,229 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <ble_os.h>
 #include <string.h>
 #include <errno.h>
 
-#include <bluetooth/mesh.h>
+#include <net/buf.h>
+#include <api/mesh.h>
 
+#define BT_DBG_ENABLED IS_ENABLED(CONFIG_BT_MESH_DEBUG)
 #include "common/log.h"
 
 #include "mesh.h"
+#include "net.h"
+#include "ble_transport.h"
 #include "test.h"
 
-int bt_mesh_test(void)
+#define TEST_ASSERT(cond) do { \
+		if (!(cond)) { \
+			BT_ERR("self test failed, %s:%d", __func__, __LINE__); \
+			return -EINVAL; \
+		} \
+	} while (0)
+
+/* Sources sharing one bucket of the RPL index, so the chains get long */
+#define RPL_SRC(base, i) ((base) + ((i) << 4))
+
+/* A network larger than the RPL, heard from in random order */
+#define RPL_CHURN_SRCS 300
+#define RPL_CHURN_MSGS 1000
+
+static int rpl_fill(u16_t base)
+{
+	struct bt_mesh_rpl *rpl;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(bt_mesh.rpl); i++) {
+		rpl = bt_mesh_rpl_alloc(RPL_SRC(base, i));
+		TEST_ASSERT(rpl && rpl->src == RPL_SRC(base, i));
+	}
+
+	for (i = 0; i < ARRAY_SIZE(bt_mesh.rpl); i++) {
+		rpl = bt_mesh_rpl_find(RPL_SRC(base, i));
+		TEST_ASSERT(rpl && rpl->src == RPL_SRC(base, i));
+	}
+
+	return 0;
+}
+
+/* The least recently heard source is dropped once the RPL is full */
+static int rpl_evict(u16_t base, u16_t src)
+{
+	struct bt_mesh_rpl *rpl;
+	int i;
+
+	rpl = bt_mesh_rpl_alloc(src);
+	TEST_ASSERT(rpl && rpl->src == src);
+	TEST_ASSERT(bt_mesh_rpl_find(src) == rpl);
+	TEST_ASSERT(bt_mesh_rpl_find(RPL_SRC(base, 0)) == NULL);
+
+	for (i = 1; i < ARRAY_SIZE(bt_mesh.rpl); i++) {
+		TEST_ASSERT(bt_mesh_rpl_find(RPL_SRC(base, i)));
+	}
+
+	return 0;
+}
+
+static int rpl_test(void)
+{
+	int i, err;
+
+	bt_mesh_rpl_clear();
+
+	err = rpl_fill(0x0001);
+	if (err) {
+		return err;
+	}
+
+	err = rpl_evict(0x0001, 0x7001);
+	if (err) {
+		return err;
+	}
+
+	/* A bulk clear (IV Index Recovery, reset) must leave no stale entry
+	 * in the index, the next evictions go by the new allocations.
+	 */
+	bt_mesh_rpl_clear();
+
+	for (i = 0; i < ARRAY_SIZE(bt_mesh.rpl); i++) {
+		TEST_ASSERT(bt_mesh_rpl_find(RPL_SRC(0x0001, i)) == NULL);
+	}
+
+	TEST_ASSERT(bt_mesh_rpl_find(0x7001) == NULL);
+
+	err = rpl_fill(0x0002);
+	if (err) {
+		return err;
+	}
+
+	err = rpl_evict(0x0002, 0x7002);
+	if (err) {
+		return err;
+	}
+
+	/* Entries restored by a raw write, as the settings do, are found
+	 * after the index rebuild.
+	 */
+	memset(bt_mesh.rpl, 0, sizeof(bt_mesh.rpl));
+	bt_mesh.rpl[ARRAY_SIZE(bt_mesh.rpl) - 1].src = 0x7004;
+	bt_mesh_rpl_index_rebuild();
+	TEST_ASSERT(bt_mesh_rpl_find(0x7004) == &bt_mesh.rpl[ARRAY_SIZE(bt_mesh.rpl) - 1]);
+	TEST_ASSERT(bt_mesh_rpl_find(0x7002) == NULL);
+
+	/* The other entries are free again, nothing is evicted */
+	TEST_ASSERT(bt_mesh_rpl_alloc(0x7005));
+	TEST_ASSERT(bt_mesh_rpl_find(0x7004));
+
+	bt_mesh_rpl_clear();
+
+	return 0;
+}
+
+/* Without replays no entry is touched, so the RPL must hold exactly the
+ * sources allocated last, checked against a FIFO of them.
+ */
+static int rpl_churn_test(void)
+{
+	u16_t model[ARRAY_SIZE(bt_mesh.rpl)];
+	u32_t seed = 1;
+	int i, j, n = 0, oldest = 0;
+	u16_t src;
+	bool known;
+
+	bt_mesh_rpl_clear();
+
+	for (i = 0; i < RPL_CHURN_MSGS; i++) {
+		seed = seed * 1103515245 + 12345;
+		src = 1 + (seed >> 8) % RPL_CHURN_SRCS;
+
+		for (j = 0, known = false; j < n; j++) {
+			known |= model[j] == src;
+		}
+
+		TEST_ASSERT(!bt_mesh_rpl_find(src) == !known);
+		if (known) {
+			continue;
+		}
+
+		TEST_ASSERT(bt_mesh_rpl_alloc(src));
+		if (n < ARRAY_SIZE(model)) {
+			model[n++] = src;
+		} else {
+			model[oldest] = src;
+			oldest = (oldest + 1) % ARRAY_SIZE(model);
+		}
+	}
+
+	for (src = 1, j = 0; src <= RPL_CHURN_SRCS; src++) {
+		j += bt_mesh_rpl_find(src) != NULL;
+	}
+
+	TEST_ASSERT(j == n);
+	bt_mesh_rpl_clear();
+
+	return 0;
+}
+
+static bool msg_cache_check(struct net_buf_simple *pdu, u32_t seq)
+{
+	struct bt_mesh_net_rx rx;
+
+	(void)memset(&rx, 0, sizeof(rx));
+
+	/* IVI + NID, CTL + TTL, SEQ and SRC are all the hash looks at */
+	net_buf_simple_reset(pdu);
+	net_buf_simple_add_le16(pdu, 0);
+	net_buf_simple_add_u8(pdu, seq >> 16);
+	net_buf_simple_add_be16(pdu, seq);
+	net_buf_simple_add_be16(pdu, 0x0001);
+
+	return bt_mesh_net_msg_cache_match(&rx, pdu);
+}
+
+static int msg_cache_test(void)
 {
+	NET_BUF_SIMPLE_DEFINE(pdu, 8);
+	u32_t seq;
+
+	bt_mesh_net_msg_cache_reset();
+
+	for (seq = 0; seq < CONFIG_BT_MESH_MSG_CACHE_SIZE; seq++) {
+		TEST_ASSERT(!msg_cache_check(&pdu, seq));
+	}
+
+	for (seq = 0; seq < CONFIG_BT_MESH_MSG_CACHE_SIZE; seq++) {
+		TEST_ASSERT(msg_cache_check(&pdu, seq));
+	}
+
+	/* A new message drops the oldest one only */
+	TEST_ASSERT(!msg_cache_check(&pdu, CONFIG_BT_MESH_MSG_CACHE_SIZE));
+
+	for (seq = 1; seq <= CONFIG_BT_MESH_MSG_CACHE_SIZE; seq++) {
+		TEST_ASSERT(msg_cache_check(&pdu, seq));
+	}
+
+	TEST_ASSERT(!msg_cache_check(&pdu, 0));
+
+	bt_mesh_net_msg_cache_reset();
+
 	return 0;
 }
+
+int bt_mesh_test(void)
+{
+	int err;
+
+	err = rpl_test();
+	if (err) {
+		return err;
+	}
+
+	err = rpl_churn_test();
+	if (err) {
+		return err;
+	}
+
+	return msg_cache_test();
+}
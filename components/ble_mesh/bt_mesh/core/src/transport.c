@@ -582,26 +582,160 @@ int bt_mesh_trans_resend(struct bt_mesh_net_tx *tx, struct net_buf_simple *msg,
 	return err;
 }
 
+/* Index of bt_mesh.rpl: entries in use are chained by source address hash
+ * and kept in least recently used order, free entries are chained through
+ * rpl_next. Links are entry index + 1, so that 0 ends a list.
+ */
+static u16_t rpl_bucket[CONFIG_BT_MESH_RPL_HASH_SIZE];
+static u16_t rpl_next[CONFIG_BT_MESH_CRPL];
+static u16_t rpl_lru_prev[CONFIG_BT_MESH_CRPL];
+static u16_t rpl_lru_next[CONFIG_BT_MESH_CRPL];
+static u16_t rpl_lru_head; /* least recently used */
+static u16_t rpl_lru_tail;
+static u16_t rpl_free;
+
+static inline u16_t rpl_hash(u16_t src)
+{
+	return (src ^ (src >> 8)) & (CONFIG_BT_MESH_RPL_HASH_SIZE - 1);
+}
+
+static void rpl_lru_unlink(u16_t id)
+{
+	u16_t prev = rpl_lru_prev[id - 1], next = rpl_lru_next[id - 1];
+
+	if (prev) {
+		rpl_lru_next[prev - 1] = next;
+	} else {
+		rpl_lru_head = next;
+	}
+
+	if (next) {
+		rpl_lru_prev[next - 1] = prev;
+	} else {
+		rpl_lru_tail = prev;
+	}
+}
+
+static void rpl_lru_append(u16_t id)
+{
+	rpl_lru_prev[id - 1] = rpl_lru_tail;
+	rpl_lru_next[id - 1] = 0;
+
+	if (rpl_lru_tail) {
+		rpl_lru_next[rpl_lru_tail - 1] = id;
+	} else {
+		rpl_lru_head = id;
+	}
+
+	rpl_lru_tail = id;
+}
+
+static void rpl_index_add(u16_t id)
+{
+	u16_t *bucket = &rpl_bucket[rpl_hash(bt_mesh.rpl[id - 1].src)];
+
+	rpl_next[id - 1] = *bucket;
+	*bucket = id;
+	rpl_lru_append(id);
+}
+
+static void rpl_index_del(u16_t id)
+{
+	u16_t *link = &rpl_bucket[rpl_hash(bt_mesh.rpl[id - 1].src)];
+
+	while (*link != id) {
+		link = &rpl_next[*link - 1];
+	}
+
+	*link = rpl_next[id - 1];
+	rpl_lru_unlink(id);
+}
+
+void bt_mesh_rpl_index_rebuild(void)
+{
+	u16_t id;
+
+	memset(rpl_bucket, 0, sizeof(rpl_bucket));
+	rpl_lru_head = 0;
+	rpl_lru_tail = 0;
+	rpl_free = 0;
+
+	for (id = ARRAY_SIZE(bt_mesh.rpl); id > 0; id--) {
+		if (bt_mesh.rpl[id - 1].src) {
+			rpl_index_add(id);
+		} else {
+			rpl_next[id - 1] = rpl_free;
+			rpl_free = id;
+		}
+	}
+}
+
+struct bt_mesh_rpl *bt_mesh_rpl_find(u16_t src)
+{
+	u16_t id;
+
+	for (id = rpl_bucket[rpl_hash(src)]; id; id = rpl_next[id - 1]) {
+		if (bt_mesh.rpl[id - 1].src == src) {
+			return &bt_mesh.rpl[id - 1];
+		}
+	}
+
+	return NULL;
+}
+
+struct bt_mesh_rpl *bt_mesh_rpl_alloc(u16_t src)
+{
+	struct bt_mesh_rpl *rpl;
+	u16_t id;
+
+	if (rpl_free) {
+		id = rpl_free;
+		rpl_free = rpl_next[id - 1];
+	} else {
+		/* Replace the source which was heard from the longest ago */
+		id = rpl_lru_head;
+		BT_WARN("RPL is full, drop 0x%04x", bt_mesh.rpl[id - 1].src);
+		rpl_index_del(id);
+
+#ifdef CONFIG_BT_MESH_EVENT_CALLBACK
+		mesh_model_evt_cb event_cb = bt_mesh_event_get_cb_func();
+		if (event_cb) {
+			event_cb(BT_MESH_MODEL_EVT_RPL_IS_FULL, NULL);
+		}
+#endif
+	}
+
+	rpl = &bt_mesh.rpl[id - 1];
+	memset(rpl, 0, sizeof(*rpl));
+	rpl->src = src;
+	rpl_index_add(id);
+
+	return rpl;
+}
+
 static bool is_replay(struct bt_mesh_net_rx *rx)
 {
-	static uint8_t index = 0;
-	int i = 0;
-	struct bt_mesh_rpl *rpl = NULL;
+	struct bt_mesh_rpl *rpl;
 
 	/* Don't bother checking messages from ourselves */
 	if (rx->net_if == BT_MESH_NET_IF_LOCAL) {
 		return false;
 	}
 
-	for (i = 0; i < ARRAY_SIZE(bt_mesh.rpl); i++) {
-		rpl = &bt_mesh.rpl[i];
+	rpl = bt_mesh_rpl_find(rx->ctx.addr);
+	if (rpl) {
+		if (rx->old_iv && !rpl->old_iv) {
+			return true;
+		}
 
-		/* Empty slot */
-		if (!rpl->src) {
-			rpl->src = rx->ctx.addr;
+		if ((!rx->old_iv && rpl->old_iv) ||
+		    rpl->seq < rx->seq) {
 			rpl->seq = rx->seq;
 			rpl->old_iv = rx->old_iv;
 
+			rpl_lru_unlink(rpl - bt_mesh.rpl + 1);
+			rpl_lru_append(rpl - bt_mesh.rpl + 1);
+
 			if (IS_ENABLED(CONFIG_BT_SETTINGS)) {
 				bt_mesh_store_rpl(rpl);
 			}
@@ -609,34 +743,10 @@ static bool is_replay(struct bt_mesh_net_rx *rx)
 			return false;
 		}
 
-		/* Existing slot for given address */
-		if (rpl->src == rx->ctx.addr) {
-			if (rx->old_iv && !rpl->old_iv) {
-				return true;
-			}
-
-			if ((!rx->old_iv && rpl->old_iv) ||
-			    rpl->seq < rx->seq) {
-				rpl->seq = rx->seq;
-				rpl->old_iv = rx->old_iv;
-
-				if (IS_ENABLED(CONFIG_BT_SETTINGS)) {
-					bt_mesh_store_rpl(rpl);
-				}
-
-				return false;
-			} else {
-				return true;
-			}
-		}
+		return true;
 	}
 
-	/*[genie begin] changed by lgy at 2020-12-09*/
-	// overlap rpl when it is full
-	BT_WARN("RPL is full:%d", index);
-
-	rpl = &bt_mesh.rpl[index];
-	rpl->src = rx->ctx.addr;
+	rpl = bt_mesh_rpl_alloc(rx->ctx.addr);
 	rpl->seq = rx->seq;
 	rpl->old_iv = rx->old_iv;
 
@@ -644,18 +754,7 @@ static bool is_replay(struct bt_mesh_net_rx *rx)
 		bt_mesh_store_rpl(rpl);
 	}
 
-	index++;
-	index = index % CONFIG_BT_MESH_CRPL;
-
-#ifdef CONFIG_BT_MESH_EVENT_CALLBACK
-	mesh_model_evt_cb event_cb = bt_mesh_event_get_cb_func();
-	if (event_cb) {
-		event_cb(BT_MESH_MODEL_EVT_RPL_IS_FULL, NULL);
-	}
-#endif
-
 	return false;
-	/*[genie end] changed by lgy at 2020-12-09*/
 }
 
 static int sdu_recv(struct bt_mesh_net_rx *rx, u32_t seq, u8_t hdr,
@@ -1547,6 +1646,7 @@ void bt_mesh_rx_reset(void)
 		bt_mesh_clear_rpl();
 	} else {
 		memset(bt_mesh.rpl, 0, sizeof(bt_mesh.rpl));
+		bt_mesh_rpl_index_rebuild();
 	}
 }
 
@@ -1575,12 +1675,15 @@ void bt_mesh_trans_init(void)
 				       (i * CONFIG_BT_MESH_RX_SDU_MAX));
 		seg_rx[i].buf.data = seg_rx[i].buf.__buf;
 	}
+
+	bt_mesh_rpl_index_rebuild();
 }
 
 void bt_mesh_rpl_clear(void)
 {
 	BT_DBG("");
 	memset(bt_mesh.rpl, 0, sizeof(bt_mesh.rpl));
+	bt_mesh_rpl_index_rebuild();
 }
 
 void bt_mesh_rpl_clear_all(void)
@@ -1591,6 +1694,7 @@ void bt_mesh_rpl_clear_all(void)
 		bt_mesh_clear_all_node_rpl();
 	 }
 	 memset(bt_mesh.rpl, 0, sizeof(bt_mesh.rpl));
+	 bt_mesh_rpl_index_rebuild();
 }
 
 void bt_mesh_rpl_clear_node(uint16_t unicast_addr, uint8_t elem_num)
@@ -1609,5 +1713,7 @@ void bt_mesh_rpl_clear_node(uint16_t unicast_addr, uint8_t elem_num)
 			memset(rpl, 0, sizeof(struct bt_mesh_rpl));
 		}
 	}
+
+	bt_mesh_rpl_index_rebuild();
 }
 
@@ -117,10 +117,18 @@
 #define CONFIG_BT_MESH_CRPL 10
 #endif
 
+#ifndef CONFIG_BT_MESH_RPL_HASH_SIZE
+#define CONFIG_BT_MESH_RPL_HASH_SIZE 16
+#endif
+
 #ifndef CONFIG_BT_MESH_MSG_CACHE_SIZE
 #define CONFIG_BT_MESH_MSG_CACHE_SIZE 10
 #endif
 
+#ifndef CONFIG_BT_MESH_MSG_CACHE_HASH_SIZE
+#define CONFIG_BT_MESH_MSG_CACHE_HASH_SIZE 16
+#endif
+
 #ifndef CONFIG_BT_MESH_ADV_BUF_COUNT
 #define CONFIG_BT_MESH_ADV_BUF_COUNT 9
 #endif
@@ -260,6 +268,14 @@
 #define CONFIG_BT_MESH_RPL_STORE_TIMEOUT 5
 #endif
 
+/* Added to the RPL loaded from flash: covers a source sending 2 messages a
+ * second for one store timeout, a quiet source loses as many messages
+ * after a reboot.
+ */
+#ifndef CONFIG_BT_MESH_RPL_SEQ_GAP
+#define CONFIG_BT_MESH_RPL_SEQ_GAP (2 * CONFIG_BT_MESH_RPL_STORE_TIMEOUT)
+#endif
+
 #endif //CONFIG_BT_SETTINGS
 
 #ifndef CONFIG_BT_MESH_DEBUG
@@ -11,8 +11,21 @@
 #include "fatfs_vfs.h"
 #include "ff.h"
 
+#ifndef CONFIG_FATFS_CLMT_SIZE_MIN
+#define CONFIG_FATFS_CLMT_SIZE_MIN 16    /* items of the link map tried first, 2 per fragment + 2 */
+#endif
+
+#ifndef CONFIG_FATFS_CLMT_SIZE_MAX
+#define CONFIG_FATFS_CLMT_SIZE_MAX 1024  /* a file more fragmented than this seeks along the FAT chain */
+#endif
+
 static const char *fatfs_mnt_path = "/fatfs0";
 
+typedef struct {
+    FIL file;                 /* keep first, f_arg points to it */
+    uint8_t linkmap_tried;
+} fatfs_file_t;
+
 typedef struct {
     int dd_vfs_fd;
     int dd_rsv;
@@ -109,16 +122,19 @@ static int _fatfs_open(file_t *fp, const char *path, int flags)
     FRESULT ret;
     //char *relpath = NULL;
 
-    FIL *file = aos_malloc(sizeof(FIL));
+    fatfs_file_t *ffile = aos_malloc(sizeof(fatfs_file_t));
 
-    if (file == NULL) {
+    if (ffile == NULL) {
         return -ENOMEM;
     }
 
-    ret = f_open(file, path, _fatfs_mode_conv(flags));
+    ffile->linkmap_tried = 0;
+    ret = f_open(&ffile->file, path, _fatfs_mode_conv(flags));
 
     if (ret == FR_OK) {
-        fp->f_arg = file;
+        fp->f_arg = &ffile->file;
+    } else {
+        aos_free(ffile);
     }
 
     ret = _fatfs_ret_to_err(ret);
@@ -135,6 +151,7 @@ static int _fatfs_close(file_t *fp)
     ret = f_close(file);
 
     if (ret == FR_OK) {
+        aos_free(file->cltbl);
         aos_free(file);
     }
 
@@ -173,16 +190,61 @@ static ssize_t _fatfs_write(file_t *fp, const char *buf, size_t len)
     return _fatfs_ret_to_err(ret);
 }
 
+/*
+ * the cluster link map makes a seek find its cluster without walking the FAT chain from
+ * the start. it is built on the first seek of a file opened for read only(a file in the
+ * fast seek mode can't be stretched), starts small and grows once to the size the chain needs
+ */
+static void _fatfs_linkmap_create(fatfs_file_t *ffile)
+{
+    FRESULT ret;
+    DWORD *tbl, size = CONFIG_FATFS_CLMT_SIZE_MIN;
+    FIL *file = &ffile->file;
+
+    ffile->linkmap_tried = 1;
+    if ((file->flag & FA_WRITE) || f_size(file) <= (FSIZE_t)file->obj.fs->csize * FF_MAX_SS) {
+        return;
+    }
+
+    for (;;) {
+        tbl = aos_malloc(sizeof(DWORD) * size);
+        if (tbl == NULL) {
+            return;
+        }
+
+        tbl[0] = size;
+        file->cltbl = tbl;
+        ret = f_lseek(file, CREATE_LINKMAP);
+        if (ret == FR_OK) {
+            return;
+        }
+
+        file->cltbl = NULL;
+        size = tbl[0];        /* the size needed */
+        aos_free(tbl);
+
+        if (ret != FR_NOT_ENOUGH_CORE || size > CONFIG_FATFS_CLMT_SIZE_MAX) {
+            return;
+        }
+    }
+}
+
 static off_t _fatfs_lseek(file_t *fp, off_t off, int whence)
 {
     FRESULT ret;
     FIL *file;
+    fatfs_file_t *ffile;
 
     if (whence == SEEK_CUR || whence == SEEK_END) {
         return -EPERM;
     }
 
     file = (FIL*)(fp->f_arg);
+    ffile = (fatfs_file_t*)file;
+    if (!ffile->linkmap_tried) {
+        _fatfs_linkmap_create(ffile);
+    }
+
     ret = f_lseek(file, off);
 
     return _fatfs_ret_to_err(ret);
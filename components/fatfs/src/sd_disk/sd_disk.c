@@ -43,6 +43,18 @@
 /*******************************************************************************
  * Definitons
  ******************************************************************************/
+#ifndef CONFIG_FATFS_SD_READ_AHEAD
+#define CONFIG_FATFS_SD_READ_AHEAD (16) /* sectors read by one command on a sequential small read, 0: disable */
+#endif
+
+/*! @brief Read-ahead window of the volume */
+typedef struct _sd_read_ahead {
+    uint8_t *buf;
+    uint32_t size;     /* bytes of buf */
+    uint32_t sector;   /* first sector in the window */
+    uint32_t count;    /* valid sectors in the window, 0: empty */
+    uint32_t next;     /* sector after the last small read out of the window */
+} sd_read_ahead_t;
 
 /*******************************************************************************
  * Prototypes
@@ -57,6 +69,8 @@ extern sd_card_t SDIO_SDCard;
 
 static aos_mutex_t mutex;
 
+static sd_read_ahead_t read_ahead;
+
 /*******************************************************************************
  * Code
  ******************************************************************************/
@@ -68,6 +82,11 @@ DRESULT sd_disk_write(uint8_t physicalDrive, const uint8_t *buffer, uint32_t sec
 
     aos_mutex_lock(&mutex, AOS_WAIT_FOREVER);
 
+    /* a failed write may have changed some of the sectors too */
+    if (sector < read_ahead.sector + read_ahead.count && read_ahead.sector < sector + count) {
+        read_ahead.count = 0;
+    }
+
     if (kStatus_Success != SD_WriteBlocks(&SDIO_SDCard, buffer, sector, count)) {
         aos_mutex_unlock(&mutex);
         return RES_ERROR;
@@ -78,15 +97,62 @@ DRESULT sd_disk_write(uint8_t physicalDrive, const uint8_t *buffer, uint32_t sec
     return RES_OK;
 }
 
+/*
+ * fatfs reads the file data sector by sector for the small reads. a sequential one
+ * (right after the window or the last small read) fills the whole window by one command,
+ * the next sectors come from the window then. a random read still reads only what it needs
+ */
+static status_t sd_disk_read_ahead(uint8_t *buffer, uint32_t sector, uint8_t count)
+{
+    uint32_t n;
+    status_t ret;
+    sd_read_ahead_t *ra = &read_ahead;
+    uint32_t block_size = SDIO_SDCard.block_size;
+
+    if (ra->count && sector >= ra->sector && sector + count <= ra->sector + ra->count) {
+        memcpy(buffer, ra->buf + (sector - ra->sector) * block_size, count * block_size);
+        return kStatus_Success;
+    }
+
+    n = SDIO_SDCard.block_count - sector;
+    n = n < CONFIG_FATFS_SD_READ_AHEAD ? n : CONFIG_FATFS_SD_READ_AHEAD;
+
+    if ((ra->count && sector == ra->sector + ra->count) || sector == ra->next) {
+        if (n >= count) {
+            ra->count = 0;
+            ret = SD_ReadBlocks(&SDIO_SDCard, ra->buf, sector, n);
+            if (kStatus_Success != ret) {
+                return ret;
+            }
+            ra->sector = sector;
+            ra->count  = n;
+            memcpy(buffer, ra->buf, count * block_size);
+            return kStatus_Success;
+        }
+    }
+
+    ra->next = sector + count;
+
+    return SD_ReadBlocks(&SDIO_SDCard, buffer, sector, count);
+}
+
 DRESULT sd_disk_read(uint8_t physicalDrive, uint8_t *buffer, uint32_t sector, uint8_t count)
 {
+    status_t ret;
+
     if (physicalDrive != SDDISK) {
         return RES_PARERR;
     }
 
     aos_mutex_lock(&mutex, AOS_WAIT_FOREVER);
 
-    if (kStatus_Success != SD_ReadBlocks(&SDIO_SDCard, buffer, sector, count)) {
+    if (read_ahead.buf && count < CONFIG_FATFS_SD_READ_AHEAD) {
+        ret = sd_disk_read_ahead(buffer, sector, count);
+    } else {
+        ret = SD_ReadBlocks(&SDIO_SDCard, buffer, sector, count);
+    }
+
+    if (kStatus_Success != ret) {
         aos_mutex_unlock(&mutex);
         return RES_ERROR;
     }
@@ -169,5 +235,22 @@ DSTATUS sd_disk_initialize(uint8_t physicalDrive)
 
     status_t ret = SD_Init(&SDIO_SDCard, NULL, 1);
 
+    /* the window is kept over a re-init, it is empty again */
+    read_ahead.sector = 0;
+    read_ahead.count  = 0;
+    read_ahead.next   = UINT32_MAX;
+#if CONFIG_FATFS_SD_READ_AHEAD > 1
+    if (read_ahead.buf && read_ahead.size != CONFIG_FATFS_SD_READ_AHEAD * SDIO_SDCard.block_size) {
+        aos_free(read_ahead.buf);
+        read_ahead.buf  = NULL;
+        read_ahead.size = 0;
+    }
+    /* no window if no memory, the reads go to the card directly */
+    if (ret == kStatus_Success && read_ahead.buf == NULL) {
+        read_ahead.buf  = aos_malloc(CONFIG_FATFS_SD_READ_AHEAD * SDIO_SDCard.block_size);
+        read_ahead.size = read_ahead.buf ? CONFIG_FATFS_SD_READ_AHEAD * SDIO_SDCard.block_size : 0;
+    }
+#endif
+
     return (ret == kStatus_Success) ? RES_OK : RES_NOTRDY;
 }
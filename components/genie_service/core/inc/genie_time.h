@@ -15,8 +15,8 @@ typedef struct
 } vendor_attr_data_t;
 #pragma pack()
 
-#define GENIE_TIME_HW_TEIMER_ID (0)
-#define GENIE_TIME_HW_TEIMER_PERIOD (1000 * 1000)
+//the timer is armed for the next deadline only, at most this far ahead(seconds)
+#define GENIE_TIME_ARM_MAX (24 * 60 * 60)
 
 #define DEF_SYNC_PERIOD 180
 #define DEF_SYNC_DELAY 10
@@ -73,10 +73,11 @@ typedef struct _genie_time_timer_s
 {
     uint8_t init : 1;
     uint8_t update : 1;
-    timer_dev_t timer;
+    aos_timer_t timer;
     sys_slist_t timer_list_active;
     sys_slist_t timer_list_idle;
-    uint32_t unix_time;
+    uint32_t unix_time;   //at uptime_sync
+    int64_t uptime_sync;  //ms
     uint32_t unix_time_sync_match;
     uint8_t unix_time_sync_retry_times;
     genie_time_event_func_t genie_time_event_cb;
@@ -3,6 +3,7 @@
  */
 
 #include <stdint.h>
+#include <aos/kernel.h>
 #include <api/mesh.h>
 #include <misc/slist.h>
 #include "genie_service.h"
@@ -12,21 +13,22 @@
 #endif
 
 static inline uint8_t is_leap_year(uint16_t year);
+static inline utc_time_t unix2UTC(uint32_t unix_time);
 static genie_time_data_t genie_time_data;
 static genie_time_timer_t genie_time_timer;
-static utc_time_t local_time = {0};
 
 #define GENIE_TIME_LOCK k_sem_take(&genie_time_timer.lock, -1)
 #define GENIE_TIME_UNLOCK k_sem_give(&genie_time_timer.lock)
 
-utc_time_t genie_time_local_time_get()
+uint32_t genie_time_local_unixtime_get()
 {
-    return local_time;
+    //no tick counting, the time runs on the uptime since the last sync
+    return genie_time_timer.unix_time + (uint32_t)((k_uptime_get() - genie_time_timer.uptime_sync) / 1000);
 }
 
-uint32_t genie_time_local_unixtime_get()
+utc_time_t genie_time_local_time_get()
 {
-    return genie_time_timer.unix_time;
+    return unix2UTC(genie_time_local_unixtime_get() + genie_time_data.timezone * HOUR);
 }
 
 static int genie_time_time_sync_get(uint16_t *period_time, uint8_t *retry_delay, uint8_t *retry_times)
@@ -102,6 +104,85 @@ static inline uint8_t next_weekday_diff_get(uint8_t weekday_now, uint8_t schedul
     return day_diff;
 }
 
+static inline uint8_t next_weekday(uint8_t weekday_now)
+{
+    return (weekday_now + 1) % 7;
+}
+
+//first match of the periodic timer not before unix_time, the repeat is counted in whole days
+static uint32_t genie_time_periodic_next(genie_time_t *vendor_timer, uint32_t unix_time)
+{
+    uint32_t local = unix_time + genie_time_data.timezone * HOUR;
+    uint32_t midnight = local - local % DAY;
+    uint8_t weekday = (midnight / DAY + 4) % 7; // 1970/1/1 is thursday
+
+    if (midnight + vendor_timer->periodic_time < local)
+    {
+        midnight += DAY;
+        weekday = next_weekday(weekday);
+    }
+
+    midnight += next_weekday_diff_get(weekday, vendor_timer->schedule) * DAY;
+
+    return midnight + vendor_timer->periodic_time - genie_time_data.timezone * HOUR;
+}
+
+//recompute the periodic matches after the time or the timezone changed
+static void genie_time_periodic_refresh(void)
+{
+    genie_time_t *tmp = NULL, *node = NULL;
+    uint32_t unix_time = genie_time_local_unixtime_get();
+
+    GENIE_TIME_LOCK;
+    SYS_SLIST_FOR_EACH_CONTAINER_SAFE(&genie_time_timer.timer_list_active, node, tmp, next)
+    {
+        if (node->state != TIMER_INVAILD && node->periodic)
+        {
+            node->unixtime_match = genie_time_periodic_next(node, unix_time);
+        }
+    }
+    GENIE_TIME_UNLOCK;
+}
+
+/*
+ * arm the timer for the earliest deadline only, instead of a tick every second.
+ * called whenever the timers, the sync or the time change
+ */
+static void genie_time_schedule(void)
+{
+    genie_time_t *tmp = NULL, *node = NULL;
+    uint32_t deadline = 0xffffffff;
+    int64_t timeout;
+
+    if (!genie_time_timer.init || !genie_time_timer.update)
+    {
+        return;
+    }
+
+    GENIE_TIME_LOCK;
+    if (genie_time_timer.unix_time_sync_match)
+    {
+        deadline = genie_time_timer.unix_time_sync_match;
+    }
+
+    SYS_SLIST_FOR_EACH_CONTAINER_SAFE(&genie_time_timer.timer_list_active, node, tmp, next)
+    {
+        if (node->state != TIMER_INVAILD && node->unixtime_match < deadline)
+        {
+            deadline = node->unixtime_match;
+        }
+    }
+    GENIE_TIME_UNLOCK;
+
+    //ms to the start of the deadline second
+    timeout = ((int64_t)deadline - genie_time_timer.unix_time) * 1000 - (k_uptime_get() - genie_time_timer.uptime_sync);
+    timeout = timeout < 1 ? 1 : (timeout > GENIE_TIME_ARM_MAX * 1000 ? GENIE_TIME_ARM_MAX * 1000 : timeout);
+
+    aos_timer_stop(&genie_time_timer.timer);
+    aos_timer_change_once(&genie_time_timer.timer, (int)timeout);
+    aos_timer_start(&genie_time_timer.timer);
+}
+
 static genie_time_t *genie_time_find(uint8_t index)
 {
     if (index >= GENIE_TIME_MAX)
@@ -189,14 +270,7 @@ static int genie_time_periodic_start(uint8_t index, uint32_t periodic_time, uint
     vendor_timer->state = TIMER_ON;
     vendor_timer->attr_data.para = attr_data->para;
     vendor_timer->attr_data.type = attr_data->type;
-
-    utc_time_t utc = local_time;
-    utc.hour = 0;
-    utc.minutes = 0;
-    utc.seconds = 0;
-    utc.day = utc.day + next_weekday_diff_get(local_time.weekday, schedule);
-
-    vendor_timer->unixtime_match = UTC2unix(&utc) + periodic_time - genie_time_data.timezone * HOUR;
+    vendor_timer->unixtime_match = genie_time_periodic_next(vendor_timer, genie_time_local_unixtime_get());
 
     GENIE_LOG_DBG("periodic timer unixtime_match %d\n", vendor_timer->unixtime_match);
 
@@ -205,6 +279,7 @@ static int genie_time_periodic_start(uint8_t index, uint32_t periodic_time, uint
     GENIE_TIME_UNLOCK;
 
     genie_time_save();
+    genie_time_schedule();
 
     return 0;
 }
@@ -321,7 +396,7 @@ static int genie_time_start(uint8_t index, uint32_t unix_time, vendor_attr_data_
         //return -GT_E_INDEX;
     }
 
-    if (unix_time <= genie_time_timer.unix_time)
+    if (unix_time <= genie_time_local_unixtime_get())
     {
         return -GT_E_PARAM;
     }
@@ -355,6 +430,7 @@ static int genie_time_start(uint8_t index, uint32_t unix_time, vendor_attr_data_
     GENIE_TIME_UNLOCK;
 
     genie_time_save();
+    genie_time_schedule();
 
     return 0;
 }
@@ -650,6 +726,7 @@ static int genie_time_remove(int8_t index)
     }
 
     genie_time_save();
+    genie_time_schedule();
 
     return ret;
 }
@@ -900,96 +977,6 @@ static inline uint8_t is_leap_year(uint16_t year)
     }
 }
 
-static inline void month_update()
-{
-    local_time.month++;
-
-    if (local_time.month >= 12)
-    {
-        local_time.month = 0;
-        local_time.year++;
-    }
-}
-
-static inline void days_update()
-{
-    uint8_t month_days_list[12] = {
-        31,
-        28,
-        31,
-        30,
-        31,
-        30,
-        31,
-        31,
-        30,
-        31,
-        30,
-        31,
-    };
-
-    local_time.day++;
-
-    if (is_leap_year(local_time.year))
-    {
-        month_days_list[1] = 29;
-    }
-
-    uint8_t month_day = month_days_list[local_time.month];
-
-    if (local_time.day > month_day)
-    {
-        local_time.day = 0;
-        month_update();
-    }
-
-    local_time.weekday = (local_time.weekday + 1) % 7;
-}
-
-static inline void hours_update()
-{
-    local_time.hour++;
-
-    if (local_time.hour == 24)
-    {
-        local_time.hour = 0;
-        days_update();
-    }
-}
-
-static inline void minutes_update()
-{
-    local_time.minutes++;
-
-    if (local_time.minutes == 60)
-    {
-        local_time.minutes = 0;
-        hours_update();
-    }
-}
-
-static inline void seconds_update()
-{
-    local_time.seconds++;
-
-    if (local_time.seconds == 60)
-    {
-        local_time.seconds = 0;
-        minutes_update();
-    }
-}
-
-static inline uint8_t is_weekday_match(uint8_t weekday_now, uint8_t schedule)
-{
-    uint8_t weekday_mask = weekday_now ? (uint8_t)(1 << (weekday_now - 1)) : (uint8_t)(1 << 6);
-    return (weekday_mask == (schedule & weekday_mask));
-}
-
-static inline uint8_t next_weekday(uint8_t weekday_now)
-{
-    return (weekday_now + 1) % 7;
-}
-
 static int genie_time_erase()
 {
 #ifdef GT_STORE
@@ -1053,31 +1040,15 @@ static int genie_time_restore()
 #endif
 }
 
-static uint8_t is_genie_time_timeout(genie_time_t *vendor_timer)
-{
-    if (vendor_timer->state == TIMER_INVAILD)
-    {
-        return 0;
-    }
-
-    if (vendor_timer->periodic)
-    {
-        if (is_weekday_match(local_time.weekday, vendor_timer->schedule) && vendor_timer->unixtime_match < genie_time_timer.unix_time)
-        {
-            vendor_timer->unixtime_match += (1 + next_weekday_diff_get(next_weekday(local_time.weekday), vendor_timer->schedule)) * DAY;
-        }
-    }
-
-    return vendor_timer->unixtime_match == genie_time_timer.unix_time;
-}
-
 static void genie_time_do_work(struct k_work *work)
 {
     genie_time_t *tmp = NULL, *node = NULL;
+    uint32_t unix_time = genie_time_local_unixtime_get();
 
     SYS_SLIST_FOR_EACH_CONTAINER_SAFE(&genie_time_timer.timer_list_active, node, tmp, next)
     {
-        if (is_genie_time_timeout(node))
+        //missed ones fire late too, e.g. the time jumped over them on a resync
+        if (node->state != TIMER_INVAILD && node->unixtime_match <= unix_time)
         {
             if (genie_time_timer.genie_time_event_cb)
             {
@@ -1095,7 +1066,7 @@ static void genie_time_do_work(struct k_work *work)
             }
             else
             {
-                node->unixtime_match += 24 * HOUR;
+                node->unixtime_match = genie_time_periodic_next(node, unix_time + 1);
             }
 
             GENIE_TIME_UNLOCK;
@@ -1103,44 +1074,33 @@ static void genie_time_do_work(struct k_work *work)
         }
     }
 
-    if (genie_time_timer.unix_time_sync_match && genie_time_timer.unix_time_sync_match <= genie_time_timer.unix_time)
+    if (genie_time_timer.unix_time_sync_match && genie_time_timer.unix_time_sync_match <= unix_time)
     {
+        int ret = 0;
+
         if (genie_time_timer.genie_time_event_cb)
         {
-            int ret = genie_time_timer.genie_time_event_cb(GT_TIMING_SYNC, 0, NULL);
-
-            if (ret)
-            {
-                if (genie_time_timer.unix_time_sync_retry_times > 0)
-                {
-                    genie_time_timer.unix_time_sync_match += genie_time_data.timing_sync_config.retry_delay * MINU;
-                    genie_time_timer.unix_time_sync_retry_times--;
-                    return;
-                }
-            }
+            ret = genie_time_timer.genie_time_event_cb(GT_TIMING_SYNC, 0, NULL);
         }
 
-        genie_time_timer.unix_time_sync_retry_times = genie_time_data.timing_sync_config.retry_times;
-        genie_time_timer.unix_time_sync_match = genie_time_timer.unix_time + genie_time_data.timing_sync_config.period_time * MINU;
+        if (ret && genie_time_timer.unix_time_sync_retry_times > 0)
+        {
+            genie_time_timer.unix_time_sync_match += genie_time_data.timing_sync_config.retry_delay * MINU;
+            genie_time_timer.unix_time_sync_retry_times--;
+        }
+        else
+        {
+            genie_time_timer.unix_time_sync_retry_times = genie_time_data.timing_sync_config.retry_times;
+            genie_time_timer.unix_time_sync_match = unix_time + genie_time_data.timing_sync_config.period_time * MINU;
+        }
     }
+
+    genie_time_schedule();
 }
 
-static void timer_update(void *args)
+static void genie_time_timer_cb(void *timer, void *args)
 {
-    if (!genie_time_timer.update)
-    {
-        return;
-    }
-
-    genie_time_timer.unix_time += 1;
-    seconds_update();
-
     k_work_submit(&genie_time_timer.work);
-
-    if (genie_time_timer.unix_time % 60 == 0)
-    {
-        GENIE_LOG_DBG("timer_update %d\n", genie_time_timer.unix_time);
-    }
 }
 
 int genie_time_utc_start(uint8_t index, utc_time_t utc_time, vendor_attr_data_t *attr_data)
@@ -1156,6 +1116,8 @@ int genie_time_utc_start(uint8_t index, utc_time_t utc_time, vendor_attr_data_t
 
 void genie_time_local_time_show()
 {
+    utc_time_t local_time = genie_time_local_time_get();
+
     GENIE_LOG_DBG("%4d/%2d/%2d %2d:%2d:%d weekday %2d %04d\n",
                   local_time.year, local_time.month + 1, local_time.day,
                   local_time.hour, local_time.minutes, local_time.seconds,
@@ -1177,6 +1139,8 @@ static int genie_time_timezone_update(int8_t timezone)
     }
 
     genie_time_data.timezone = timezone;
+    genie_time_periodic_refresh();
+    genie_time_schedule();
 
     return 0;
 }
@@ -1195,8 +1159,9 @@ static int genie_time_time_sync_set(uint16_t period_time, uint8_t retry_delay, u
     genie_time_data.timing_sync_config.retry_delay = retry_delay;
     genie_time_data.timing_sync_config.retry_times = retry_times;
 
-    genie_time_timer.unix_time_sync_match = genie_time_timer.unix_time + genie_time_data.timing_sync_config.period_time * MINU;
+    genie_time_timer.unix_time_sync_match = genie_time_local_unixtime_get() + genie_time_data.timing_sync_config.period_time * MINU;
     genie_time_timer.unix_time_sync_retry_times = retry_times;
+    genie_time_schedule();
 
     return 0;
 }
@@ -1210,8 +1175,9 @@ static int genie_time_local_time_update(uint32_t unix_time)
 
     genie_time_timer.update = 1;
     genie_time_timer.unix_time = unix_time;
+    genie_time_timer.uptime_sync = k_uptime_get();
 
-    local_time = unix2UTC(unix_time + genie_time_data.timezone * HOUR);
+    utc_time_t local_time = genie_time_local_time_get();
 
     GENIE_LOG_DBG("unix_time %d\n", unix_time);
     GENIE_LOG_DBG("localtime update %4d/%2d/%2d %2d:%2d:%d weekday %2d\n",
@@ -1220,6 +1186,8 @@ static int genie_time_local_time_update(uint32_t unix_time)
                   local_time.weekday);
     GENIE_LOG_DBG("unix_time revert %d\n", UTC2unix(&local_time));
 
+    //the sync set below arms the timer again
+    genie_time_periodic_refresh();
     genie_time_time_sync_set(DEF_SYNC_PERIOD, DEF_SYNC_DELAY, DEF_SYNC_DELAY_RETRY);
 
     return 0;
@@ -1396,7 +1364,6 @@ int genie_time_init(void)
     }
 
     memset(&genie_time_timer, 0, sizeof(genie_time_timer));
-    memset(&local_time, 0, sizeof(local_time));
 
     genie_time_timer.genie_time_event_cb = genie_time_event_callback;
 
@@ -1406,13 +1373,12 @@ int genie_time_init(void)
     k_sem_init(&genie_time_timer.lock, 1, 1);
 
     k_work_init(&genie_time_timer.work, genie_time_do_work);
-    genie_time_timer.timer.port = GENIE_TIME_HW_TEIMER_ID;
-    genie_time_timer.timer.config.period = GENIE_TIME_HW_TEIMER_PERIOD;
-    genie_time_timer.timer.config.reload_mode = TIMER_RELOAD_AUTO;
-    genie_time_timer.timer.config.cb = timer_update;
-    genie_time_timer.timer.config.arg = NULL;
-    hal_timer_init(&genie_time_timer.timer);
-    hal_timer_start(&genie_time_timer.timer);
+    //armed once the local time is set, deleted by genie_time_finalize
+    if (aos_timer_new_ext(&genie_time_timer.timer, genie_time_timer_cb, NULL, GENIE_TIME_ARM_MAX * 1000, 0, 0))
+    {
+        k_sem_delete(&genie_time_timer.lock);
+        return -1;
+    }
 
     genie_time_timer.init = 1;
 
@@ -1455,19 +1421,12 @@ int genie_time_finalize(void)
         genie_time_stop(i);
     }
 
-    hal_timer_stop(&genie_time_timer.timer);
-    /*
-    ret = hal_timer_finalize(&genie_time_timer.timer);
-
-    if (ret)
-    {
-        printf("timer finalize faild\r\n");
-        return ret;
-    }*/
+    //the memset below must not leave a live kernel timer behind
+    aos_timer_stop(&genie_time_timer.timer);
+    aos_timer_free(&genie_time_timer.timer);
 
     k_sem_delete(&genie_time_timer.lock);
     (void)memset(&genie_time_timer, 0, offsetof(genie_time_timer_t, work));
-    memset(&local_time, 0, sizeof(local_time));
 
     ret = genie_time_erase();
 
@@ -35,6 +35,8 @@ struct message_msg {
     aos_queue_t     queue;           /** queue for SYNC MESSAGE */
     void           *resp_data;
     int             resp_len;
+    void           *ack_data;        /** resp_data of the sync sender, the ack is copied to it */
+    int             ack_len;
 };
 
 /**
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2019-2020 Alibaba Group Holding Limited
+ */
+
+#ifndef AOS_IPC_RING_H
+#define AOS_IPC_RING_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define IPC_RING_CACHE_LINE (32)
+#define IPC_RING_CACHE      0x01         /** the shared memory is cacheable */
+
+typedef struct ipc_ring_shm ipc_ring_shm_t;
+typedef struct ipc_ring     ipc_ring_t;
+
+/**
+ * single-producer/single-consumer descriptor ring in shared memory.
+ * the producer and the consumer each own a local ipc_ring_t attached to the same
+ * ipc_ring_shm_t, no lock is needed between the two cores.
+ */
+struct ipc_ring {
+    ipc_ring_shm_t *shm;
+    uint8_t        *slots;
+    uint32_t        slot_num;            /** power of 2 */
+    uint32_t        slot_size;           /** aligned to IPC_RING_CACHE_LINE */
+    uint32_t        head;                /** local producer index */
+    uint32_t        tail;                /** local consumer index */
+    uint32_t        event;               /** consumer: idle sequence, producer: last kicked idle sequence */
+    uint32_t        flag;
+};
+
+/**
+ * @brief  get the shared memory size a ring needs
+ * @param  [in] slot_num  : number of slots, power of 2
+ * @param  [in] desc_size : descriptor size
+ * @return size in bytes, aligned to IPC_RING_CACHE_LINE
+ */
+size_t     ipc_ring_shm_size(int slot_num, int desc_size);
+
+/**
+ * @brief  format the shared memory as a ring, called once by the producer
+ * @param  [in] ring      : local ring handle
+ * @param  [in] shm       : shared memory, aligned to IPC_RING_CACHE_LINE
+ * @param  [in] slot_num  : number of slots, power of 2
+ * @param  [in] desc_size : descriptor size
+ * @param  [in] flag      : IPC_RING_CACHE
+ * @return 0 on success, -1 on failed
+ */
+int        ipc_ring_init(ipc_ring_t *ring, void *shm, int slot_num, int desc_size, int flag);
+
+/**
+ * @brief  attach to a ring formatted by the peer
+ * @param  [in] ring      : local ring handle
+ * @param  [in] shm       : shared memory
+ * @param  [in] flag      : IPC_RING_CACHE
+ * @return 0 on success, -1 on failed
+ */
+int        ipc_ring_attach(ipc_ring_t *ring, void *shm, int flag);
+
+/**
+ * @brief  get the next free slot, the descriptor is written in place
+ * @param  [in] ring      : local ring handle
+ * @return slot pointer, NULL if the ring is full
+ */
+void      *ipc_ring_reserve(ipc_ring_t *ring);
+
+/**
+ * @brief  queue the reserved slot, it is not visible to the consumer before ipc_ring_publish
+ * @param  [in] ring      : local ring handle
+ */
+void       ipc_ring_push(ipc_ring_t *ring);
+
+/**
+ * @brief  make all pushed slots visible to the consumer
+ * @param  [in] ring      : local ring handle
+ * @return 1 if the consumer sleeps and a doorbell is needed, 0 otherwise
+ */
+int        ipc_ring_publish(ipc_ring_t *ring);
+
+/**
+ * @brief  get the oldest published slot
+ * @param  [in] ring      : local ring handle
+ * @return slot pointer, NULL if the ring is empty
+ */
+void      *ipc_ring_peek(ipc_ring_t *ring);
+
+/**
+ * @brief  release the slot got by ipc_ring_peek
+ * @param  [in] ring      : local ring handle
+ */
+void       ipc_ring_pop(ipc_ring_t *ring);
+
+/**
+ * @brief  announce the consumer is going to sleep, the next publish will ask for a doorbell
+ * @param  [in] ring      : local ring handle
+ * @return 0 if the ring is still empty and the consumer may sleep, 1 otherwise
+ */
+int        ipc_ring_idle(ipc_ring_t *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AOS_IPC_RING_H
@@ -64,7 +64,7 @@ typedef struct phy_msg {
     aos_sem_t       sem;             /** queue for SYNC MESSAGE */
 } phy_data_t;
 
-#define SERVER_QUEUE_SIZE (sizeof(phy_data_t) * 10)
+#define SERVER_QUEUE_SIZE (sizeof(message_t) * 10)
 typedef struct service {
     int id;
     ipc_process_t process;
@@ -75,12 +75,16 @@ typedef struct service {
     char ser_name[SER_NAME_MAX_LEN];
     char que_buf[SERVER_QUEUE_SIZE];
     aos_queue_t queue;
+    message_t rx;               /** message being received by the ipc task */
+    char *rx_pos;
+    int rx_left;                /** bytes of rx still to come */
 } service_t;
 
 typedef struct _dispatch {
     int total_len;
     int resp_len;
     aos_queue_t queue;
+    void *resp_data;            /** buffer of the sync sender, echoed by the ack */
 } dispatch_t;
 
 struct ipc {
@@ -94,7 +98,6 @@ struct ipc {
     aos_event_t evt;
     aos_mutex_t ch_mutex;
     aos_mutex_t tx_mutex;
-    aos_mutex_t rx_mutex;
     aos_sem_t   sem;
     void *priv;
     shm_t shm;
@@ -58,36 +58,35 @@ static int ipc_channel_recv(ipc_t *ipc, phy_data_t *msg, int timeout_ms)
     return ret;
 }
 
+/* the chunk stays in the shm of the peer, it is read in place and acked by phy_ack */
 static int phy_recv(ipc_t *ipc, phy_data_t *msg, int ms)
 {
-    phy_data_t m;
     int ret;
 
     while (1) {
-        ret = ipc_channel_recv(ipc, &m, ms);
+        ret = ipc_channel_recv(ipc, msg, ms);
 
-        if (m.flag & PHY_ACK) {
-            aos_sem_signal(&m.sem);
+        if (msg->flag & PHY_ACK) {
+            aos_sem_signal(&msg->sem);
             continue;
         }
 
-        if ((msg->flag & SHM_CACHE) && m.data) {
-            csi_dcache_invalid_range((uint32_t *)m.data, SHM_ALIGN_SIZE(m.len, SHM_ALIGN_CACHE));
+        if ((msg->flag & SHM_CACHE) && msg->data) {
+            csi_dcache_invalid_range((uint32_t *)msg->data, SHM_ALIGN_SIZE(msg->len, SHM_ALIGN_CACHE));
         }
-        memcpy(msg, &m, sizeof(phy_data_t));
-        msg->data = aos_malloc_check(m.len);
-        msg->len  = m.len;
-        if (m.data)
-            memcpy(msg->data, m.data, m.len);
-
-        m.flag |= PHY_ACK;
-        ipc_channel_send(ipc, &m, ms);
         break;
     }
 
     return ret;
 }
 
+/* the peer reuses its shm once the chunk is acked */
+static void phy_ack(ipc_t *ipc, phy_data_t *msg, int ms)
+{
+    msg->flag |= PHY_ACK;
+    ipc_channel_send(ipc, msg, ms);
+}
+
 static int phy_send(ipc_t *ipc, phy_data_t *msg, int ms)
 {
     if (msg->flag & SHM_CACHE) {
@@ -158,6 +157,12 @@ static int transfer_send(service_t *ser, message_t *msg, int timeout_ms)
 
     dispatch.total_len = total_len;
     dispatch.resp_len = msg->resp_len;
+    /* the ack goes straight to the buffer of the sender when its size is the one asked for */
+    if (msg->flag & MESSAGE_ACK) {
+        dispatch.resp_data = (msg->req_len == msg->ack_len) ? msg->ack_data : NULL;
+    } else {
+        dispatch.resp_data = (msg->flag & MESSAGE_SYNC) ? msg->resp_data : NULL;
+    }
     memcpy(&dispatch.queue, &msg->queue, sizeof(aos_queue_t));
 
     shm_reset(shm);
@@ -177,61 +182,63 @@ static int transfer_send(service_t *ser, message_t *msg, int timeout_ms)
     return 0;
 }
 
-static int phy_wait(service_t *ser, phy_data_t *msg, int ms)
+/* a chunk is copied from the shm to the message it belongs to, the whole message goes to the service */
+static void transfer_input(service_t *ser, phy_data_t *phy_msg)
 {
-    unsigned int len;
-    return (aos_queue_recv(&ser->queue, ms, msg, &len));
-}
+    message_t *msg = &ser->rx;
+    char *data     = phy_msg->data;
+    int len        = phy_msg->len;
 
-static int transfer_recv(service_t *ser, message_t *msg, int timeout_ms)
-{
-    phy_data_t phy_msg;
-    ipc_t *ipc = ser->ipc;
+    if (ser->rx_left == 0) {
+        /* the first chunk of a message starts with the dispatch */
+        dispatch_t *dispatch = (dispatch_t *)data;
 
-    int ret = phy_wait(ser, &phy_msg, timeout_ms);
+        memset(msg, 0x00, sizeof(message_t));
+        msg->req_len  = dispatch->total_len;
+        msg->resp_len = dispatch->resp_len;
+        memcpy(&msg->queue, &dispatch->queue, sizeof(aos_queue_t));
 
-    aos_mutex_lock(&ipc->rx_mutex, AOS_WAIT_FOREVER);
+        if (phy_msg->flag & MESSAGE_ACK) {
+            msg->req_data = dispatch->resp_data;
+        } else {
+            msg->ack_data = dispatch->resp_data;
+            msg->ack_len  = dispatch->resp_len;
+        }
 
-    dispatch_t *dispatch = (dispatch_t *)(phy_msg.data);
-    int total_len        = dispatch->total_len;
-    int recv_len         = 0;
-    char *recv           = NULL;
+        if (msg->req_data == NULL && msg->req_len > 0) {
+            msg->req_data = aos_malloc_check(msg->req_len);
+        }
 
-    if (total_len > 0) {
-        msg->req_data = aos_malloc_check(total_len);
-    } else {
-        msg->req_data = NULL;
+        ser->rx_pos  = msg->req_data;
+        ser->rx_left = msg->req_len;
+        data += sizeof(dispatch_t);
+        len  -= sizeof(dispatch_t);
     }
-    msg->req_len = total_len;
-    memcpy(&msg->queue, &dispatch->queue, sizeof(aos_queue_t));
-    msg->resp_len  = dispatch->resp_len;
-
-    if (msg->req_data != NULL) {
-        recv = (char *)msg->req_data;
-        memcpy(recv, (char *)phy_msg.data + sizeof(dispatch_t), phy_msg.len - sizeof(dispatch_t));
-        recv_len += (phy_msg.len - sizeof(dispatch_t));
-        total_len -= recv_len;
-        recv += recv_len;
+
+    len = MIN(len, ser->rx_left);
+    if (ser->rx_pos) {
+        memcpy(ser->rx_pos, data, len);
+        ser->rx_pos += len;
     }
+    ser->rx_left -= len;
 
-    aos_free(phy_msg.data);
+    if (ser->rx_left == 0) {
+        msg->flag       = phy_msg->flag;
+        msg->service_id = phy_msg->service_id;
+        msg->command    = phy_msg->command;
+        msg->seq        = phy_msg->seq;
 
-    while(recv && total_len > 0) {
-        phy_wait(ser, &phy_msg, timeout_ms);
-        memcpy(recv, phy_msg.data, phy_msg.len);
-        recv += phy_msg.len;
-        total_len -= phy_msg.len;
-        aos_free(phy_msg.data);
+        while (aos_queue_send(&ser->queue, msg, sizeof(message_t)) != 0) {
+            aos_msleep(100);
+        }
     }
-    aos_mutex_unlock(&ipc->rx_mutex);
+}
 
-    msg->flag          = phy_msg.flag;
-    msg->service_id    = phy_msg.service_id;
-    msg->command       = phy_msg.command;
-    msg->seq           = phy_msg.seq;
-    msg->resp_data = NULL;
+static int transfer_recv(service_t *ser, message_t *msg, int timeout_ms)
+{
+    unsigned int len;
 
-    return ret;
+    return aos_queue_recv(&ser->queue, timeout_ms, msg, &len);
 }
 
 static void ipc_task_process_entry(void *arg)
@@ -245,10 +252,9 @@ static void ipc_task_process_entry(void *arg)
 
         ser = find_service(ipc, data.service_id);
         if (ser) {
-            while (aos_queue_send(&ser->queue, &data, sizeof(phy_data_t)) != 0) {
-                aos_msleep(100);
-            }
+            transfer_input(ser, &data);
         }
+        phy_ack(ipc, &data, AOS_WAIT_FOREVER);
     }
 
     aos_task_exit(0);
@@ -321,11 +327,13 @@ int ipc_message_send(ipc_t *ipc, message_t *m, int timeout_ms)
         aos_queue_recv(&m->queue, AOS_WAIT_FOREVER, &msg, &len);
         aos_queue_free(&m->queue);
 
-        if (msg.resp_len == m->resp_len) {
-            memcpy(m->resp_data, msg.resp_data, msg.resp_len);
-            aos_free(msg.resp_data);
-        } else {
-            aos_assert(0);
+        if (msg.resp_data != m->resp_data) {
+            if (msg.resp_len == m->resp_len) {
+                memcpy(m->resp_data, msg.resp_data, msg.resp_len);
+                aos_free(msg.resp_data);
+            } else {
+                aos_assert(0);
+            }
         }
     }
 
@@ -413,8 +421,6 @@ ipc_t *ipc_get(int cpu_id)
         aos_check(!ret, ENOME);
         ret = aos_mutex_new(&ipc->tx_mutex);
         aos_check(!ret, ENOME);
-        ret = aos_mutex_new(&ipc->rx_mutex);
-        aos_check(!ret, ENOME);
         ret = aos_sem_new(&ipc->sem, 0);
         aos_check(!ret, ENOME);
         ret = aos_event_set(&ipc->evt, IPC_WRITE_EVENT, AOS_EVENT_OR);
@@ -460,8 +466,9 @@ int ipc_add_service(ipc_t *ipc, int service_id, ipc_process_t cb, void *priv)
         ser->process = cb;
         ser->priv    = priv;
         ser->ipc     = ipc;
+        ser->rx_left = 0;
         slist_add_tail(&ser->next, &ipc->service_list);
-        aos_queue_new(&ser->queue, ser->que_buf, SERVER_QUEUE_SIZE, sizeof(phy_data_t));
+        aos_queue_new(&ser->queue, ser->que_buf, SERVER_QUEUE_SIZE, sizeof(message_t));
         snprintf(ser->ser_name, SER_NAME_MAX_LEN, "ser%d->%d", service_id, ipc->des_cpu_id);
         aos_task_new_ext(&ser->task, ser->ser_name, ipc_service_entry, ser, 4 * 1024, 9);
 
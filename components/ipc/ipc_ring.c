@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2019-2020 Alibaba Group Holding Limited
+ */
+
+#include <string.h>
+#include <ipc_ring.h>
+
+#ifdef linux
+#   define ring_dcache_clean(addr, size)
+#   define ring_dcache_invalid(addr, size)
+#else
+#include <csi_core.h>
+#   define ring_dcache_clean(addr, size)   csi_dcache_clean_range((uint32_t *)(addr), size)
+#   define ring_dcache_invalid(addr, size) csi_dcache_invalid_range((uint32_t *)(addr), size)
+#endif
+
+#define RING_MAGIC (0x52494e47)
+#define RING_ALIGN(size) (((uint32_t)(size) + IPC_RING_CACHE_LINE - 1U) & (~(uint32_t)(IPC_RING_CACHE_LINE - 1U)))
+#define RING_PAD(n) (IPC_RING_CACHE_LINE - (n) * sizeof(uint32_t))
+
+/**
+ * every field group is written by one side only and lives on its own cache line,
+ * so that a cache clean of one side never overwrites what the other side wrote.
+ */
+struct ipc_ring_shm {
+    uint32_t        magic;               /** read only after init */
+    uint32_t        slot_num;
+    uint32_t        slot_size;
+    uint8_t         pad0[RING_PAD(3)];
+
+    volatile uint32_t head;              /** written by the producer */
+    uint8_t         pad1[RING_PAD(1)];
+
+    volatile uint32_t tail;              /** written by the consumer */
+    volatile uint32_t idle;              /** odd while the consumer sleeps */
+    uint8_t         pad2[RING_PAD(2)];
+
+    uint8_t         slots[0];
+};
+
+#define ring_mb() __sync_synchronize()
+
+static inline void ring_sync_out(ipc_ring_t *ring, volatile void *addr, size_t size)
+{
+    ring_mb();
+
+    if (ring->flag & IPC_RING_CACHE) {
+        ring_dcache_clean(addr, RING_ALIGN(size));
+    }
+}
+
+static inline void ring_sync_in(ipc_ring_t *ring, volatile void *addr, size_t size)
+{
+    if (ring->flag & IPC_RING_CACHE) {
+        ring_dcache_invalid(addr, RING_ALIGN(size));
+    }
+
+    ring_mb();
+}
+
+static inline void *ring_slot(ipc_ring_t *ring, uint32_t idx)
+{
+    return ring->slots + (idx & (ring->slot_num - 1)) * ring->slot_size;
+}
+
+size_t ipc_ring_shm_size(int slot_num, int desc_size)
+{
+    return sizeof(ipc_ring_shm_t) + slot_num * RING_ALIGN(desc_size);
+}
+
+int ipc_ring_init(ipc_ring_t *ring, void *shm, int slot_num, int desc_size, int flag)
+{
+    ipc_ring_shm_t *s = (ipc_ring_shm_t *)shm;
+
+    if (ring == NULL || shm == NULL || desc_size <= 0 || slot_num <= 0 || (slot_num & (slot_num - 1))) {
+        return -1;
+    }
+
+    if ((uintptr_t)shm & (IPC_RING_CACHE_LINE - 1)) {
+        return -1;
+    }
+
+    memset(s, 0x00, sizeof(ipc_ring_shm_t));
+    s->slot_num  = slot_num;
+    s->slot_size = RING_ALIGN(desc_size);
+    s->magic     = RING_MAGIC;
+
+    memset(ring, 0x00, sizeof(ipc_ring_t));
+    ring->flag = flag;
+    ring_sync_out(ring, s, sizeof(ipc_ring_shm_t));
+
+    return ipc_ring_attach(ring, shm, flag);
+}
+
+int ipc_ring_attach(ipc_ring_t *ring, void *shm, int flag)
+{
+    ipc_ring_shm_t *s = (ipc_ring_shm_t *)shm;
+
+    if (ring == NULL || shm == NULL) {
+        return -1;
+    }
+
+    memset(ring, 0x00, sizeof(ipc_ring_t));
+    ring->flag = flag;
+    ring_sync_in(ring, s, sizeof(ipc_ring_shm_t));
+
+    if (s->magic != RING_MAGIC) {
+        return -1;
+    }
+
+    ring->shm       = s;
+    ring->slots     = s->slots;
+    ring->slot_num  = s->slot_num;
+    ring->slot_size = s->slot_size;
+    ring->head      = s->head;
+    ring->tail      = s->tail;
+    ring->event     = s->idle;
+
+    return 0;
+}
+
+void *ipc_ring_reserve(ipc_ring_t *ring)
+{
+    ipc_ring_shm_t *s = ring->shm;
+
+    if (ring->head - ring->tail >= ring->slot_num) {
+        /* refresh the consumer index only when the cached one says full */
+        ring_sync_in(ring, &s->tail, sizeof(uint32_t));
+        ring->tail = s->tail;
+
+        if (ring->head - ring->tail >= ring->slot_num) {
+            return NULL;
+        }
+    }
+
+    return ring_slot(ring, ring->head);
+}
+
+void ipc_ring_push(ipc_ring_t *ring)
+{
+    if (ring->flag & IPC_RING_CACHE) {
+        ring_dcache_clean(ring_slot(ring, ring->head), ring->slot_size);
+    }
+
+    ring->head++;
+}
+
+int ipc_ring_publish(ipc_ring_t *ring)
+{
+    ipc_ring_shm_t *s = ring->shm;
+    uint32_t idle;
+
+    s->head = ring->head;
+    ring_sync_out(ring, &s->head, sizeof(uint32_t));
+
+    ring_sync_in(ring, &s->tail, sizeof(uint32_t) * 2);
+    idle = s->idle;
+
+    /* one doorbell per sleep of the consumer, whatever the batch size */
+    if ((idle & 1) && idle != ring->event) {
+        ring->event = idle;
+        return 1;
+    }
+
+    return 0;
+}
+
+void *ipc_ring_peek(ipc_ring_t *ring)
+{
+    ipc_ring_shm_t *s = ring->shm;
+
+    if (ring->event & 1) {
+        ring->event++;
+        s->idle = ring->event;
+        ring_sync_out(ring, &s->tail, sizeof(uint32_t) * 2);
+    }
+
+    if (ring->tail == ring->head) {
+        ring_sync_in(ring, &s->head, sizeof(uint32_t));
+        ring->head = s->head;
+
+        if (ring->tail == ring->head) {
+            return NULL;
+        }
+    }
+
+    if (ring->flag & IPC_RING_CACHE) {
+        ring_dcache_invalid(ring_slot(ring, ring->tail), ring->slot_size);
+    }
+
+    return ring_slot(ring, ring->tail);
+}
+
+void ipc_ring_pop(ipc_ring_t *ring)
+{
+    ipc_ring_shm_t *s = ring->shm;
+
+    ring->tail++;
+    s->tail = ring->tail;
+    ring_sync_out(ring, &s->tail, sizeof(uint32_t) * 2);
+}
+
+int ipc_ring_idle(ipc_ring_t *ring)
+{
+    ipc_ring_shm_t *s = ring->shm;
+
+    if (!(ring->event & 1)) {
+        ring->event++;
+        s->idle = ring->event;
+        ring_sync_out(ring, &s->tail, sizeof(uint32_t) * 2);
+    }
+
+    /* a publish racing with the store above must not be missed */
+    ring_sync_in(ring, &s->head, sizeof(uint32_t));
+    ring->head = s->head;
+
+    return ring->tail != ring->head;
+}
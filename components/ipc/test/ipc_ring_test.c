@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2019-2020 Alibaba Group Holding Limited
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <aos/kernel.h>
+#include <ipc_ring.h>
+
+/*
+ * two tasks stand for the two cores: the producer pushes descriptors in batches of any size,
+ * the consumer checks them in order and sleeps on a semaphore which stands for the mailbox
+ * doorbell. the producer waits for the ring to drain after some batches, so a doorbell lost by
+ * the publish/idle handshake is not saved by the next publish, and the test fails
+ */
+
+#define TEST_ASSERT(name, v)  do { \
+                            if (!(v)) { \
+                                printf("ASSERT[%s] %d\n", name, __LINE__); \
+                                return -1; \
+                            } \
+                        } while(0);
+
+#define TEST_DESC_CNT          (20000)
+#define TEST_SLOT_NUM          (64)
+#define TEST_BATCH_MAX         (7)
+#define TEST_TIMEOUT_MS        (10000)
+#define TEST_DRAIN_MS          (500)
+
+typedef struct {
+    uint32_t seq;
+    uint32_t sum;
+} test_desc_t;
+
+static struct {
+    ipc_ring_t prod;
+    ipc_ring_t cons;
+    aos_sem_t  doorbell;
+    aos_sem_t  done;
+    uint32_t   seed;
+    int        batches;
+    int        kicks;
+    int        wakes;
+    int        lost;
+    int        bad;
+    volatile int consumed;
+} g_test;
+
+static uint32_t _rand(void)
+{
+    g_test.seed = g_test.seed * 1103515245 + 12345;
+    return g_test.seed >> 8;
+}
+
+static void _producer(void *arg)
+{
+    int i = 0, n;
+    test_desc_t *desc;
+
+    while (i < TEST_DESC_CNT) {
+        for (n = 1 + _rand() % TEST_BATCH_MAX; n > 0 && i < TEST_DESC_CNT; n--) {
+            while ((desc = ipc_ring_reserve(&g_test.prod)) == NULL) {
+                aos_msleep(1);
+            }
+            desc->seq = i;
+            desc->sum = i * 2654435761u;
+            ipc_ring_push(&g_test.prod);
+            i++;
+        }
+
+        g_test.batches++;
+        if (ipc_ring_publish(&g_test.prod)) {
+            g_test.kicks++;
+            aos_sem_signal(&g_test.doorbell);
+        }
+
+        if (_rand() % 4 == 0) {
+            for (n = 0; g_test.consumed != i && n < TEST_DRAIN_MS; n++) {
+                aos_msleep(1);
+            }
+            g_test.lost += g_test.consumed != i;
+        }
+    }
+}
+
+static void _consumer(void *arg)
+{
+    int i = 0;
+    uint32_t seed = 7;
+    volatile int spin;
+    test_desc_t *desc;
+
+    while (i < TEST_DESC_CNT) {
+        desc = ipc_ring_peek(&g_test.cons);
+        if (desc) {
+            if (desc->seq != i || desc->sum != i * 2654435761u) {
+                g_test.bad++;
+            }
+            ipc_ring_pop(&g_test.cons);
+            g_test.consumed = ++i;
+            continue;
+        }
+
+        /* a slow core between finding the ring empty and going idle, the producer runs meanwhile */
+        seed = seed * 1103515245 + 12345;
+        for (spin = (seed >> 8) % 20000; spin > 0; spin--);
+
+        if (ipc_ring_idle(&g_test.cons) == 0) {
+            aos_sem_wait(&g_test.doorbell, AOS_WAIT_FOREVER);
+            g_test.wakes++;
+        }
+    }
+
+    aos_sem_signal(&g_test.done);
+}
+
+/**
+ * @brief  test the ipc ring between two tasks: order, content and doorbells
+ * @return 0/-1
+ */
+int ipc_ring_test(void)
+{
+    int rc;
+    void *shm;
+    aos_task_t task;
+    size_t size = ipc_ring_shm_size(TEST_SLOT_NUM, sizeof(test_desc_t));
+
+    memset(&g_test, 0, sizeof(g_test));
+    g_test.seed = 1;
+    shm = aos_malloc(size + IPC_RING_CACHE_LINE);
+    TEST_ASSERT("ring", shm);
+
+    rc = ipc_ring_init(&g_test.prod, (void *)(((uintptr_t)shm + IPC_RING_CACHE_LINE - 1) & ~(uintptr_t)(IPC_RING_CACHE_LINE - 1)),
+                       TEST_SLOT_NUM, sizeof(test_desc_t), 0);
+    rc |= ipc_ring_attach(&g_test.cons, g_test.prod.shm, 0);
+    rc |= aos_sem_new(&g_test.doorbell, 0);
+    rc |= aos_sem_new(&g_test.done, 0);
+    TEST_ASSERT("ring", rc == 0);
+
+    rc = aos_task_new_ext(&task, "ring_cons", _consumer, NULL, 2048, AOS_DEFAULT_APP_PRI);
+    rc |= aos_task_new_ext(&task, "ring_prod", _producer, NULL, 2048, AOS_DEFAULT_APP_PRI);
+    TEST_ASSERT("ring", rc == 0);
+
+    /* the tasks are left behind on a timeout, the test is over anyway */
+    rc = aos_sem_wait(&g_test.done, TEST_TIMEOUT_MS);
+    TEST_ASSERT("ring doorbell lost", rc == 0);
+    printf("ring: %d descs in %d batches, %d doorbells, %d wakeups\n",
+           TEST_DESC_CNT, g_test.batches, g_test.kicks, g_test.wakes);
+    TEST_ASSERT("ring", g_test.bad == 0);
+    TEST_ASSERT("ring doorbell lost", g_test.lost == 0);
+    TEST_ASSERT("ring", g_test.kicks <= g_test.batches);
+
+    aos_sem_free(&g_test.doorbell);
+    aos_sem_free(&g_test.done);
+    aos_free(shm);
+    printf("test over, all pass\n");
+
+    return 0;
+}
@@ -139,6 +139,15 @@ LV_ATTRIBUTE_FAST_MEM void _lv_blend_fill(const lv_area_t * clip_area, const lv_
     if(opa < LV_OPA_MIN) return;
     if(mask_res == LV_DRAW_MASK_RES_TRANSP) return;
 
+#if LV_COLOR_DEPTH == 1
+    /*At 1 bpp `lv_color_mix` either keeps the background or takes the new color,
+     *so decide it once here and let the cover-only paths run*/
+    if(mode == LV_BLEND_MODE_NORMAL) {
+        if(opa <= LV_OPA_50) return;
+        opa = LV_OPA_COVER;
+    }
+#endif
+
     lv_disp_t * disp = _lv_refr_get_disp_refreshing();
     lv_disp_buf_t * vdb = lv_disp_get_buf(disp);
     const lv_area_t * disp_area = &vdb->area;
@@ -161,15 +170,16 @@ LV_ATTRIBUTE_FAST_MEM void _lv_blend_fill(const lv_area_t * clip_area, const lv_
     draw_area.y2 -= disp_area->y1;
 
     /*Round the values in the mask if anti-aliasing is disabled*/
-#if LV_ANTIALIAS
+#if LV_ANTIALIAS && LV_COLOR_DEPTH != 1
     if(mask && disp->driver.antialiasing == 0)
 #else
     if(mask)
 #endif
     {
-        int32_t mask_w = lv_area_get_width(&draw_area);
-        int32_t i;
-        for(i = 0; i < mask_w; i++)  mask[i] = mask[i] > 128 ? LV_OPA_COVER : LV_OPA_TRANSP;
+        /*The mask has a line for every line of the draw area*/
+        uint32_t mask_size = lv_area_get_size(&draw_area);
+        uint32_t i;
+        for(i = 0; i < mask_size; i++)  mask[i] = mask[i] > 128 ? LV_OPA_COVER : LV_OPA_TRANSP;
     }
 
     if(disp->driver.set_px_cb) {
@@ -207,6 +217,15 @@ LV_ATTRIBUTE_FAST_MEM void _lv_blend_map(const lv_area_t * clip_area, const lv_a
     if(opa < LV_OPA_MIN) return;
     if(mask_res == LV_DRAW_MASK_RES_TRANSP) return;
 
+#if LV_COLOR_DEPTH == 1
+    /*At 1 bpp `lv_color_mix` either keeps the background or takes the new color,
+     *so decide it once here and let the cover-only paths run*/
+    if(mode == LV_BLEND_MODE_NORMAL) {
+        if(opa <= LV_OPA_50) return;
+        opa = LV_OPA_COVER;
+    }
+#endif
+
     /* Get clipped fill area which is the real draw area.
      * It is always the same or inside `fill_area` */
     lv_area_t draw_area;
@@ -229,15 +248,16 @@ LV_ATTRIBUTE_FAST_MEM void _lv_blend_map(const lv_area_t * clip_area, const lv_a
     draw_area.y2 -= disp_area->y1;
 
     /*Round the values in the mask if anti-aliasing is disabled*/
-#if LV_ANTIALIAS
+#if LV_ANTIALIAS && LV_COLOR_DEPTH != 1
     if(mask && disp->driver.antialiasing == 0)
 #else
     if(mask)
 #endif
     {
-        int32_t mask_w = lv_area_get_width(&draw_area);
-        int32_t i;
-        for(i = 0; i < mask_w; i++)  mask[i] = mask[i] > 128 ? LV_OPA_COVER : LV_OPA_TRANSP;
+        /*The mask has a line for every line of the draw area*/
+        uint32_t mask_size = lv_area_get_size(&draw_area);
+        uint32_t i;
+        for(i = 0; i < mask_size; i++)  mask[i] = mask[i] > 128 ? LV_OPA_COVER : LV_OPA_TRANSP;
     }
     if(disp->driver.set_px_cb) {
         map_set_px(disp_area, disp_buf, &draw_area, map_area, map_buf, opa, mask, mask_res);
@@ -524,6 +524,58 @@ LV_ATTRIBUTE_FAST_MEM static void draw_letter_normal(lv_coord_t pos_x, lv_coord_
     uint32_t col_bit;
     col_bit = bit_ofs & 0x7; /* "& 0x7" equals to "% 8" just faster */
 
+    uint32_t col_bit_max = 8 - bpp;
+    uint32_t col_bit_row_ofs = (box_w + col_start - col_end) * bpp;
+
+#if LV_COLOR_DEPTH == 1
+    /*At 1 bpp a letter pixel either takes the color or keeps the background
+     *(see `lv_color_mix`), so without other masks write the glyph straight
+     *to the display buffer instead of building a mask and blending it.
+     *The opacity is rounded as `_lv_blend_fill` rounds the masks.*/
+    if(lv_draw_mask_get_cnt() == 0 && blend_mode == LV_BLEND_MODE_NORMAL) {
+        lv_disp_t * disp = _lv_refr_get_disp_refreshing();
+        lv_disp_buf_t * vdb = lv_disp_get_buf(disp);
+        int32_t disp_w = lv_area_get_width(&vdb->area);
+        int32_t x_ofs = pos_x - vdb->area.x1;
+        int32_t y_ofs = pos_y - vdb->area.y1;
+        lv_color_t * disp_buf_row = vdb->buf_act + disp_w * (row_start + y_ofs) + x_ofs;
+
+        if(disp->driver.gpu_wait_cb) disp->driver.gpu_wait_cb(&disp->driver);
+
+        for(row = row_start ; row < row_end; row++) {
+            bitmask = bitmask_init >> col_bit;
+            for(col = col_start; col < col_end; col++) {
+                letter_px = (*map_p & bitmask) >> (col_bit_max - col_bit);
+                if(letter_px && bpp_opa_table_p[letter_px] > 128) {
+                    if(disp->driver.set_px_cb) {
+                        disp->driver.set_px_cb(&disp->driver, (void *)vdb->buf_act, disp_w, col + x_ofs, row + y_ofs,
+                                               color, LV_OPA_COVER);
+                    }
+                    else {
+                        disp_buf_row[col] = color;
+                    }
+                }
+
+                if(col_bit < col_bit_max) {
+                    col_bit += bpp;
+                    bitmask = bitmask >> bpp;
+                }
+                else {
+                    col_bit = 0;
+                    bitmask = bitmask_init;
+                    map_p++;
+                }
+            }
+
+            col_bit += col_bit_row_ofs;
+            map_p += (col_bit >> 3);
+            col_bit = col_bit & 0x7;
+            disp_buf_row += disp_w;
+        }
+        return;
+    }
+#endif
+
     lv_coord_t hor_res = lv_disp_get_hor_res(_lv_refr_get_disp_refreshing());
     uint32_t mask_buf_size = box_w * box_h > hor_res ? hor_res : box_w * box_h;
     lv_opa_t * mask_buf = _lv_mem_buf_get(mask_buf_size);
@@ -537,9 +589,6 @@ LV_ATTRIBUTE_FAST_MEM static void draw_letter_normal(lv_coord_t pos_x, lv_coord_
 
     uint8_t other_mask_cnt = lv_draw_mask_get_cnt();
 
-    uint32_t col_bit_max = 8 - bpp;
-    uint32_t col_bit_row_ofs = (box_w + col_start - col_end) * bpp;
-
     for(row = row_start ; row < row_end; row++) {
         int32_t mask_p_start = mask_p;
 
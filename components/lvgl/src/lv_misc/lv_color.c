@@ -8,6 +8,7 @@
  *********************/
 #include "lv_color.h"
 #include "lv_math.h"
+#include "lv_mem.h"
 
 /*********************
  *      DEFINES
@@ -79,6 +80,9 @@ LV_ATTRIBUTE_FAST_MEM void lv_color_fill(lv_color_t * buf, lv_color_t color, uin
         buf++;
         px_num --;
     }
+#elif LV_COLOR_DEPTH == 1 || LV_COLOR_DEPTH == 8
+    /*One byte per pixel*/
+    _lv_memset(buf, color.full, px_num);
 #else
     while(px_num > 16) {
         *buf = color;
@@ -24,6 +24,11 @@
  *  STATIC PROTOTYPES
  **********************/
 static void create_copy(void);
+#if LV_COLOR_DEPTH == 1
+static void mono_opa(void);
+static lv_draw_mask_res_t full_cover_mask_cb(lv_opa_t * mask_buf, lv_coord_t abs_x, lv_coord_t abs_y,
+                                             lv_coord_t len, void * p);
+#endif
 
 /**********************
  *  STATIC VARIABLES
@@ -46,6 +51,9 @@ void lv_test_label(void)
 
 #if LV_USE_LABEL
     create_copy();
+#if LV_COLOR_DEPTH == 1
+    mono_opa();
+#endif
 #else
     lv_test_print("Skip label test: LV_USE_LABEL == 0");
 #endif
@@ -67,4 +75,59 @@ static void create_copy(void)
     lv_test_assert_img_eq("lv_test_img32_label_1.png", "Create a label and leave the default settings");
 #endif
 }
+
+#if LV_COLOR_DEPTH == 1
+/*At 1 bpp letters are written directly when no other mask is active,
+ *they must be the same as the ones blended through a mask buffer*/
+static void mono_opa(void)
+{
+    extern lv_color_t test_fb[];
+    static lv_color_t ref_fb[LV_HOR_RES_MAX * LV_VER_RES_MAX];
+    lv_draw_mask_common_dsc_t mask_dsc;
+    uint32_t opa;
+    uint32_t diff = 0;
+
+    lv_test_print("");
+    lv_test_print("Draw a label at any opacity, direct and blended");
+    lv_test_print("---------------------------");
+
+    lv_obj_clean(lv_scr_act());
+    lv_obj_t * label = lv_label_create(lv_scr_act(), NULL);
+    lv_label_set_text(label, "Opa 0123\nWXYZ");
+
+    mask_dsc.cb = full_cover_mask_cb;
+    mask_dsc.type = LV_DRAW_MASK_TYPE_LINE;
+
+    for(opa = 0; opa <= LV_OPA_COVER; opa++) {
+        /*The flush callback copies the area to the start of the frame, so refresh it all*/
+        lv_obj_set_style_local_text_opa(label, LV_LABEL_PART_MAIN, LV_STATE_DEFAULT, opa);
+        lv_obj_invalidate(lv_scr_act());
+        lv_refr_now(NULL);
+        _lv_memcpy(ref_fb, test_fb, sizeof(ref_fb));
+
+        int16_t mask_id = lv_draw_mask_add(&mask_dsc, NULL);
+        lv_obj_invalidate(lv_scr_act());
+        lv_refr_now(NULL);
+        lv_draw_mask_remove_id(mask_id);
+
+        if(memcmp(ref_fb, test_fb, sizeof(ref_fb)) != 0) diff++;
+    }
+
+    lv_test_assert_int_eq(0, diff, "Direct and blended letters are the same at every opacity");
+
+    lv_obj_clean(lv_scr_act());
+}
+
+static lv_draw_mask_res_t full_cover_mask_cb(lv_opa_t * mask_buf, lv_coord_t abs_x, lv_coord_t abs_y,
+                                             lv_coord_t len, void * p)
+{
+    LV_UNUSED(mask_buf);
+    LV_UNUSED(abs_x);
+    LV_UNUSED(abs_y);
+    LV_UNUSED(len);
+    LV_UNUSED(p);
+
+    return LV_DRAW_MASK_RES_FULL_COVER;
+}
+#endif
 #endif
@@ -63,6 +63,9 @@
 #endif
 
 #include <string.h>
+#if LWIP_SOCKET_SELECT
+#include <sys/select.h>
+#endif
 
 #ifdef LWIP_HOOK_FILENAME
 #include LWIP_HOOK_FILENAME
@@ -489,6 +492,31 @@ get_socket(int fd)
   return sock;
 }
 
+/**
+ * get_socket() for a user outside of this file (e.g. sendfile). The socket is
+ * held until lwip_socket_put(), a close meanwhile frees it only then.
+ *
+ * @param fd externally used socket index
+ * @return struct lwip_sock for the socket or NULL (errno set) if not found
+ */
+struct lwip_sock *
+lwip_socket_get(int fd)
+{
+  return get_socket(fd);
+}
+
+/**
+ * Release a socket got by lwip_socket_get().
+ *
+ * @param sock the socket returned by lwip_socket_get()
+ */
+void
+lwip_socket_put(struct lwip_sock *sock)
+{
+  LWIP_UNUSED_ARG(sock);
+  done_socket(sock);
+}
+
 /**
  * Allocate a new socket for a given netconn.
  *
@@ -537,6 +565,274 @@ alloc_socket(struct netconn *newconn, int accepted)
   return -1;
 }
 
+#if LWIP_SOCKET_SELECT
+/**
+ * Readiness set: event_callback queues a registered socket on the ready list
+ * of its set, lwip_evset_wait only checks the queued sockets again instead of
+ * scanning all the fds. The list and the evset members of the sockets are
+ * protected by SYS_ARCH_PROTECT.
+ */
+struct evset {
+  struct lwip_sock *head;
+  struct lwip_sock *tail;
+  sys_sem_t *psem;
+  sys_sem_t sem;
+  /* sockets closed while registered, reported once as EVSET_HUP */
+  u32_t closed[(NUM_SOCKETS + 31) / 32];
+  u8_t closed_any;
+};
+
+/* called under SYS_ARCH_PROTECT */
+static u32_t
+lwip_evset_revents(struct lwip_sock *sock)
+{
+  u32_t revents = 0;
+
+  if ((sock->lastdata.pbuf != NULL) || (sock->rcvevent > 0)) {
+    revents |= EVSET_IN;
+  }
+  if (sock->sendevent != 0) {
+    revents |= EVSET_OUT;
+  }
+  if (sock->errevent != 0) {
+    revents |= EVSET_ERR;
+  }
+  return revents & (sock->evset_events | EVSET_ERR);
+}
+
+/* called under SYS_ARCH_PROTECT */
+static void
+lwip_evset_enqueue(struct evset *set, struct lwip_sock *sock)
+{
+  sock->evset_queued = 1;
+  sock->evset_next = NULL;
+  if (set->tail != NULL) {
+    set->tail->evset_next = sock;
+  } else {
+    set->head = sock;
+  }
+  set->tail = sock;
+}
+
+/* called under SYS_ARCH_PROTECT */
+static void
+lwip_evset_push(struct lwip_sock *sock)
+{
+  struct evset *set = sock->evset;
+
+  if ((set == NULL) || sock->evset_queued || (lwip_evset_revents(sock) == 0)) {
+    return;
+  }
+  lwip_evset_enqueue(set, sock);
+  sys_sem_signal(set->psem);
+}
+
+/* called under SYS_ARCH_PROTECT */
+static void
+lwip_evset_unlink(struct lwip_sock *sock)
+{
+  struct evset *set = sock->evset;
+  struct lwip_sock *prev = NULL, *it;
+
+  if (set == NULL) {
+    return;
+  }
+  if (sock->evset_queued) {
+    for (it = set->head; (it != NULL) && (it != sock); it = it->evset_next) {
+      prev = it;
+    }
+    if (it == sock) {
+      if (prev != NULL) {
+        prev->evset_next = sock->evset_next;
+      } else {
+        set->head = sock->evset_next;
+      }
+      if (set->tail == sock) {
+        set->tail = prev;
+      }
+    }
+  }
+  sock->evset = NULL;
+  sock->evset_next = NULL;
+  sock->evset_events = 0;
+  sock->evset_queued = 0;
+}
+
+/* called under SYS_ARCH_PROTECT, the socket is being closed */
+static void
+lwip_evset_close(struct lwip_sock *sock)
+{
+  struct evset *set = sock->evset;
+  int i = (int)(sock - sockets);
+
+  if (set == NULL) {
+    return;
+  }
+  lwip_evset_unlink(sock);
+  set->closed[i / 32] |= 1UL << (i % 32);
+  set->closed_any = 1;
+  sys_sem_signal(set->psem);
+}
+
+evset_t *
+lwip_evset_new(void *semaphore)
+{
+  struct evset *set = (struct evset *)mem_calloc(1, sizeof(struct evset));
+
+  if (set == NULL) {
+    set_errno(ENOMEM);
+    return NULL;
+  }
+  if (semaphore != NULL) {
+    set->psem = (sys_sem_t *)semaphore;
+  } else {
+    if (sys_sem_new(&set->sem, 0) != ERR_OK) {
+      mem_free(set);
+      set_errno(ENOMEM);
+      return NULL;
+    }
+    set->psem = &set->sem;
+  }
+  return set;
+}
+
+void
+lwip_evset_free(evset_t *set)
+{
+  int i;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  if (set == NULL) {
+    return;
+  }
+  SYS_ARCH_PROTECT(lev);
+  for (i = 0; i < NUM_SOCKETS; i++) {
+    if (sockets[i].evset == set) {
+      lwip_evset_unlink(&sockets[i]);
+    }
+  }
+  SYS_ARCH_UNPROTECT(lev);
+  if (set->psem == &set->sem) {
+    sys_sem_free(&set->sem);
+  }
+  mem_free(set);
+}
+
+int
+lwip_evset_ctl(evset_t *set, int op, int fd, u32_t events)
+{
+  struct lwip_sock *sock;
+  int err = 0;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  if (set == NULL) {
+    set_errno(EINVAL);
+    return -1;
+  }
+  SYS_ARCH_PROTECT(lev);
+  sock = tryget_socket_unconn_nouse(fd);
+  if ((sock == NULL) || (sock->conn == NULL)) {
+    err = EBADF;
+  } else if (op == EVSET_CTL_ADD) {
+    if (sock->evset != NULL) {
+      err = EEXIST;
+    } else {
+      sock->evset = set;
+      sock->evset_events = (u8_t)events;
+      lwip_evset_push(sock);
+    }
+  } else if ((op == EVSET_CTL_MOD) || (op == EVSET_CTL_DEL)) {
+    if (sock->evset != set) {
+      err = ENOENT;
+    } else if (op == EVSET_CTL_MOD) {
+      sock->evset_events = (u8_t)events;
+      lwip_evset_push(sock);
+    } else {
+      lwip_evset_unlink(sock);
+    }
+  } else {
+    err = EINVAL;
+  }
+  SYS_ARCH_UNPROTECT(lev);
+
+  if (err != 0) {
+    set_errno(err);
+    return -1;
+  }
+  return 0;
+}
+
+/* pop the ready list, the sockets still ready are queued again at the tail */
+static int
+lwip_evset_collect(struct evset *set, evset_event_t *evs, int maxevents)
+{
+  struct lwip_sock *sock, *keep = NULL, *keep_tail = NULL;
+  u32_t revents;
+  int i, n = 0;
+  SYS_ARCH_DECL_PROTECT(lev);
+
+  SYS_ARCH_PROTECT(lev);
+  if (set->closed_any) {
+    for (i = 0; (i < NUM_SOCKETS) && (n < maxevents); i++) {
+      if (set->closed[i / 32] & (1UL << (i % 32))) {
+        set->closed[i / 32] &= ~(1UL << (i % 32));
+        evs[n].fd = i + LWIP_SOCKET_OFFSET;
+        evs[n].events = EVSET_HUP;
+        n++;
+      }
+    }
+    set->closed_any = (i < NUM_SOCKETS);
+  }
+  while ((n < maxevents) && ((sock = set->head) != NULL)) {
+    set->head = sock->evset_next;
+    if (set->head == NULL) {
+      set->tail = NULL;
+    }
+    sock->evset_queued = 0;
+    sock->evset_next = NULL;
+
+    revents = lwip_evset_revents(sock);
+    if (revents != 0) {
+      evs[n].fd = (int)(sock - sockets) + LWIP_SOCKET_OFFSET;
+      evs[n].events = revents;
+      n++;
+      if (keep_tail != NULL) {
+        keep_tail->evset_next = sock;
+      } else {
+        keep = sock;
+      }
+      keep_tail = sock;
+    }
+  }
+  while ((sock = keep) != NULL) {
+    keep = sock->evset_next;
+    lwip_evset_enqueue(set, sock);
+  }
+  SYS_ARCH_UNPROTECT(lev);
+
+  return n;
+}
+
+int
+lwip_evset_wait(evset_t *set, evset_event_t *evs, int maxevents, int timeout_ms)
+{
+  int n;
+
+  if ((set == NULL) || (evs == NULL) || (maxevents <= 0)) {
+    set_errno(EINVAL);
+    return -1;
+  }
+  n = lwip_evset_collect(set, evs, maxevents);
+  if ((n > 0) || (timeout_ms == 0)) {
+    return n;
+  }
+  /* 0 means wait forever */
+  sys_arch_sem_wait(set->psem, (timeout_ms < 0) ? 0 : (u32_t)timeout_ms);
+
+  return lwip_evset_collect(set, evs, maxevents);
+}
+#endif /* LWIP_SOCKET_SELECT */
+
 /** Free a socket (under lock)
  *
  * @param sock the socket to free
@@ -559,6 +855,9 @@ free_socket_locked(struct lwip_sock *sock, int is_tcp, struct netconn **conn,
   LWIP_UNUSED_ARG(is_tcp);
 #endif /* LWIP_NETCONN_FULLDUPLEX */
 
+#if LWIP_SOCKET_SELECT
+  lwip_evset_close(sock);
+#endif /* LWIP_SOCKET_SELECT */
   *lastdata = sock->lastdata;
   sock->lastdata.pbuf = NULL;
   *conn = sock->conn;
@@ -2565,6 +2864,10 @@ event_callback(struct netconn *conn, enum netconn_evt evt, u16_t len)
       break;
   }
 
+#if LWIP_SOCKET_SELECT
+  lwip_evset_push(sock);
+#endif /* LWIP_SOCKET_SELECT */
+
   if (sock->select_waiting && check_waiters) {
     /* Save which events are active */
     int has_recvevent, has_sendevent, has_errevent;
@@ -56,6 +56,11 @@
 
 #include <string.h>
 
+#if LWIPERF_SENDFILE
+#include "lwip/sockets.h"
+#include "lwip/apps/sendfile.h"
+#endif
+
 /* Currently, only TCP is implemented */
 #if LWIP_TCP && LWIP_CALLBACK_API
 
@@ -838,4 +843,79 @@ lwiperf_abort(void *lwiperf_session)
   }
 }
 
+
+#if LWIPERF_SENDFILE && LWIP_SOCKET && LWIP_IPV4
+/**
+ * @ingroup iperf
+ * Benchmark sendfile(): send count bytes of in_fd to an iperf server as a
+ * unidirectional client test. This blocks until the transfer is done, so it
+ * must be called from an application task, not from the tcpip thread.
+ *
+ * @returns 0 on success, -1 if the connection or the transfer failed
+ */
+int
+lwiperf_sendfile_client(const ip_addr_t* remote_addr, u16_t remote_port,
+  int in_fd, size_t count, lwiperf_report_fn report_fn, void* report_arg)
+{
+  lwiperf_settings_t settings;
+  struct sockaddr_in remote, local;
+  socklen_t local_len = sizeof(local);
+  ip_addr_t local_ip;
+  u32_t time_started, duration_ms, bandwidth_kbitpsec;
+  ssize_t sent;
+  int s;
+
+  LWIP_ASSERT("remote_addr != NULL", remote_addr != NULL);
+  if (!IP_IS_V4(remote_addr)) {
+    return -1;
+  }
+
+  s = lwip_socket(AF_INET, SOCK_STREAM, 0);
+  if (s < 0) {
+    return -1;
+  }
+
+  memset(&remote, 0, sizeof(remote));
+  remote.sin_family = AF_INET;
+  remote.sin_port = lwip_htons(remote_port);
+  inet_addr_from_ip4addr(&remote.sin_addr, ip_2_ip4(remote_addr));
+  if (lwip_connect(s, (struct sockaddr *)&remote, sizeof(remote)) < 0) {
+    lwip_close(s);
+    return -1;
+  }
+
+  memset(&settings, 0, sizeof(settings));
+  settings.num_threads = lwip_htonl(1);
+  settings.remote_port = lwip_htonl(LWIPERF_TCP_PORT_DEFAULT);
+  settings.amount = lwip_htonl((u32_t)count);
+
+  time_started = sys_now();
+  sent = -1;
+  if (lwip_send(s, &settings, sizeof(settings), 0) == sizeof(settings)) {
+    sent = sendfile(s, in_fd, NULL, count);
+  }
+  duration_ms = sys_now() - time_started;
+
+  memset(&local, 0, sizeof(local));
+  lwip_getsockname(s, (struct sockaddr *)&local, &local_len);
+  ip_addr_set_zero_ip4(&local_ip);
+  inet_addr_to_ip4addr(ip_2_ip4(&local_ip), &local.sin_addr);
+  lwip_close(s);
+
+  if (report_fn != NULL) {
+    u32_t bytes_transferred = (sent > 0) ? (u32_t)sent + sizeof(settings) : 0;
+    if (duration_ms == 0) {
+      bandwidth_kbitpsec = 0;
+    } else {
+      bandwidth_kbitpsec = (bytes_transferred / duration_ms) * 8U;
+    }
+    report_fn(report_arg, ((size_t)sent == count) ? LWIPERF_TCP_DONE_CLIENT : LWIPERF_TCP_ABORTED_LOCAL_TXERROR,
+              &local_ip, lwip_ntohs(local.sin_port), remote_addr, remote_port,
+              bytes_transferred, duration_ms, bandwidth_kbitpsec);
+  }
+
+  return ((size_t)sent == count) ? 0 : -1;
+}
+#endif /* LWIPERF_SENDFILE && LWIP_SOCKET && LWIP_IPV4 */
+
 #endif /* LWIP_TCP && LWIP_CALLBACK_API */
@@ -5,58 +5,424 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <network/network.h>
+#include <strings.h>
+#include <lwip/sockets.h>
+#include <aos/kernel.h>
+#include <vfs.h>
+#include <lwip/api.h>
+#include <lwip/tcp.h>
+#include <lwip/tcpip.h>
+#include <lwip/priv/tcp_priv.h>
+#include <lwip/priv/sockets_priv.h>
 #include <lwip/apps/sendfile.h>
 
-#define DATALEN 1024
 #define MAXSIZE 32
 #define PATHMAX 64
 static int sendfile_server_task_started = 0;
 
-ssize_t sendfile(int out_fd, int in_fd, off_t* offset, size_t count)
+/*
+ * Without the core lock the buffers can not be tracked until acked, the
+ * copy path then lets the stack copy them.
+ */
+#if LWIP_TCPIP_CORE_LOCKING && LWIP_CALLBACK_API
+#define SENDFILE_TRACK_ACK 1
+#define SENDFILE_BUF_FLAG NETCONN_NOCOPY
+#else
+#define SENDFILE_TRACK_ACK 0
+#define SENDFILE_BUF_FLAG NETCONN_COPY
+#endif
+
+/* a close from another task removes the hooks, the wait wakes up this often to notice it */
+#define SENDFILE_WAIT_SLICE 1000
+
+typedef struct {
+    uint8_t *buf;
+    u32_t    seq;       /* snd_lbb after the buffer was queued */
+    int      busy;      /* still referenced by the tcp queue */
+} sendfile_buf_t;
+
+static struct lwip_sock *sendfile_get_sock(int out_fd)
 {
-    char data[DATALEN];
-    int writelen;
-    int readlen;
-    int curlen = 0;
+    struct lwip_sock *sock = lwip_socket_get(out_fd);
 
-    while(1) {
-        memset(data, 0, sizeof(data));
-        readlen = read(in_fd, data, sizeof(data));
+    if (sock == NULL) {
+        return NULL;
+    }
 
-        if(0 == readlen) {
-            LWIP_DEBUGF( SENDFILE_DEBUG, ("%s:%d read finished", __func__, __LINE__));
-            break;
+    if (NETCONNTYPE_GROUP(netconn_type(sock->conn)) != NETCONN_TCP) {
+        lwip_socket_put(sock);
+        errno = EBADF;
+        return NULL;
+    }
+
+    return sock;
+}
+
+#if SENDFILE_TRACK_ACK
+/*
+ * While buffers are in flight the sent/poll/err callbacks of the pcb are
+ * chained in front of the ones of the netconn, they signal the waiter so the
+ * task sleeps with the core lock released until the peer acks. The list is
+ * guarded by the core lock, the callbacks run with it held.
+ */
+typedef struct sendfile_waiter {
+    struct sendfile_waiter *next;
+    struct netconn *conn;       /* callback_arg of the pcb */
+    struct tcp_pcb *pcb;        /* NULL once the stack freed it */
+    tcp_sent_fn     sent;
+    tcp_poll_fn     poll;
+    tcp_err_fn      errf;
+    sys_sem_t       sem;
+} sendfile_waiter_t;
+
+static sendfile_waiter_t *sendfile_waiters;
+
+static sendfile_waiter_t *sendfile_waiter_find(void *arg)
+{
+    sendfile_waiter_t *w;
+
+    for (w = sendfile_waiters; w != NULL && w->conn != arg; w = w->next);
+
+    return w;
+}
+
+static err_t sendfile_sent_cb(void *arg, struct tcp_pcb *pcb, u16_t len)
+{
+    sendfile_waiter_t *w = sendfile_waiter_find(arg);
+    err_t err = ERR_OK;
+
+    if (w != NULL) {
+        if (w->sent != NULL) {
+            err = w->sent(arg, pcb, len);
         }
+        sys_sem_signal(&w->sem);
+    }
+
+    return err;
+}
+
+static err_t sendfile_poll_cb(void *arg, struct tcp_pcb *pcb)
+{
+    sendfile_waiter_t *w = sendfile_waiter_find(arg);
+    err_t err = ERR_OK;
+
+    if (w != NULL) {
+        if (w->poll != NULL) {
+            err = w->poll(arg, pcb);
+        }
+        sys_sem_signal(&w->sem);
+    }
+
+    return err;
+}
+
+/* the pcb and its queue are freed already */
+static void sendfile_err_cb(void *arg, err_t err)
+{
+    sendfile_waiter_t *w = sendfile_waiter_find(arg);
+
+    if (w != NULL) {
+        w->pcb = NULL;
+        if (w->errf != NULL) {
+            w->errf(arg, err);
+        }
+        sys_sem_signal(&w->sem);
+    }
+}
+
+static int sendfile_waiter_add(struct netconn *conn, sendfile_waiter_t *w)
+{
+    struct tcp_pcb *pcb;
+
+    memset(w, 0, sizeof(sendfile_waiter_t));
+    if (sys_sem_new(&w->sem, 0) != ERR_OK) {
+        errno = ENOMEM;
+        return -1;
+    }
+
+    LOCK_TCPIP_CORE();
+    pcb = conn->pcb.tcp;
+    if (pcb == NULL) {
+        UNLOCK_TCPIP_CORE();
+        sys_sem_free(&w->sem);
+        errno = ENOTCONN;
+        return -1;
+    }
+    w->conn = conn;
+    w->pcb  = pcb;
+    w->sent = pcb->sent;
+    w->poll = pcb->poll;
+    w->errf = pcb->errf;
+    w->next = sendfile_waiters;
+    sendfile_waiters = w;
+    tcp_sent(pcb, sendfile_sent_cb);
+    tcp_poll(pcb, sendfile_poll_cb, pcb->pollinterval);
+    tcp_err(pcb, sendfile_err_cb);
+    UNLOCK_TCPIP_CORE();
+
+    return 0;
+}
 
-        if(((readlen < 0) && ((EAGAIN != errno) && (EINTR != errno) && (EINPROGRESS != errno)))) {
-            LWIP_DEBUGF( SENDFILE_DEBUG, ("%s:%d readlen %d errno: %d out_fd %d in_fd %d", __func__, __LINE__, readlen, errno, out_fd, in_fd));
-            return -1;
+static void sendfile_waiter_del(sendfile_waiter_t *w)
+{
+    sendfile_waiter_t **pw;
+    struct tcp_pcb *pcb;
+
+    LOCK_TCPIP_CORE();
+    for (pw = &sendfile_waiters; *pw != w; pw = &(*pw)->next);
+    *pw = w->next;
+
+    /* a pcb the netconn dropped may be freed, its hooks are gone with the close anyway */
+    pcb = w->pcb;
+    if (pcb != NULL && pcb == w->conn->pcb.tcp) {
+        if (pcb->sent == sendfile_sent_cb) {
+            tcp_sent(pcb, w->sent);
+        }
+        if (pcb->poll == sendfile_poll_cb) {
+            tcp_poll(pcb, w->poll, pcb->pollinterval);
+        }
+        if (pcb->errf == sendfile_err_cb) {
+            tcp_err(pcb, w->errf);
         }
+    }
+    UNLOCK_TCPIP_CORE();
+
+    sys_sem_free(&w->sem);
+}
+
+static u32_t sendfile_queued_seq(sendfile_waiter_t *w)
+{
+    u32_t seq = 0;
+
+    LOCK_TCPIP_CORE();
+    if (w->pcb != NULL) {
+        seq = w->pcb->snd_lbb;
+    }
+    UNLOCK_TCPIP_CORE();
 
-        if((NULL != offset) && (curlen < *offset) && (curlen + readlen > *offset)) {
-            curlen += readlen;
+    return seq;
+}
 
-            writelen = write(out_fd, data + *offset - curlen, curlen - *offset);
-            if (((writelen < 0)&&(EAGAIN != errno) && (EINTR != errno) && (EINPROGRESS != errno))
-                   || (writelen != readlen)) {
-                LWIP_DEBUGF( SENDFILE_DEBUG, ("sendfile failed out_fd %d in_fd %d", out_fd, in_fd));
+/*
+ * sleep until the peer acked the buffer. A peer which never acks is given up
+ * by the stack (retransmission and persist limits), that frees the queue with
+ * the pcb and fails the wait with the error of the connection.
+ */
+static int sendfile_buf_release(sendfile_waiter_t *w, sendfile_buf_t *b)
+{
+    int acked, gone;
+
+    while (b->busy) {
+        LOCK_TCPIP_CORE();
+        gone  = (w->pcb == NULL) || (w->pcb != w->conn->pcb.tcp);
+        acked = !gone && TCP_SEQ_GEQ(w->pcb->lastack, b->seq);
+        UNLOCK_TCPIP_CORE();
+
+        if (acked || gone) {
+            b->busy = 0;
+            if (gone) {
+                errno = w->conn->pending_err != ERR_OK ? err_to_errno(w->conn->pending_err) : ENOTCONN;
                 return -1;
             }
+        } else {
+            sys_arch_sem_wait(&w->sem, SENDFILE_WAIT_SLICE);
         }
-        else if((NULL == offset) || (curlen + readlen > *offset)) {
-            curlen += readlen;
-            writelen = write(out_fd, data, readlen);
-            if (((writelen < 0)&&(EAGAIN != errno) && (EINTR != errno) && (EINPROGRESS != errno))
-                   || (writelen != readlen)) {
-                LWIP_DEBUGF( SENDFILE_DEBUG, ("sendfile write failed out_fd %d errno", out_fd, errno));
-                return -1;
+    }
+
+    return 0;
+}
+#else
+/* the stack copied the buffers, they are free at once */
+typedef int sendfile_waiter_t;
+
+static int sendfile_waiter_add(struct netconn *conn, sendfile_waiter_t *w)
+{
+    LWIP_UNUSED_ARG(conn);
+    LWIP_UNUSED_ARG(w);
+    return 0;
+}
+
+static void sendfile_waiter_del(sendfile_waiter_t *w)
+{
+    LWIP_UNUSED_ARG(w);
+}
+
+static u32_t sendfile_queued_seq(sendfile_waiter_t *w)
+{
+    LWIP_UNUSED_ARG(w);
+    return 0;
+}
+
+static int sendfile_buf_release(sendfile_waiter_t *w, sendfile_buf_t *b)
+{
+    LWIP_UNUSED_ARG(w);
+    LWIP_UNUSED_ARG(b);
+    return 0;
+}
+#endif /* SENDFILE_TRACK_ACK */
+
+static ssize_t sendfile_write(struct netconn *conn, const void *data, size_t len, u8_t flag)
+{
+    size_t written = 0;
+    err_t err;
+
+    err = netconn_write_partly(conn, data, len, flag, &written);
+    if (err != ERR_OK && written == 0) {
+        errno = err_to_errno(err);
+        return -1;
+    }
+
+    return written;
+}
+
+/* the file stays mapped while the data is queued, nothing has to be waited for */
+static ssize_t sendfile_mapped(struct netconn *conn, struct sendfile_map *map, off_t pos, size_t count)
+{
+    if (pos >= map->size) {
+        return 0;
+    }
+
+    if (count > map->size - pos) {
+        count = map->size - pos;
+    }
+
+    return sendfile_write(conn, (const uint8_t *)map->addr + pos, count, NETCONN_NOCOPY);
+}
+
+/*
+ * one buffer is read while the other one is in flight, so the file read
+ * overlaps the transmission and the send buffer is kept full
+ */
+static ssize_t sendfile_buffered(struct netconn *conn, int in_fd, size_t count)
+{
+    sendfile_buf_t b[2];
+    sendfile_waiter_t w;
+    ssize_t readlen, writelen;
+    size_t total = 0;
+    int idx = 0;
+    int ret = 0;
+
+    memset(b, 0, sizeof(b));
+    b[0].buf = aos_malloc(SENDFILE_BUF_SIZE * 2);
+    if (b[0].buf == NULL) {
+        errno = ENOMEM;
+        return -1;
+    }
+    b[1].buf = b[0].buf + SENDFILE_BUF_SIZE;
+
+    if (sendfile_waiter_add(conn, &w) < 0) {
+        aos_free(b[0].buf);
+        return -1;
+    }
+
+    while (total < count) {
+        if (sendfile_buf_release(&w, &b[idx]) < 0) {
+            ret = -1;
+            break;
+        }
+
+        readlen = aos_read(in_fd, b[idx].buf, LWIP_MIN(count - total, SENDFILE_BUF_SIZE));
+        if (readlen <= 0) {
+            if (readlen < 0) {
+                LWIP_DEBUGF(SENDFILE_DEBUG, ("sendfile: read %d failed %d\n", in_fd, readlen));
+                ret = -1;
             }
+            break;
         }
-        memset(data, 0, sizeof(data));
-        aos_msleep(100);
+
+        writelen = sendfile_write(conn, b[idx].buf, readlen, SENDFILE_BUF_FLAG);
+        if (writelen < 0) {
+            ret = -1;
+            break;
+        }
+
+        if (SENDFILE_BUF_FLAG == NETCONN_NOCOPY) {
+            b[idx].seq  = sendfile_queued_seq(&w);
+            b[idx].busy = 1;
+        }
+
+        total += writelen;
+        if (writelen < readlen) {
+            /* nonblocking socket, the unsent tail is read again next time */
+            aos_lseek(in_fd, writelen - readlen, SEEK_CUR);
+            break;
+        }
+        idx ^= 1;
     }
-    return curlen;
+
+    /* what is queued is sent, a connection lost meanwhile shows on the next call */
+    sendfile_buf_release(&w, &b[0]);
+    sendfile_buf_release(&w, &b[1]);
+    sendfile_waiter_del(&w);
+    aos_free(b[0].buf);
+
+    return (ret < 0 && total == 0) ? -1 : (ssize_t)total;
+}
+
+ssize_t sendfile(int out_fd, int in_fd, off_t *offset, size_t count)
+{
+    struct lwip_sock *sock;
+    struct sendfile_map map;
+    off_t saved = 0;
+    off_t pos;
+    ssize_t ret;
+
+    sock = sendfile_get_sock(out_fd);
+    if (sock == NULL) {
+        return -1;
+    }
+
+    pos = aos_lseek(in_fd, 0, SEEK_CUR);
+    if (pos < 0) {
+        lwip_socket_put(sock);
+        errno = EBADF;
+        return -1;
+    }
+
+    if (offset != NULL) {
+        saved = pos;
+        pos = *offset;
+    }
+
+    memset(&map, 0, sizeof(map));
+    if (aos_ioctl(in_fd, SENDFILE_IOCTL_MAP, (unsigned long)&map) == 0 && map.addr != NULL) {
+        ret = sendfile_mapped(sock->conn, &map, pos, count);
+        if (ret > 0) {
+            pos += ret;
+        }
+    } else {
+        if (offset != NULL) {
+            aos_lseek(in_fd, pos, SEEK_SET);
+        }
+
+        ret = sendfile_buffered(sock->conn, in_fd, count);
+        pos = aos_lseek(in_fd, 0, SEEK_CUR);
+    }
+    lwip_socket_put(sock);
+
+    if (offset != NULL) {
+        *offset = pos;
+        aos_lseek(in_fd, saved, SEEK_SET);
+    } else {
+        aos_lseek(in_fd, pos, SEEK_SET);
+    }
+
+    return ret;
+}
+
+ssize_t sendfile_rom(int out_fd, const void *data, size_t size)
+{
+    struct lwip_sock *sock = sendfile_get_sock(out_fd);
+    ssize_t ret;
+
+    if (sock == NULL) {
+        return -1;
+    }
+
+    ret = sendfile_write(sock->conn, data, size, NETCONN_NOCOPY);
+    lwip_socket_put(sock);
+
+    return ret;
 }
 
 int sendfile_client(int argc,char *argv[])
@@ -138,28 +504,38 @@ int sendfile_client(int argc,char *argv[])
 
     mode = atoi(mode_buf);
     size = atoi(size_buf);
-    
-    fd = open(file_name, O_WRONLY|O_CREAT, mode);
-    if(fd <= 0) {
-        LWIP_DEBUGF( SENDFILE_DEBUG, ("open file %s failed: %s", file_name, strerror(errno)));
+    (void)mode;
+
+    fd = aos_open(file_name, O_WRONLY | O_CREAT);
+    if(fd < 0) {
+        LWIP_DEBUGF( SENDFILE_DEBUG, ("open file %s failed: %d", file_name, fd));
         close(sockfd);
-        close(fd);
+        ret = -1;
         goto exit;
     }
 
-    while(1) {
-        ret = sendfile(fd, sockfd, 0, size);
+    /* the file is received into buf, sendfile only goes from a file to a socket */
+    while(size > 0) {
+        ret = recv(sockfd, buf, sizeof(buf), 0);
         if((ret < 0) && ((EAGAIN != errno) && (EINTR != errno) && (EINPROGRESS != errno))) {
-            LWIP_DEBUGF( SENDFILE_DEBUG, ("sendfile ret %d, %s", ret, strerror(errno)));
+            LWIP_DEBUGF( SENDFILE_DEBUG, ("recv ret %d, %s", ret, strerror(errno)));
             break;
         }
         if(ret == 0) {
             LWIP_DEBUGF( SENDFILE_DEBUG, ("sendfile finished"));
             break;
         }
+        if((ret > 0) && (aos_write(fd, buf, ret) != ret)) {
+            LWIP_DEBUGF( SENDFILE_DEBUG, ("write %s failed", file_name));
+            ret = -1;
+            break;
+        }
+        if(ret > 0) {
+            size -= ret;
+        }
     }
 
-    close(fd);
+    aos_close(fd);
     close(sockfd);
 exit:
     return ret;
@@ -197,7 +573,7 @@ void sendfile_server_thread(void *args)
 {
     int sockfd;                	/* socket desciptor */
     int connfd;                	/* file descriptor for socket */
-    int addrlen;				/* argument to accept */
+    socklen_t addrlen;			/* argument to accept */
     int ret;                    /* holds return code of system calls */
     int fd;                    	/* file descriptor for file to send */
     int port = 0;               /* port number to use */
@@ -205,7 +581,7 @@ void sendfile_server_thread(void *args)
     char filename[PATHMAX]={0}; /* filename to send */
     char buf[MAXSIZE];
     off_t offset = 0;          	/* file offset */
-    struct stat stat_buf;      	/* argument to fstat */
+    struct stat stat_buf;      	/* argument to aos_stat */
 	
     struct sockaddr_in addrserver;   	/* socket parameters for bind ipv4*/
     struct sockaddr_in addrclient;  	/* socket parameters for accept ipv4*/
@@ -271,41 +647,33 @@ void sendfile_server_thread(void *args)
         LWIP_DEBUGF( SENDFILE_DEBUG, ("received request to send file %s", filename));
 
         /* open the file to be sent */
-        fd = open(filename, O_RDONLY);
+        fd = aos_open(filename, O_RDONLY);
         if (fd < 0) {
 	    close(connfd);
-            close(fd);
-            LWIP_DEBUGF( SENDFILE_DEBUG, ("unable to open '%s': %s", filename, strerror(errno)));
+            LWIP_DEBUGF( SENDFILE_DEBUG, ("unable to open '%s': %d", filename, fd));
             goto exit;
         }
 
         /* get the size of the file to be sent */
-        fstat(fd, &stat_buf);
+        aos_stat(filename, &stat_buf);
         memset(buf, 0, sizeof(buf));
-        snprintf(buf, sizeof(buf), "mode=%d size=%d\n", stat_buf.st_mode, stat_buf.st_size);
+        snprintf(buf, sizeof(buf), "mode=%d size=%d\n", (int)stat_buf.st_mode, (int)stat_buf.st_size);
         write(connfd, buf, strlen(buf));
 
         /* copy file using sendfile */
         offset = 0;
         ret = sendfile(connfd, fd, &offset, stat_buf.st_size);
+        aos_close(fd);
+        close(connfd);
+
         if (ret < 0) {
             LWIP_DEBUGF( SENDFILE_DEBUG, ("error from sendfile: %s", strerror(errno)));
-	    close(connfd);
-            close(fd);
-            goto exit;
-        }
-
-        if(ret == 0) {
-            close(connfd);
-            close(fd);
             goto exit;
         }
 
         if (ret != stat_buf.st_size) {
             LWIP_DEBUGF( SENDFILE_DEBUG, ("incomplete transfer from sendfile: %d of %d bytes",
 		  ret, (int)stat_buf.st_size));
-	    close(connfd);
-            close(fd);
             goto exit;
         }
     }//for(;;)
@@ -46,6 +46,11 @@ extern "C" {
 
 #define LWIPERF_TCP_PORT_DEFAULT  5001
 
+/** Set to 1 to build lwiperf_sendfile_client(), which needs the sendfile app and vfs */
+#ifndef LWIPERF_SENDFILE
+#define LWIPERF_SENDFILE          0
+#endif
+
 /** lwIPerf test results */
 enum lwiperf_report_type
 {
@@ -92,6 +97,12 @@ void* lwiperf_start_tcp_client_default(const ip_addr_t* remote_addr,
 
 void  lwiperf_abort(void* lwiperf_session);
 
+#if LWIPERF_SENDFILE
+int   lwiperf_sendfile_client(const ip_addr_t* remote_addr, u16_t remote_port,
+                              int in_fd, size_t count,
+                              lwiperf_report_fn report_fn, void* report_arg);
+#endif
+
 
 #ifdef __cplusplus
 }
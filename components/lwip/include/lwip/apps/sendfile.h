@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2017-2019 Alibaba Group Holding Limited
+ */
+
+#ifndef LWIP_HDR_APPS_SENDFILE_H
+#define LWIP_HDR_APPS_SENDFILE_H
+
+#include <sys/types.h>
+#include "lwip/opt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef SENDFILE_DEBUG
+#define SENDFILE_DEBUG              LWIP_DBG_OFF
+#endif
+
+/** Size of each of the two read buffers used when the file can not be mapped */
+#ifndef SENDFILE_BUF_SIZE
+#define SENDFILE_BUF_SIZE           LWIP_MIN(LWIP_MAX(TCP_SND_BUF / 2, TCP_MSS), 4096)
+#endif
+
+/**
+ * aos_ioctl() command asking a file for a stable view of its content, arg is a
+ * struct sendfile_map *. A driver answers it only when the data is addressable
+ * (e.g. an XIP-mapped flash partition) and will not change while it is sent.
+ */
+#define SENDFILE_IOCTL_MAP          0x5346
+
+struct sendfile_map {
+    const void *addr;       /** address of the file offset 0 */
+    size_t      size;       /** file size */
+};
+
+/**
+ * @brief  send a file to a tcp socket without a copy when the file can be mapped,
+ *         through two read-ahead buffers otherwise
+ * @param  [in] out_fd : connected lwip tcp socket
+ * @param  [in] in_fd  : file opened by aos_open
+ * @param  [in] offset : start offset, updated on return; NULL to use and update the file position
+ * @param  [in] count  : number of bytes to send
+ * @return number of bytes sent, -1 with errno set on failed
+ */
+ssize_t sendfile(int out_fd, int in_fd, off_t *offset, size_t count);
+
+/**
+ * @brief  send a memory region which never changes (ROM, XIP flash) without a copy
+ * @param  [in] out_fd : connected lwip tcp socket
+ * @param  [in] data   : data to send, it is referenced by the tcp queue until acked
+ * @param  [in] size   : number of bytes to send
+ * @return number of bytes sent, -1 with errno set on failed
+ */
+ssize_t sendfile_rom(int out_fd, const void *data, size_t size);
+
+int  sendfile_client(int argc, char *argv[]);
+int  sendfile_server(int argc, char **argv);
+void sendfile_server_task_create(char *port);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LWIP_HDR_APPS_SENDFILE_H */
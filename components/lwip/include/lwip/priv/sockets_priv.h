@@ -81,6 +81,16 @@ struct lwip_sock {
   /** counter of how many threads are waiting for this socket using select */
   SELWAIT_T select_waiting;
 #endif /* LWIP_SOCKET_SELECT || LWIP_SOCKET_POLL */
+#if LWIP_SOCKET_SELECT
+  /** readiness set the socket is registered in, see evset_ctl() */
+  struct evset *evset;
+  /** next socket on the ready list of evset */
+  struct lwip_sock *evset_next;
+  /** EVSET_* events registered */
+  u8_t evset_events;
+  /** 1 while the socket is on the ready list */
+  u8_t evset_queued;
+#endif /* LWIP_SOCKET_SELECT */
 #if LWIP_NETCONN_FULLDUPLEX
   /* counter of how many threads are using a struct lwip_sock (not the 'int') */
   u8_t fd_used;
@@ -132,6 +142,8 @@ struct lwip_setgetsockopt_data {
 #endif
 
 struct lwip_sock* lwip_socket_dbg_get_socket(int fd);
+struct lwip_sock* lwip_socket_get(int fd);
+void lwip_socket_put(struct lwip_sock *sock);
 
 #if LWIP_SOCKET_SELECT || LWIP_SOCKET_POLL
 
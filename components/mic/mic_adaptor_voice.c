@@ -121,6 +121,7 @@ static int mic_adaptor_set_param(mic_t *mic, mic_param_t *param)
     voice_pcm_param_t      pcm_p;
     voice_param_t v_p;
 
+    memset(&v_p, 0, sizeof(voice_param_t));
     pcm_p.access        = 0;
     pcm_p.channles      = param->channels;
     pcm_p.channles_sum  = param->channels;
@@ -4,6 +4,7 @@
 extern "C" {
 #endif
 
+#include <stdint.h>
 #include <sys/time.h>
 #if defined(CONFIG_SAL) || defined(CONFIG_TCPIP)
 #include <sys/socket.h>
@@ -35,6 +36,35 @@ extern int select2(int maxfdp1, fd_set *readset, fd_set *writeset, fd_set *excep
 extern int select(int maxfdp1, fd_set *readset, fd_set *writeset, fd_set *exceptset,
             struct timeval *timeout);
 
+/*
+ * persistent readiness set: a socket registered in a set puts itself on the
+ * ready list of the set when it gets an event, so evset_wait only looks at
+ * the ready sockets instead of scanning every fd as select does.
+ */
+#define EVSET_IN         0x01    /* readable */
+#define EVSET_OUT        0x02    /* writable */
+#define EVSET_ERR        0x04    /* error, always reported */
+#define EVSET_HUP        0x08    /* closed and left the set, reported once */
+
+#define EVSET_CTL_ADD    1
+#define EVSET_CTL_MOD    2
+#define EVSET_CTL_DEL    3
+
+typedef struct evset evset_t;
+
+typedef struct {
+    int      fd;
+    uint32_t events;
+} evset_event_t;
+
+/* semaphore: optional, signalling it wakes evset_wait up as for select2 */
+extern evset_t *evset_new(void *semaphore);
+extern void     evset_free(evset_t *set);
+/* a socket belongs to one set at a time, it leaves the set when closed */
+extern int      evset_ctl(evset_t *set, int op, int fd, uint32_t events);
+/* level triggered, timeout_ms < 0 waits forever; return the number of ready fds, 0 on timeout or wake up */
+extern int      evset_wait(evset_t *set, evset_event_t *evs, int maxevents, int timeout_ms);
+
 
 #ifdef __cplusplus
 }
@@ -52,6 +52,15 @@ extern "C"
 #endif
 
 
+/* RV32M and C-SKY DSPv2 are picked from the compiler unless C_EQUIVALENT is forced */
+#if !defined(C_EQUIVALENT) && !defined(PV_RISCV_RV32M) && !defined(PV_CSKY_DSPV2)
+#if (defined(__riscv) && (__riscv_xlen == 32) && defined(__riscv_mul))
+#define PV_RISCV_RV32M
+#elif defined(__CSKY_DSPV2__)
+#define PV_CSKY_DSPV2
+#endif
+#endif
+
 #if (defined(PV_ARM_V5)||defined(PV_ARM_V4))
 
 #include "pv_mp3dec_fxd_op_arm.h"
@@ -64,6 +73,10 @@ extern "C"
 
 #include "pv_mp3dec_fxd_op_msc_evc.h"
 
+#elif (defined(PV_RISCV_RV32M)||defined(PV_CSKY_DSPV2))
+
+#include "pv_mp3dec_fxd_op_riscv_csky.h"
+
 #else
 
 #ifndef C_EQUIVALENT
@@ -0,0 +1,157 @@
+/* ------------------------------------------------------------------
+ * Copyright (C) 1998-2009 PacketVideo
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either
+ * express or implied.
+ * See the License for the specific language governing permissions
+ * and limitations under the License.
+ * -------------------------------------------------------------------
+ */
+/*
+------------------------------------------------------------------------------
+   PacketVideo Corp.
+   MP3 Decoder Library
+
+   Pathname: ./cpp/include/pv_mp3dec_fxd_op_riscv_csky.h
+
+------------------------------------------------------------------------------
+ REVISION HISTORY
+
+ Description: fixed point functions for RV32 with the M extension and for
+              C-SKY with DSPv2.
+------------------------------------------------------------------------------
+ INCLUDE DESCRIPTION
+
+ Meant to be bit exact with pv_mp3dec_fxd_op_c_equivalent.h: fxp_mul32_Qn
+ keeps bits [n, n + 31] of the 64-bit product, i.e.
+ (hi << (32 - n)) | (lo >> n). RV32 gets hi from mulh and lo from mul,
+ C-SKY gets the pair from one mul.s32 and extracts the word with dexti.
+ The generic header leaves the 64-bit shift to the compiler and may be
+ called out of line at -Os.
+
+ Not yet run on a target: decode a stream once with C_EQUIVALENT defined
+ and once without, the pcm must be identical.
+
+------------------------------------------------------------------------------
+*/
+
+#ifndef PV_MP3DEC_FXD_OP_RISCV_CSKY_H
+#define PV_MP3DEC_FXD_OP_RISCV_CSKY_H
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include "pvmp3_audio_type_defs.h"
+
+
+#if (defined(PV_RISCV_RV32M)||defined(PV_CSKY_DSPV2))
+
+#define Qfmt_31(a)   (Int32)((float)(a)*0x7FFFFFFF)
+
+#define Qfmt15(x)   (Int16)((x)*((Int32)1<<15) + ((x)>=0?0.5F:-0.5F))
+
+#define PV_FXD_INLINE   static inline __attribute__((always_inline))
+
+#if defined(PV_RISCV_RV32M)
+
+    PV_FXD_INLINE int32 fxp_mul32_Q32(const int32 a, const int32 b)
+    {
+        int32 hi;
+        __asm__("mulh %0, %1, %2" : "=r"(hi) : "r"(a), "r"(b));
+        return hi;
+    }
+
+    /* bits [n, n + 31] of a * b, the low word is a plain mul */
+#define PV_FXP_MUL32_QN(a, b, n)                                            \
+    ((int32)(((uint32)fxp_mul32_Q32(a, b) << (32 - (n))) |                 \
+             (((uint32)(a) * (uint32)(b)) >> (n))))
+
+#else /* PV_CSKY_DSPV2 */
+
+    PV_FXD_INLINE int32 fxp_mul32_Q32(const int32 a, const int32 b)
+    {
+        int32 hi;
+        __asm__("mul.s32.h %0, %1, %2" : "=r"(hi) : "r"(a), "r"(b));
+        return hi;
+    }
+
+    /* the 64-bit product lands in a register pair, dexti takes the word from bit n */
+#define PV_FXP_MUL32_QN(a, b, n)                                            \
+    __extension__({                                                         \
+        int64 _p;                                                           \
+        int32 _r;                                                           \
+        __asm__("mul.s32 %1, %2, %3\n\t"                                    \
+                "dexti %0, %1, %R1, %4"                                     \
+                : "=r"(_r), "=&r"(_p)                                       \
+                : "r"(a), "r"(b), "i"(n));                                  \
+        _r;                                                                 \
+    })
+
+#endif
+
+    PV_FXD_INLINE int32 pv_abs(int32 a)
+    {
+        int32 b = (a < 0) ? -a : a;
+        return b;
+    }
+
+    PV_FXD_INLINE int32 fxp_mul32_Q30(const int32 a, const int32 b)
+    {
+        return PV_FXP_MUL32_QN(a, b, 30);
+    }
+
+    PV_FXD_INLINE int32 fxp_mac32_Q30(const int32 a, const int32 b, int32 L_add)
+    {
+        return (L_add + PV_FXP_MUL32_QN(a, b, 30));
+    }
+
+    PV_FXD_INLINE int32 fxp_mul32_Q29(const int32 a, const int32 b)
+    {
+        return PV_FXP_MUL32_QN(a, b, 29);
+    }
+
+    PV_FXD_INLINE int32 fxp_mul32_Q28(const int32 a, const int32 b)
+    {
+        return PV_FXP_MUL32_QN(a, b, 28);
+    }
+
+    PV_FXD_INLINE int32 fxp_mul32_Q27(const int32 a, const int32 b)
+    {
+        return PV_FXP_MUL32_QN(a, b, 27);
+    }
+
+    PV_FXD_INLINE int32 fxp_mul32_Q26(const int32 a, const int32 b)
+    {
+        return PV_FXP_MUL32_QN(a, b, 26);
+    }
+
+    PV_FXD_INLINE int32 fxp_mac32_Q32(int32 L_add, const int32 a, const int32 b)
+    {
+        return (L_add + fxp_mul32_Q32(a, b));
+    }
+
+    PV_FXD_INLINE int32 fxp_msb32_Q32(int32 L_sub, const int32 a, const int32 b)
+    {
+        return (L_sub - fxp_mul32_Q32(a, b));
+    }
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif   /*  PV_MP3DEC_FXD_OP_RISCV_CSKY_H  */
+
@@ -551,6 +551,10 @@ void lwip_socket_thread_cleanup(void); /* LWIP_NETCONN_SEM_PER_THREAD==1: destro
 #if LWIP_SOCKET_SELECT
 #define lwip_select       select
 #define lwip_select2      select2
+#define lwip_evset_new    evset_new
+#define lwip_evset_free   evset_free
+#define lwip_evset_ctl    evset_ctl
+#define lwip_evset_wait   evset_wait
 #endif
 #if LWIP_SOCKET_POLL
 #define lwip_poll         poll
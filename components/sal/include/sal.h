@@ -23,6 +23,17 @@ extern "C" {
 #define CONFIG_SAL_DEFAULT_OUTPUTMBOX_SIZE       8
 #endif
 
+/* tcp sockets which get a receive ring at once, the ring is malloced per socket,
+ * 0 to queue every chunk as a netbuf */
+#ifndef CONFIG_SAL_RX_RING_NUM
+#define CONFIG_SAL_RX_RING_NUM                   2
+#endif
+
+/* bytes of one receive ring, power of 2 */
+#ifndef CONFIG_SAL_RX_RING_SIZE
+#define CONFIG_SAL_RX_RING_SIZE                  2048
+#endif
+
 typedef enum {
     /* WiFi */
     TCP_SERVER,
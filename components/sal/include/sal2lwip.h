@@ -76,6 +76,10 @@
 #define sal_socket       socket
 #define sal_select       select
 #define sal_select2      select2
+#define sal_evset_new    evset_new
+#define sal_evset_free   evset_free
+#define sal_evset_ctl    evset_ctl
+#define sal_evset_wait   evset_wait
 #define sal_ioctlsocket  ioctl
 
 // #define sal_fcntl        fcntl
@@ -31,6 +31,7 @@
 #endif
 
 #include <string.h>
+#include <sys/select.h>
 
 #include "sal2lwip.h"
 
@@ -154,6 +155,18 @@ struct sal_sock {
     uint8_t err;
     /** counter of how many threads are waiting for this socket using select */
     SELWAIT_T select_waiting;
+#if CONFIG_SAL_RX_RING_NUM > 0
+    /** receive ring of a tcp socket, NULL if the pool is empty */
+    struct sal_rxring *rxring;
+#endif
+    /** readiness set the socket is registered in */
+    evset_t *evset;
+    /** next socket on the ready list of evset */
+    struct sal_sock *evset_next;
+    /** EVSET_* events registered */
+    uint8_t evset_events;
+    /** 1 while the socket is on the ready list */
+    uint8_t evset_queued;
 };
 
 typedef struct sal_netbuf {
@@ -161,6 +174,7 @@ typedef struct sal_netbuf {
     u16_t     len;
     ip_addr_t addr;
     u16_t     port;
+    struct sal_netbuf *next;
 } sal_netbuf_t;
 
 typedef struct sal_outputbuf {
@@ -672,6 +686,18 @@ static void salnetconn_drain(sal_netconn_t *conn)
 {
     sal_netbuf_t *mem;
 
+#if CONFIG_SAL_RX_RING_NUM > 0
+    struct sal_sock *rxsock = tryget_socket(conn->socket);
+
+    /* the mbox of a ring only holds tokens */
+    if (rxsock && rxsock->rxring && sal_mbox_valid(&conn->recvmbox)) {
+        while (sal_mbox_tryfetch(&conn->recvmbox, (void **)(&mem)) != SAL_MBOX_EMPTY);
+
+        sal_mbox_free(&conn->recvmbox);
+        sal_mbox_set_invalid(&conn->recvmbox);
+    }
+#endif
+
     if (sal_mbox_valid(&conn->recvmbox)) {
         while (sal_mbox_tryfetch(&conn->recvmbox, (void **)(&mem)) != SAL_MBOX_EMPTY) {
             if (mem != NULL) {
@@ -1548,6 +1574,627 @@ sal_select(int maxfdp1, fd_set *readset, fd_set *writeset, fd_set *exceptset,
 }
 
 //把有事件的标出来
+#if CONFIG_SAL_RX_RING_NUM > 0
+/**
+ * Receive ring of a tcp socket, taken from a pool allocated once in sal_init.
+ * Every chunk from the module driver is appended to the ring, so small chunks
+ * coalesce and nothing is allocated per packet. When a reader is blocked on an
+ * empty ring the chunk is copied straight into its buffer. recvmbox only carries
+ * a wakeup token with the byte count, at most one token of a ring is pending.
+ * Chunks which don't fit are kept in a spill list, read after the ring.
+ */
+typedef struct sal_rxring {
+    uint8_t      *buf;
+    uint32_t      head;                  /** written by input */
+    uint32_t      tail;                  /** written by recv */
+    sal_netbuf_t *spill;                 /** chunks which did not fit in the ring */
+    sal_netbuf_t *spill_tail;
+    uint32_t      spill_len;             /** bytes queued on the spill list */
+    uint16_t      spill_off;             /** bytes read of the first spill chunk */
+    uint8_t       token;                 /** a wakeup token is in recvmbox */
+    uint8_t       used;
+    uint8_t       valid;                 /** the lock is created */
+    uint8_t      *user;                  /** buffer of the blocked reader */
+    uint32_t      user_len;
+    uint32_t      user_off;
+    sal_mutex_t   lock;
+} sal_rxring_t;
+
+#if (CONFIG_SAL_RX_RING_SIZE & (CONFIG_SAL_RX_RING_SIZE - 1)) != 0
+#error "CONFIG_SAL_RX_RING_SIZE must be a power of 2"
+#endif
+
+#define RXRING_MASK (CONFIG_SAL_RX_RING_SIZE - 1)
+
+/* chunks beyond one ring's worth of spill are dropped, the app does not read */
+#define RXRING_SPILL_MAX CONFIG_SAL_RX_RING_SIZE
+
+static sal_rxring_t g_sal_rxring[CONFIG_SAL_RX_RING_NUM];
+
+/* only the locks are made here, the buffer lives as long as its tcp socket */
+static void sal_rxring_init(void)
+{
+    int i;
+
+    for (i = 0; i < CONFIG_SAL_RX_RING_NUM; i++) {
+        if (sal_mutex_new(&g_sal_rxring[i].lock) != ERR_OK) {
+            SAL_ERROR("fail to creat rx ring lock %d\n", i);
+            break;
+        }
+
+        g_sal_rxring[i].valid = 1;
+    }
+}
+
+static sal_rxring_t *sal_rxring_get(void)
+{
+    sal_rxring_t *rx = NULL;
+    int i;
+    SAL_ARCH_DECL_PROTECT(lev);
+
+    SAL_ARCH_PROTECT(lev);
+    for (i = 0; i < CONFIG_SAL_RX_RING_NUM; i++) {
+        if (g_sal_rxring[i].valid && !g_sal_rxring[i].used) {
+            rx = &g_sal_rxring[i];
+            rx->used = 1;
+            break;
+        }
+    }
+    SAL_ARCH_UNPROTECT(lev);
+
+    if (rx) {
+        rx->buf = aos_malloc(CONFIG_SAL_RX_RING_SIZE);
+        if (rx->buf == NULL) {
+            SAL_ERROR("no memory for rx ring, use netbuf\n");
+            SAL_ARCH_SET(rx->used, 0);
+            return NULL;
+        }
+
+        rx->head      = 0;
+        rx->tail      = 0;
+        rx->spill     = NULL;
+        rx->spill_tail = NULL;
+        rx->spill_len = 0;
+        rx->spill_off = 0;
+        rx->token     = 0;
+        rx->user      = NULL;
+        rx->user_len  = 0;
+        rx->user_off  = 0;
+    }
+
+    return rx;
+}
+
+static void sal_rxring_put(sal_rxring_t *rx)
+{
+    sal_netbuf_t *nb;
+
+    sal_mutex_lock(&rx->lock);
+    while (rx->spill) {
+        nb = rx->spill;
+        rx->spill = nb->next;
+        aos_free(nb->payload);
+        aos_free(nb);
+    }
+    rx->spill_tail = NULL;
+    rx->spill_len  = 0;
+    aos_free(rx->buf);
+    rx->buf = NULL;
+    sal_mutex_unlock(&rx->lock);
+
+    SAL_ARCH_SET(rx->used, 0);
+}
+
+static inline int sal_rxring_ready(sal_rxring_t *rx)
+{
+    return rx->head != rx->tail || rx->spill != NULL;
+}
+
+static int sal_rxring_spill(sal_rxring_t *rx, const uint8_t *data, size_t len)
+{
+    sal_netbuf_t *nb;
+
+    if (rx->spill_len + len > RXRING_SPILL_MAX) {
+        return -1;
+    }
+
+    nb = (sal_netbuf_t *)aos_zalloc(sizeof(sal_netbuf_t));
+    if (nb == NULL) {
+        return -1;
+    }
+
+    nb->payload = aos_malloc(len);
+    if (nb->payload == NULL) {
+        aos_free(nb);
+        return -1;
+    }
+
+    memcpy(nb->payload, data, len);
+    nb->len = len;
+
+    if (rx->spill_tail) {
+        rx->spill_tail->next = nb;
+    } else {
+        rx->spill = nb;
+    }
+    rx->spill_tail = nb;
+    rx->spill_len += len;
+
+    return 0;
+}
+
+static int sal_rxring_input(struct sal_sock *sock, int s, const uint8_t *data, size_t len)
+{
+    sal_rxring_t *rx = sock->rxring;
+    uint32_t total = len;
+    uint32_t off, n;
+    int post = 0;
+    int ret = 0;
+
+    sal_mutex_lock(&rx->lock);
+
+    /* a reader waits on an empty ring, skip the ring */
+    if (rx->user && !sal_rxring_ready(rx)) {
+        n = rx->user_len - rx->user_off;
+        n = n < len ? n : len;
+        memcpy(rx->user + rx->user_off, data, n);
+        rx->user_off += n;
+        data += n;
+        len  -= n;
+    }
+
+    if (len > 0) {
+        if (rx->spill == NULL && CONFIG_SAL_RX_RING_SIZE - (rx->head - rx->tail) >= len) {
+            off = rx->head & RXRING_MASK;
+            n   = CONFIG_SAL_RX_RING_SIZE - off;
+            n   = n < len ? n : len;
+            memcpy(rx->buf + off, data, n);
+            memcpy(rx->buf, data + n, len - n);
+            rx->head += len;
+        } else {
+            ret = sal_rxring_spill(rx, data, len);
+        }
+    }
+
+    if (!rx->token) {
+        rx->token = 1;
+        post = 1;
+    }
+
+    sal_mutex_unlock(&rx->lock);
+
+    if (ret) {
+        SAL_ERROR("socket %d drop %d bytes, rx ring full or no memory\n", s, (int)len);
+    }
+
+    if (post) {
+        if (sal_mbox_trypost(&sock->conn->recvmbox, (void *)(uintptr_t)total) != ERR_OK) {
+            SAL_ARCH_SET(rx->token, 0);
+            SAL_ERROR("try post recv token fail\n");
+            return -1;
+        }
+
+        sal_deal_event(s, NETCONN_EVT_RCVPLUS);
+    }
+
+    return ret;
+}
+
+/* copy out of the ring and then the spill list, a pending token is consumed */
+static int sal_rxring_read(struct sal_sock *sock, int s, uint8_t *mem, size_t len, int peek)
+{
+    sal_rxring_t *rx = sock->rxring;
+    sal_netbuf_t *nb;
+    uint32_t off, n, cnt, skip;
+    void *msg;
+    int token = 0;
+
+    sal_mutex_lock(&rx->lock);
+
+    cnt = rx->head - rx->tail;
+    cnt = cnt < len ? cnt : len;
+    off = rx->tail & RXRING_MASK;
+    n   = CONFIG_SAL_RX_RING_SIZE - off;
+    n   = n < cnt ? n : cnt;
+    memcpy(mem, rx->buf + off, n);
+    memcpy(mem + n, rx->buf, cnt - n);
+
+    if (!peek) {
+        rx->tail += cnt;
+    }
+
+    skip = rx->spill_off;
+    for (nb = rx->spill; nb && cnt < len; ) {
+        n = nb->len - skip;
+        n = n < len - cnt ? n : len - cnt;
+        memcpy(mem + cnt, (uint8_t *)nb->payload + skip, n);
+        cnt += n;
+        skip += n;
+
+        if (skip < nb->len) {
+            break;
+        }
+
+        skip = 0;
+        if (peek) {
+            nb = nb->next;
+        } else {
+            rx->spill = nb->next;
+            if (rx->spill == NULL) {
+                rx->spill_tail = NULL;
+            }
+            rx->spill_len -= nb->len;
+            aos_free(nb->payload);
+            aos_free(nb);
+            nb = rx->spill;
+        }
+    }
+
+    if (!peek) {
+        rx->spill_off = skip;
+    }
+
+    if (rx->token && sal_mbox_tryfetch(&sock->conn->recvmbox, &msg) != SAL_MBOX_EMPTY) {
+        rx->token = 0;
+        token = 1;
+    }
+
+    sal_mutex_unlock(&rx->lock);
+
+    if (token) {
+        sal_deal_event(s, NETCONN_EVT_RCVMINUS);
+    }
+
+    return cnt;
+}
+
+static ssize_t sal_rxring_recv(struct sal_sock *sock, int s, void *mem, size_t len, int flags)
+{
+    sal_rxring_t *rx = sock->rxring;
+    sal_netconn_t *conn = sock->conn;
+    int peek = (flags & MSG_PEEK) != 0;
+    void *msg;
+    u32_t ret;
+    int n;
+
+    for (;;) {
+        n = sal_rxring_read(sock, s, mem, len, peek);
+        if (n > 0) {
+            return n;
+        }
+
+        if (conn->state == NETCONN_CLOSE) {
+            return 0;
+        }
+
+        if ((flags & MSG_DONTWAIT) || netconn_is_nonblocking(conn)) {
+            sock_set_errno(sock, EWOULDBLOCK);
+            return -1;
+        }
+
+        sal_mutex_lock(&rx->lock);
+        if (sal_rxring_ready(rx)) {
+            sal_mutex_unlock(&rx->lock);
+            continue;
+        }
+        if (!peek && rx->user == NULL) {
+            rx->user     = mem;
+            rx->user_len = len;
+            rx->user_off = 0;
+        }
+        sal_mutex_unlock(&rx->lock);
+
+        ret = sal_arch_mbox_fetch(&conn->recvmbox, &msg, conn->recv_timeout);
+
+        sal_mutex_lock(&rx->lock);
+        n = 0;
+        if (rx->user == mem) {
+            n = rx->user_off;
+            rx->user     = NULL;
+            rx->user_len = 0;
+            rx->user_off = 0;
+        }
+        if (ret != SAL_ARCH_TIMEOUT) {
+            rx->token = 0;
+        }
+        sal_mutex_unlock(&rx->lock);
+
+        if (ret != SAL_ARCH_TIMEOUT) {
+            sal_deal_event(s, NETCONN_EVT_RCVMINUS);
+        }
+
+        if (n > 0) {
+            return n;
+        }
+
+        if (ret == SAL_ARCH_TIMEOUT) {
+            SAL_ERROR("sal recv data time out, socket %d timeout %d\n", s, conn->recv_timeout);
+            sock_set_errno(sock, err_to_errno(ERR_TIMEOUT));
+            return -1;
+        }
+    }
+}
+#endif /* CONFIG_SAL_RX_RING_NUM > 0 */
+
+/**
+ * Readiness set: sal_deal_event queues a registered socket on the ready list
+ * of its set, evset_wait only checks the queued sockets again. The list and
+ * the evset fields of the sockets are protected by SAL_ARCH_PROTECT.
+ */
+struct evset {
+    struct sal_sock *head;
+    struct sal_sock *tail;
+    sal_sem_t       *psem;
+    sal_sem_t        sem;
+    /* sockets closed while registered, reported once as EVSET_HUP */
+    uint32_t         closed[(NUM_SOCKETS + 31) / 32];
+    uint8_t          closed_any;
+};
+
+/* called with SAL_ARCH protected */
+static uint32_t sal_evset_revents(struct sal_sock *sock)
+{
+    uint32_t revents = 0;
+
+    if (sock->lastdata != NULL || sock->rcvevent > 0) {
+        revents |= EVSET_IN;
+    }
+#if CONFIG_SAL_RX_RING_NUM > 0
+    if (sock->rxring && sal_rxring_ready(sock->rxring)) {
+        revents |= EVSET_IN;
+    }
+#endif
+    if (sock->sendevent != 0) {
+        revents |= EVSET_OUT;
+    }
+    if (sock->errevent != 0) {
+        revents |= EVSET_ERR;
+    }
+
+    return revents & (sock->evset_events | EVSET_ERR);
+}
+
+/* called with SAL_ARCH protected */
+static void sal_evset_enqueue(evset_t *set, struct sal_sock *sock)
+{
+    sock->evset_queued = 1;
+    sock->evset_next   = NULL;
+
+    if (set->tail) {
+        set->tail->evset_next = sock;
+    } else {
+        set->head = sock;
+    }
+    set->tail = sock;
+}
+
+/* called with SAL_ARCH protected */
+static void sal_evset_push(struct sal_sock *sock)
+{
+    evset_t *set = sock->evset;
+
+    if (set == NULL || sock->evset_queued || sal_evset_revents(sock) == 0) {
+        return;
+    }
+
+    sal_evset_enqueue(set, sock);
+    sal_sem_signal(set->psem);
+}
+
+/* called with SAL_ARCH protected */
+static void sal_evset_unlink(struct sal_sock *sock)
+{
+    evset_t *set = sock->evset;
+    struct sal_sock *prev = NULL, *it;
+
+    if (set == NULL) {
+        return;
+    }
+
+    if (sock->evset_queued) {
+        for (it = set->head; it != NULL && it != sock; it = it->evset_next) {
+            prev = it;
+        }
+
+        if (it == sock) {
+            if (prev) {
+                prev->evset_next = sock->evset_next;
+            } else {
+                set->head = sock->evset_next;
+            }
+
+            if (set->tail == sock) {
+                set->tail = prev;
+            }
+        }
+    }
+
+    sock->evset        = NULL;
+    sock->evset_next   = NULL;
+    sock->evset_events = 0;
+    sock->evset_queued = 0;
+}
+
+/* called with SAL_ARCH protected, the socket is being closed */
+static void sal_evset_close(struct sal_sock *sock)
+{
+    evset_t *set = sock->evset;
+    int i = (int)(sock - sockets);
+
+    if (set == NULL) {
+        return;
+    }
+
+    sal_evset_unlink(sock);
+    set->closed[i / 32] |= 1UL << (i % 32);
+    set->closed_any = 1;
+    sal_sem_signal(set->psem);
+}
+
+evset_t *sal_evset_new(void *semaphore)
+{
+    evset_t *set = aos_zalloc(sizeof(evset_t));
+
+    if (set == NULL) {
+        set_errno(ENOMEM);
+        return NULL;
+    }
+
+    if (semaphore) {
+        set->psem = (sal_sem_t *)semaphore;
+    } else {
+        if (sal_sem_new(&set->sem, 0) != ERR_OK) {
+            aos_free(set);
+            set_errno(ENOMEM);
+            return NULL;
+        }
+        set->psem = &set->sem;
+    }
+
+    return set;
+}
+
+void sal_evset_free(evset_t *set)
+{
+    int i;
+    SAL_ARCH_DECL_PROTECT(lev);
+
+    if (set == NULL) {
+        return;
+    }
+
+    SAL_ARCH_PROTECT(lev);
+    for (i = 0; i < NUM_SOCKETS; i++) {
+        if (sockets[i].evset == set) {
+            sal_evset_unlink(&sockets[i]);
+        }
+    }
+    SAL_ARCH_UNPROTECT(lev);
+
+    if (set->psem == &set->sem) {
+        sal_sem_free(&set->sem);
+    }
+    aos_free(set);
+}
+
+int sal_evset_ctl(evset_t *set, int op, int fd, uint32_t events)
+{
+    struct sal_sock *sock;
+    int err = 0;
+    SAL_ARCH_DECL_PROTECT(lev);
+
+    if (set == NULL) {
+        set_errno(EINVAL);
+        return -1;
+    }
+
+    SAL_ARCH_PROTECT(lev);
+    sock = tryget_socket(fd);
+    if (sock == NULL) {
+        err = EBADF;
+    } else if (op == EVSET_CTL_ADD) {
+        if (sock->evset != NULL) {
+            err = EEXIST;
+        } else {
+            sock->evset        = set;
+            sock->evset_events = events;
+            sal_evset_push(sock);
+        }
+    } else if (op == EVSET_CTL_MOD || op == EVSET_CTL_DEL) {
+        if (sock->evset != set) {
+            err = ENOENT;
+        } else if (op == EVSET_CTL_MOD) {
+            sock->evset_events = events;
+            sal_evset_push(sock);
+        } else {
+            sal_evset_unlink(sock);
+        }
+    } else {
+        err = EINVAL;
+    }
+    SAL_ARCH_UNPROTECT(lev);
+
+    if (err) {
+        set_errno(err);
+        return -1;
+    }
+
+    return 0;
+}
+
+/* pop the ready list, the sockets still ready are queued again at the tail */
+static int sal_evset_collect(evset_t *set, evset_event_t *evs, int maxevents)
+{
+    struct sal_sock *sock, *keep = NULL, *keep_tail = NULL;
+    uint32_t revents;
+    int i, n = 0;
+    SAL_ARCH_DECL_PROTECT(lev);
+
+    SAL_ARCH_PROTECT(lev);
+    if (set->closed_any) {
+        for (i = 0; i < NUM_SOCKETS && n < maxevents; i++) {
+            if (set->closed[i / 32] & (1UL << (i % 32))) {
+                set->closed[i / 32] &= ~(1UL << (i % 32));
+                evs[n].fd     = i + SAL_SOCKET_OFFSET;
+                evs[n].events = EVSET_HUP;
+                n++;
+            }
+        }
+        set->closed_any = i < NUM_SOCKETS;
+    }
+
+    while (n < maxevents && (sock = set->head) != NULL) {
+        set->head = sock->evset_next;
+        if (set->head == NULL) {
+            set->tail = NULL;
+        }
+        sock->evset_queued = 0;
+        sock->evset_next   = NULL;
+
+        revents = sal_evset_revents(sock);
+        if (revents) {
+            evs[n].fd     = (int)(sock - sockets) + SAL_SOCKET_OFFSET;
+            evs[n].events = revents;
+            n++;
+
+            if (keep_tail) {
+                keep_tail->evset_next = sock;
+            } else {
+                keep = sock;
+            }
+            keep_tail = sock;
+        }
+    }
+
+    while ((sock = keep) != NULL) {
+        keep = sock->evset_next;
+        sal_evset_enqueue(set, sock);
+    }
+    SAL_ARCH_UNPROTECT(lev);
+
+    return n;
+}
+
+int sal_evset_wait(evset_t *set, evset_event_t *evs, int maxevents, int timeout_ms)
+{
+    int n;
+
+    if (set == NULL || evs == NULL || maxevents <= 0) {
+        set_errno(EINVAL);
+        return -1;
+    }
+
+    n = sal_evset_collect(set, evs, maxevents);
+    if (n > 0 || timeout_ms == 0) {
+        return n;
+    }
+
+    /* 0 means wait forever */
+    sal_arch_sem_wait(set->psem, timeout_ms < 0 ? 0 : timeout_ms);
+
+    return sal_evset_collect(set, evs, maxevents);
+}
+
 static int sal_selscan(int maxfdp1, fd_set *readset_in, fd_set *writeset_in,
                        fd_set *exceptset_in, fd_set *readset_out,
                        fd_set *writeset_out, fd_set *exceptset_out)
@@ -1579,6 +2226,11 @@ static int sal_selscan(int maxfdp1, fd_set *readset_in, fd_set *writeset_in,
 
         if (sock != NULL || event != NULL) {
             void *lastdata = sock ? sock->lastdata : NULL;
+#if CONFIG_SAL_RX_RING_NUM > 0
+            if (sock && sock->rxring && sal_rxring_ready(sock->rxring)) {
+                lastdata = sock->rxring;
+            }
+#endif
             int16_t rcvevent = sock ? sock->rcvevent : event->reads;
             uint16_t sendevent = sock ? sock->sendevent : event->writes;
             uint16_t errevent = sock ? sock->errevent : 0;
@@ -1646,6 +2298,28 @@ ssize_t sal_recvfrom(int s, void *mem, size_t len, int flags,
         return -1;
     }
 
+#if CONFIG_SAL_RX_RING_NUM > 0
+    if (pstsock->rxring) {
+        off = sal_rxring_recv(pstsock, s, mem, len, flags);
+
+        if (off > 0) {
+            if (from && fromlen) {
+                IPADDR_PORT_TO_SOCKADDR(&saddr, &(pstsock->conn->pcb.tcp->remote_ip), (pstsock->conn->pcb.tcp->remote_port));
+
+                if (*fromlen > saddr.sa.sa_len) {
+                    *fromlen = saddr.sa.sa_len;
+                }
+
+                memcpy(from, &saddr, *fromlen);
+            }
+
+            sock_set_errno(pstsock, 0);
+        }
+
+        return off;
+    }
+#endif
+
     do {
         SAL_DEBUG("sal recvfrom : top while sock->lastdata=%p\n", pstsock->lastdata);
 
@@ -2130,6 +2804,16 @@ int sal_packet_input(int s, void *data, size_t len, char remote_ip[16], uint16_t
 
 #endif
 
+#if CONFIG_SAL_RX_RING_NUM > 0
+    if (sock->rxring) {
+#ifdef SAL_SERVER
+        return sal_rxring_input(sock, sock_fd, data, len);
+#else
+        return sal_rxring_input(sock, s, data, len);
+#endif
+    }
+#endif
+
     ret = salnetconn_packet_input(sock->conn, data, len, remote_ip, remote_port);
 
     if (ret) {
@@ -2198,6 +2882,8 @@ void sal_deal_event(int s, enum netconn_evt evt)
         break;
     }
 
+    sal_evset_push(sock);
+
     if (sock->select_waiting == 0) {
         /* noone is waiting for this socket, no need to check select_cb_list */
         SAL_ARCH_UNPROTECT(lev);
@@ -2298,6 +2984,9 @@ static int alloc_socket(sal_netconn_t *newconn, int accepted)
             sockets[i].errevent   = 0;
             sockets[i].err        = 0;
             sockets[i].select_waiting = 0;
+#if CONFIG_SAL_RX_RING_NUM > 0
+            sockets[i].rxring = (NETCONNTYPE_GROUP(newconn->type) == NETCONN_TCP) ? sal_rxring_get() : NULL;
+#endif
             return i + SAL_SOCKET_OFFSET;
         }
 
@@ -2427,6 +3116,10 @@ int sal_init(void)
         return -1;
     }
 
+#if CONFIG_SAL_RX_RING_NUM > 0
+    sal_rxring_init();
+#endif
+
 #if SAL_PACKET_SEND_MODE_ASYNC
     aos_task_t  task;
 
@@ -2648,6 +3341,18 @@ int sal_connect(int s, const struct sockaddr *name, socklen_t namelen)
  */
 static void free_socket(struct sal_sock *sock)
 {
+    SAL_ARCH_DECL_PROTECT(lev);
+
+    SAL_ARCH_PROTECT(lev);
+    sal_evset_close(sock);
+    SAL_ARCH_UNPROTECT(lev);
+
+#if CONFIG_SAL_RX_RING_NUM > 0
+    if (sock->rxring) {
+        sal_rxring_put(sock->rxring);
+        sock->rxring = NULL;
+    }
+#endif
     sock->lastdata   = NULL;
     sock->lastoffset = 0;
     sock->err        = 0;
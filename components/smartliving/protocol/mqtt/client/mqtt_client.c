@@ -13,6 +13,7 @@
 
 #include "MQTTPacket/MQTTPacket.h"
 #include "iotx_mqtt_internal.h"
+#include "mqtt_topic_trie.h"
 #include "utils_md5.h"
 #include "report.h"
 #ifdef LOG_REPORT_TO_CLOUD
@@ -61,10 +62,14 @@ typedef struct {
 static struct list_head g_mqtt_sub_list = LIST_HEAD_INIT(g_mqtt_sub_list);
 
 #if  WITH_MQTT_DYN_BUF
+/* small buffers are kept for the next packet, only the large ones go back to the heap */
 static int _reset_send_buffer(iotx_mc_client_t *c)
 {
     ARGUMENT_SANITY_CHECK(c != NULL, FAIL_RETURN);
     ARGUMENT_SANITY_CHECK(c->buf_send != NULL, FAIL_RETURN);
+    if (c->buf_size_send <= IOTX_MC_DYN_BUF_KEEP_LEN) {
+        return 0;
+    }
     mqtt_free(c->buf_send);
     c->buf_send = NULL;
     c->buf_size_send = 0;
@@ -75,6 +80,9 @@ static int _reset_recv_buffer(iotx_mc_client_t *c)
 {
     ARGUMENT_SANITY_CHECK(c != NULL, FAIL_RETURN);
     ARGUMENT_SANITY_CHECK(c->buf_read != NULL, FAIL_RETURN);
+    if (c->buf_size_read <= IOTX_MC_DYN_BUF_KEEP_LEN) {
+        return 0;
+    }
     mqtt_free(c->buf_read);
     c->buf_read = NULL;
     c->buf_size_read = 0;
@@ -90,8 +98,12 @@ static int _alloc_send_buffer(iotx_mc_client_t *c, int len)
         tmp_len = c->buf_size_send_max;
     }
     if (c->buf_send != NULL) {
-        mqtt_warning("c->buf_send is not null,free it first!");
+        if (c->buf_size_send >= tmp_len) {
+            return SUCCESS_RETURN;
+        }
         mqtt_free(c->buf_send);
+        c->buf_send = NULL;
+        c->buf_size_send = 0;
     }
     c->buf_send = mqtt_malloc(tmp_len);
     if (c->buf_send == NULL) {
@@ -109,6 +121,9 @@ static int _alloc_recv_buffer(iotx_mc_client_t *c, int len)
     if (tmp_len > c->buf_size_read_max) {
         tmp_len = c->buf_size_read_max;
     }
+    if (c->buf_read != NULL && c->buf_size_read >= tmp_len) {
+        return SUCCESS_RETURN;
+    }
     if (c->buf_read != NULL) { //do realloc
         char *temp = mqtt_malloc(tmp_len);
         if (temp == NULL) {
@@ -226,40 +241,6 @@ static inline int _is_in_yield_cb()
     return _in_yield_cb;
 }
 
-static int iotx_mc_check_rule(char *iterm, iotx_mc_topic_type_t type)
-{
-    int i = 0;
-    int len = 0;
-
-    if (NULL == iterm) {
-        mqtt_err("iterm is NULL");
-        return FAIL_RETURN;
-    }
-
-    len = strlen(iterm);
-
-    for (i = 0; i < len; i++) {
-        if (TOPIC_FILTER_TYPE == type) {
-            if ('+' == iterm[i] || '#' == iterm[i]) {
-                if (1 != len) {
-                    mqtt_err("the character # and + is error");
-                    return FAIL_RETURN;
-                }
-            }
-        } else {
-            if ('+' == iterm[i] || '#' == iterm[i]) {
-                mqtt_err("has character # and + is error");
-                return FAIL_RETURN;
-            }
-        }
-
-        if (iterm[i] < 32 || iterm[i] >= 127) {
-            return FAIL_RETURN;
-        }
-    }
-    return SUCCESS_RETURN;
-}
-
 /* check whether the topic is matched or not */
 static char iotx_mc_is_topic_matched(char *topicFilter, MQTTString *topicName)
 {
@@ -296,54 +277,76 @@ static char iotx_mc_is_topic_matched(char *topicFilter, MQTTString *topicName)
 }
 /* Check topic name */
 /* 0, topic name is valid; NOT 0, topic name is invalid */
+/* validate every level in place in one pass, without copying and tokenizing the topic */
 static int iotx_mc_check_topic(const char *topicName, iotx_mc_topic_type_t type)
 {
+    const char *p;
+    const char *level = NULL;
+    int wildcard = 0;
     int mask = 0;
-    char *delim = "/";
-    char *iterm = NULL;
-    char topicString[IOTX_MC_TOPIC_NAME_MAX_LEN];
-    if (NULL == topicName || '/' != topicName[0]) {
-        return FAIL_RETURN;
-    }
+    int levels = 0;
 
-    if (strlen(topicName) > IOTX_MC_TOPIC_NAME_MAX_LEN) {
-        mqtt_err("len of topicName exceeds 64");
+    if (NULL == topicName || '/' != topicName[0]) {
         return FAIL_RETURN;
     }
 
-    memset(topicString, 0x0, IOTX_MC_TOPIC_NAME_MAX_LEN);
-    strncpy(topicString, topicName, IOTX_MC_TOPIC_NAME_MAX_LEN - 1);
-
-    iterm = strtok(topicString, delim);
+    for (p = topicName; ; p++) {
+        if ('/' == *p || '\0' == *p) {
+            if (NULL != level) {
+                /* The character '#' is not in the last */
+                if (1 == mask) {
+                    mqtt_err("the character # is error");
+                    return FAIL_RETURN;
+                }
 
-    if (SUCCESS_RETURN != iotx_mc_check_rule(iterm, type)) {
-        mqtt_err("run iotx_check_rule error");
-        return FAIL_RETURN;
-    }
+                if (wildcard) {
+                    if (TOPIC_FILTER_TYPE != type) {
+                        mqtt_err("has character # and + is error");
+                        return FAIL_RETURN;
+                    }
+                    if (1 != p - level) {
+                        mqtt_err("the character # and + is error");
+                        return FAIL_RETURN;
+                    }
+                    if ('#' == level[0]) {
+                        mask = 1;
+                    }
+                }
 
-    for (;;) {
-        iterm = strtok(NULL, delim);
+                levels++;
+                level = NULL;
+                wildcard = 0;
+            }
 
-        if (iterm == NULL) {
-            break;
+            if ('\0' == *p) {
+                break;
+            }
+            continue;
         }
 
-        /* The character '#' is not in the last */
-        if (1 == mask) {
-            mqtt_err("the character # is error");
+        if (p - topicName >= IOTX_MC_TOPIC_NAME_MAX_LEN) {
+            mqtt_err("len of topicName exceeds %d", IOTX_MC_TOPIC_NAME_MAX_LEN);
             return FAIL_RETURN;
         }
 
-        if (SUCCESS_RETURN != iotx_mc_check_rule(iterm, type)) {
-            mqtt_err("run iotx_check_rule error");
+        if (*p < 32 || *p >= 127) {
             return FAIL_RETURN;
         }
 
-        if (iterm[0] == '#') {
-            mask = 1;
+        if ('+' == *p || '#' == *p) {
+            wildcard = 1;
+        }
+
+        if (NULL == level) {
+            level = p;
         }
     }
 
+    if (0 == levels) {
+        mqtt_err("topic has no level");
+        return FAIL_RETURN;
+    }
+
     return SUCCESS_RETURN;
 }
 
@@ -522,10 +525,25 @@ int MQTTPublish(iotx_mc_client_t *c, const char *topicName, iotx_mqtt_topic_info
     return SUCCESS_RETURN;
 }
 
+static int add_handle_to_list(iotx_mc_client_t *c, iotx_mc_topic_handle_t *h)
+{
+    if (SUCCESS_RETURN != iotx_mc_trie_insert(c->sub_trie, h)) {
+        mqtt_err("insert topic trie failed");
+        return FAIL_RETURN;
+    }
+
+    h->next = c->first_sub_handle;
+    c->first_sub_handle = h;
+
+    return SUCCESS_RETURN;
+}
+
 static int remove_handle_from_list(iotx_mc_client_t *c, iotx_mc_topic_handle_t *h)
 {
     iotx_mc_topic_handle_t **hp, *h1;
 
+    iotx_mc_trie_remove(c->sub_trie, h);
+
     hp = &c->first_sub_handle;
     while ((*hp) != NULL) {
         h1 = *hp;
@@ -567,6 +585,7 @@ static int MQTTSubscribe(iotx_mc_client_t *c, const char *topicFilter, iotx_mqtt
     if (NULL == handler) {
         return FAIL_RETURN;
     }
+    memset(handler, 0, sizeof(iotx_mc_topic_handle_t));
 
 #if !(WITH_MQTT_ZIP_TOPIC)
     handler->topic_filter = mqtt_malloc(strlen(topicFilter) + 1);
@@ -617,9 +636,8 @@ static int MQTTSubscribe(iotx_mc_client_t *c, const char *topicFilter, iotx_mqtt
         }
         if (dup == 0) {
             handler->qos = IOTX_MQTT_QOS3_SUB_LOCAL;
-            handler->next = c->first_sub_handle;
-            c->first_sub_handle = handler;
-        }else {
+        }
+        if (dup != 0 || SUCCESS_RETURN != add_handle_to_list(c, handler)) {
             mqtt_free(handler->topic_filter);
             mqtt_free(handler);
         }
@@ -703,10 +721,7 @@ static int MQTTSubscribe(iotx_mc_client_t *c, const char *topicFilter, iotx_mqtt
                 dup = 1;
             }
         }
-        if (dup == 0) {
-            handler->next = c->first_sub_handle;
-            c->first_sub_handle = handler;
-        } else {
+        if (dup != 0 || SUCCESS_RETURN != add_handle_to_list(c, handler)) {
             mqtt_free(handler->topic_filter);
             mqtt_free(handler);
         }
@@ -742,6 +757,7 @@ static int MQTTUnsubscribe(iotx_mc_client_t *c, const char *topicFilter, unsigne
     if (NULL == handler) {
         return FAIL_RETURN;
     }
+    memset(handler, 0, sizeof(iotx_mc_topic_handle_t));
 
 #if !(WITH_MQTT_ZIP_TOPIC)
     handler->topic_filter = mqtt_malloc(strlen(topicFilter) + 1);
@@ -1310,10 +1326,49 @@ static int iotx_mc_read_packet(iotx_mc_client_t *c, iotx_time_t *timer, unsigned
     return SUCCESS_RETURN;
 }
 
+#define IOTX_MC_DELIVER_LOCAL_NUM (8)
+
+typedef struct {
+    iotx_mqtt_event_handle_t   *handles;
+    int                         num;
+    int                         size;
+    iotx_mqtt_event_handle_t    local[IOTX_MC_DELIVER_LOCAL_NUM];
+} iotx_mc_deliver_ctx_t;
+
+/* copy the matched handles, so that the callbacks run unlocked and may unsubscribe */
+static void _deliver_collect(iotx_mc_topic_handle_t *h, void *arg)
+{
+    iotx_mc_deliver_ctx_t *ctx = (iotx_mc_deliver_ctx_t *)arg;
+
+    if (NULL == h->handle.h_fp) {
+        return;
+    }
+
+    if (ctx->num == ctx->size) {
+        iotx_mqtt_event_handle_t *handles = mqtt_malloc(ctx->size * 2 * sizeof(iotx_mqtt_event_handle_t));
+        if (NULL == handles) {
+            mqtt_err("too many matched handles, drop one");
+            return;
+        }
+        memcpy(handles, ctx->handles, ctx->num * sizeof(iotx_mqtt_event_handle_t));
+        if (ctx->handles != ctx->local) {
+            mqtt_free(ctx->handles);
+        }
+        ctx->handles = handles;
+        ctx->size *= 2;
+    }
+
+    ctx->handles[ctx->num++] = h->handle;
+}
+
 /* deliver message */
 static void iotx_mc_deliver_message(iotx_mc_client_t *c, MQTTString *topicName, iotx_mqtt_topic_info_pt topic_msg)
 {
-    int flag_matched = 0;
+    int i;
+    char *net_topic;
+    int net_topic_len;
+    char *md5 = NULL;
+    iotx_mc_deliver_ctx_t ctx;
 
     if (!c || !topicName || !topic_msg) {
         return;
@@ -1322,13 +1377,6 @@ static void iotx_mc_deliver_message(iotx_mc_client_t *c, MQTTString *topicName,
     topic_msg->ptopic = topicName->lenstring.data;
     topic_msg->topic_len = topicName->lenstring.len;
 
-#if WITH_MQTT_ZIP_TOPIC
-
-    MQTTString      md5_topic;
-    char            md5_topic_data[MQTT_MD5_PATH_DEFAULT_LEN] = {0};
-    char           *net_topic;
-    uint32_t        net_topic_len;
-
     if (topicName->cstring) {
         net_topic = topicName->cstring;
         net_topic_len = strlen(topicName->cstring);
@@ -1336,44 +1384,37 @@ static void iotx_mc_deliver_message(iotx_mc_client_t *c, MQTTString *topicName,
         net_topic = topicName->lenstring.data;
         net_topic_len = topicName->lenstring.len;
     }
-    md5_topic.cstring = NULL;
-    md5_topic.lenstring.data = md5_topic_data;
-    md5_topic.lenstring.len = MQTT_MD5_PATH_DEFAULT_LEN;
+
+#if WITH_MQTT_ZIP_TOPIC
+    char            md5_topic_data[MQTT_MD5_PATH_DEFAULT_LEN] = {0};
+
     iotx_mc_get_md5_topic(net_topic, net_topic_len, md5_topic_data, MQTT_MD5_PATH_DEFAULT_LEN);
-    /* we have to find the right message handler - indexed by topic */
-    HAL_MutexLock(c->lock_generic);
-    iotx_mc_topic_handle_t *h;
-    for (h = c->first_sub_handle; h != NULL; h = h->next) {
-        if (MQTTPacket_equals(&md5_topic, (char *)h->topic_filter)
-            || iotx_mc_is_topic_matched((char *)h->topic_filter, topicName)) {
-#else
-    /* we have to find the right message handler - indexed by topic */
-    HAL_MutexLock(c->lock_generic);
-    iotx_mc_topic_handle_t *h;
-    for (h = c->first_sub_handle; h != NULL; h = h->next) {
-        if (MQTTPacket_equals(topicName, (char *)h->topic_filter)
-            || iotx_mc_is_topic_matched((char *)h->topic_filter, topicName)) {
+    md5 = md5_topic_data;
 #endif
-            mqtt_debug("topic be matched");
 
-            iotx_mc_topic_handle_t *msg_handle = h;
-            HAL_MutexUnlock(c->lock_generic);
+    ctx.handles = ctx.local;
+    ctx.num = 0;
+    ctx.size = IOTX_MC_DELIVER_LOCAL_NUM;
 
-            if (NULL != msg_handle->handle.h_fp) {
-                iotx_mqtt_event_msg_t msg;
-                msg.event_type = IOTX_MQTT_EVENT_PUBLISH_RECEIVED;
-                msg.msg = (void *)topic_msg;
-                _handle_event(&msg_handle->handle, c, &msg);
-                flag_matched = 1;
-            }
+    /* we have to find the right message handler - indexed by topic */
+    HAL_MutexLock(c->lock_generic);
+    iotx_mc_trie_match(c->sub_trie, net_topic, net_topic_len, md5, _deliver_collect, &ctx);
+    HAL_MutexUnlock(c->lock_generic);
 
-            HAL_MutexLock(c->lock_generic);
-        }
+    for (i = 0; i < ctx.num; i++) {
+        iotx_mqtt_event_msg_t msg;
+
+        mqtt_debug("topic be matched");
+        msg.event_type = IOTX_MQTT_EVENT_PUBLISH_RECEIVED;
+        msg.msg = (void *)topic_msg;
+        _handle_event(&ctx.handles[i], c, &msg);
     }
 
-    HAL_MutexUnlock(c->lock_generic);
+    if (ctx.handles != ctx.local) {
+        mqtt_free(ctx.handles);
+    }
 
-    if (0 == flag_matched) {
+    if (0 == ctx.num) {
         mqtt_debug("NO matching any topic, call default handle function");
 
         if (NULL != c->handle_event.h_fp) {
@@ -1556,8 +1597,10 @@ static int iotx_mc_handle_recv_SUBACK(iotx_mc_client_t *c)
             handle->topic_type =  messagehandler[j].topic_type;
 
             HAL_MutexLock(c->lock_generic);
-            handle->next = c->first_sub_handle;
-            c->first_sub_handle = handle;
+            if (SUCCESS_RETURN != add_handle_to_list(c, handle)) {
+                mqtt_free(handle->topic_filter);
+                mqtt_free(handle);
+            }
             HAL_MutexUnlock(c->lock_generic);
         } else {
             mqtt_free(messagehandler[j].topic_filter);
@@ -2297,7 +2340,18 @@ int iotx_mc_init(iotx_mc_client_t *pClient, iotx_mqtt_param_t *pInitParams)
 #else
     pClient->buf_size_send_max = pInitParams->write_buf_size;
     pClient->buf_size_read_max = pInitParams->read_buf_size;
+
+    /* preallocate the buffers kept across packets, so the normal traffic does not touch the heap */
+    if (_alloc_send_buffer(pClient, IOTX_MC_DYN_BUF_KEEP_LEN - MQTT_DYNBUF_SEND_MARGIN) < 0
+        || _alloc_recv_buffer(pClient, IOTX_MC_DYN_BUF_KEEP_LEN - MQTT_DYNBUF_RECV_MARGIN) < 0) {
+        goto RETURN;
+    }
 #endif
+
+    pClient->sub_trie = iotx_mc_trie_create();
+    if (pClient->sub_trie == NULL) {
+        goto RETURN;
+    }
     pClient->keepalive_probes = 0;
 
     pClient->handle_event.h_fp = pInitParams->handle_event.h_fp;
@@ -2355,6 +2409,10 @@ RETURN :
             mqtt_free(pClient->buf_read);
             pClient->buf_read = NULL;
         }
+        if (pClient->sub_trie != NULL) {
+            iotx_mc_trie_destroy(pClient->sub_trie);
+            pClient->sub_trie = NULL;
+        }
         if (pClient->ipstack) {
             mqtt_free(pClient->ipstack);
             pClient->ipstack = NULL;
@@ -2932,7 +2990,10 @@ static int iotx_mc_release(iotx_mc_client_t *pClient)
             mqtt_free(handler);
             handler = next_handler;
         }
+        pClient->first_sub_handle = NULL;
     }
+    iotx_mc_trie_destroy(pClient->sub_trie);
+    pClient->sub_trie = NULL;
     iotx_conn_info_release();
     HAL_MutexDestroy(pClient->lock_generic);
     HAL_MutexDestroy(pClient->lock_list_sub);
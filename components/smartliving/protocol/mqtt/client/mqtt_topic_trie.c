@@ -0,0 +1,348 @@
+/*
+ * Copyright (C) 2015-2018 Alibaba Group Holding Limited
+ */
+#include "sl_config.h"
+#include <stdlib.h>
+#include <stddef.h>
+#include "iot_import.h"
+#include "iotx_utils.h"
+
+#include "iotx_mqtt_internal.h"
+#include "mqtt_topic_trie.h"
+
+#define TRIE_MD5_LEN (16)
+
+typedef struct iotx_mc_trie_node_s {
+    struct iotx_mc_trie_node_s *parent;
+    struct iotx_mc_trie_node_s *hash_next;      /* next node of the same bucket */
+    struct iotx_mc_trie_node_s *plus;           /* child of level '+' */
+    struct iotx_mc_trie_node_s *pound;          /* child of level '#' */
+    iotx_mc_topic_handle_t     *handles;        /* handles whose topic filter ends here */
+    uint32_t                    refs;           /* children and handles, the node is freed at 0 */
+    uint32_t                    key_hash;
+    uint16_t                    key_len;
+    char                        key[0];
+} iotx_mc_trie_node_t;
+
+struct iotx_mc_topic_trie_s {
+    iotx_mc_trie_node_t        *root;
+#if WITH_MQTT_ZIP_TOPIC
+    iotx_mc_trie_node_t        *md5_root;       /* md5 of the exact topics, one level */
+#endif
+    iotx_mc_trie_node_t        *bucket[IOTX_MC_TOPIC_TRIE_BUCKET_NUM];
+};
+
+typedef struct {
+    iotx_mc_topic_trie_t       *trie;
+    const char                 *end;
+    iotx_mc_trie_visit_fpt      visit;
+    void                       *arg;
+    int                         num;
+} iotx_mc_trie_match_t;
+
+static uint32_t _trie_hash(const char *key, int len)
+{
+    uint32_t hash = 2166136261u;
+
+    while (len--) {
+        hash = (hash ^ (uint8_t)(*key++)) * 16777619u;
+    }
+
+    return hash;
+}
+
+static uint32_t _trie_bucket(iotx_mc_trie_node_t *parent, uint32_t hash)
+{
+    uintptr_t p = (uintptr_t)parent;
+
+    return (hash ^ (uint32_t)(p >> 3) ^ (uint32_t)(p >> 11)) & (IOTX_MC_TOPIC_TRIE_BUCKET_NUM - 1);
+}
+
+static iotx_mc_trie_node_t *_trie_node_new(const char *key, int len)
+{
+    iotx_mc_trie_node_t *node = mqtt_malloc(sizeof(iotx_mc_trie_node_t) + len);
+
+    if (node == NULL) {
+        return NULL;
+    }
+
+    memset(node, 0, sizeof(iotx_mc_trie_node_t));
+    memcpy(node->key, key, len);
+    node->key_len  = len;
+    node->key_hash = _trie_hash(key, len);
+
+    return node;
+}
+
+static iotx_mc_trie_node_t *_trie_child(iotx_mc_topic_trie_t *trie, iotx_mc_trie_node_t *parent,
+                                        const char *key, int len, uint32_t hash)
+{
+    iotx_mc_trie_node_t *node = trie->bucket[_trie_bucket(parent, hash)];
+
+    for (; node != NULL; node = node->hash_next) {
+        if (node->parent == parent && node->key_hash == hash && node->key_len == len
+            && 0 == memcmp(node->key, key, len)) {
+            return node;
+        }
+    }
+
+    return NULL;
+}
+
+/* find or create the child of one level, wildcard children are also hashed for destroy and prune */
+static iotx_mc_trie_node_t *_trie_get(iotx_mc_topic_trie_t *trie, iotx_mc_trie_node_t *parent,
+                                      const char *key, int len, int wildcard)
+{
+    iotx_mc_trie_node_t *node;
+    uint32_t idx;
+
+    if (wildcard && len == 1 && key[0] == '+' && parent->plus) {
+        return parent->plus;
+    }
+
+    if (wildcard && len == 1 && key[0] == '#' && parent->pound) {
+        return parent->pound;
+    }
+
+    node = _trie_child(trie, parent, key, len, _trie_hash(key, len));
+    if (node) {
+        return node;
+    }
+
+    node = _trie_node_new(key, len);
+    if (node == NULL) {
+        return NULL;
+    }
+
+    node->parent = parent;
+    idx = _trie_bucket(parent, node->key_hash);
+    node->hash_next = trie->bucket[idx];
+    trie->bucket[idx] = node;
+    parent->refs++;
+
+    if (wildcard && len == 1 && key[0] == '+') {
+        parent->plus = node;
+    } else if (wildcard && len == 1 && key[0] == '#') {
+        parent->pound = node;
+    }
+
+    return node;
+}
+
+/* free the nodes which hold neither handle nor child, up to the root */
+static void _trie_prune(iotx_mc_topic_trie_t *trie, iotx_mc_trie_node_t *node)
+{
+    iotx_mc_trie_node_t **pp, *parent;
+
+    while (node->parent != NULL && node->refs == 0) {
+        parent = node->parent;
+
+        pp = &trie->bucket[_trie_bucket(parent, node->key_hash)];
+        while (*pp != node) {
+            pp = &(*pp)->hash_next;
+        }
+        *pp = node->hash_next;
+
+        if (parent->plus == node) {
+            parent->plus = NULL;
+        } else if (parent->pound == node) {
+            parent->pound = NULL;
+        }
+
+        mqtt_free(node);
+        parent->refs--;
+        node = parent;
+    }
+}
+
+iotx_mc_topic_trie_t *iotx_mc_trie_create(void)
+{
+    iotx_mc_topic_trie_t *trie = mqtt_malloc(sizeof(iotx_mc_topic_trie_t));
+
+    if (trie == NULL) {
+        return NULL;
+    }
+
+    memset(trie, 0, sizeof(iotx_mc_topic_trie_t));
+    trie->root = _trie_node_new("", 0);
+    if (trie->root == NULL) {
+        mqtt_free(trie);
+        return NULL;
+    }
+
+#if WITH_MQTT_ZIP_TOPIC
+    trie->md5_root = _trie_node_new("", 0);
+    if (trie->md5_root == NULL) {
+        mqtt_free(trie->root);
+        mqtt_free(trie);
+        return NULL;
+    }
+#endif
+
+    return trie;
+}
+
+void iotx_mc_trie_destroy(iotx_mc_topic_trie_t *trie)
+{
+    iotx_mc_trie_node_t *node, *next;
+    int i;
+
+    if (trie == NULL) {
+        return;
+    }
+
+    for (i = 0; i < IOTX_MC_TOPIC_TRIE_BUCKET_NUM; i++) {
+        for (node = trie->bucket[i]; node != NULL; node = next) {
+            next = node->hash_next;
+            mqtt_free(node);
+        }
+    }
+
+#if WITH_MQTT_ZIP_TOPIC
+    mqtt_free(trie->md5_root);
+#endif
+    mqtt_free(trie->root);
+    mqtt_free(trie);
+}
+
+int iotx_mc_trie_insert(iotx_mc_topic_trie_t *trie, iotx_mc_topic_handle_t *handle)
+{
+    iotx_mc_trie_node_t *node, *next;
+    const char *level, *end;
+
+    if (trie == NULL || handle == NULL || handle->topic_filter == NULL) {
+        return FAIL_RETURN;
+    }
+
+    node = trie->root;
+#if WITH_MQTT_ZIP_TOPIC
+    if (handle->topic_type == TOPIC_NAME_TYPE) {
+        node = _trie_get(trie, trie->md5_root, handle->topic_filter, TRIE_MD5_LEN, 0);
+        if (node == NULL) {
+            return ERROR_MALLOC;
+        }
+    } else
+#endif
+    {
+        level = handle->topic_filter;
+        for (;;) {
+            end = strchr(level, '/');
+            if (end == NULL) {
+                end = level + strlen(level);
+            }
+
+            next = _trie_get(trie, node, level, end - level, 1);
+            if (next == NULL) {
+                _trie_prune(trie, node);
+                return ERROR_MALLOC;
+            }
+            node = next;
+
+            if (*end == '\0') {
+                break;
+            }
+            level = end + 1;
+        }
+    }
+
+    handle->trie_node = node;
+    handle->trie_next = node->handles;
+    node->handles = handle;
+    node->refs++;
+
+    return SUCCESS_RETURN;
+}
+
+void iotx_mc_trie_remove(iotx_mc_topic_trie_t *trie, iotx_mc_topic_handle_t *handle)
+{
+    iotx_mc_trie_node_t *node;
+    iotx_mc_topic_handle_t **hp;
+
+    if (trie == NULL || handle == NULL || handle->trie_node == NULL) {
+        return;
+    }
+
+    node = (iotx_mc_trie_node_t *)handle->trie_node;
+    for (hp = &node->handles; *hp != NULL; hp = &(*hp)->trie_next) {
+        if (*hp == handle) {
+            *hp = handle->trie_next;
+            node->refs--;
+            break;
+        }
+    }
+
+    handle->trie_node = NULL;
+    handle->trie_next = NULL;
+    _trie_prune(trie, node);
+}
+
+static void _trie_visit(iotx_mc_trie_match_t *m, iotx_mc_trie_node_t *node)
+{
+    iotx_mc_topic_handle_t *h;
+
+    for (h = node->handles; h != NULL; h = h->trie_next) {
+        m->visit(h, m->arg);
+        m->num++;
+    }
+}
+
+/* level is NULL when all the levels of the topic are consumed */
+static void _trie_match(iotx_mc_trie_match_t *m, iotx_mc_trie_node_t *node, const char *level)
+{
+    iotx_mc_trie_node_t *child;
+    const char *end, *next;
+    int len;
+
+    if (level == NULL) {
+        _trie_visit(m, node);
+        return;
+    }
+
+    end = memchr(level, '/', m->end - level);
+    next = end ? end + 1 : NULL;
+    len = (end ? end : m->end) - level;
+
+    /* '#' matches the rest of the topic, from a level which must not be empty */
+    if (node->pound && len > 0) {
+        _trie_visit(m, node->pound);
+    }
+
+    child = _trie_child(m->trie, node, level, len, _trie_hash(level, len));
+    if (child && child != node->plus && child != node->pound) {
+        _trie_match(m, child, next);
+    }
+
+    /* '+' matches exactly one level, which must not be empty */
+    if (node->plus && len > 0) {
+        _trie_match(m, node->plus, next);
+    }
+}
+
+int iotx_mc_trie_match(iotx_mc_topic_trie_t *trie, const char *topic, int topic_len, const char *md5,
+                       iotx_mc_trie_visit_fpt visit, void *arg)
+{
+    iotx_mc_trie_match_t m;
+
+    if (trie == NULL || topic == NULL || visit == NULL) {
+        return 0;
+    }
+
+    m.trie  = trie;
+    m.end   = topic + topic_len;
+    m.visit = visit;
+    m.arg   = arg;
+    m.num   = 0;
+
+    _trie_match(&m, trie->root, topic);
+
+#if WITH_MQTT_ZIP_TOPIC
+    if (md5) {
+        iotx_mc_trie_node_t *node = _trie_child(trie, trie->md5_root, md5, TRIE_MD5_LEN, _trie_hash(md5, TRIE_MD5_LEN));
+        if (node) {
+            _trie_visit(&m, node);
+        }
+    }
+#endif
+
+    return m.num;
+}
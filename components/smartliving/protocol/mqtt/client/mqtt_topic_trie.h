@@ -0,0 +1,30 @@
+/*
+ * Copyright (C) 2015-2018 Alibaba Group Holding Limited
+ */
+
+
+
+#ifndef __MQTT_TOPIC_TRIE_H__
+#define __MQTT_TOPIC_TRIE_H__
+
+#include "iotx_mqtt.h"
+
+/* called for every handle which matches the topic */
+typedef void (*iotx_mc_trie_visit_fpt)(iotx_mc_topic_handle_t *handle, void *arg);
+
+/*
+ * The subscribe handles are indexed by the levels of their topic filter, a level of '+' or '#' becomes
+ * a wildcard node. All the exact children of all nodes share one hash table keyed by (parent, level),
+ * so a published topic reaches all the matching handles in O(topic levels), whatever the number of
+ * subscriptions. The trie is not locked, the caller holds the lock of the subscribe list.
+ */
+iotx_mc_topic_trie_t *iotx_mc_trie_create(void);
+void iotx_mc_trie_destroy(iotx_mc_topic_trie_t *trie);
+int iotx_mc_trie_insert(iotx_mc_topic_trie_t *trie, iotx_mc_topic_handle_t *handle);
+void iotx_mc_trie_remove(iotx_mc_topic_trie_t *trie, iotx_mc_topic_handle_t *handle);
+
+/* md5 is only used with WITH_MQTT_ZIP_TOPIC, return the number of matched handles */
+int iotx_mc_trie_match(iotx_mc_topic_trie_t *trie, const char *topic, int topic_len, const char *md5,
+                       iotx_mc_trie_visit_fpt visit, void *arg);
+
+#endif  /* __MQTT_TOPIC_TRIE_H__ */
@@ -46,8 +46,12 @@ typedef struct iotx_mc_topic_handle_s {
     iotx_mqtt_event_handle_t handle;
     iotx_mqtt_qos_t qos;
     struct iotx_mc_topic_handle_s *next;
+    void *trie_node;                                /* node of topic trie this handle hangs on */
+    struct iotx_mc_topic_handle_s *trie_next;       /* next handle of the same trie node */
 } iotx_mc_topic_handle_t;
 
+typedef struct iotx_mc_topic_trie_s iotx_mc_topic_trie_t;
+
 /* Handle structure of subscribed topic */
 typedef struct  {
     char *topic_filter;
@@ -101,6 +105,7 @@ typedef struct Client {
     char                           *buf_send;                                   /* pointer of send buffer */
     char                           *buf_read;                                   /* pointer of read buffer */
     iotx_mc_topic_handle_t         *first_sub_handle;                           /* list of subscribe handle */
+    iotx_mc_topic_trie_t           *sub_trie;                                   /* topic trie of subscribe handle */
     utils_network_pt                ipstack;                                    /* network parameter */
     iotx_time_t                     next_ping_time;                             /* next ping time */
     iotx_mc_state_t                 client_state;                               /* state of MQTT client */
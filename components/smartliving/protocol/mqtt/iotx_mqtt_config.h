@@ -42,6 +42,16 @@
     #define ATHOST_MQTT_REPORT_DISBALED         (1)
 #endif
 
+/* number of hash buckets of the subscribe topic trie, power of 2 */
+#ifndef IOTX_MC_TOPIC_TRIE_BUCKET_NUM
+    #define IOTX_MC_TOPIC_TRIE_BUCKET_NUM       (64)
+#endif
+
+/* dynamic buffers up to this size are kept for the next packet instead of being freed */
+#ifndef IOTX_MC_DYN_BUF_KEEP_LEN
+    #define IOTX_MC_DYN_BUF_KEEP_LEN            (1024)
+#endif
+
 /* maximum republish elements in list */
 #define IOTX_MC_REPUB_NUM_MAX                   (20)
 
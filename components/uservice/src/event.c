@@ -293,6 +293,20 @@ int  eventlist_remove_fd(event_list_t *evlist, uint32_t fd)
     return 0;
 }
 
+int eventlist_has_fd(event_list_t *evlist, uint32_t fd)
+{
+    aos_assert(evlist);
+    if (fd & FD_MASK) {
+        return 0;
+    }
+
+    aos_mutex_lock(&evlist->mutex, AOS_WAIT_FOREVER);
+    event_t *ev = find_event(evlist, fd | FD_MASK);
+    aos_mutex_unlock(&evlist->mutex);
+
+    return ev != NULL;
+}
+
 int eventlist_setfd(event_list_t *evlist, void *data)
 {
     aos_assert(evlist && data);
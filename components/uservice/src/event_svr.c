@@ -26,6 +26,7 @@ static struct event_call {
     aos_task_t   select_task;
     aos_sem_t    select_sem;
     aos_event_t  wait_event;
+    evset_t     *evset;
 } ev_service;
 
 struct event_param {
@@ -45,6 +46,7 @@ enum {
     CMD_REMOVE_EVENT,
     CMD_PUBLISH_EVENT,
     CMD_PUBLISH_FD_EVENT,
+    CMD_CLOSE_FD_EVENT,
 };
 
 #define EVENT_SUBSCRIBE 0x0000FF00
@@ -62,17 +64,28 @@ static int process_rpc(void *context, rpc_t *rpc)
     switch (rpc->cmd_id) {
     case CMD_SUB_FD_EVENT:
         eventlist_subscribe_fd(&ev_service.event, param->event_id, param->cb, param->data);
+        evset_ctl(ev_service.evset, EVSET_CTL_ADD, param->event_id, EVSET_IN);
         aos_sem_signal(&ev_service.select_sem);
         break;
 
     case CMD_REMOVE_FD_EVENT:
         eventlist_unsubscribe_fd(&ev_service.event, param->event_id, param->cb, param->data);
+        if (!eventlist_has_fd(&ev_service.event, param->event_id)) {
+            evset_ctl(ev_service.evset, EVSET_CTL_DEL, param->event_id, 0);
+        }
         break;
 
     case CMD_PUBLISH_FD_EVENT:
         eventlist_publish_fd(&ev_service.event, param->event_id, param->data);
         break;
 
+    case CMD_CLOSE_FD_EVENT:
+        /* the subscriptions end with the socket, unless the fd was subscribed again since */
+        if (evset_ctl(ev_service.evset, EVSET_CTL_MOD, param->event_id, EVSET_IN) != 0) {
+            eventlist_remove_fd(&ev_service.event, param->event_id);
+        }
+        break;
+
     case CMD_SUB_EVENT:
         eventlist_subscribe(&ev_service.event, param->event_id, param->cb, param->data);
         break;
@@ -121,6 +134,7 @@ int event_service_init(utask_t *task)
     eventlist_init(&ev_service.event);
     dlist_init(&ev_service.timeouts);
     aos_sem_new(&ev_service.select_sem, 0);
+    ev_service.evset = evset_new(&ev_service.select_sem);
 
     ev_service.svr = uservice_new("event_svr", process_rpc, NULL);
     aos_event_new(&ev_service.wait_event, 0);
@@ -246,7 +260,6 @@ static int do_time_event()
 #define SELECT_TIMEOUT (10)
 static void select_task_entry(void *arg)
 {
-    event_list_t *evlist = &ev_service.event;
     utask_t *task = ev_service.svr->task;
 
 #if defined(CONFIG_SAL) || defined(CONFIG_TCPIP)
@@ -255,25 +268,19 @@ static void select_task_entry(void *arg)
 #endif
 
     while (1) {
-        fd_set         readfds;
-        struct timeval timeout;
+        evset_event_t evs[FD_MAX_STEMP];
 
         int time_ms = do_time_event();
 
-        int max_fd = eventlist_setfd(evlist, &readfds);
-
-        timeout.tv_sec   = time_ms / 1000;
-        timeout.tv_usec  = (time_ms % 1000) * 1000;
+        /* only the sockets which got an event are returned, no fd scan */
+        int ret = evset_wait(ev_service.evset, evs, FD_MAX_STEMP, time_ms);
+        for (int i = 0; i < ret; i++) {
+            if (evs[i].events & EVSET_HUP) {
+                struct event_param param = { .event_id = evs[i].fd };
 
-        int ret = select2(max_fd + 1, &readfds, NULL, NULL, time_ms == -1 ? NULL : &timeout, &ev_service.select_sem);
-        if (ret > 0) {
-            for (int fd = 0; fd <= max_fd; fd++) {
-                if (FD_ISSET(fd, &readfds)) {
-                    if(aos_queue_get_count(&task->queue) < (task->queue_count*3/4)) {
-                        event_publish_fd(fd, NULL, 1);
-                        // eventlist_remove_fd(evlist, fd);
-                    }
-                }
+                event_call(&param, CMD_CLOSE_FD_EVENT, 1);
+            } else if(aos_queue_get_count(&task->queue) < (task->queue_count*3/4)) {
+                event_publish_fd(evs[i].fd, NULL, 1);
             }
         }
     }
@@ -82,6 +82,7 @@ int  eventlist_subscribe_fd(event_list_t *evlist, uint32_t fd, event_callback_t
 int  eventlist_unsubscribe_fd(event_list_t *evlist, uint32_t fd, event_callback_t cb, void *context);
 int  eventlist_publish_fd(event_list_t *evlist, uint32_t fd, void *data);
 int  eventlist_remove_fd(event_list_t *evlist, uint32_t fd);
+int  eventlist_has_fd(event_list_t *evlist, uint32_t fd);
 
 int  eventlist_setfd(event_list_t *evlist, void *readfds);
 
@@ -88,6 +88,11 @@ int voice_backflow_control(voice_t *v, voice_backflow_id_t id, int flag);
 int voice_mute(voice_t *v, int timeout);
 int voice_unmute(voice_t *v);
 
+/**
+ * @brief  register the cli command "vpcm", voice pcm capture stat
+ */
+void cli_reg_cmd_vpcm(void);
+
 // TODO
 // event control
 // int voice_kws_control(voice_t *v, int flag);
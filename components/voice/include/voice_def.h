@@ -79,6 +79,8 @@ typedef struct {
     void   *ai_param;     // 算法侧参数配置
     int     ai_param_len;
     void   *shm_addr;
+    int     batch_periods; // 每次发送的周期数, 0 使用默认值
+    int     ring_periods;  // 采集环形缓冲周期数, 0 使用默认值
 } voice_param_t;
 
 typedef struct {
@@ -89,6 +91,16 @@ typedef struct {
     int                      len;
 } voice_capture_t;
 
+typedef struct {
+    uint32_t        periods;         /** periods captured into the ring */
+    uint32_t        sends;           /** batches sent to the consumer */
+    uint32_t        overrun;         /** periods dropped because the ring was full */
+    uint32_t        mic_xrun;        /** alsa xrun recovered on mic */
+    uint32_t        ref_xrun;        /** alsa xrun recovered on ref */
+    uint32_t        realign;         /** periods dropped to realign mic and ref */
+    int             skew_ms;         /** last ref - mic capture time */
+} voice_pcm_stat_t;
+
 typedef struct {
     uint8_t         flag;            /** flag for MESSAGE_SYNC and MESSAGE_ACK */
     uint16_t        command;         /** command id the service provide */
@@ -121,6 +133,9 @@ void pcm_deinit(voice_pcm_t *p);
 void pcm_mic_config(voice_pcm_t *p, voice_pcm_param_t *param);
 void pcm_ref_config(voice_pcm_t *p, voice_pcm_param_t *param);
 int pcm_start(voice_pcm_t *p);
+void pcm_batch_config(voice_pcm_t *p, int batch_periods, int ring_periods);
+int pcm_stat_get(voice_pcm_t *p, voice_pcm_stat_t *stat);
+void pcm_stat_clear(voice_pcm_t *p);
 
 #ifdef __cplusplus
 }
@@ -111,6 +111,7 @@ static void voice_pcm_param_init(voice_t *v)
     voice_msg_send(v, VOICE_PCM_PARAM_SET_CMD, (void *)v, sizeof(voice_t), 1);
     if (v->param.ipc_mode == 1) {
         v->pcm = pcm_init(voice_data_send, v);
+        pcm_batch_config(v->pcm, v->param.batch_periods, v->param.ring_periods);
         pcm_mic_config(v->pcm, v->mic_param);
         pcm_ref_config(v->pcm, v->ref_param);
         pcm_start(v->pcm);
@@ -31,6 +31,7 @@ struct __voice {
     int                      state;
     volatile int             task_running;
     voice_data_t             *pcm_data;
+    int                      pcm_data_size;
     voice_data_t             *backflow_data[VOCIE_BACKFLOW_DATA];
     int                      backflow_enable[VOCIE_BACKFLOW_DATA];
 
@@ -71,8 +72,10 @@ static int voice_msg_send(voice_t *v, int cmd, void *data, int len, int sync)
 
 static void pcm_data_update(voice_t *v, void *data, int len)
 {
-    if (v->pcm_data == NULL) {
+    if (v->pcm_data == NULL || v->pcm_data_size < len) {
+        aos_free(v->pcm_data);
         v->pcm_data = aos_malloc_check(len + sizeof(voice_data_t));
+        v->pcm_data_size = len;
     }
 
     memcpy(v->pcm_data->data, data, len);
@@ -168,21 +171,38 @@ static void voice_ch_deinit(voice_t *v)
 
 }
 
-static void *pcm_ref_get(voice_t *v, int ms)
+static int pcm_period_len(voice_t *v)
+{
+    int len = v->mic_param->period_bytes;
+
+    if (v->ref_param) {
+        len += v->ref_param->period_bytes;
+    }
+
+    return len;
+}
+
+/* the ap side may batch several [mic|ref] periods in one message */
+static int pcm_period_num(voice_t *v)
+{
+    return v->pcm_data->len / pcm_period_len(v);
+}
+
+static void *pcm_ref_get(voice_t *v, int idx)
 {
     void *ref;
     voice_pcm_param_t *p = v->mic_param;
 
-    int offset = p->period_bytes;
+    int offset = idx * pcm_period_len(v) + p->period_bytes;
 
     ref = ((char *)v->pcm_data->data + offset);
 
     return ref;
 }
 
-static void *pcm_mic_get(voice_t *v, int ms)
+static void *pcm_mic_get(voice_t *v, int idx)
 {
-    void *mic = (void **)v->pcm_data->data;
+    void *mic = (char *)v->pcm_data->data + idx * pcm_period_len(v);
 
     return mic;
 }
@@ -219,7 +239,7 @@ static int voice_wait_pcm(voice_t *v, int ms)
 
 static void voice_entry(void *p)
 {
-    int ret;
+    int ret, i;
     voice_t *v = (voice_t *)p;
     int ms = v->param.cts_ms;
     void *mic;
@@ -229,9 +249,13 @@ static void voice_entry(void *p)
     voice_ops(v)->init(v->priv);
 
     while (v->task_running) {
-        if (voice_wait_pcm(v, ms) == 0) {
-            mic = pcm_mic_get(v, ms);
-            ref = pcm_ref_get(v, ms);
+        if (voice_wait_pcm(v, ms) != 0) {
+            continue;
+        }
+
+        for (i = 0; i < pcm_period_num(v); i++) {
+            mic = pcm_mic_get(v, i);
+            ref = pcm_ref_get(v, i);
 
             voice_data_send(v, VOICE_MIC_DATA, mic, v->mic_param->period_bytes, 0);
             voice_data_send(v, VOICE_REF_DATA, ref, v->ref_param->period_bytes, 0);
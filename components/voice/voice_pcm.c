@@ -15,15 +15,39 @@
 #include <voice_def.h>
 
 #define TAG                    "voice"
+
+#ifndef CONFIG_VOICE_PCM_BATCH
+#define CONFIG_VOICE_PCM_BATCH 1
+#endif
+
+#ifndef CONFIG_VOICE_PCM_RING
+#define CONFIG_VOICE_PCM_RING  4
+#endif
+
 struct __voice_pcm {
     void                    *priv;
     voice_capture_t         *mic;
     voice_capture_t         *ref;
-    void                    *data;
-    int                      len;
+    void                    *data;     /* ring of ring_num periods + one drop period */
+    int                      len;      /* bytes of one period, mic + ref */
+    int                      batch;    /* periods per pcm_send */
+    int                      ring_num; /* ring periods, multiple of batch */
+    volatile uint32_t        wr;       /* periods captured */
+    volatile uint32_t        rd;       /* periods sent */
+    aos_sem_t                sem;
+    aos_sem_t                send_exit;
+    aos_sem_t                exit_sem;
+    volatile int             quit;     /* set by pcm_deinit, the tasks exit */
+    int                      started;
     voice_pcm_send           pcm_send;
+    int                      skew_base;
+    int                      skew_valid;
+    voice_pcm_stat_t         stat;     /* written by the two tasks only */
+    volatile uint32_t        stat_clear; /* clears asked by pcm_stat_clear, served by the tasks */
 };
 
+static voice_pcm_t *g_vpcm;
+
 static aos_pcm_t *_param_init(voice_pcm_t *vpcm, char *name, voice_pcm_param_t *p)
 {
     if (name == NULL || p == NULL) {
@@ -95,7 +119,7 @@ static int pcm_alsa_start(voice_pcm_t *p)
 
 #ifdef VOICE_DEBUG
 int g_hello_offset = 0;
-static int pcm_recv(aos_pcm_t *pcm, void *data, int len, int access)
+static int pcm_recv(aos_pcm_t *pcm, void *data, int len, int access, uint32_t *xrun)
 {
     if ((len + g_hello_offset) >= local_audio_nhxb_len) {
         g_hello_offset = 0;
@@ -109,7 +133,7 @@ static int pcm_recv(aos_pcm_t *pcm, void *data, int len, int access)
 }
 #else
 // static char test_data[1024*4];
-static int pcm_recv(aos_pcm_t *pcm, void *data, int len, int access)
+static int pcm_recv(aos_pcm_t *pcm, void *data, int len, int access, uint32_t *xrun)
 {
     int ret = -1;
 
@@ -118,6 +142,7 @@ static int pcm_recv(aos_pcm_t *pcm, void *data, int len, int access)
 
         if (ret < 0) {
             aos_pcm_recover(pcm, ret, 1);
+            (*xrun)++;
             continue;
         }
 
@@ -140,66 +165,211 @@ static int pcm_recv(aos_pcm_t *pcm, void *data, int len, int access)
     return aos_pcm_frames_to_bytes(pcm, ret);
 }
 #endif
+
+static void *pcm_period_addr(voice_pcm_t *p, int idx)
+{
+    return (char *)p->data + idx * p->len;
+}
+
+static void pcm_capture_bind(voice_pcm_t *p, void *period)
+{
+    p->mic->data = period;
+
+    if (p->ref) {
+        p->ref->data = (char *)period + p->mic->len;
+    }
+}
+
 static void pcm_buffer_init(voice_pcm_t *pcm)
 {
     int mic_len = 0;
     int ref_len = 0;
 
-    if (pcm == NULL || pcm->mic == NULL || pcm->ref == NULL) {
+    if (pcm == NULL || pcm->mic == NULL) {
         return;
     }
 
-    if (pcm->mic) {
-        voice_pcm_param_t *p = pcm->mic->param;
-        mic_len = p->period_bytes;
-    }
+    mic_len = pcm->mic->param->period_bytes;
 
     if (pcm->ref) {
-        voice_pcm_param_t *p =pcm->ref->param;
-        ref_len = p->period_bytes;
+        ref_len = pcm->ref->param->period_bytes;
+    }
+
+    if (pcm->batch <= 0) {
+        pcm->batch = CONFIG_VOICE_PCM_BATCH;
+    }
+
+    if (pcm->ring_num < pcm->batch * 2) {
+        pcm->ring_num = CONFIG_VOICE_PCM_RING > pcm->batch * 2 ? CONFIG_VOICE_PCM_RING : pcm->batch * 2;
     }
 
-    pcm->data = voice_malloc(mic_len + ref_len);
+    /* keep every batch contiguous so that it can be sent without copy */
+    pcm->ring_num = (pcm->ring_num + pcm->batch - 1) / pcm->batch * pcm->batch;
+
     pcm->len = mic_len + ref_len;
+    pcm->data = voice_malloc(pcm->len * (pcm->ring_num + 1));
     pcm->mic->len = mic_len;
-    pcm->mic->data = pcm->data;
 
-    if (pcm && pcm->ref && pcm->ref->param) {
-        pcm->ref->data = (char *)pcm->data + mic_len;
+    if (pcm->ref) {
         pcm->ref->len = ref_len;
     }
+
+    pcm->wr = 0;
+    pcm->rd = 0;
+    pcm_capture_bind(pcm, pcm_period_addr(pcm, 0));
 }
 
 static void pcm_buffer_deinit(voice_pcm_t *p)
 {
-    aos_free(p->mic->param);
-    aos_free(p->ref->param);
-    aos_free(p->mic);
-    aos_free(p->ref);
+    if (p->mic) {
+        aos_free(p->mic->param);
+        aos_free(p->mic);
+    }
+
+    if (p->ref) {
+        aos_free(p->ref->param);
+        aos_free(p->ref);
+    }
+
     voice_free(p->data);
 }
 
+static int pcm_period_ms(voice_capture_t *capture)
+{
+    voice_pcm_param_t *p = capture->param;
+
+    return p->period_bytes * 1000 / (p->rate * p->channles_sum * p->sample_bits / 8);
+}
+
+/*
+ * mic and ref are clocked together, so the gap between their read completions is stable.
+ * When it moves by more than half a period one stream has a period backlog (e.g. after an
+ * xrun), the stream that returned early holds the older data and one period of it is dropped.
+ */
+static void pcm_align(voice_pcm_t *p, long long mic_ts, long long ref_ts)
+{
+    voice_capture_t *capture;
+    int skew = (int)(ref_ts - mic_ts);
+    int half = pcm_period_ms(p->mic) / 2;
+    uint32_t *xrun;
+
+    p->stat.skew_ms = skew;
+
+    if (!p->skew_valid) {
+        p->skew_base  = skew;
+        p->skew_valid = 1;
+        return;
+    }
+
+    if (skew - p->skew_base > half) {
+        capture = p->mic;
+        xrun    = &p->stat.mic_xrun;
+    } else if (p->skew_base - skew > half) {
+        capture = p->ref;
+        xrun    = &p->stat.ref_xrun;
+    } else {
+        return;
+    }
+
+    pcm_capture_bind(p, pcm_period_addr(p, p->ring_num));
+    pcm_recv(capture->hdl, capture->data, capture->len, capture->param->access, xrun);
+    p->stat.realign++;
+    p->skew_valid = 0;
+}
+
+static void pcm_send_entry(void *priv)
+{
+    voice_pcm_t *p = (voice_pcm_t *)priv;
+    uint32_t cleared = 0;
+
+    while (1) {
+        aos_sem_wait(&p->sem, AOS_WAIT_FOREVER);
+
+        if (p->quit) {
+            break;
+        }
+
+        if (cleared != p->stat_clear) {
+            cleared = p->stat_clear;
+            p->stat.sends = 0;
+        }
+
+        while (p->wr - p->rd >= p->batch) {
+            p->pcm_send(p->priv, pcm_period_addr(p, p->rd % p->ring_num), p->len * p->batch);
+            p->rd += p->batch;
+            p->stat.sends++;
+        }
+    }
+
+    aos_sem_signal(&p->send_exit);
+    aos_task_exit(0);
+}
+
 static void pcm_entry(void *priv)
 {
     voice_pcm_t *p = (voice_pcm_t *)priv;
     int ret = -1;
     voice_capture_t *capture;
+    long long mic_ts, ref_ts = 0;
+    aos_task_t task;
+    uint32_t cleared = 0;
+    int full;
 
     pcm_buffer_init(p);
     pcm_alsa_start(p);
 
-    while (1) {
+    aos_task_new_ext(&task, "vpcm_send", pcm_send_entry, p, 2 * 1024, AOS_DEFAULT_APP_PRI - 3);
+
+    while (!p->quit) {
+        /* the counters of this task, the sender clears its own */
+        if (cleared != p->stat_clear) {
+            cleared = p->stat_clear;
+            p->stat.periods  = 0;
+            p->stat.overrun  = 0;
+            p->stat.mic_xrun = 0;
+            p->stat.ref_xrun = 0;
+            p->stat.realign  = 0;
+        }
+
+        /* never wait for the consumer, a full ring drops the period instead */
+        full = (p->wr - p->rd >= p->ring_num);
+        pcm_capture_bind(p, pcm_period_addr(p, full ? p->ring_num : p->wr % p->ring_num));
+
         capture = p->mic;
-        ret = pcm_recv(capture->hdl, capture->data, capture->len,capture->param->access);
+        ret = pcm_recv(capture->hdl, capture->data, capture->len,capture->param->access, &p->stat.mic_xrun);
+        mic_ts = aos_now_ms();
         capture = p->ref;
         if (capture) {
-            ret = pcm_recv(capture->hdl, capture->data, capture->len,capture->param->access);
+            ret = pcm_recv(capture->hdl, capture->data, capture->len,capture->param->access, &p->stat.ref_xrun);
+            ref_ts = aos_now_ms();
+        }
+
+        if (ret < 0) {
+            continue;
+        }
+
+        if (full) {
+            p->stat.overrun++;
+        } else {
+            p->wr++;
+            p->stat.periods++;
+
+            if (p->wr % p->batch == 0) {
+                aos_sem_signal(&p->sem);
+            }
         }
 
-        if (ret >= 0) {
-            p->pcm_send(p->priv, p->data, p->len);
+        if (p->ref) {
+            pcm_align(p, mic_ts, ref_ts);
         }
     }
+
+    /* the sender goes first, it reads the ring */
+    aos_sem_signal(&p->sem);
+    aos_sem_wait(&p->send_exit, AOS_WAIT_FOREVER);
+
+    aos_sem_signal(&p->exit_sem);
+    aos_task_exit(0);
 }
 
 voice_pcm_t *pcm_init(voice_pcm_send send, void *priv)
@@ -208,13 +378,67 @@ voice_pcm_t *pcm_init(voice_pcm_send send, void *priv)
 
     p->pcm_send = send;
     p->priv     = priv;
+    p->batch    = CONFIG_VOICE_PCM_BATCH;
+    p->ring_num = CONFIG_VOICE_PCM_RING;
+
+    g_vpcm = p;
 
     return p;
 }
 
 void pcm_deinit(voice_pcm_t *p)
 {
+    if (p == NULL) {
+        return;
+    }
+
+    if (g_vpcm == p) {
+        g_vpcm = NULL;
+    }
+
+    /* the capture task exits after its current period, once the sender is gone */
+    if (p->started) {
+        p->quit = 1;
+        aos_sem_wait(&p->exit_sem, AOS_WAIT_FOREVER);
+        aos_sem_free(&p->sem);
+        aos_sem_free(&p->send_exit);
+        aos_sem_free(&p->exit_sem);
+    }
+
     pcm_buffer_deinit(p);
+    aos_free(p);
+}
+
+void pcm_batch_config(voice_pcm_t *p, int batch_periods, int ring_periods)
+{
+    if (batch_periods > 0) {
+        p->batch = batch_periods;
+    }
+
+    if (ring_periods > 0) {
+        p->ring_num = ring_periods;
+    }
+}
+
+int pcm_stat_get(voice_pcm_t *p, voice_pcm_stat_t *stat)
+{
+    if (p == NULL || stat == NULL) {
+        return -1;
+    }
+
+    memcpy(stat, &p->stat, sizeof(voice_pcm_stat_t));
+
+    return 0;
+}
+
+void pcm_stat_clear(voice_pcm_t *p)
+{
+    if (p == NULL) {
+        return;
+    }
+
+    /* the tasks own the counters, each clears its own on the next period */
+    p->stat_clear++;
 }
 
 void pcm_mic_config(voice_pcm_t *p, voice_pcm_param_t *param)
@@ -254,12 +478,23 @@ void pcm_ref_config(voice_pcm_t *p, voice_pcm_param_t *param)
 int pcm_start(voice_pcm_t *p)
 {
     aos_task_t task;
-    int ret = aos_task_new_ext(&task, "vpcm", pcm_entry, p, 2 * 1024, AOS_DEFAULT_APP_PRI - 4);
+    int ret;
+
+    aos_sem_new(&p->sem, 0);
+    aos_sem_new(&p->send_exit, 0);
+    aos_sem_new(&p->exit_sem, 0);
+
+    ret = aos_task_new_ext(&task, "vpcm", pcm_entry, p, 2 * 1024, AOS_DEFAULT_APP_PRI - 4);
 
     if (ret < 0) {
+        aos_sem_free(&p->sem);
+        aos_sem_free(&p->send_exit);
+        aos_sem_free(&p->exit_sem);
         return -1;
     }
 
+    p->started = 1;
+
     return 0;
 }
 
@@ -269,7 +504,7 @@ int pcm_stop(voice_pcm_t *p)
         pcm_alsa_stop(p->mic->hdl);
     }
 
-    if (p->ref->hdl) {
+    if (p->ref && p->ref->hdl) {
         pcm_alsa_stop(p->ref->hdl);
     }
 
@@ -277,3 +512,40 @@ int pcm_stop(voice_pcm_t *p)
     return 0;
 }
 
+#ifdef AOS_COMP_CLI
+#include <aos/cli.h>
+
+static void cmd_vpcm_func(char *wbuf, int wbuf_len, int argc, char **argv)
+{
+    voice_pcm_stat_t stat;
+
+    if (pcm_stat_get(g_vpcm, &stat) < 0) {
+        printf("voice pcm not started\n");
+        return;
+    }
+
+    if (argc > 1 && strcmp(argv[1], "clear") == 0) {
+        pcm_stat_clear(g_vpcm);
+        return;
+    }
+
+    printf("batch   : %d/%d periods\n", g_vpcm->batch, g_vpcm->ring_num);
+    printf("periods : %u\n", stat.periods);
+    printf("sends   : %u\n", stat.sends);
+    printf("overrun : %u\n", stat.overrun);
+    printf("xrun    : mic %u, ref %u\n", stat.mic_xrun, stat.ref_xrun);
+    printf("realign : %u (skew %d ms)\n", stat.realign, stat.skew_ms);
+}
+
+void cli_reg_cmd_vpcm(void)
+{
+    static const struct cli_command cmd_info = {
+        "vpcm",
+        "voice pcm capture stat, vpcm [clear]",
+        cmd_vpcm_func
+    };
+
+    aos_cli_register_command(&cmd_info);
+}
+#endif
+
@@ -27,6 +27,8 @@
 #include "librws.h"
 #include "rws_common.h"
 
+#define RWS_FRAME_HEADER_MAX 14 // 2 + 8 bytes length + 4 bytes mask
+
 typedef enum _rws_opcode {
     rws_opcode_continuation = 0x0, // %x0 denotes a continuation frame
     rws_opcode_text_frame = 0x1, // %x1 denotes a text frame
@@ -54,16 +56,21 @@ typedef struct _rws_frame_struct {
 
 size_t rws_check_recv_frame_size(const void * data, const size_t data_size);
 
-_rws_frame * rws_frame_create_with_recv_data(const void * data, const size_t data_size);
+// dst = src ^ mask, a word at a time. 'offset' is the payload position of src[0], dst may be src
+void rws_frame_mask_copy(void * dst, const void * src, const size_t data_size, const unsigned char mask[4], size_t offset);
 
-// data - should be null, and setted by newly created. 'data' & 'data_size' can be null
-void rws_frame_fill_with_send_data(_rws_frame * f, const void * data, const size_t data_size, rws_bool is_finish);
+_rws_frame * rws_frame_create_with_recv_data(const void * data, const size_t data_size);
 
-void litews_frame_fill_with_send_bin_data(_rws_frame * f, const void * data, const size_t data_size, rws_binary bin_type);
+// writes the header and the payload (masked if 'f->is_masked') to 'dst', which holds
+// RWS_FRAME_HEADER_MAX + 'data_size' bytes. 'data' can be null. returns the frame size
+size_t rws_frame_write_send_data(_rws_frame * f, void * dst, const void * data, const size_t data_size, rws_bool is_finish);
 
 // combine datas of 2 frames. combined is 'to'
 void rws_frame_combine_datas(_rws_frame * to, _rws_frame * from);
 
+// zeroed with a new random mask
+void rws_frame_init(_rws_frame * f);
+
 _rws_frame * rws_frame_create(void);
 
 void rws_frame_delete(_rws_frame * f);
@@ -57,6 +57,10 @@ typedef int rws_socket_t;
 #define RWS_INVALID_SOCKET -1
 #define RWS_SOCK_CLOSE(sock) close(sock)
 
+#ifndef RWS_SEND_BUF_SIZE
+#define RWS_SEND_BUF_SIZE 4096 // send buffer kept between the writes, a larger one is freed after the write
+#endif
+
 #ifdef WEBSOCKET_SSL_ENABLE
 typedef struct _rws_ssl_struct {
     mbedtls_ssl_context ssl_ctx;        /* mbedtls ssl context */
@@ -103,9 +107,12 @@ struct rws_socket_struct {
     size_t received_size; // size of 'received' memory
     size_t received_len; // length of actualy readed message
 
-    _rws_list * send_frames;
     _rws_list * recvd_frames;
 
+    void * send_buf; // the queued frames, built in place and written at once
+    size_t send_buf_size;
+    size_t send_buf_len;
+
     int max_send_append_size;
     int send_append_size;
 
@@ -177,8 +184,6 @@ void rws_socket_resize_received(rws_socket s, const size_t size);
 
 void rws_socket_append_recvd_frames(rws_socket s, _rws_frame * frame);
 
-void rws_socket_append_send_frames(rws_socket s, _rws_frame * frame);
-
 rws_bool rws_socket_send_text_priv(rws_socket s, const char * text);
 rws_bool rws_socket_send_text_priv2(rws_socket s, const char * text, size_t len);
 
@@ -26,9 +26,45 @@
 
 #include <aos/debug.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 #include <time.h>
 
+typedef unsigned long rws_word; // native register width, 32 or 64 bits
+
+void rws_frame_mask_copy(void * dst, const void * src, const size_t data_size, const unsigned char mask[4], size_t offset)
+{
+    unsigned char * d = (unsigned char *)dst;
+    const unsigned char * sp = (const unsigned char *)src;
+    unsigned char rot[sizeof(rws_word)];
+    rws_word wmask, w;
+    size_t index = 0, i;
+
+    // bytes up to the first word aligned destination
+    while (index < data_size && ((uintptr_t)(d + index) & (sizeof(rws_word) - 1))) {
+        d[index] = sp[index] ^ mask[(offset + index) & 0x3];
+        index++;
+    }
+
+    if (data_size - index >= sizeof(rws_word)) {
+        // the mask as it lines up with the aligned words, byte order independent
+        for (i = 0; i < sizeof(rws_word); i++) {
+            rot[i] = mask[(offset + index + i) & 0x3];
+        }
+        memcpy(&wmask, rot, sizeof(rws_word));
+
+        for (; index + sizeof(rws_word) <= data_size; index += sizeof(rws_word)) {
+            // source may be unaligned, memcpy becomes a plain load where allowed
+            memcpy(&w, sp + index, sizeof(rws_word));
+            *(rws_word *)(d + index) = w ^ wmask;
+        }
+    }
+
+    for (; index < data_size; index++) {
+        d[index] = sp[index] ^ mask[(offset + index) & 0x3];
+    }
+}
+
 _rws_frame * rws_frame_create_with_recv_data(const void * data, const size_t data_size)
 {
     if (data && data_size >= 2) {
@@ -41,10 +77,8 @@ _rws_frame * rws_frame_create_with_recv_data(const void * data, const size_t dat
         unsigned int header_size = is_masked ? 6 : 2;
 
         unsigned int expected_size = 0, mask_pos = 0;
-        size_t index = 0;
         _rws_frame * frame = NULL;
         const unsigned char * actual_udata = NULL;
-        unsigned char * unmasked = NULL;
 
         switch (payload) {
         case 126:
@@ -108,12 +142,7 @@ _rws_frame * rws_frame_create_with_recv_data(const void * data, const size_t dat
             frame->data_size = expected_size;
             actual_udata = udata + header_size;
             if (is_masked) {
-                unmasked = (unsigned char *)frame->data;
-                for (index = 0; index < expected_size; index++) {
-                    *unmasked = *actual_udata ^ frame->mask[index & 0x3];
-                    unmasked++;
-                    actual_udata++;
-                }
+                rws_frame_mask_copy(frame->data, actual_udata, expected_size, frame->mask, 0);
             } else {
                 memcpy(frame->data, actual_udata, expected_size);
             }
@@ -141,7 +170,8 @@ void rws_frame_create_header(_rws_frame * f, unsigned char * header, const size_
     } else {
         *header++ = 127 | (f->is_masked ? 0x80 : 0);
 
-        *(unsigned int *)header = 0;
+        // header may start at any offset of the send buffer
+        memset(header, 0, 4);
         header += 4;
 
         *header++ = (size >> 24) & 0xff;
@@ -157,121 +187,24 @@ void rws_frame_create_header(_rws_frame * f, unsigned char * header, const size_
     }
 }
 
-void litews_frame_create_bin_header(_rws_frame * f, unsigned char * header, const size_t data_size, rws_binary bin_type)
+size_t rws_frame_write_send_data(_rws_frame * f, void * dst, const void * data, const size_t data_size, rws_bool is_finish)
 {
-    const unsigned int size = (unsigned int)data_size;
-
-    if(bin_type == rws_binary_start) {
-        *header++ = 0x00 | f->opcode;
-    } else if(bin_type == rws_binary_continue) {
-        *header++ = 0x00 | f->opcode;
-    } else {
-        *header++ = 0x80 | f->opcode;
-    }
-
-    if (size < 126) {
-        *header++ = (size & 0xff) | (f->is_masked ? 0x80 : 0);
-        f->header_size = 2;
-    } else if (size < 65536) {
-        *header++ = 126 | (f->is_masked ? 0x80 : 0);
-        *header++ = (size >> 8) & 0xff;
-        *header++ = size & 0xff;
-        f->header_size = 4;
-    } else {
-        *header++ = 127 | (f->is_masked ? 0x80 : 0);
-
-        *(unsigned int *)header = 0;
-        header += 4;
-
-        *header++ = (size >> 24) & 0xff;
-        *header++ = (size >> 16) & 0xff;
-        *header++ = (size >> 8) & 0xff;
-        *header++ = size & 0xff;
-        f->header_size = 10;
-    }
-
-    if (f->is_masked) {
-        memcpy(header, f->mask, 4);
-        f->header_size += 4;
-    }
-}
-
-void rws_frame_fill_with_send_data(_rws_frame * f, const void * data, const size_t data_size, rws_bool is_finish)
-{
-    unsigned char header[16];
-    unsigned char * frame = NULL;
-    unsigned char mask[4];
-    size_t index = 0;
+    unsigned char * frame = (unsigned char *)dst;
 
     f->is_finished = is_finish;
-    rws_frame_create_header(f, header, data_size);
-    f->data_size = data_size + f->header_size;
-    f->data = rws_malloc(f->data_size);
-    if (f->data == NULL) {
-        printf("rws_malloc fail\n");
-        return;
-    }
-    frame = (unsigned char *)f->data;
-    memcpy(frame, header, f->header_size);
+    rws_frame_create_header(f, frame, data_size);
 
     if (data) { // have data to send
         frame += f->header_size;
-        memcpy(frame, data, data_size);
-
-        if (f->is_masked) {
-            memcpy(mask, &f->mask, 4);
-            for (index = 0; index < data_size; index++) {
-                *frame = *frame ^ mask[index & 0x3];
-                frame++;
-            }
-        }
-    }
-    // f->is_finished = is_finish;
-}
-
-void litews_frame_fill_with_send_bin_data(_rws_frame * f, const void * data, const size_t data_size, rws_binary bin_type)
-{
-    unsigned char header[16];
-    unsigned char * frame = NULL;
-    unsigned char mask[4];
-    size_t index = 0;
-
-    litews_frame_create_bin_header(f, header, data_size, bin_type);
-
-    //check bin header data
-    //  -----------------------------------------------
-    //   F  |   |   |   |   |   |   |   |
-    //   I  | 0 | 0 | 0 |    OPCODE     |
-    //   N  |   |   |   |   |   |   |   |
-
-    f->data_size = data_size + f->header_size;
-    f->data = rws_malloc(f->data_size);
-    if (f->data == NULL) {
-        DBG("rws_malloc fail\n");
-        return;
-    }
-    frame = (unsigned char *)f->data;
-    memcpy(frame, header, f->header_size);
-
-    if (data) {
-        // have data to send
-        frame += f->header_size;
-        memcpy(frame, data, data_size);
-
         if (f->is_masked) {
-            memcpy(mask, &f->mask, 4);
-            for (index = 0; index < data_size; index++) {
-                *frame = *frame ^ mask[index & 0x3];
-                frame++;
-            }
+            // copy and mask in one pass
+            rws_frame_mask_copy(frame, data, data_size, f->mask, 0);
+        } else {
+            memcpy(frame, data, data_size);
         }
     }
 
-    if(bin_type == rws_binary_finish) {
-        f->is_finished = rws_true;
-    } else {
-        f->is_finished = rws_false;
-    }
+    return f->header_size + data_size;
 }
 
 void rws_frame_combine_datas(_rws_frame * to, _rws_frame * from)
@@ -291,9 +224,8 @@ void rws_frame_combine_datas(_rws_frame * to, _rws_frame * from)
     to->data_size += from->data_size;
 }
 
-_rws_frame * rws_frame_create(void)
+void rws_frame_init(_rws_frame * f)
 {
-    _rws_frame * f = (_rws_frame *)rws_malloc_zero(sizeof(_rws_frame));
     union {
         unsigned int ui;
         unsigned char b[4];
@@ -301,7 +233,16 @@ _rws_frame * rws_frame_create(void)
     aos_assert(sizeof(unsigned int) == 4);
     //	mask_union.ui = 2018915346;
     mask_union.ui = (rand() / (RAND_MAX / 2) + 1) * rand();
+    memset(f, 0, sizeof(_rws_frame));
     memcpy(f->mask, mask_union.b, 4);
+}
+
+_rws_frame * rws_frame_create(void)
+{
+    _rws_frame * f = (_rws_frame *)rws_malloc_zero(sizeof(_rws_frame));
+    if (f) {
+        rws_frame_init(f);
+    }
     return f;
 }
 
@@ -102,6 +102,39 @@ static rws_bool rws_socket_mem_used_out(rws_socket s, int data_size)
     return rws_false;
 }
 
+// builds the frame in place at the end of the send buffer, the buffer grows when it is short
+static rws_bool rws_socket_append_send_data(rws_socket s, rws_opcode opcode, const void * data, const size_t data_size, rws_bool is_finish)
+{
+    size_t need = s->send_buf_len + RWS_FRAME_HEADER_MAX + data_size;
+    size_t size = s->send_buf_size ? s->send_buf_size : RWS_SEND_BUF_SIZE;
+    void * buf = NULL;
+    _rws_frame frame;
+
+    if (need > s->send_buf_size) {
+        while (size < need) {
+            size *= 2;
+        }
+        buf = rws_malloc(size);
+        if (buf == NULL) {
+            DBG("rws_malloc fail\n");
+            return rws_false;
+        }
+        if (s->send_buf_len) {
+            memcpy(buf, s->send_buf, s->send_buf_len);
+        }
+        rws_free(s->send_buf);
+        s->send_buf = buf;
+        s->send_buf_size = size;
+    }
+
+    rws_frame_init(&frame);
+    frame.is_masked = rws_true;
+    frame.opcode = opcode;
+    s->send_buf_len += rws_frame_write_send_data(&frame, (unsigned char *)s->send_buf + s->send_buf_len, data, data_size, is_finish);
+
+    return rws_true;
+}
+
 unsigned int rws_socket_get_next_message_id(rws_socket s)
 {
     const unsigned int mess_id = ++s->next_message_id;
@@ -115,14 +148,12 @@ void rws_socket_send_ping(rws_socket s)
 {
     char buff[16];
     size_t len = 0;
-    _rws_frame * frame = rws_frame_create();
 
     len = rws_sprintf(buff, 16, "%u", rws_socket_get_next_message_id(s));
 
-    frame->is_masked = rws_true;
-    frame->opcode = rws_opcode_ping;
-    rws_frame_fill_with_send_data(frame, buff, len, rws_true);
-    rws_socket_append_send_frames(s, frame);
+    rws_mutex_lock(s->send_mutex);
+    rws_socket_append_send_data(s, rws_opcode_ping, buff, len, rws_true);
+    rws_mutex_unlock(s->send_mutex);
 }
 
 #if 0
@@ -416,12 +447,10 @@ void rws_socket_process_pong_frame(rws_socket s, _rws_frame * frame)
 
 void rws_socket_process_ping_frame(rws_socket s, _rws_frame * frame)
 {
-    _rws_frame * pong_frame = rws_frame_create();
-    pong_frame->opcode = rws_opcode_pong;
-    pong_frame->is_masked = rws_true;
-    rws_frame_fill_with_send_data(pong_frame, frame->data, frame->data_size, rws_true);
+    rws_mutex_lock(s->send_mutex);
+    rws_socket_append_send_data(s, rws_opcode_pong, frame->data, frame->data_size, rws_true);
+    rws_mutex_unlock(s->send_mutex);
     rws_frame_delete(frame);
-    rws_socket_append_send_frames(s, pong_frame);
 }
 
 void rws_socket_process_conn_close_frame(rws_socket s, _rws_frame * frame)
@@ -493,30 +522,27 @@ void rws_socket_idle_recv(rws_socket s)
 
 void rws_socket_idle_send(rws_socket s)
 {
-    _rws_node * cur = NULL;
-    rws_bool sending = rws_true;
-    _rws_frame * frame = NULL;
-
     rws_mutex_lock(s->send_mutex);
-    cur = s->send_frames;
-    if (cur) {
-        while (cur && s->is_connected && sending) {
-            frame = (_rws_frame *)cur->value.object;
-            cur->value.object = NULL;
-            if (frame) {
-                sending = rws_socket_send(s, frame->data, frame->data_size);
+    if (s->send_buf_len) {
+        if (s->is_connected && !rws_socket_send(s, s->send_buf, s->send_buf_len)) {
+            // the frames are lost with the connection, not kept for a resend
+            if (!s->error) {
+                s->error = rws_error_new_code_descr(rws_error_code_read_write_socket, "Send frames");
             }
-            rws_frame_delete(frame);
-            cur = cur->next;
         }
-        rws_socket_delete_all_frames_in_list(s->send_frames);
-        rws_list_delete_clean(&s->send_frames);
-        s->send_append_size = 0;
-        
+        s->send_buf_len = 0;
+
+        // a buffer grown by a burst is not kept
+        if (s->send_buf_size > RWS_SEND_BUF_SIZE) {
+            rws_free_clean(&s->send_buf);
+            s->send_buf_size = 0;
+        }
+
         if (s->error) {
             s->command = COMMAND_INFORM_DISCONNECTED;
         }
     }
+    s->send_append_size = 0;
     rws_mutex_unlock(s->send_mutex);
 }
 
@@ -548,16 +574,17 @@ void rws_socket_wait_handshake_responce(rws_socket s)
 void rws_socket_send_disconnect(rws_socket s)
 {
     char buff[16];
+    unsigned char data[RWS_FRAME_HEADER_MAX + 16];
     size_t len = 0;
-    _rws_frame * frame = rws_frame_create();
+    _rws_frame frame;
 
     len = rws_sprintf(buff, 16, "%u", rws_socket_get_next_message_id(s));
 
-    frame->is_masked = rws_true;
-    frame->opcode = rws_opcode_connection_close;
-    rws_frame_fill_with_send_data(frame, buff, len, rws_true);
-    rws_socket_send(s, frame->data, frame->data_size);
-    rws_frame_delete(frame);
+    rws_frame_init(&frame);
+    frame.is_masked = rws_true;
+    frame.opcode = rws_opcode_connection_close;
+    len = rws_frame_write_send_data(&frame, data, buff, len, rws_true);
+    rws_socket_send(s, data, len);
     s->command = COMMAND_END;
     rws_thread_sleep(RWS_CONNECT_RETRY_DELAY); // little bit wait after send message
 }
@@ -825,22 +852,8 @@ void rws_socket_append_recvd_frames(rws_socket s, _rws_frame * frame)
     }
 }
 
-void rws_socket_append_send_frames(rws_socket s, _rws_frame * frame)
-{
-    _rws_node_value frame_list_var;
-    frame_list_var.object = frame;
-    if (s->send_frames) {
-        rws_list_append(s->send_frames, frame_list_var);
-    } else {
-        s->send_frames = rws_list_create();
-        s->send_frames->value = frame_list_var;
-    }
-}
-
 rws_bool rws_socket_send_text_priv2(rws_socket s, const char * text, size_t len)
 {
-    _rws_frame * frame = NULL;
-
     if (len <= 0) {
         return rws_false;
     }
@@ -849,19 +862,12 @@ rws_bool rws_socket_send_text_priv2(rws_socket s, const char * text, size_t len)
         return rws_false;
     }
 
-    frame = rws_frame_create();
-    frame->is_masked = rws_true;
-    frame->opcode = rws_opcode_text_frame;
-    rws_frame_fill_with_send_data(frame, text, len, rws_true);
-    rws_socket_append_send_frames(s, frame);
-
-    return rws_true;
+    return rws_socket_append_send_data(s, rws_opcode_text_frame, text, len, rws_true);
 }
 
 rws_bool rws_socket_send_text_priv(rws_socket s, const char * text)
 {
     size_t len = text ? strlen(text) : 0;
-    _rws_frame * frame = NULL;
 
     if (len <= 0) {
         return rws_false;
@@ -871,54 +877,38 @@ rws_bool rws_socket_send_text_priv(rws_socket s, const char * text)
         return rws_false;
     }
 
-    frame = rws_frame_create();
-    frame->is_masked = rws_true;
-    frame->opcode = rws_opcode_text_frame;
-    rws_frame_fill_with_send_data(frame, text, len, rws_true);
-    rws_socket_append_send_frames(s, frame);
-
-    return rws_true;
+    return rws_socket_append_send_data(s, rws_opcode_text_frame, text, len, rws_true);
 }
 
 rws_bool rws_socket_send_bin_priv(rws_socket s, const char * bin, size_t size, rws_binary bin_type)
 {
-    _rws_frame * frame = NULL;
+    rws_opcode opcode = rws_opcode_continuation;
 
     if (rws_socket_mem_used_out(s, size)) {
         return rws_false;
     }
 
-    frame = rws_frame_create();
-    if (frame != NULL) {
-        frame->is_masked = rws_true;
-        switch (bin_type) {
-        case rws_binary_start:
-            //DBG("rws_binary_start\n");
-            frame->opcode = rws_opcode_binary_frame;
-            break;
-        case rws_binary_continue:
-            //DBG("rws_binary_continue\n");
-            frame->opcode = rws_opcode_continuation;
-            break;
-        case rws_binary_finish:
-            //DBG("rws_binary_finish\n");
-            frame->opcode = rws_opcode_continuation;
-            break;
-        }
-        litews_frame_fill_with_send_bin_data(frame, bin, size, bin_type);
-        rws_socket_append_send_frames(s, frame);
-
-        return rws_true;
-    } else {
-        /*Need to free data????*/
-        return rws_false;
+    switch (bin_type) {
+    case rws_binary_start:
+        //DBG("rws_binary_start\n");
+        opcode = rws_opcode_binary_frame;
+        break;
+    case rws_binary_continue:
+        //DBG("rws_binary_continue\n");
+        opcode = rws_opcode_continuation;
+        break;
+    case rws_binary_finish:
+        //DBG("rws_binary_finish\n");
+        opcode = rws_opcode_continuation;
+        break;
     }
+
+    return rws_socket_append_send_data(s, opcode, bin, size, bin_type == rws_binary_finish ? rws_true : rws_false);
 }
 
 rws_bool rws_socket_send_bin_start_priv(rws_socket s, const char *bin, size_t len)
 {
     CHECK_RET_WITH_RET(bin, rws_false);
-    _rws_frame * frame = NULL;
 
     if (len <= 0) {
         return rws_false;
@@ -928,19 +918,12 @@ rws_bool rws_socket_send_bin_start_priv(rws_socket s, const char *bin, size_t le
         return rws_false;
     }
 
-    frame = rws_frame_create();
-    frame->is_masked = rws_true;
-    frame->opcode = rws_opcode_binary_frame;
-    rws_frame_fill_with_send_data(frame, bin, len, rws_false);
-    rws_socket_append_send_frames(s, frame);
-
-    return rws_true;
+    return rws_socket_append_send_data(s, rws_opcode_binary_frame, bin, len, rws_false);
 }
 
 rws_bool rws_socket_send_bin_continue_priv(rws_socket s, const char *bin, size_t len)
 {
     CHECK_RET_WITH_RET(bin, rws_false);
-    _rws_frame * frame = NULL;
 
     if (len <= 0) {
         return rws_false;
@@ -950,19 +933,12 @@ rws_bool rws_socket_send_bin_continue_priv(rws_socket s, const char *bin, size_t
         return rws_false;
     }
 
-    frame = rws_frame_create();
-    frame->is_masked = rws_true;
-    frame->opcode = rws_opcode_continuation;
-    rws_frame_fill_with_send_data(frame, bin, len, rws_false);
-    rws_socket_append_send_frames(s, frame);
-
-    return rws_true;
+    return rws_socket_append_send_data(s, rws_opcode_continuation, bin, len, rws_false);
 }
 
 rws_bool rws_socket_send_bin_finish_priv(rws_socket s, const char *bin, size_t len)
 {
     CHECK_RET_WITH_RET(bin, rws_false);
-    _rws_frame * frame = NULL;
 
     if (len <= 0) {
         return rws_false;
@@ -972,13 +948,7 @@ rws_bool rws_socket_send_bin_finish_priv(rws_socket s, const char *bin, size_t l
         return rws_false;
     }
     
-    frame = rws_frame_create();
-    frame->is_masked = rws_true;
-    frame->opcode = rws_opcode_continuation;
-    rws_frame_fill_with_send_data(frame, bin, len, rws_true);
-    rws_socket_append_send_frames(s, frame);
-
-    return rws_true;
+    return rws_socket_append_send_data(s, rws_opcode_continuation, bin, len, rws_true);
 }
 
 void rws_socket_delete_all_frames_in_list(_rws_list * list_with_frames)
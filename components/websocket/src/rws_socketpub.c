@@ -202,9 +202,10 @@ void rws_socket_delete(rws_socket s)
     s->received_len = 0;
 
     s->send_append_size = 0;
+    rws_free_clean(&s->send_buf);
+    s->send_buf_size = 0;
+    s->send_buf_len = 0;
 
-    rws_socket_delete_all_frames_in_list(s->send_frames);
-    rws_list_delete_clean(&s->send_frames);
     rws_socket_delete_all_frames_in_list(s->recvd_frames);
     rws_list_delete_clean(&s->recvd_frames);
 
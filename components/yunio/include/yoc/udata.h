@@ -6,6 +6,7 @@
 #define UDATA_H
 
 #include <stdlib.h>
+#include <stdint.h>
 
 #include <aos/list.h>
 
@@ -50,10 +51,17 @@ Value value(int type, ...);
 #define value_b(v) value(TYPE_BOOL, v)
 #define value_f(v) value(TYPE_FLOAT, (double)v)
 
+#ifndef CONFIG_UDATA_INDEX_SIZE
+#define CONFIG_UDATA_INDEX_SIZE (32)   /* buckets of the key index, power of 2 */
+#endif
+
 struct _udata {
     slist_t head;
     Value key;
     Value value;
+    uint32_t hash;      /* hash of key */
+    uData *hash_next;   /* next node in the same bucket */
+    uData **index;      /* key index, only used in the root node */
 };
 
 typedef int (*josn_node_cb_t)(const char *json, const char *key, const char *val, int type, void *arg);
@@ -69,6 +77,7 @@ void yoc_udata_clear_flag_all(uData *data);
 int yoc_udata_set_flag(uData *udata, Value key, int flag);
 
 int yoc_data_print(uData *data);
+int yoc_udata_json_len(uData *data, int check_update);
 int yoc_udata_to_json(uData *data, char *buffer, size_t len, int check_update);
 int yoc_udata_from_json(uData *data, char *json);
 
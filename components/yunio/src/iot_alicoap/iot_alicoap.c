@@ -117,12 +117,19 @@ static int alicoap_channel_start(iot_channel_t *ch)
 static int alicoap_channel_send(iot_channel_t *ch)
 {
     int  ret = 0;
-    char str[128]; // = "{\"type\":1,\"val\":22}";
-
+    char buf[128]; // = "{\"type\":1,\"val\":22}";
+    char *str = buf;
+    int  len;
 
     aos_mutex_lock(&ch->ch_mutex, AOS_WAIT_FOREVER);
 
-    ret = yoc_udata_to_json(ch->uData, str, sizeof(str), 1);
+    /* the exact length is known before encoding, only a large report needs the heap */
+    len = yoc_udata_json_len(ch->uData, 1) + 1;
+    if (len > sizeof(buf)) {
+        str = aos_malloc(len);
+    }
+
+    ret = str ? yoc_udata_to_json(ch->uData, str, len, 1) : -1;
 
     /* clear key update flag */
     yoc_udata_clear_flag_all(ch->uData);
@@ -137,6 +144,10 @@ static int alicoap_channel_send(iot_channel_t *ch)
         ret = -1;
     }
 
+    if (str != buf) {
+        aos_free(str);
+    }
+
     return ret;
 }
 
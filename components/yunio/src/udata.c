@@ -36,7 +36,11 @@ int value_cmp(const Value *v1, const Value *v2)
                 return v1->v_int - v2->v_int;
 
             case TYPE_FLOAT:
-                return v1->v_float - v2->v_float;
+                /* not by the difference, it truncates to int: 1.9 and 2.1 would be equal */
+                if (v1->v_float == v2->v_float) {
+                    return 0;
+                }
+                return v1->v_float < v2->v_float ? -1 : 1;
 
             case TYPE_STR:
                 return strcmp(v1->v_str, v2->v_str);
@@ -180,9 +184,63 @@ int value_set(Value *v, int type, ...)
     return ret;
 }
 
+static uint32_t _udata_hash(const Value *key)
+{
+    uint32_t    hash = 2166136261u;
+    uint32_t    bits;
+    const char *str;
+
+    switch (key->type) {
+        case TYPE_STR:
+            for (str = key->v_str; str && *str; str++) {
+                hash = (hash ^ (uint8_t)*str) * 16777619u;
+            }
+            break;
+
+        case TYPE_INT:
+            hash = (uint32_t)key->v_int * 2654435761u;
+            break;
+
+        case TYPE_BOOL:
+            hash = key->v_bool;
+            break;
+
+        case TYPE_FLOAT:
+            /* value_cmp compares float exactly, so by the bits, 0.0 and -0.0 are equal */
+            bits = 0;
+            if (key->v_float != 0) {
+                memcpy(&bits, &key->v_float, sizeof(bits));
+            }
+            /* the low mantissa bits of a round value are 0, mix the high bits down */
+            hash = bits ^ (bits >> 16);
+            hash *= 0x45d9f3bu;
+            hash ^= hash >> 16;
+            break;
+
+        default:
+            hash = 0;
+            break;
+    }
+
+    return hash ^ key->type;
+}
+
 static uData *_udata_find(uData *data, Value key)
 {
     uData *node;
+
+    if (data->index) {
+        uint32_t hash = _udata_hash(&key);
+
+        for (node = data->index[hash & (CONFIG_UDATA_INDEX_SIZE - 1)]; node; node = node->hash_next) {
+            if (node->hash == hash && value_cmp(&node->key, &key) == 0) {
+                return node;
+            }
+        }
+
+        return NULL;
+    }
+
     slist_for_each_entry(&data->head, node, uData, head)
     {
         if (value_cmp(&node->key, &key) == 0) {
@@ -193,6 +251,27 @@ static uData *_udata_find(uData *data, Value key)
     return NULL;
 }
 
+static void _udata_add(uData *data, uData *node)
+{
+    uint32_t idx;
+
+    /* the index is created with the first node, lookups walk the list if that failed */
+    if (data->index == NULL && slist_empty(&data->head)) {
+        data->index = aos_zalloc(sizeof(uData *) * CONFIG_UDATA_INDEX_SIZE);
+    }
+
+    slist_add_tail(&node->head, &data->head);
+
+    if (data->index == NULL) {
+        return;
+    }
+
+    node->hash        = _udata_hash(&node->key);
+    idx               = node->hash & (CONFIG_UDATA_INDEX_SIZE - 1);
+    node->hash_next   = data->index[idx];
+    data->index[idx]  = node;
+}
+
 uData *yoc_udata_new()
 {
     uData *data = aos_zalloc(sizeof(uData));
@@ -218,6 +297,7 @@ void yoc_udata_free(uData *data)
 
     value_uninit(&data->key);
     value_uninit(&data->value);
+    aos_free(data->index);
     aos_free(data);
 
     //while (!slist_empty(&data->head)) {
@@ -228,18 +308,11 @@ void yoc_udata_free(uData *data)
 
 uData *yoc_udata_get(uData *data, Value key)
 {
-    uData *node = NULL;
-    slist_for_each_entry(&data->head, node, uData, head)
-    {
-        if (value_cmp(&node->key, &key) == 0) {
-            value_uninit(&key);
-            return node;
-        }
-    }
+    uData *node = _udata_find(data, key);
 
     value_uninit(&key);
 
-    return NULL;
+    return node;
 }
 
 int yoc_udata_set(uData *data, Value key, Value value, int force_set_update_flag)
@@ -256,7 +329,7 @@ int yoc_udata_set(uData *data, Value key, Value value, int force_set_update_flag
             d->value = value;
             /* new node not set update flag*/
             d->value.updated = 0;
-            slist_add_tail(&d->head, &data->head);
+            _udata_add(data, d);
         }
     } else {
         if (value_cmp(&value, &d->value) != 0) {
@@ -299,87 +372,188 @@ int yoc_udata_set_flag(uData *udata, Value key, int flag)
     return -1;
 }
 
-int yoc_udata_to_json(uData *data, char *buffer, size_t len, int check_update)
+static int _json_int_len(int v)
 {
-    uData *node;
+    unsigned int u   = v < 0 ? 0U - (unsigned int)v : (unsigned int)v;
+    int          len = v < 0 ? 2 : 1;
 
-    int   ret;
-    char *ptr = buffer;
+    while (u >= 10) {
+        u /= 10;
+        len++;
+    }
 
-    ret = snprintf(ptr, len, "%c", '{');
+    return len;
+}
 
-    if (ret >= len) {
-        return -1;
+static char *_json_put_int(char *ptr, int v)
+{
+    unsigned int u   = v < 0 ? 0U - (unsigned int)v : (unsigned int)v;
+    int          len = _json_int_len(v);
+    char        *end = ptr + len;
+
+    if (v < 0) {
+        *ptr = '-';
     }
 
-    ptr += ret;
-    len -= ret;
+    do {
+        *--end = '0' + u % 10;
+        u /= 10;
+    } while (u);
 
-    slist_for_each_entry(&data->head, node, uData, head)
-    {
-        if (check_update && !node->value.updated) {
-            continue;
-        }
+    return ptr + len;
+}
 
-        switch (node->key.type) {
-            case TYPE_INT:
-                ret = snprintf(ptr, len, "\"%d\":", node->key.v_int);
-                break;
+static char *_json_put_str(char *ptr, const char *str, int len)
+{
+    *ptr++ = '\"';
+    memcpy(ptr, str, len);
+    ptr += len;
+    *ptr++ = '\"';
 
-            case TYPE_STR:
-                ret = snprintf(ptr, len, "\"%s\":", node->key.v_str);
-                break;
+    return ptr;
+}
 
-            default:
-                ret = 0;
-                break;
-        }
+/* length of '"key":value,' , 0 if the node can't be encoded */
+static int _json_node_len(uData *node)
+{
+    int len;
 
-        if (ret >= len) {
-            return -1;
-        }
+    switch (node->key.type) {
+        case TYPE_INT:
+            len = _json_int_len(node->key.v_int) + 3;
+            break;
 
-        ptr += ret;
-        len -= ret;
+        case TYPE_STR:
+            len = strlen(node->key.v_str) + 3;
+            break;
 
-        switch (node->value.type) {
-            case TYPE_BOOL:
-                ret = snprintf(ptr, len, "%s,", node->value.v_bool ? "true" : "false");
-                break;
+        default:
+            return 0;
+    }
 
-            case TYPE_INT:
-                ret = snprintf(ptr, len, "%d,", node->value.v_int);
-                break;
+    switch (node->value.type) {
+        case TYPE_BOOL:
+            return len + (node->value.v_bool ? 4 : 5) + 1;
 
-            case TYPE_STR:
-                ret = snprintf(ptr, len, "\"%s\",", node->value.v_str);
-                break;
-            case TYPE_FLOAT:
-                ret = snprintf(ptr, len, "\"%d\",", (int)node->value.v_float);
-                break;
-            default:
-                snprintf(ptr, len, "\"%s\",", node->value.v_str);
-                ret = 0;
-                break;
-        }
+        case TYPE_INT:
+            return len + _json_int_len(node->value.v_int) + 1;
 
-        if (ret >= len) {
-            return -1;
+        case TYPE_STR:
+            return len + strlen(node->value.v_str) + 3;
+
+        case TYPE_FLOAT:
+            return len + _json_int_len((int)node->value.v_float) + 3;
+
+        default:
+            return 0;
+    }
+}
+
+static char *_json_put_node(char *ptr, uData *node)
+{
+    if (node->key.type == TYPE_INT) {
+        *ptr++ = '\"';
+        ptr    = _json_put_int(ptr, node->key.v_int);
+        *ptr++ = '\"';
+    } else {
+        ptr = _json_put_str(ptr, node->key.v_str, strlen(node->key.v_str));
+    }
+
+    *ptr++ = ':';
+
+    switch (node->value.type) {
+        case TYPE_BOOL:
+            if (node->value.v_bool) {
+                memcpy(ptr, "true", 4);
+                ptr += 4;
+            } else {
+                memcpy(ptr, "false", 5);
+                ptr += 5;
+            }
+            break;
+
+        case TYPE_INT:
+            ptr = _json_put_int(ptr, node->value.v_int);
+            break;
+
+        case TYPE_STR:
+            ptr = _json_put_str(ptr, node->value.v_str, strlen(node->value.v_str));
+            break;
+
+        case TYPE_FLOAT:
+            *ptr++ = '\"';
+            ptr    = _json_put_int(ptr, (int)node->value.v_float);
+            *ptr++ = '\"';
+            break;
+    }
+
+    *ptr++ = ',';
+
+    return ptr;
+}
+
+/**
+ * exact strlen of the json yoc_udata_to_json makes, 0 if there is nothing to encode.
+ * the buffer given to yoc_udata_to_json must hold one more byte for '\0'
+ */
+int yoc_udata_json_len(uData *data, int check_update)
+{
+    uData *node;
+    int    len = 0;
+
+    aos_check_return_val(data, 0);
+
+    slist_for_each_entry(&data->head, node, uData, head)
+    {
+        if (check_update && !node->value.updated) {
+            continue;
         }
 
-        ptr += ret;
-        len -= ret;
+        len += _json_node_len(node);
     }
 
+    /* '{' and the last ',' replaced by '}' */
+    return len ? len + 1 : 0;
+}
+
+int yoc_udata_to_json(uData *data, char *buffer, size_t len, int check_update)
+{
+    uData *node;
+    char  *ptr;
+    int    json_len;
+
+    aos_check_return_einval(data && buffer && len > 0);
+
+    json_len = yoc_udata_json_len(data, check_update);
+
     /* empty */
-    if (*(ptr - 1) == '{') {
+    if (json_len == 0) {
         buffer[0] = '\0';
         return 0;
     }
 
+    if (json_len >= len) {
+        return -1;
+    }
+
+    ptr    = buffer;
+    *ptr++ = '{';
+
+    slist_for_each_entry(&data->head, node, uData, head)
+    {
+        if (check_update && !node->value.updated) {
+            continue;
+        }
+
+        if (_json_node_len(node) > 0) {
+            ptr = _json_put_node(ptr, node);
+        }
+    }
+
     *(ptr - 1) = '}';
+    *ptr       = '\0';
 
-    return strlen(buffer);
+    return json_len;
 }
 
 static int josn_node_cb(const char *json, const char *key, const char *val, int type, void *arg)
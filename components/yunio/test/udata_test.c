@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2018-2020 Alibaba Group Holding Limited
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <aos/aos.h>
+#include <yoc/udata.h>
+
+/*
+ * float keys: the lookups, 0.0 and -0.0 as one key, and the spread of the round values
+ * over the key index, which put them all in one bucket before
+ */
+
+#define TEST_ASSERT(name, v)  do { \
+                            if (!(v)) { \
+                                printf("ASSERT[%s] %d\n", name, __LINE__); \
+                                return -1; \
+                            } \
+                        } while(0);
+
+#define TEST_KEY_CNT           (8 * CONFIG_UDATA_INDEX_SIZE)
+/* a bucket holds at most 3 times its share */
+#define TEST_BUCKET_MAX        (3 * TEST_KEY_CNT / CONFIG_UDATA_INDEX_SIZE)
+
+static float _key(int i, int round)
+{
+    return round ? (float)i * (i % 2 ? 1.0f : 1000.0f) : (float)i * 0.1f + 0.05f;
+}
+
+static int _bucket_check(const char *name, uData *d)
+{
+    int i, n, max = 0, empty = 0;
+    uData *node;
+
+    TEST_ASSERT(name, d->index);
+    for (i = 0; i < CONFIG_UDATA_INDEX_SIZE; i++) {
+        n = 0;
+        for (node = d->index[i]; node; node = node->hash_next) {
+            n++;
+        }
+        max    = n > max ? n : max;
+        empty += n == 0;
+    }
+    printf("%s: bucket max %d, empty %d\n", name, max, empty);
+    TEST_ASSERT(name, max <= TEST_BUCKET_MAX);
+    TEST_ASSERT(name, empty == 0);
+
+    return 0;
+}
+
+static int _float_check(const char *name, int round)
+{
+    int i, rc;
+    uData *d, *n;
+
+    d = yoc_udata_new();
+    TEST_ASSERT(name, d);
+    for (i = 1; i <= TEST_KEY_CNT; i++) {
+        yoc_udata_set(d, value_f(_key(i, round)), value_i(i), 0);
+    }
+    yoc_udata_set(d, value_f(0.0f), value_i(0), 0);
+
+    for (i = 1; i <= TEST_KEY_CNT; i++) {
+        n = yoc_udata_get(d, value_f(_key(i, round)));
+        TEST_ASSERT(name, n && n->value.v_int == i);
+    }
+    n = yoc_udata_get(d, value_f(-0.0f));
+    TEST_ASSERT(name, n && n->value.v_int == 0);
+    TEST_ASSERT(name, yoc_udata_get(d, value_f(_key(TEST_KEY_CNT + 1, round))) == NULL);
+
+    rc = _bucket_check(name, d);
+    yoc_udata_free(d);
+
+    return rc;
+}
+
+/**
+ * @brief  test the float keys of udata
+ * @return 0/-1
+ */
+int udata_test(void)
+{
+    int rc;
+
+    rc = _float_check("float", 0);
+    rc |= _float_check("float round", 1);
+
+    if (rc == 0) {
+        printf("test over, all pass\n");
+    }
+
+    return rc;
+}
@@ -127,6 +127,25 @@ void Write_Data(unsigned char Data)
     lcd_dc(1);
     lcd_cs(1);
 }
+
+/* Write a run of display data in one chip select */
+static void Write_Data_Burst(const uint8_t *data, int len)
+{
+    unsigned char i, d;
+
+    lcd_cs(0);
+    lcd_dc(1);
+    while (len--) {
+        d = *data++;
+        for (i = 0; i < 8; i++) {
+            lcd_sclk(0);
+            lcd_sdin((d & 0x80) >> 7);
+            d = d << 1;
+            lcd_sclk(1);
+        }
+    }
+    lcd_cs(1);
+}
 #endif
 
 //-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
@@ -292,56 +311,24 @@ void Set_Command_Lock(unsigned char d)
 #define Max_Row 64
 #define Brightness 0xBF
 
-#define SET_BIT(b, n) b |= (1 << n)
-#define CLR_BIT(b, n) b &= ~(uint8_t)(1 << n)
-
+/* Copy of the panel GDDRAM, page by page, one bit per row */
 uint8_t g_oled_ram[8][128];
 
-void oled_draw_point(uint8_t r, uint8_t c, uint8_t t)
-{
-    if (t) {
-        SET_BIT(g_oled_ram[r / 8][c], ((r % 8)));
-    } else {
-        CLR_BIT(g_oled_ram[r / 8][c], (r % 8));
-    }
-}
-
-void oled_draw_frame(uint8_t p[Max_Row][Max_Column])
-{
-    unsigned char i, j;
-
-    for (i = 0; i < Max_Row; i++) {
-        for (j = 0; j < Max_Column; j++) {
-            oled_draw_point(i, j, p[i][j]);
-        }
-    }
-}
-
 void oled_reflesh()
 {
-    unsigned char i, j;
+    unsigned char i;
+
     for (i = 0; i < 8; i++) {
         Set_Start_Page(i);
         Set_Start_Column(0x00);
-
-        for (j = 0; j < 128; j++) {
-            Write_Data(g_oled_ram[i][j]);
-        }
+        Write_Data_Burst(g_oled_ram[i], Max_Column);
     }
 }
 
 void Fill_RAM(unsigned char Data)
 {
-    unsigned char i, j;
-
-    for (i = 0; i < 8; i++) {
-        Set_Start_Page(i);
-        Set_Start_Column(0x00);
-
-        for (j = 0; j < 128; j++) {
-            Write_Data(Data);
-        }
-    }
+    memset(g_oled_ram, Data, sizeof(g_oled_ram));
+    oled_reflesh();
 }
 
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
@@ -370,22 +357,70 @@ static void oled_initialize()
 
     Set_Display_On_Off(0xAF); // Display On (0xAE/0xAF)
 }
+/* The draw buffer has the GDDRAM layout: byte (y / 8) * buf_w + x holds the
+ * 8 rows of a page in one column, bit y % 8. The rounder keeps the areas on
+ * whole pages so LVGL draws straight into it. */
+static void oled_rounder(lv_disp_drv_t *disp_drv, lv_area_t *area)
+{
+    area->y1 = area->y1 & ~7;
+    area->y2 = area->y2 | 7;
+}
+
+static void oled_set_px(lv_disp_drv_t *disp_drv, uint8_t *buf, lv_coord_t buf_w, lv_coord_t x,
+                        lv_coord_t y, lv_color_t color, lv_opa_t opa)
+{
+    uint8_t *byte = buf + (y >> 3) * buf_w + x;
+
+    if (opa < LV_OPA_50) {
+        return;
+    }
+
+    if (color.full) {
+        *byte |= 1 << (y & 7);
+    } else {
+        *byte &= ~(1 << (y & 7));
+    }
+}
+
 /* Flush the content of the internal buffer the specific area on the display
  * You can use DMA or any hardware acceleration to do this operation in the background but
  * 'lv_disp_flush_ready()' has to be called when finished. */
 static void oled_flush(lv_disp_drv_t *disp_drv, const lv_area_t *area, lv_color_t *color_p)
 {
-    oled_draw_frame((uint8_t(*)[Max_Column])color_p);
-    oled_reflesh();
+    const uint8_t *src = (const uint8_t *)color_p;
+    int            w   = lv_area_get_width(area);
+    int            page, first, last;
+    uint8_t *      dst;
+
+    for (page = area->y1 >> 3; page <= area->y2 >> 3; page++, src += w) {
+        dst = &g_oled_ram[page][area->x1];
+
+        /* Only the columns which differ from the panel are sent */
+        for (first = 0; first < w && src[first] == dst[first]; first++)
+            ;
+        if (first == w) {
+            continue;
+        }
+        for (last = w - 1; src[last] == dst[last]; last--)
+            ;
+
+        memcpy(dst + first, src + first, last - first + 1);
+
+        Set_Start_Page(page);
+        Set_Start_Column(area->x1 + first);
+        Write_Data_Burst(dst + first, last - first + 1);
+    }
 
     /* IMPORTANT!!!
      * Inform the graphics library that you are ready with the flushing*/
     lv_disp_flush_ready(disp_drv);
 }
 
+/* One packed screen, 1 KB. The flush is synchronous so a second buffer would
+ * not overlap anything, and LVGL can not use two screen sized buffers with
+ * set_px_cb. The size is given in pixels. */
 static lv_disp_buf_t disp_buf1;
-static lv_color_t    buf1[64 * 128];
-static lv_color_t    buf2[64 * 128];
+static uint8_t       buf1[Max_Row / 8 * Max_Column];
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
 //  Main Program
 //=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=-=
@@ -398,13 +433,15 @@ void oled_init()
 
     // lv_disp porting
     /*Create a display buffer*/
-    lv_disp_buf_init(&disp_buf1, buf1, buf2, 64 * 128);
+    lv_disp_buf_init(&disp_buf1, buf1, NULL, Max_Row * Max_Column);
 
     /*Create a display*/
     lv_disp_drv_t disp_drv;
     lv_disp_drv_init(&disp_drv); /*Basic initialization*/
-    disp_drv.buffer   = &disp_buf1;
-    disp_drv.flush_cb = oled_flush;
-    disp_drv.rotated  = 0;
+    disp_drv.buffer     = &disp_buf1;
+    disp_drv.flush_cb   = oled_flush;
+    disp_drv.rounder_cb = oled_rounder;
+    disp_drv.set_px_cb  = oled_set_px;
+    disp_drv.rotated    = 0;
     lv_disp_drv_register(&disp_drv);
 }
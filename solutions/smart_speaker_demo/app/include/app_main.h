@@ -140,6 +140,7 @@ int8_t app_sd_detect_check(void);
 /* 命令行测试 */
 void cli_reg_cmd_aui(void);
 void cli_reg_cmd_yvdbg(void);
+void cli_reg_cmd_vpcm(void);
 void cli_reg_cmd_app(void);
 void cli_reg_cmd_gpio(void);
 void cli_reg_cmd_tftp(void);
@@ -221,6 +221,7 @@ static void cli_reg_cmds(void)
 {
     cli_reg_cmd_aui();
     cli_reg_cmd_yvdbg();
+    cli_reg_cmd_vpcm();
     cli_reg_cmd_app();
     cli_reg_cmd_gpio();
 